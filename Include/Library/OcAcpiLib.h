@@ -100,6 +100,12 @@ typedef struct {
   // Number of allocated region slots.
   //
   UINT32                                         AllocatedRegions;
+  //
+  // Region indices hashed by address and by name, AllocatedRegions * 2 slots
+  // each with MAX_UINT32 marking free slots.
+  //
+  UINT32                                         *RegionsByAddress;
+  UINT32                                         *RegionsByName;
 } OC_ACPI_CONTEXT;
 
 //
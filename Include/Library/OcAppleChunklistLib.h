@@ -18,6 +18,12 @@
 #include <Library/OcAppleRamDiskLib.h>
 #include <Library/OcCryptoLib.h>
 
+//
+// Size of a single file read done when loading a file against a chunklist.
+// Kept small enough for the data to stay in the cache until it is hashed.
+//
+#define OC_APPLE_CHUNKLIST_LOAD_BLOCK_SIZE  SIZE_1MB
+
 //
 // Chunklist context.
 //
@@ -74,4 +80,25 @@ OcAppleChunklistVerifyData (
   IN     CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable
   );
 
+/**
+  Loads the specified file into a RAM disk and verifies it against
+  a chunklist context as it is being read.
+
+  @param[in] Context            The Context to verify against.
+  @param[in] ExtentTable        A pointer to the RAM disk extent table to load
+                                the file into.
+  @param[in] File               File protocol open for reading.
+  @param[in] FileSize           The size of the file specified in File.
+
+  @retval TRUE   The file was loaded and verified successfully.
+  @retval FALSE  The file could not be loaded or failed verification.
+**/
+BOOLEAN
+OcAppleChunklistLoadFile (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT         *Context,
+  IN     CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
+  IN     EFI_FILE_PROTOCOL                  *File,
+  IN     UINTN                              FileSize
+  );
+
 #endif // APPLE_CHUNKLIST_LIB_H
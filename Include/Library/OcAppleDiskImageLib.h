@@ -41,9 +41,10 @@ OcAppleDiskImageInitializeContext (
 
 BOOLEAN
 OcAppleDiskImageInitializeFromFile (
-  OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  EFI_FILE_PROTOCOL            *File,
-  IN  BOOLEAN                      AvoidHighMem
+  OUT    OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     EFI_FILE_PROTOCOL            *File,
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT   *ChunklistContext OPTIONAL,
+  IN     BOOLEAN                      AvoidHighMem
   );
 
 VOID
@@ -102,6 +102,14 @@ typedef struct {
   //
   CHAR8                    *PrelinkedInfo;
   //
+  // Original PRELINK_INFO_SECTION size.
+  //
+  UINT32                   PrelinkedInfoSize;
+  //
+  // Expected PRELINK_INFO_SECTION size after injection, 0 unless planned.
+  //
+  UINT32                   PrelinkedInfoPlannedSize;
+  //
   // Parsed instance of PlistInfo. New entries are added here.
   //
   XML_DOCUMENT             *PrelinkedInfoDocument;
@@ -130,6 +138,60 @@ typedef struct {
   LIST_ENTRY               PrelinkedKexts;
 } PRELINKED_CONTEXT;
 
+//
+// Kext executable validated before injection.
+//
+typedef struct {
+  //
+  // Mach-O context for the original executable, which must stay valid
+  // until the kext is injected.
+  //
+  OC_MACHO_CONTEXT         MachContext;
+  //
+  // Executable size in memory, 0 for executables without segments.
+  //
+  UINT32                   VmSize;
+  //
+  // Offset of kmod_info from the executable load address, 0 when missing.
+  //
+  UINT64                   KmodOffset;
+  //
+  // Final slot assigned by PrelinkedInjectPlan, SlotSize is 0 unless planned.
+  //
+  UINT32                   SlotOffset;
+  UINT32                   SlotSize;
+  UINT64                   SlotAddress;
+  UINT64                   SlotLoadAddress;
+} PRELINKED_KEXT_PREFLIGHT;
+
+//
+// Kext to be laid out by PrelinkedInjectPlan.
+//
+typedef struct {
+  //
+  // Kext Info.plist size.
+  //
+  UINT32                    InfoPlistSize;
+  //
+  // Kext executable preflight, NULL for plist-only kexts.
+  //
+  PRELINKED_KEXT_PREFLIGHT  *Preflight;
+} PRELINKED_KEXT_LAYOUT;
+
+//
+// Pre-resolved patcher symbol.
+//
+typedef struct {
+  //
+  // Symbol name.
+  //
+  CONST CHAR8              *Name;
+  //
+  // Symbol address in file or NULL when not found.
+  //
+  UINT8                    *Address;
+} PATCHER_SYMBOL;
+
 //
 // Kernel and kext patching context.
 //
@@ -146,8 +208,37 @@ typedef struct {
   // Virtual kmod_info_t address.
   //
   UINT64                   VirtualKmod;
+  //
+  // Symbols resolved with PatcherResolveSymbols, checked before
+  // scanning the symbol table, or NULL.
+  //
+  PATCHER_SYMBOL           *Symbols;
+  //
+  // Amount of resolved symbols.
+  //
+  UINT32                   SymbolCount;
 } PATCHER_CONTEXT;
 
+//
+// Kernel quirks applicable with KernelApplyQuirks.
+//
+typedef enum {
+  KernelQuirkAppleCpuPmCfgLock,
+  KernelQuirkAppleXcpmCfgLock,
+  KernelQuirkAppleXcpmExtraMsrs,
+  KernelQuirkAppleXcpmForceBoost,
+  KernelQuirkCustomSmbiosGuid,
+  KernelQuirkDisableIoMapper,
+  KernelQuirkExternalDiskIcons,
+  KernelQuirkIncreasePciBarSize,
+  KernelQuirkLapicKernelPanic,
+  KernelQuirkPanicNoKextDump,
+  KernelQuirkPowerTimeoutKernelPanic,
+  KernelQuirkThirdPartyDrives,
+  KernelQuirkXhciPortLimit,
+  KernelQuirkMax
+} KERNEL_QUIRK_NAME;
+
 //
 // Kernel and kext patch description.
 //
@@ -301,6 +392,62 @@ PrelinkedReserveKextSize (
   IN     UINT32       ExecutableSize OPTIONAL
   );
 
+/**
+  Updated required reserve size to inject preflighted kext.
+
+  @param[in,out] ReservedSize    Current reserved size, updated.
+  @param[in]     InfoPlistSize   Kext Info.plist size.
+  @param[in]     Preflight       Kext executable preflight, optional.
+
+  @return  RETURN_SUCCESS on success.
+**/
+RETURN_STATUS
+PrelinkedReserveKextSizeEx (
+  IN OUT UINT32                    *ReservedSize,
+  IN     UINT32                    InfoPlistSize,
+  IN     PRELINKED_KEXT_PREFLIGHT  *Preflight OPTIONAL
+  );
+
+/**
+  Validate kext executable once for size reservation and injection,
+  and locate its kmod_info.
+
+  @param[out] Preflight       Kext executable preflight.
+  @param[in]  Executable      Kext executable, referenced by Preflight.
+  @param[in]  ExecutableSize  Kext executable size.
+
+  @return  RETURN_SUCCESS on success.
+**/
+RETURN_STATUS
+PrelinkedPreflightKext (
+  OUT PRELINKED_KEXT_PREFLIGHT  *Preflight,
+  IN  CONST UINT8               *Executable,
+  IN  UINT32                    ExecutableSize
+  );
+
+/**
+  Plan final placement of the kexts to be injected. Must be called after
+  PrelinkedInjectPrepare, normally before any kext injection.
+
+  Every kext executable is assigned a slot in PRELINK_TEXT_SEGMENT, which is
+  grown once to fit all of them, and the regenerated PRELINK_INFO_SECTION
+  size is estimated. Planned kexts should then be injected in any order
+  with PrelinkedInjectKextEx, which copies every executable to its slot.
+
+  @param[in,out] Context   Prelinked context.
+  @param[in]     Kexts     Kexts to be injected, preflights are updated.
+  @param[in]     NumKexts  Number of kexts in Kexts.
+
+  @return  RETURN_SUCCESS on success.
+  @return  RETURN_BUFFER_TOO_SMALL when the kexts do not fit the allocation.
+**/
+RETURN_STATUS
+PrelinkedInjectPlan (
+  IN OUT PRELINKED_CONTEXT      *Context,
+  IN     PRELINKED_KEXT_LAYOUT  *Kexts,
+  IN     UINT32                 NumKexts
+  );
+
 /**
   Perform kext injection.
 
@@ -325,6 +472,28 @@ PrelinkedInjectKext (
   IN     UINT32             ExecutableSize OPTIONAL
   );
 
+/**
+  Perform preflighted kext injection.
+
+  @param[in,out] Context         Prelinked context.
+  @param[in]     BundlePath      Kext bundle path (e.g. /L/E/mykext.kext).
+  @param[in,out] InfoPlist       Kext Info.plist.
+  @param[in]     InfoPlistSize   Kext Info.plist size.
+  @param[in,out] ExecutablePath  Kext executable path (e.g. Contents/MacOS/mykext), optional.
+  @param[in]     Preflight       Kext executable preflight, optional.
+
+  @return  RETURN_SUCCESS on success.
+**/
+RETURN_STATUS
+PrelinkedInjectKextEx (
+  IN OUT PRELINKED_CONTEXT         *Context,
+  IN     CONST CHAR8               *BundlePath,
+  IN     CONST CHAR8               *InfoPlist,
+  IN     UINT32                    InfoPlistSize,
+  IN     CONST CHAR8               *ExecutablePath OPTIONAL,
+  IN     PRELINKED_KEXT_PREFLIGHT  *Preflight OPTIONAL
+  );
+
 /**
   Initialize patcher from prelinked context for kext patching.
 
@@ -373,6 +542,22 @@ PatcherGetSymbolAddress (
   IN OUT UINT8              **Address
   );
 
+/**
+  Resolve multiple symbols in one symbol table pass. Resolved symbols are
+  used by PatcherGetSymbolAddress and PatcherApplyGenericPatch until
+  Context->Symbols is reset, so Symbols must stay valid till then.
+
+  @param[in,out] Context         Patcher context.
+  @param[in,out] Symbols         Symbols to resolve, addresses are updated.
+  @param[in]     SymbolCount     Amount of symbols.
+**/
+VOID
+PatcherResolveSymbols (
+  IN OUT PATCHER_CONTEXT    *Context,
+  IN OUT PATCHER_SYMBOL     *Symbols,
+  IN     UINT32             SymbolCount
+  );
+
 /**
   Apply generic patch.
 
@@ -574,4 +759,23 @@ PatchPowerStateTimeout (
   IN OUT PATCHER_CONTEXT   *Patcher
   );
 
+/**
+  Apply enabled kernel and kext quirks. Quirks are grouped by target image,
+  every image is initialised once, has all base symbols resolved in one
+  symbol table pass, and is patched in base symbol address order.
+  PatchKernelCpuId requires extra arguments and is applied separately.
+
+  @param[in,out] Prelinked      Prelinked context for kext quirks, optional.
+  @param[in,out] KernelPatcher  Kernel patcher context for kernel quirks, optional.
+  @param[in]     Quirks         Enabled quirks, KernelQuirkMax entries.
+
+  @return  RETURN_SUCCESS when all enabled quirks applied.
+**/
+RETURN_STATUS
+KernelApplyQuirks (
+  IN OUT PRELINKED_CONTEXT  *Prelinked OPTIONAL,
+  IN OUT PATCHER_CONTEXT    *KernelPatcher OPTIONAL,
+  IN     CONST BOOLEAN      *Quirks
+  );
+
 #endif // OC_APPLE_KERNEL_LIB_H
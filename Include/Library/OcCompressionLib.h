@@ -117,4 +117,126 @@ DecompressZLIB (
   IN  UINTN        SrcLen
   );
 
+/**
+  Algorithms supported by decompression streams.
+**/
+typedef enum {
+  OcCompressionLzss,
+  OcCompressionLzvn,
+  OcCompressionZlib
+} OC_COMPRESSION_TYPE;
+
+/**
+  Resumable decompression stream.
+**/
+typedef struct OC_DECOMPRESS_STREAM_ OC_DECOMPRESS_STREAM;
+
+/**
+  Allocate decompression stream. Window and codec state allocations
+  are kept until the stream is freed and are reused after reset.
+
+  @param[in]  Type        Compression algorithm.
+
+  @return  Allocated stream or NULL.
+**/
+OC_DECOMPRESS_STREAM *
+OcDecompressStreamInit (
+  IN OC_COMPRESSION_TYPE  Type
+  );
+
+/**
+  Reset decompression stream to decode a new compressed buffer.
+  Pending input is dropped.
+
+  @param[in,out]  Stream      Decompression stream.
+**/
+VOID
+OcDecompressStreamReset (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream
+  );
+
+/**
+  Provide next chunk of compressed data. The data is not copied and must
+  stay valid until it is consumed by OcDecompressStreamDrain, i.e. until
+  it returns RETURN_NOT_READY or RETURN_END_OF_FILE.
+
+  @param[in,out]  Stream      Decompression stream.
+  @param[in]      Src         Source buffer.
+  @param[in]      SrcLen      Source buffer size.
+  @param[in]      Final       This is the last chunk of compressed data.
+
+  @retval RETURN_SUCCESS            Input is queued.
+  @retval RETURN_ALREADY_STARTED    Previous input is not consumed yet.
+  @retval RETURN_INVALID_PARAMETER  Input is too large or final chunk was already fed.
+**/
+RETURN_STATUS
+OcDecompressStreamFeed (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     CONST UINT8           *Src,
+  IN     UINT32                SrcLen,
+  IN     BOOLEAN               Final
+  );
+
+/**
+  Decompress up to DstLen bytes from the queued input.
+  Decompression may be stopped at any point and resumed later.
+
+  @param[in,out]  Stream      Decompression stream.
+  @param[out]     Dst         Destination buffer.
+  @param[in]      DstLen      Destination buffer size.
+  @param[out]     Produced    Decompressed size, may be non-zero with any status.
+
+  @retval RETURN_SUCCESS            DstLen bytes are decompressed.
+  @retval RETURN_NOT_READY          Input is consumed, more input is needed.
+  @retval RETURN_END_OF_FILE        Compressed stream end is reached.
+  @retval RETURN_VOLUME_CORRUPTED   Compressed stream is invalid or truncated.
+  @retval RETURN_INVALID_PARAMETER  Output is too large.
+**/
+RETURN_STATUS
+OcDecompressStreamDrain (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+     OUT UINT8                 *Dst,
+  IN     UINT32                DstLen,
+     OUT UINT32                *Produced
+  );
+
+/**
+  Decompress and discard up to Length bytes from the queued input.
+  Used to reach a range in the middle of decompressed data.
+
+  @param[in,out]  Stream      Decompression stream.
+  @param[in]      Length      Amount of bytes to skip.
+  @param[out]     Skipped     Skipped size, may be non-zero with any status.
+
+  @return  Same as OcDecompressStreamDrain.
+**/
+RETURN_STATUS
+OcDecompressStreamSkip (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     UINT32                Length,
+     OUT UINT32                *Skipped
+  );
+
+/**
+  Total amount of bytes decompressed since stream init or reset.
+
+  @param[in]  Stream      Decompression stream.
+
+  @return  Decompressed size.
+**/
+UINT64
+OcDecompressStreamOffset (
+  IN CONST OC_DECOMPRESS_STREAM  *Stream
+  );
+
+/**
+  Free decompression stream.
+
+  @param[in,out]  Stream      Decompression stream.
+**/
+VOID
+OcDecompressStreamFree (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream
+  );
+
 #endif // OC_COMPRESSION_LIB_H
@@ -56,6 +56,30 @@ OcConsoleControlConfigure (
   IN BOOLEAN                      ReplaceTabWithSpace
   );
 
+/**
+  Configure coalescing of console output. When enabled consecutive
+  OutputString calls are accumulated in a fixed-size staging buffer
+  and written at line ends, when the buffer is full, before attribute
+  or cursor changes, or on OcConsoleFlushOutput. Staged output is
+  discarded on ClearScreen, SetMode and Reset.
+
+  @param[in] Enable  Enable or disable coalescing, disabling flushes.
+**/
+VOID
+OcConsoleControlSetCoalescing (
+  IN BOOLEAN  Enable
+  );
+
+/**
+  Write any output staged by console control.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcConsoleFlushOutput (
+  VOID
+  );
+
 /**
   Configure console control behaviour.
 
@@ -98,6 +98,34 @@ ReadFile (
   IN  UINT32                           MaxFileSize OPTIONAL
   );
 
+/**
+  Open root directory of the volume through a per-volume cache.
+  Every directory is listed once, and file existence checks
+  and EFI_FILE_INFO queries are answered from these listings.
+  The cache is dropped on writes through cached handles, on media change,
+  and by OcFileCacheInvalidate. Writes through other handles are not tracked.
+
+  @param[in]   Device   Device handle with simple file system protocol.
+  @param[out]  Root     Root directory, to be closed with Root->Close.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcFileCacheOpenVolume (
+  IN  EFI_HANDLE         Device,
+  OUT EFI_FILE_PROTOCOL  **Root
+  );
+
+/**
+  Drop cached directory listings.
+
+  @param[in]  Device   Device handle to drop the cache of, or NULL for all.
+**/
+VOID
+OcFileCacheInvalidate (
+  IN EFI_HANDLE  Device  OPTIONAL
+  );
+
 /**
   Determine file size if it is less than 4 GB.
 
@@ -627,4 +627,15 @@ STATIC_ASSERT (sizeof (UINTN) == 4, "UINTN is expected to be 4 bytes");
 
 #endif // __GNUC__
 
+/**
+  Print queued UBSan reports followed by failure counts per source location.
+  Non-fatal reports are only queued when they happen, and this is done
+  automatically when the image is unloaded. Reports still queued at
+  ExitBootServices are dropped. Does nothing without UBSan support.
+**/
+VOID
+OcUbsanDumpReports (
+  VOID
+  );
+
 #endif // OC_GUARD_LIB_H
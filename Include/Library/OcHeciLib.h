@@ -19,6 +19,35 @@ HeciReadMessage (
   IN OUT  UINT32           *Length
   );
 
+/**
+  Read HECI message without blocking the protocol, polling it until
+  a message arrives or the timeout expires.
+
+  @param[out]    MessageBody  Message buffer.
+  @param[in,out] Length       Message buffer size on input,
+                              message size on output.
+  @param[in]     Timeout      Timeout in microseconds.
+
+  @retval EFI_SUCCESS   Message was read.
+  @retval EFI_TIMEOUT   No message arrived in time.
+**/
+EFI_STATUS
+HeciReadMessageWithTimeout (
+  IN      UINT32           *MessageBody,
+  IN OUT  UINT32           *Length,
+  IN      UINT32           Timeout
+  );
+
+/**
+  Set timeout for HECI response reads.
+
+  @param[in] Timeout  Timeout in microseconds.
+**/
+VOID
+HeciSetReadTimeout (
+  IN UINT32  Timeout
+  );
+
 EFI_STATUS
 HeciSendMessage (
   IN      UINT32           *Message,
@@ -37,6 +66,20 @@ HeciUpdateReceiveMsgStatus (
   VOID
   );
 
+/**
+  Allow the current ME client to send several responses without
+  waiting for a flow control message per response, so that multiple
+  requests may be in flight.
+
+  @param[in] Count  Number of outstanding responses to allow.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+HeciGrantReceiveCredits (
+  IN UINT8  Count
+  );
+
 EFI_STATUS
 HeciGetResponse (
   OUT VOID    *MessageData,
@@ -43,6 +43,37 @@ typedef struct {
   MACH_RELOCATION_INFO  *ExternRelocations;
 } OC_MACHO_CONTEXT;
 
+///
+/// C++ class metadata of a Mach-O, collected in a single symbol table pass.
+/// Names are not terminated and point into the Mach-O string table.
+///
+typedef struct {
+  ///
+  /// Mangled class name, e.g. 8OSObject.
+  ///
+  CONST CHAR8          *ClassName;
+  UINT32               ClassNameLength;
+  ///
+  /// Mangled super class name, resolved through SuperMetaClass.
+  ///
+  CONST CHAR8          *SuperClassName;
+  UINT32               SuperClassNameLength;
+  ///
+  /// Super Metaclass Pointer, only classes defining it need patching.
+  ///
+  CONST MACH_NLIST_64  *Smcp;
+  ///
+  /// Metaclass pointer referenced by Smcp.
+  ///
+  CONST MACH_NLIST_64  *SuperMetaClass;
+  ///
+  /// Locally defined VTable, Meta VTable and final class symbols.
+  ///
+  CONST MACH_NLIST_64  *Vtable;
+  CONST MACH_NLIST_64  *MetaVtable;
+  CONST MACH_NLIST_64  *FinalSymbol;
+} MACHO_CXX_CLASS;
+
 /**
   Initializes a Mach-O Context.
 
@@ -633,6 +664,47 @@ MachoGetVtableSymbolsFromSmcp64 (
   OUT    CONST MACH_NLIST_64  **MetaVtable
   );
 
+/**
+  Collects the C++ class metadata of a Mach-O into a table sorted for
+  MachoGetCxxClass.  This replaces per-class name synthesis and symbol
+  lookups with one pass over the symbol table.
+
+  @param[in,out] Context     Context of the Mach-O.
+  @param[in]     MaxClasses  Number of entries Classes can hold.  The number
+                             of symbols is always sufficient.
+  @param[out]    Classes     Output buffer for the class table.
+  @param[out]    NumClasses  Number of classes stored in Classes.
+
+  @returns  Whether the table has been built successfully.
+
+**/
+BOOLEAN
+MachoBuildCxxClassTable64 (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     UINT32            MaxClasses,
+  OUT    MACHO_CXX_CLASS   *Classes,
+  OUT    UINT32            *NumClasses
+  );
+
+/**
+  Retrieves a class from a table built by MachoBuildCxxClassTable64.
+
+  @param[in] Classes          The class table to search.
+  @param[in] NumClasses       Number of classes in Classes.
+  @param[in] ClassName        Mangled class name, need not be terminated.
+  @param[in] ClassNameLength  Length of ClassName.
+
+  @retval NULL  The class is not defined by the Mach-O.
+
+**/
+CONST MACHO_CXX_CLASS *
+MachoGetCxxClass (
+  IN CONST MACHO_CXX_CLASS  *Classes,
+  IN UINT32                 NumClasses,
+  IN CONST CHAR8            *ClassName,
+  IN UINT32                 ClassNameLength
+  );
+
 /**
   Returns whether the Relocation's type indicates a Pair for the Intel 64
   platform.
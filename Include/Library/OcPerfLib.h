@@ -0,0 +1,145 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_PERF_LIB_H
+#define OC_PERF_LIB_H
+
+#include <Protocol/OcPerf.h>
+#include <Protocol/SimpleFileSystem.h>
+
+/**
+  Number of records kept in the trace ring, older records are overwritten.
+**/
+#define OC_PERF_RECORD_MAX  1024U
+
+/**
+  Maximum exported trace size.
+**/
+#define OC_PERF_TRACE_MAX_SIZE \
+  (sizeof (OC_PERF_TRACE_HEADER) + OC_PERF_RECORD_MAX * sizeof (OC_PERF_RECORD))
+
+/**
+  Default variable name for trace export to NVRAM.
+**/
+#define OC_PERF_TRACE_VARIABLE_NAME  L"opencore-perf-trace"
+
+/**
+  Mark phase start.
+
+  @param[in] Phase  Phase identifier.
+**/
+VOID
+OcPerfBegin (
+  IN UINT16  Phase
+  );
+
+/**
+  Mark phase end.
+
+  @param[in] Phase   Phase identifier.
+  @param[in] Size    Processed size in bytes, 0 if not applicable.
+  @param[in] Status  Phase status.
+**/
+VOID
+OcPerfEnd (
+  IN UINT16      Phase,
+  IN UINT32      Size,
+  IN EFI_STATUS  Status
+  );
+
+/**
+  Add a record to the trace owned by this image.
+
+  @param[in] Phase   Phase identifier.
+  @param[in] Type    OC_PERF_RECORD_BEGIN or OC_PERF_RECORD_END.
+  @param[in] Size    Processed size in bytes.
+  @param[in] Status  Phase status.
+**/
+VOID
+OcPerfAddRecord (
+  IN UINT16      Phase,
+  IN UINT8       Type,
+  IN UINT32      Size,
+  IN EFI_STATUS  Status
+  );
+
+/**
+  Export the trace owned by this image into a buffer.
+  When the buffer cannot fit all the records, only the newest ones are exported.
+
+  @param[out]    Buffer      Trace buffer.
+  @param[in,out] BufferSize  Trace buffer size on input, exported size on output.
+
+  @retval EFI_SUCCESS           Trace is exported.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer cannot fit trace header.
+**/
+EFI_STATUS
+OcPerfExportTrace (
+     OUT VOID    *Buffer,
+  IN OUT UINT32  *BufferSize
+  );
+
+/**
+  Drop all records from the trace owned by this image.
+**/
+VOID
+OcPerfReset (
+  VOID
+  );
+
+/**
+  Install and initialise boot phase timing protocol.
+  When the protocol is already installed by another image, records
+  of this image are forwarded to it.
+
+  @param[in] Reinstall  Overwrite installed protocol.
+
+  @retval installed or located protocol.
+  @retval NULL  There was an error locating or installing the protocol.
+**/
+OC_PERF_PROTOCOL *
+OcPerfInstallProtocol (
+  IN BOOLEAN  Reinstall
+  );
+
+/**
+  Export the trace into a file.
+
+  @param[in] Root      Writable file system root, any will be tried if NULL.
+  @param[in] FileName  File name to write.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcPerfExportToFile (
+  IN EFI_FILE_PROTOCOL  *Root  OPTIONAL,
+  IN CONST CHAR16       *FileName
+  );
+
+/**
+  Export the newest trace records into a volatile NVRAM variable
+  under OpenCore vendor GUID.
+
+  @param[in] VariableName  Variable name.
+  @param[in] MaxSize       Maximum variable size.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcPerfExportToNvram (
+  IN CONST CHAR16  *VariableName,
+  IN UINT32        MaxSize
+  );
+
+#endif // OC_PERF_LIB_H
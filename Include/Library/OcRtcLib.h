@@ -49,4 +49,44 @@ OcRtcWriteIvy (
   IN UINT8 Value
   );
 
+//
+// Block interface, picks the fastest available ports and
+// splits transfers crossing the 0x80 bank boundary.
+//
+
+/**
+  Read a range of RTC memory.
+
+  @param[in]  Offset   Starting offset.
+  @param[in]  Size     Amount of bytes to read, Offset + Size must not exceed 0x100.
+  @param[out] Buffer   Buffer to read to.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcRtcReadBlock (
+  IN  UINT8  Offset,
+  IN  UINTN  Size,
+  OUT UINT8  *Buffer
+  );
+
+/**
+  Write a range of RTC memory.
+
+  @param[in]  Offset          Starting offset.
+  @param[in]  Size            Amount of bytes to write, Offset + Size must not exceed 0x100.
+  @param[in]  Buffer          Buffer to write from.
+  @param[in]  UpdateChecksum  Recalculate Apple checksums of the banks written to.
+                              Only valid on Apple firmware RTC layout.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+OcRtcWriteBlock (
+  IN UINT8        Offset,
+  IN UINTN        Size,
+  IN CONST UINT8  *Buffer,
+  IN BOOLEAN      UpdateChecksum
+  );
+
 #endif // OC_RTC_LIB_H
@@ -136,6 +136,27 @@ typedef enum OC_SMBIOS_UPDATE_MODE_ {
   OcSmbiosUpdateCustom       = 3,
 } OC_SMBIOS_UPDATE_MODE;
 
+//
+// Sparse SMBIOS update statistics.
+//
+typedef struct OC_SMBIOS_PATCH_STATS_ {
+  //
+  // Bytes and structures copied verbatim from the original table.
+  //
+  UINT32  CopiedSize;
+  UINT32  CopiedCount;
+  //
+  // Bytes and structures rebuilt due to overrides.
+  //
+  UINT32  RebuiltSize;
+  UINT32  RebuiltCount;
+  //
+  // Bytes and structures created anew.
+  //
+  UINT32  CreatedSize;
+  UINT32  CreatedCount;
+} OC_SMBIOS_PATCH_STATS;
+
 VOID
 SmbiosGetSmcVersion (
   IN  CONST UINT8  *SmcRevision,
@@ -149,4 +170,24 @@ CreateSmbios (
   IN OC_CPU_INFO            *CpuInfo
   );
 
+/**
+  Update SMBIOS keeping host structures and handles. Unlike CreateSmbios,
+  which regenerates every structure, only structures with overridden fields
+  are rebuilt, the rest is copied verbatim. Missing Apple structures are added.
+
+  @param[in]  Data     SMBIOS overrides.
+  @param[in]  Mode     SMBIOS update mode.
+  @param[in]  CpuInfo  CPU information.
+  @param[out] Stats    Update statistics, optional.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+PatchSmbios (
+  IN  OC_SMBIOS_DATA         *Data,
+  IN  OC_SMBIOS_UPDATE_MODE  Mode,
+  IN  OC_CPU_INFO            *CpuInfo,
+  OUT OC_SMBIOS_PATCH_STATS  *Stats  OPTIONAL
+  );
+
 #endif // OC_SMBIOS_LIB_H
@@ -31,4 +31,30 @@ OcSmcIoInstallProtocol (
   IN BOOLEAN  AuthRestart
   );
 
+/**
+  Register additional virtual SMC key or update an existing one.
+  Keys are kept sorted, so lookup cost stays logarithmic as more
+  keys are registered. Keys may be registered before or after
+  the protocol is installed.
+
+  @param[in] Key         SMC key.
+  @param[in] Type        SMC key type.
+  @param[in] Size        SMC key data size, up to SMC_MAX_DATA_SIZE.
+  @param[in] Attributes  SMC key attributes.
+  @param[in] Data        SMC key data of Size bytes, zeroes when NULL.
+
+  @retval EFI_SUCCESS            Key was registered.
+  @retval EFI_ACCESS_DENIED      Key is managed internally.
+  @retval EFI_INVALID_PARAMETER  Key data is too large.
+  @retval EFI_OUT_OF_RESOURCES   Key table could not grow.
+**/
+EFI_STATUS
+OcSmcIoRegisterKey (
+  IN SMC_KEY             Key,
+  IN SMC_KEY_TYPE        Type,
+  IN SMC_DATA_SIZE       Size,
+  IN SMC_KEY_ATTRIBUTES  Attributes,
+  IN CONST SMC_DATA      *Data  OPTIONAL
+  );
+
 #endif // OC_SMC_LIB_H
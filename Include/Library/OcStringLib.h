@@ -90,6 +90,68 @@ AsciiUint64ToLowerHex (
   IN  UINT64  Value
   );
 
+/**
+  Returns the length of a Null-terminated ASCII string.
+  Equivalent to AsciiStrLen, but uses vector instructions when available
+  and does not check PcdMaximumAsciiStringLength.
+
+  @param[in]  String  A pointer to a Null-terminated ASCII string.
+
+  @retval  String length in characters.
+**/
+UINTN
+OcAsciiStrLen (
+  IN CONST CHAR8  *String
+  );
+
+/**
+  Compares two Null-terminated ASCII strings.
+  Equivalent to AsciiStrCmp, but uses vector instructions when available
+  and does not check PcdMaximumAsciiStringLength.
+
+  @param[in]  FirstString   A pointer to a Null-terminated ASCII string.
+  @param[in]  SecondString  A pointer to a Null-terminated ASCII string.
+
+  @retval ==0    FirstString is identical to SecondString.
+  @retval !=0    FirstString is not identical to SecondString.
+**/
+INTN
+OcAsciiStrCmp (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  );
+
+/**
+  Returns the first occurrence of a Null-terminated ASCII sub-string
+  in a Null-terminated ASCII string.
+  Equivalent to AsciiStrStr, but uses vector instructions when available
+  and does not check PcdMaximumAsciiStringLength.
+
+  @param[in]  String        A pointer to a Null-terminated ASCII string.
+  @param[in]  SearchString  A pointer to a Null-terminated ASCII string to search for.
+
+  @retval  Pointer to the matched sub-string in String or NULL.
+**/
+CHAR8 *
+OcAsciiStrStr (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  );
+
+/**
+  Returns the length of a Null-terminated Unicode string.
+  Equivalent to StrLen, but uses vector instructions when available
+  and does not check PcdMaximumUnicodeStringLength.
+
+  @param[in]  String  A pointer to a Null-terminated Unicode string.
+
+  @retval  String length in characters.
+**/
+UINTN
+OcStrLen (
+  IN CONST CHAR16  *String
+  );
+
 /**
   Performs a case insensitive comparison of two Null-terminated Unicode strings,
   and returns the difference between the first mismatched Unicode characters.
@@ -17,8 +17,39 @@
 
 #include <Uefi.h>
 
+#include <Protocol/OcVirtualFile.h>
 #include <Protocol/SimpleFileSystem.h>
 
+/**
+  Fill a range of lazily backed virtual file.
+
+  @param[in]  Context   Source context.
+  @param[in]  Offset    Offset in the file, within file size.
+  @param[in]  Size      Amount of bytes to fill, within file size.
+  @param[out] Buffer    Buffer to fill.
+
+  @return  EFI_SUCCESS when Buffer was filled.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *OC_VIRTUAL_FILE_READ_RANGE) (
+  IN  VOID    *Context,
+  IN  UINT64  Offset,
+  IN  UINTN   Size,
+  OUT VOID    *Buffer
+  );
+
+/**
+  Release lazily backed virtual file source.
+
+  @param[in]  Context   Source context.
+**/
+typedef
+VOID
+(EFIAPI *OC_VIRTUAL_FILE_FREE_SOURCE) (
+  IN  VOID    *Context
+  );
+
 /**
   Creates read-only EFI_FILE_PROTOCOL instance over a buffer allocated
   from pool. On success FileName and FileData ownership is transferred
@@ -45,6 +76,71 @@ CreateVirtualFile (
   IN OUT EFI_FILE_PROTOCOL  **File
   );
 
+/**
+  Creates read-only EFI_FILE_PROTOCOL instance over a lazy source, which
+  fills requested ranges on demand (e.g. decompresses or patches them).
+  Reads go directly into caller buffers, so the file is never materialised
+  as a whole. On success FileName ownership is transferred to the resulting
+  EFI_FILE_PROTOCOL, which frees it with FreePool and calls FreeSource
+  upon closing EFI_FILE_PROTOCOL.
+
+  @param[in]      FileName         Pointer to the file's name.
+  @param[in]      FileSize         File size.
+  @param[in]      ReadRange        Range filling callback.
+  @param[in]      FreeSource       Source release callback, optional.
+  @param[in]      Context          Source context passed to callbacks.
+  @param[in]      ModificationTime File modification date, optional.
+  @param[in, out] File             Resulting file protocol.
+
+  @return  EFI_SUCCESS if instance was successfully created.
+**/
+EFI_STATUS
+CreateVirtualFileFromSource (
+  IN     CHAR16                       *FileName,
+  IN     UINT64                       FileSize,
+  IN     OC_VIRTUAL_FILE_READ_RANGE   ReadRange,
+  IN     OC_VIRTUAL_FILE_FREE_SOURCE  FreeSource OPTIONAL,
+  IN     VOID                         *Context,
+  IN     EFI_TIME                     *ModificationTime OPTIONAL,
+  IN OUT EFI_FILE_PROTOCOL            **File
+  );
+
+/**
+  Borrow a read-only pointer into the backing buffer of a virtual file
+  created with CreateVirtualFile. The pointer stays valid until the file
+  is closed. File position is not affected.
+
+  @param[in]      File     File protocol.
+  @param[in]      Offset   Offset in the file.
+  @param[in, out] Size     Requested size on input, size available
+                           at Buffer on output (may be smaller).
+  @param[out]     Buffer   Pointer to file data at Offset.
+
+  @retval EFI_SUCCESS            Buffer points to file data.
+  @retval EFI_UNSUPPORTED        File is not a memory-backed virtual file.
+  @retval EFI_INVALID_PARAMETER  Offset is beyond the end of the file.
+**/
+EFI_STATUS
+GetVirtualFileBuffer (
+  IN     EFI_FILE_PROTOCOL  *File,
+  IN     UINT64             Offset,
+  IN OUT UINTN              *Size,
+     OUT CONST VOID         **Buffer
+  );
+
+/**
+  Install and initialise virtual file extension protocol, which lets
+  other images borrow virtual file buffers.
+
+  @param[in] Reinstall  Overwrite installed protocol.
+
+  @retval installed or located protocol or NULL.
+**/
+OC_VIRTUAL_FILE_PROTOCOL *
+OcVirtualFileInstallProtocol (
+  IN BOOLEAN  Reinstall
+  );
+
 /**
   Creates virtual file system instance around any file.
   CreateRealFile or CreateVirtualFile must be called from
@@ -0,0 +1,166 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_PERF_PROTOCOL_H
+#define OC_PERF_PROTOCOL_H
+
+#include <Uefi.h>
+
+#define OC_PERF_PROTOCOL_REVISION  0x010000
+
+/**
+  OC_PERF_PROTOCOL_GUID
+  6C4E0E6E-7F7A-4D8B-9C3E-2B1D5A8F4C17
+**/
+#define OC_PERF_PROTOCOL_GUID               \
+  { 0x6C4E0E6E, 0x7F7A, 0x4D8B,             \
+    { 0x9C, 0x3E, 0x2B, 0x1D, 0x5A, 0x8F, 0x4C, 0x17 } }
+
+//
+// Boot phases recorded by OcSupportPkg libraries.
+// Values from OC_PERF_PHASE_CUSTOM onwards are free for consumers.
+//
+#define OC_PERF_PHASE_CONFIG_PARSE       0x0001U
+#define OC_PERF_PHASE_ACPI               0x0002U
+#define OC_PERF_PHASE_SMBIOS             0x0003U
+#define OC_PERF_PHASE_VAULT              0x0004U
+#define OC_PERF_PHASE_SCAN               0x0005U
+#define OC_PERF_PHASE_KERNEL_READ        0x0006U
+#define OC_PERF_PHASE_KERNEL_DECOMPRESS  0x0007U
+#define OC_PERF_PHASE_KEXT_LINK          0x0008U
+#define OC_PERF_PHASE_KEXT_INJECT        0x0009U
+#define OC_PERF_PHASE_CUSTOM             0x0100U
+
+//
+// Record types.
+//
+#define OC_PERF_RECORD_BEGIN  0x01U
+#define OC_PERF_RECORD_END    0x02U
+
+//
+// Record status, error bit is moved to bit 31.
+//
+#define OC_PERF_STATUS_ERROR  0x80000000U
+
+//
+// Trace signature, 'OCPF'.
+//
+#define OC_PERF_TRACE_SIGNATURE  SIGNATURE_32 ('O', 'C', 'P', 'F')
+#define OC_PERF_TRACE_VERSION    1
+
+#pragma pack(1)
+
+/**
+  Single trace record.
+**/
+typedef struct {
+  //
+  // Performance counter value.
+  //
+  UINT64  Timestamp;
+  //
+  // Optional processed size in bytes, only set for end records.
+  //
+  UINT32  Size;
+  //
+  // Truncated status, only set for end records.
+  //
+  UINT32  Status;
+  //
+  // Phase identifier.
+  //
+  UINT16  Phase;
+  //
+  // OC_PERF_RECORD_BEGIN or OC_PERF_RECORD_END.
+  //
+  UINT8   Type;
+  //
+  // Nesting depth at record time.
+  //
+  UINT8   Depth;
+} OC_PERF_RECORD;
+
+/**
+  Exported trace header followed by RecordCount records
+  in chronological order.
+**/
+typedef struct {
+  UINT32  Signature;
+  UINT16  Version;
+  UINT16  RecordSize;
+  //
+  // Performance counter frequency in Hz, 0 if unknown.
+  //
+  UINT64  Frequency;
+  UINT32  RecordCount;
+  //
+  // Number of older records overwritten or not exported.
+  //
+  UINT32  Dropped;
+} OC_PERF_TRACE_HEADER;
+
+#pragma pack()
+
+typedef struct OC_PERF_PROTOCOL_ OC_PERF_PROTOCOL;
+
+/**
+  Add a record to the trace.
+
+  @param[in] This    Protocol instance.
+  @param[in] Phase   Phase identifier.
+  @param[in] Type    OC_PERF_RECORD_BEGIN or OC_PERF_RECORD_END.
+  @param[in] Size    Processed size in bytes.
+  @param[in] Status  Phase status.
+**/
+typedef
+VOID
+(EFIAPI *OC_PERF_ADD_RECORD) (
+  IN OC_PERF_PROTOCOL  *This,
+  IN UINT16            Phase,
+  IN UINT8             Type,
+  IN UINT32            Size,
+  IN EFI_STATUS        Status
+  );
+
+/**
+  Export the trace into a buffer. When the buffer cannot fit all the
+  records, only the newest ones are exported.
+
+  @param[in]     This        Protocol instance.
+  @param[out]    Buffer      Trace buffer.
+  @param[in,out] BufferSize  Trace buffer size on input, exported size on output.
+
+  @retval EFI_SUCCESS           Trace is exported.
+  @retval EFI_BUFFER_TOO_SMALL  Buffer cannot fit trace header.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *OC_PERF_EXPORT_TRACE) (
+  IN     OC_PERF_PROTOCOL  *This,
+     OUT VOID              *Buffer,
+  IN OUT UINT32            *BufferSize
+  );
+
+/**
+  OpenCore boot phase timing protocol.
+**/
+struct OC_PERF_PROTOCOL_ {
+  UINTN                 Revision;
+  OC_PERF_ADD_RECORD    AddRecord;
+  OC_PERF_EXPORT_TRACE  ExportTrace;
+};
+
+extern EFI_GUID gOcPerfProtocolGuid;
+
+#endif // OC_PERF_PROTOCOL_H
@@ -0,0 +1,70 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_VIRTUAL_FILE_PROTOCOL_H
+#define OC_VIRTUAL_FILE_PROTOCOL_H
+
+#include <Uefi.h>
+
+#include <Protocol/SimpleFileSystem.h>
+
+#define OC_VIRTUAL_FILE_PROTOCOL_REVISION  0x010000
+
+/**
+  OC_VIRTUAL_FILE_PROTOCOL_GUID
+  9A2F5C57-3E1B-4F0C-8E1D-5D2B8C7E4A61
+**/
+#define OC_VIRTUAL_FILE_PROTOCOL_GUID       \
+  { 0x9A2F5C57, 0x3E1B, 0x4F0C,             \
+    { 0x8E, 0x1D, 0x5D, 0x2B, 0x8C, 0x7E, 0x4A, 0x61 } }
+
+typedef struct OC_VIRTUAL_FILE_PROTOCOL_ OC_VIRTUAL_FILE_PROTOCOL;
+
+/**
+  Borrow a read-only pointer into the backing buffer of a virtual file
+  without copying its contents. The pointer stays valid until the file
+  is closed. File position is not affected.
+
+  @param[in]      This     Protocol instance.
+  @param[in]      File     File protocol created by OcVirtualFsLib.
+  @param[in]      Offset   Offset in the file.
+  @param[in, out] Size     Requested size on input, size available
+                           at Buffer on output (may be smaller).
+  @param[out]     Buffer   Pointer to file data at Offset.
+
+  @retval EFI_SUCCESS            Buffer points to file data.
+  @retval EFI_UNSUPPORTED        File is not a memory-backed virtual file.
+  @retval EFI_INVALID_PARAMETER  Offset is beyond the end of the file.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *OC_VIRTUAL_FILE_GET_BUFFER) (
+  IN     OC_VIRTUAL_FILE_PROTOCOL  *This,
+  IN     EFI_FILE_PROTOCOL         *File,
+  IN     UINT64                    Offset,
+  IN OUT UINTN                     *Size,
+     OUT CONST VOID                **Buffer
+  );
+
+/**
+  OpenCore virtual file extension protocol.
+**/
+struct OC_VIRTUAL_FILE_PROTOCOL_ {
+  UINTN                       Revision;
+  OC_VIRTUAL_FILE_GET_BUFFER  GetBuffer;
+};
+
+extern EFI_GUID gOcVirtualFileProtocolGuid;
+
+#endif // OC_VIRTUAL_FILE_PROTOCOL_H
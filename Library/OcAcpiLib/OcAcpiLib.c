@@ -20,6 +20,7 @@
 #include <Library/UefiLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/OcMiscLib.h>
+#include <Library/OcPerfLib.h>
 
 #include <IndustryStandard/AcpiAml.h>
 #include <IndustryStandard/Acpi.h>
@@ -194,133 +195,553 @@ AcpiReadName (
   return TRUE;
 }
 
+//
+// OperationRegion found in a table.
+//
+typedef struct {
+  //
+  // Region name.
+  //
+  UINT32  Name;
+  //
+  // Offset of the region address in the table, it is either region
+  // argument or the value of the name passed as region argument.
+  // 0 when the address could not be resolved.
+  //
+  UINT32  AddressOffset;
+  //
+  // Region address size, sizeof (UINT16) or sizeof (UINT32).
+  //
+  UINT32  AddressSize;
+} OC_ACPI_REGION_SITE;
+
+//
+// First declaration of a name in a table.
+//
+typedef struct {
+  UINT32  Name;
+  //
+  // Offset of the name after AML_NAME_OP, 0 for free slots.
+  //
+  UINT32  Offset;
+} OC_ACPI_NAME_SLOT;
+
+/**
+  Hash 32-bit ACPI name or address.
+
+  @param Value       Value to hash.
+  @param Size        Hash table size, power of two.
+
+  @return slot index.
+**/
+STATIC
+UINT32
+AcpiHashValue (
+  IN UINT32  Value,
+  IN UINT32  Size
+  )
+{
+  return ((Value * 0x9E3779B1U) >> 16U) & (Size - 1);
+}
+
 /**
-  Find ACPI name declaration in data.
+  Read ACPI name as 32-bit value.
 
-  @param Data        ACPI table data.
-  @param Length      ACPI table data length.
   @param Name        ACPI name of at least OC_ACPI_NAME_SIZE bytes.
 
-  @return offset > 0 for valid names.
+  @return name value.
 **/
 STATIC
 UINT32
-AcpiFindName (
-  IN CONST UINT8  *Data,
-  IN UINT32       Length,
+AcpiNameValue (
   IN CONST CHAR8  *Name
   )
 {
-  UINT32  Index;
+  UINT32  Value;
 
-  //
-  // Lookup from offset 1 and after.
-  //
-  if (Length < OC_ACPI_NAME_SIZE + 1) {
+  CopyMem (&Value, Name, sizeof (Value));
+  return Value;
+}
+
+/**
+  Insert first declaration of a name into name table.
+
+  @param Slots       Name table.
+  @param Size        Name table size, power of two.
+  @param Name        Name value.
+  @param Offset      Name offset.
+
+  @return TRUE if the name was not present yet.
+**/
+STATIC
+BOOLEAN
+AcpiInsertNameSlot (
+  IN OUT OC_ACPI_NAME_SLOT  *Slots,
+  IN     UINT32             Size,
+  IN     UINT32             Name,
+  IN     UINT32             Offset
+  )
+{
+  UINT32  Slot;
+
+  Slot = AcpiHashValue (Name, Size);
+  while (Slots[Slot].Offset != 0) {
+    if (Slots[Slot].Name == Name) {
+      return FALSE;
+    }
+    Slot = (Slot + 1) & (Size - 1);
+  }
+
+  Slots[Slot].Name   = Name;
+  Slots[Slot].Offset = Offset;
+  return TRUE;
+}
+
+/**
+  Find first declaration of a name in name table.
+
+  @param Slots       Name table.
+  @param Size        Name table size, power of two.
+  @param Name        Name value.
+
+  @return offset > 0 for found names.
+**/
+STATIC
+UINT32
+AcpiFindNameSlot (
+  IN CONST OC_ACPI_NAME_SLOT  *Slots,
+  IN UINT32                   Size,
+  IN UINT32                   Name
+  )
+{
+  UINT32  Slot;
+
+  if (Slots == NULL) {
     return 0;
   }
 
-  for (Index = 0; Index < Length - OC_ACPI_NAME_SIZE; ++Index) {
-    if (Data[Index] == AML_NAME_OP
-      && Data[Index+1] == Name[0]
-      && Data[Index+2] == Name[1]
-      && Data[Index+3] == Name[2]
-      && Data[Index+4] == Name[3]) {
-      return Index+1;
+  Slot = AcpiHashValue (Name, Size);
+  while (Slots[Slot].Offset != 0) {
+    if (Slots[Slot].Name == Name) {
+      return Slots[Slot].Offset;
     }
+    Slot = (Slot + 1) & (Size - 1);
   }
 
   return 0;
 }
 
 /**
-  Load ACPI table regions.
+  Ensure there is room for one more entry in a table growing twice.
 
-  @param Context      ACPI library context.
-  @param Table        ACPI table.
+  @param Table       Table pointer.
+  @param Count       Number of used entries.
+  @param Allocated   Number of allocated entries, updated on growth.
+  @param EntrySize   Size of one entry.
 
   @return EFI_SUCCESS unless memory allocation failure.
 **/
 STATIC
 EFI_STATUS
-AcpiLoadTableRegions (
-  IN OUT OC_ACPI_CONTEXT         *Context,
-  IN     EFI_ACPI_COMMON_HEADER  *Table
+AcpiReserveEntry (
+  IN OUT VOID    **Table,
+  IN     UINT32  Count,
+  IN OUT UINT32  *Allocated,
+  IN     UINTN   EntrySize
+  )
+{
+  VOID    *NewTable;
+  UINT32  NewAllocated;
+
+  if (Count < *Allocated) {
+    return EFI_SUCCESS;
+  }
+
+  NewAllocated = *Allocated > 0 ? *Allocated * 2 : 8;
+  NewTable     = AllocatePool (NewAllocated * EntrySize);
+  if (NewTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (*Table != NULL) {
+    CopyMem (NewTable, *Table, Count * EntrySize);
+    FreePool (*Table);
+  }
+
+  *Table     = NewTable;
+  *Allocated = NewAllocated;
+  return EFI_SUCCESS;
+}
+
+/**
+  Collect SystemMemory OperationRegions of an ACPI table in a single pass.
+  Names declared in the table are recorded in the same pass, so that regions
+  with named addresses are resolved without rescanning the table.
+
+  @param Buffer      ACPI table data.
+  @param BufferLen   ACPI table data length.
+  @param Sites       Collected regions, to be freed by the caller.
+  @param NumSites    Number of collected regions.
+
+  @return EFI_SUCCESS unless memory allocation failure.
+**/
+STATIC
+EFI_STATUS
+AcpiCollectTableRegions (
+  IN  CONST UINT8          *Buffer,
+  IN  UINT32               BufferLen,
+  OUT OC_ACPI_REGION_SITE  **Sites,
+  OUT UINT32               *NumSites
   )
 {
-  UINT32          Index;
-  UINT32          Index2;
-  UINT32          NameOffset;
-  UINT8           *Buffer;
-  UINT32          BufferLen;
-  CHAR8           Name[OC_ACPI_NAME_SIZE+1];
-  CHAR8           NameAddr[OC_ACPI_NAME_SIZE+1];
-  OC_ACPI_REGION  *NewRegions;
-  UINT32          Address;
-
-  Buffer    = (UINT8 *) Table;
-  BufferLen = Table->Length;
+  EFI_STATUS           Status;
+  UINT32               Index;
+  UINT32               NameOffset;
+  UINT32               ArgOffset;
+  UINT32               Offset;
+  CHAR8                Name[OC_ACPI_NAME_SIZE+1];
+  CHAR8                NameAddr[OC_ACPI_NAME_SIZE+1];
+  OC_ACPI_REGION_SITE  *RegionSites;
+  UINT32               NumRegionSites;
+  UINT32               AllocatedRegionSites;
+  OC_ACPI_NAME_SLOT    *Names;
+  OC_ACPI_NAME_SLOT    *NewNames;
+  UINT32               NumNames;
+  UINT32               AllocatedNames;
+
+  *Sites    = NULL;
+  *NumSites = 0;
 
   if (BufferLen < sizeof (EFI_ACPI_DESCRIPTION_HEADER)) {
     return EFI_SUCCESS;
   }
 
-  for (Index = sizeof (EFI_ACPI_DESCRIPTION_HEADER); Index < BufferLen - 0xF; ++Index) {
-    if (Buffer[Index] == AML_EXT_OP
+  RegionSites          = NULL;
+  NumRegionSites       = 0;
+  AllocatedRegionSites = 0;
+  Names                = NULL;
+  NumNames             = 0;
+  AllocatedNames       = 0;
+  Status               = EFI_SUCCESS;
+
+  for (Index = sizeof (EFI_ACPI_DESCRIPTION_HEADER); Index < BufferLen - OC_ACPI_NAME_SIZE; ++Index) {
+    //
+    // Remember first declaration of every name, named region addresses
+    // resolve to it.
+    //
+    if (Buffer[Index] == AML_NAME_OP
+      && Buffer[Index+1] != '\\'
+      && AcpiReadName (&Buffer[Index+1], &Name[0], NULL)) {
+      if (NumNames * 2 >= AllocatedNames) {
+        AllocatedNames = AllocatedNames > 0 ? AllocatedNames * 2 : 64;
+        NewNames = AllocateZeroPool (AllocatedNames * sizeof (Names[0]));
+        if (NewNames == NULL) {
+          Status = EFI_OUT_OF_RESOURCES;
+          break;
+        }
+
+        for (Offset = 0; Names != NULL && Offset < AllocatedNames / 2; ++Offset) {
+          if (Names[Offset].Offset != 0) {
+            AcpiInsertNameSlot (NewNames, AllocatedNames, Names[Offset].Name, Names[Offset].Offset);
+          }
+        }
+
+        if (Names != NULL) {
+          FreePool (Names);
+        }
+        Names = NewNames;
+      }
+
+      if (AcpiInsertNameSlot (Names, AllocatedNames, AcpiNameValue (Name), Index+1)) {
+        ++NumNames;
+      }
+    }
+
+    if (Index < BufferLen - 0xF
+      && Buffer[Index] == AML_EXT_OP
       && Buffer[Index+1] == AML_EXT_REGION_OP
       && AcpiReadName (&Buffer[Index+2], &Name[0], &NameOffset)
       && Buffer[Index+OC_ACPI_NAME_SIZE+2+NameOffset] == EFI_ACPI_6_2_SYSTEM_MEMORY) {
-      //
-      // This is SystemMemory region. Try to save it.
-      //
-      Address = 0;
-      if (Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset] == AML_DWORD_PREFIX) {
-        CopyMem (&Address, &Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], sizeof (UINT32));
-      } else if (Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset] == AML_WORD_PREFIX) {
-        CopyMem (&Address, &Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], sizeof (UINT16));
-      } else if (AcpiReadName (&Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset], &NameAddr[0], NULL)) {
-        Index2 = AcpiFindName (Buffer, BufferLen, &NameAddr[0]);
-        if (Index2 > 0 && Index2 < BufferLen - 0xF) {
-          if (Buffer[Index2+OC_ACPI_NAME_SIZE] == AML_DWORD_PREFIX) {
-            CopyMem (&Address, &Buffer[Index2+OC_ACPI_NAME_SIZE+1], sizeof (UINT32));
-          } else if (Buffer[Index2+OC_ACPI_NAME_SIZE] == AML_WORD_PREFIX) {
-            CopyMem (&Address, &Buffer[Index2+OC_ACPI_NAME_SIZE+1], sizeof (UINT16));
-          }
-        }
+      Status = AcpiReserveEntry (
+        (VOID **) &RegionSites,
+        NumRegionSites,
+        &AllocatedRegionSites,
+        sizeof (RegionSites[0])
+        );
+      if (EFI_ERROR (Status)) {
+        break;
       }
 
-      for (Index2 = 0; Index2 < Context->NumberOfRegions; ++Index2) {
-        if (Context->Regions[Index2].Address == Address) {
-          Address = 0;
-          break;
-        }
+      ArgOffset = Index+OC_ACPI_NAME_SIZE+3+NameOffset;
+      RegionSites[NumRegionSites].Name          = AcpiNameValue (Name);
+      RegionSites[NumRegionSites].AddressOffset = 0;
+      RegionSites[NumRegionSites].AddressSize   = 0;
+
+      if (Buffer[ArgOffset] == AML_DWORD_PREFIX) {
+        RegionSites[NumRegionSites].AddressOffset = ArgOffset + 1;
+        RegionSites[NumRegionSites].AddressSize   = sizeof (UINT32);
+      } else if (Buffer[ArgOffset] == AML_WORD_PREFIX) {
+        RegionSites[NumRegionSites].AddressOffset = ArgOffset + 1;
+        RegionSites[NumRegionSites].AddressSize   = sizeof (UINT16);
+      } else if (AcpiReadName (&Buffer[ArgOffset], &NameAddr[0], NULL)) {
+        //
+        // Resolved once the whole table is walked, store name in the offset.
+        //
+        RegionSites[NumRegionSites].AddressOffset = AcpiNameValue (NameAddr);
       }
 
-      if (Address != 0) {
-        if (Context->AllocatedRegions == Context->NumberOfRegions) {
-          NewRegions = AllocatePool ((Context->AllocatedRegions + 2) * sizeof (Context->Regions[0]));
-          if (NewRegions == NULL) {
-            DEBUG ((DEBUG_WARN, "OCA: Failed to allocate memory for %u regions\n", Context->AllocatedRegions+2));
-            return EFI_OUT_OF_RESOURCES;
-          }
-          CopyMem (NewRegions, Context->Regions, Context->NumberOfRegions * sizeof (Context->Regions[0]));
-          FreePool (Context->Regions);
+      ++NumRegionSites;
+    }
+  }
 
-          Context->Regions = NewRegions;
-          Context->AllocatedRegions += 2;
-        }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "OCA: Failed to allocate memory for region lookup\n"));
+    if (Names != NULL) {
+      FreePool (Names);
+    }
+    if (RegionSites != NULL) {
+      FreePool (RegionSites);
+    }
+    return Status;
+  }
+
+  //
+  // Resolve named addresses to their first declaration.
+  //
+  for (Index = 0; Index < NumRegionSites; ++Index) {
+    if (RegionSites[Index].AddressSize != 0 || RegionSites[Index].AddressOffset == 0) {
+      continue;
+    }
+
+    Offset = AcpiFindNameSlot (Names, AllocatedNames, RegionSites[Index].AddressOffset);
+    RegionSites[Index].AddressOffset = 0;
 
-        DEBUG ((DEBUG_INFO, "OCA: Found OperationRegion %a at %08X\n", Name, Address));
-        Context->Regions[Context->NumberOfRegions].Address = Address;
-        CopyMem (&Context->Regions[Context->NumberOfRegions].Name[0], &Name[0], sizeof (Name));
-        ++Context->NumberOfRegions;
+    if (Offset > 0 && Offset < BufferLen - 0xF) {
+      if (Buffer[Offset+OC_ACPI_NAME_SIZE] == AML_DWORD_PREFIX) {
+        RegionSites[Index].AddressOffset = Offset+OC_ACPI_NAME_SIZE+1;
+        RegionSites[Index].AddressSize   = sizeof (UINT32);
+      } else if (Buffer[Offset+OC_ACPI_NAME_SIZE] == AML_WORD_PREFIX) {
+        RegionSites[Index].AddressOffset = Offset+OC_ACPI_NAME_SIZE+1;
+        RegionSites[Index].AddressSize   = sizeof (UINT16);
       }
     }
   }
 
+  if (Names != NULL) {
+    FreePool (Names);
+  }
+
+  *Sites    = RegionSites;
+  *NumSites = NumRegionSites;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find region slot in region hash.
+
+  @param Hash        Region hash.
+  @param Size        Region hash size, power of two.
+  @param Value       Region address or name value.
+  @param Regions     Context regions.
+  @param ByName      Compare names instead of addresses.
+
+  @return slot index, either holding matching region or free.
+**/
+STATIC
+UINT32
+AcpiFindRegionSlot (
+  IN CONST UINT32          *Hash,
+  IN UINT32                Size,
+  IN UINT32                Value,
+  IN CONST OC_ACPI_REGION  *Regions,
+  IN BOOLEAN               ByName
+  )
+{
+  UINT32  Slot;
+
+  Slot = AcpiHashValue (Value, Size);
+  while (Hash[Slot] != MAX_UINT32) {
+    if (ByName
+      ? AcpiNameValue (Regions[Hash[Slot]].Name) == Value
+      : Regions[Hash[Slot]].Address == Value) {
+      break;
+    }
+    Slot = (Slot + 1) & (Size - 1);
+  }
+
+  return Slot;
+}
+
+/**
+  Grow region storage twice and rebuild region hashes.
+
+  @param Context      ACPI library context.
+
+  @return EFI_SUCCESS unless memory allocation failure.
+**/
+STATIC
+EFI_STATUS
+AcpiGrowRegions (
+  IN OUT OC_ACPI_CONTEXT  *Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Allocated;
+  UINT32      *ByAddress;
+  UINT32      *ByName;
+  UINT32      Index;
+  UINT32      Slot;
+
+  Allocated = Context->AllocatedRegions;
+  Status = AcpiReserveEntry (
+    (VOID **) &Context->Regions,
+    Context->NumberOfRegions,
+    &Allocated,
+    sizeof (Context->Regions[0])
+    );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "OCA: Failed to allocate memory for %u regions\n", Allocated * 2));
+    return Status;
+  }
+
+  if (Allocated == Context->AllocatedRegions && Context->RegionsByAddress != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  ByAddress = AllocatePool (Allocated * 2 * sizeof (UINT32));
+  ByName    = AllocatePool (Allocated * 2 * sizeof (UINT32));
+  if (ByAddress == NULL || ByName == NULL) {
+    DEBUG ((DEBUG_WARN, "OCA: Failed to allocate memory for %u region slots\n", Allocated * 2));
+    if (ByAddress != NULL) {
+      FreePool (ByAddress);
+    }
+    if (ByName != NULL) {
+      FreePool (ByName);
+    }
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SetMem32 (ByAddress, Allocated * 2 * sizeof (UINT32), MAX_UINT32);
+  SetMem32 (ByName, Allocated * 2 * sizeof (UINT32), MAX_UINT32);
+
+  for (Index = 0; Index < Context->NumberOfRegions; ++Index) {
+    Slot = AcpiFindRegionSlot (ByAddress, Allocated * 2, Context->Regions[Index].Address, Context->Regions, FALSE);
+    ByAddress[Slot] = Index;
+    Slot = AcpiFindRegionSlot (ByName, Allocated * 2, AcpiNameValue (Context->Regions[Index].Name), Context->Regions, TRUE);
+    if (ByName[Slot] == MAX_UINT32) {
+      ByName[Slot] = Index;
+    }
+  }
+
+  if (Context->RegionsByAddress != NULL) {
+    FreePool (Context->RegionsByAddress);
+  }
+  if (Context->RegionsByName != NULL) {
+    FreePool (Context->RegionsByName);
+  }
+
+  Context->RegionsByAddress = ByAddress;
+  Context->RegionsByName    = ByName;
+  Context->AllocatedRegions = Allocated;
   return EFI_SUCCESS;
 }
 
+/**
+  Load ACPI table regions.
+
+  @param Context      ACPI library context.
+  @param Table        ACPI table.
+
+  @return EFI_SUCCESS unless memory allocation failure.
+**/
+STATIC
+EFI_STATUS
+AcpiLoadTableRegions (
+  IN OUT OC_ACPI_CONTEXT         *Context,
+  IN     EFI_ACPI_COMMON_HEADER  *Table
+  )
+{
+  EFI_STATUS           Status;
+  UINT8                *Buffer;
+  OC_ACPI_REGION_SITE  *Sites;
+  UINT32               NumSites;
+  UINT32               Index;
+  UINT32               Slot;
+  UINT32               Address;
+
+  Buffer = (UINT8 *) Table;
+
+  Status = AcpiCollectTableRegions (Buffer, Table->Length, &Sites, &NumSites);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < NumSites; ++Index) {
+    //
+    // This is SystemMemory region. Try to save it.
+    //
+    Address = 0;
+    if (Sites[Index].AddressSize != 0) {
+      CopyMem (&Address, &Buffer[Sites[Index].AddressOffset], Sites[Index].AddressSize);
+    }
+
+    if (Address == 0) {
+      continue;
+    }
+
+    Slot = AcpiFindRegionSlot (
+      Context->RegionsByAddress,
+      Context->AllocatedRegions * 2,
+      Address,
+      Context->Regions,
+      FALSE
+      );
+    if (Context->RegionsByAddress[Slot] != MAX_UINT32) {
+      continue;
+    }
+
+    if (Context->AllocatedRegions == Context->NumberOfRegions) {
+      Status = AcpiGrowRegions (Context);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Slot = AcpiFindRegionSlot (
+        Context->RegionsByAddress,
+        Context->AllocatedRegions * 2,
+        Address,
+        Context->Regions,
+        FALSE
+        );
+    }
+
+    Context->Regions[Context->NumberOfRegions].Address = Address;
+    CopyMem (&Context->Regions[Context->NumberOfRegions].Name[0], &Sites[Index].Name, OC_ACPI_NAME_SIZE);
+    Context->Regions[Context->NumberOfRegions].Name[OC_ACPI_NAME_SIZE] = '\0';
+    DEBUG ((DEBUG_INFO, "OCA: Found OperationRegion %a at %08X\n", Context->Regions[Context->NumberOfRegions].Name, Address));
+
+    Context->RegionsByAddress[Slot] = Context->NumberOfRegions;
+    Slot = AcpiFindRegionSlot (
+      Context->RegionsByName,
+      Context->AllocatedRegions * 2,
+      Sites[Index].Name,
+      Context->Regions,
+      TRUE
+      );
+    if (Context->RegionsByName[Slot] == MAX_UINT32) {
+      Context->RegionsByName[Slot] = Context->NumberOfRegions;
+    }
+
+    ++Context->NumberOfRegions;
+  }
+
+  if (Sites != NULL) {
+    FreePool (Sites);
+  }
+
+  return Status;
+}
+
 /**
   Relocate ACPI table regions.
 
@@ -334,75 +755,60 @@ AcpiRelocateTableRegions (
   IN     EFI_ACPI_COMMON_HEADER  *Table
   )
 {
-  UINT32          Index;
-  UINT32          Index2;
-  UINT32          RegionIndex;
-  UINT32          NameOffset;
-  UINT8           *Buffer;
-  UINT32          BufferLen;
-  CHAR8           Name[OC_ACPI_NAME_SIZE+1];
-  CHAR8           NameAddr[OC_ACPI_NAME_SIZE+1];
-  UINT32          OldAddress;
-  BOOLEAN         Modified;
-
-  Buffer    = (UINT8 *) Table;
-  BufferLen = Table->Length;
-  Modified  = FALSE;
+  EFI_STATUS           Status;
+  UINT8                *Buffer;
+  OC_ACPI_REGION_SITE  *Sites;
+  UINT32               NumSites;
+  UINT32               Index;
+  UINT32               RegionIndex;
+  UINT32               OldAddress;
+  BOOLEAN              Modified;
+
+  Buffer   = (UINT8 *) Table;
+  Modified = FALSE;
 
-  if (BufferLen < sizeof (EFI_ACPI_DESCRIPTION_HEADER)) {
+  Status = AcpiCollectTableRegions (Buffer, Table->Length, &Sites, &NumSites);
+  if (EFI_ERROR (Status)) {
     return;
   }
 
-  for (Index = sizeof (EFI_ACPI_DESCRIPTION_HEADER); Index < BufferLen - 0xF; ++Index) {
-    if (Buffer[Index] == AML_EXT_OP
-      && Buffer[Index+1] == AML_EXT_REGION_OP
-      && AcpiReadName (&Buffer[Index+2], &Name[0], &NameOffset)
-      && Buffer[Index+OC_ACPI_NAME_SIZE+2+NameOffset] == EFI_ACPI_6_2_SYSTEM_MEMORY) {
-      //
-      // This is region. Compare to current BIOS tables and relocate.
-      //
-      for (RegionIndex = 0; RegionIndex < Context->NumberOfRegions; ++RegionIndex) {
-        if (AsciiStrCmp (Context->Regions[RegionIndex].Name, Name) == 0) {
-          OldAddress = 0;
-          if (Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset] == AML_DWORD_PREFIX) {
-            CopyMem (&OldAddress, &Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], sizeof (UINT32));
-            CopyMem (&Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], &Context->Regions[RegionIndex].Address, sizeof (UINT32));
-            Modified = TRUE;
-          } else if (Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset] == AML_WORD_PREFIX) {
-            CopyMem (&OldAddress, &Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], sizeof (UINT16));
-            CopyMem (&Buffer[Index+OC_ACPI_NAME_SIZE+4+NameOffset], &Context->Regions[RegionIndex].Address, sizeof (UINT16));
-            Modified = TRUE;
-          } else if (AcpiReadName (&Buffer[Index+OC_ACPI_NAME_SIZE+3+NameOffset], &NameAddr[0], NULL)) {
-            Index2 = AcpiFindName (Buffer, BufferLen, &NameAddr[0]);
-            if (Index2 > 0 && Index2 < BufferLen - 0xF) {
-              if (Buffer[Index2+OC_ACPI_NAME_SIZE] == AML_DWORD_PREFIX) {
-                CopyMem (&OldAddress, &Buffer[Index2+OC_ACPI_NAME_SIZE+1], sizeof (UINT32));
-                CopyMem (&Buffer[Index2+OC_ACPI_NAME_SIZE+1], &Context->Regions[RegionIndex].Address, sizeof (UINT32));
-                Modified = TRUE;
-              } else if (Buffer[Index2+OC_ACPI_NAME_SIZE] == AML_WORD_PREFIX) {
-                CopyMem (&OldAddress, &Buffer[Index2+OC_ACPI_NAME_SIZE+1], sizeof (UINT16));
-                CopyMem (&Buffer[Index2+OC_ACPI_NAME_SIZE+1], &Context->Regions[RegionIndex].Address, sizeof (UINT16));
-                Modified = TRUE;
-              }
-            }
-          }
+  for (Index = 0; Index < NumSites; ++Index) {
+    //
+    // This is region. Compare to current BIOS tables and relocate.
+    //
+    RegionIndex = Context->RegionsByName[
+      AcpiFindRegionSlot (
+        Context->RegionsByName,
+        Context->AllocatedRegions * 2,
+        Sites[Index].Name,
+        Context->Regions,
+        TRUE
+        )
+      ];
+    if (RegionIndex == MAX_UINT32 || Sites[Index].AddressSize == 0) {
+      continue;
+    }
 
-          if (Modified && OldAddress != Context->Regions[RegionIndex].Address) {
-            DEBUG ((
-              DEBUG_INFO,
-              "OCA: Region %a address relocated from %08X to %08X\n",
-              Context->Regions[RegionIndex].Name,
-              OldAddress,
-              Context->Regions[RegionIndex].Address
-              ));
-          }
+    OldAddress = 0;
+    CopyMem (&OldAddress, &Buffer[Sites[Index].AddressOffset], Sites[Index].AddressSize);
+    CopyMem (&Buffer[Sites[Index].AddressOffset], &Context->Regions[RegionIndex].Address, Sites[Index].AddressSize);
+    Modified = TRUE;
 
-          break;
-        }
-      }
+    if (OldAddress != Context->Regions[RegionIndex].Address) {
+      DEBUG ((
+        DEBUG_INFO,
+        "OCA: Region %a address relocated from %08X to %08X\n",
+        Context->Regions[RegionIndex].Name,
+        OldAddress,
+        Context->Regions[RegionIndex].Address
+        ));
     }
   }
 
+  if (Sites != NULL) {
+    FreePool (Sites);
+  }
+
   //
   // Update checksum
   //
@@ -604,10 +1010,21 @@ AcpiFreeContext (
     FreePool (Context->Regions);
     Context->Regions = NULL;
   }
+
+  if (Context->RegionsByAddress != NULL) {
+    FreePool (Context->RegionsByAddress);
+    Context->RegionsByAddress = NULL;
+  }
+
+  if (Context->RegionsByName != NULL) {
+    FreePool (Context->RegionsByName);
+    Context->RegionsByName = NULL;
+  }
 }
 
+STATIC
 EFI_STATUS
-AcpiApplyContext (
+InternalAcpiApplyContext (
   IN OUT OC_ACPI_CONTEXT  *Context
   )
 {
@@ -702,6 +1119,20 @@ AcpiApplyContext (
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+AcpiApplyContext (
+  IN OUT OC_ACPI_CONTEXT  *Context
+  )
+{
+  EFI_STATUS  Status;
+
+  OcPerfBegin (OC_PERF_PHASE_ACPI);
+  Status = InternalAcpiApplyContext (Context);
+  OcPerfEnd (OC_PERF_PHASE_ACPI, Context->NumberOfTables, Status);
+
+  return Status;
+}
+
 EFI_STATUS
 AcpiDropTable (
   IN OUT OC_ACPI_CONTEXT  *Context,
@@ -1022,15 +1453,13 @@ AcpiLoadRegions (
   ASSERT (Context->Regions == NULL);
 
   //
-  // Allocate something reasonably large by default.
+  // Allocate something reasonably large by default, this grows twice.
   //
   Context->NumberOfRegions  = 0;
-  Context->AllocatedRegions = 8;
-  Context->Regions = AllocatePool (sizeof (Context->Regions[0]) * Context->AllocatedRegions);
-
-  if (Context->Regions == NULL) {
-    DEBUG ((DEBUG_WARN, "OCA: Failed to allocate memory for %u regions\n", Context->NumberOfRegions));
-    return EFI_OUT_OF_RESOURCES;
+  Context->AllocatedRegions = 0;
+  Status = AcpiGrowRegions (Context);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
   if (Context->Dsdt != NULL) {
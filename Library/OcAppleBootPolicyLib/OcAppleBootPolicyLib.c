@@ -886,23 +886,12 @@ BootPolicyGetBootFile (
 {
   EFI_STATUS                      Status;
 
-  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
   EFI_FILE_PROTOCOL               *Root;
 
   *FilePath = NULL;
   Root = NULL;
 
-  Status = gBS->HandleProtocol (
-                  Device,
-                  &gEfiSimpleFileSystemProtocolGuid,
-                  (VOID **) &FileSystem
-                  );
-
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  Status = OcFileCacheOpenVolume (Device, &Root);
 
   if (EFI_ERROR (Status)) {
     return Status;
@@ -939,7 +928,6 @@ BootPolicyGetBootFileEx (
   EFI_STATUS                      Status;
   EFI_STATUS                      TmpStatus;
 
-  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *FileSystem;
   EFI_FILE_PROTOCOL               *Root;
   APPLE_APFS_CONTAINER_INFO       *ContainerInfo;
   APPLE_APFS_VOLUME_INFO          *VolumeInfo;
@@ -947,17 +935,7 @@ BootPolicyGetBootFileEx (
   *FilePath = NULL;
   Root = NULL;
 
-  Status = gBS->HandleProtocol (
-                  Device,
-                  &gEfiSimpleFileSystemProtocolGuid,
-                  (VOID **) &FileSystem
-                  );
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_BULK_INFO, "OCBP: Missing filesystem - %r\n", Status));
-    return Status;
-  }
-
-  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  Status = OcFileCacheOpenVolume (Device, &Root);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_BULK_INFO, "OCBP: Invalid root volume - %r\n", Status));
     return Status;
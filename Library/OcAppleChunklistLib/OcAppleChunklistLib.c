@@ -192,3 +192,121 @@ OcAppleChunklistVerifyData (
   FreePool (ChunkData);
   return TRUE;
 }
+
+BOOLEAN
+OcAppleChunklistLoadFile (
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT         *Context,
+  IN     CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
+  IN     EFI_FILE_PROTOCOL                  *File,
+  IN     UINTN                              FileSize
+  )
+{
+  EFI_STATUS                  Status;
+  UINTN                       Index;
+  UINT64                      ChunkTotalSize;
+  UINT8                       ChunkHash[SHA256_DIGEST_SIZE];
+  SHA256_CONTEXT              ChunkContext;
+  CONST APPLE_CHUNKLIST_CHUNK *CurrentChunk;
+  UINT32                      ChunkRemaining;
+
+  UINT32                      ExtentIndex;
+  UINT8                       *ExtentData;
+  UINTN                       ExtentSize;
+  UINTN                       RequestedSize;
+  UINTN                       ReadSize;
+  UINTN                       HashSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (Context->Chunks != NULL);
+  ASSERT (ExtentTable != NULL);
+  ASSERT (File != NULL);
+  ASSERT (FileSize > 0);
+
+  DEBUG_CODE (
+    ASSERT (Context->Signature == NULL);
+    );
+
+  //
+  // Chunks past the end of the file would never be verified, and empty chunks
+  // have nothing to be hashed as the data is read.
+  //
+  ChunkTotalSize = 0;
+  for (Index = 0; Index < Context->ChunkCount; ++Index) {
+    if (Context->Chunks[Index].Length == 0) {
+      return FALSE;
+    }
+
+    ChunkTotalSize += Context->Chunks[Index].Length;
+  }
+
+  if (Context->ChunkCount == 0 || ChunkTotalSize > FileSize) {
+    return FALSE;
+  }
+
+  Status = File->SetPosition (File, 0);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  Index          = 0;
+  CurrentChunk   = &Context->Chunks[0];
+  ChunkRemaining = CurrentChunk->Length;
+  Sha256Init (&ChunkContext);
+
+  //
+  // Read the file straight into the RAM disk in large blocks and hash every
+  // block right after it is read, while it is still in the cache. This avoids
+  // a second pass over the whole image and copying every chunk out of it.
+  //
+  for (ExtentIndex = 0; ExtentIndex < ExtentTable->ExtentCount && FileSize > 0; ++ExtentIndex) {
+    ASSERT (ExtentTable->Extents[ExtentIndex].Start <= MAX_UINTN);
+    ASSERT (ExtentTable->Extents[ExtentIndex].Length <= MAX_UINTN);
+
+    ExtentData = (UINT8 *)(UINTN)ExtentTable->Extents[ExtentIndex].Start;
+    ExtentSize = (UINTN)MIN (FileSize, ExtentTable->Extents[ExtentIndex].Length);
+
+    while (ExtentSize > 0) {
+      RequestedSize = ReadSize = MIN (ExtentSize, OC_APPLE_CHUNKLIST_LOAD_BLOCK_SIZE);
+      Status = File->Read (File, &RequestedSize, ExtentData);
+      if (EFI_ERROR (Status) || RequestedSize != ReadSize) {
+        return FALSE;
+      }
+
+      ExtentSize -= ReadSize;
+      FileSize   -= ReadSize;
+
+      while (ReadSize > 0 && Index < Context->ChunkCount) {
+        HashSize = MIN (ReadSize, ChunkRemaining);
+        Sha256Update (&ChunkContext, ExtentData, HashSize);
+
+        ExtentData     += HashSize;
+        ReadSize       -= HashSize;
+        ChunkRemaining -= (UINT32)HashSize;
+
+        if (ChunkRemaining > 0) {
+          continue;
+        }
+
+        DEBUG ((DEBUG_VERBOSE, "OcAppleChunklistLoadFile(): Validating chunk %lu of %lu\n",
+          (UINT64)Index + 1, (UINT64)Context->ChunkCount));
+        Sha256Final (&ChunkContext, ChunkHash);
+        if (CompareMem (ChunkHash, CurrentChunk->Checksum, SHA256_DIGEST_SIZE) != 0) {
+          DEBUG ((DEBUG_WARN, "OcAppleChunklistLoadFile(): Chunk %lu of %lu has been altered\n",
+            (UINT64)Index + 1, (UINT64)Context->ChunkCount));
+          return FALSE;
+        }
+
+        ++Index;
+        if (Index < Context->ChunkCount) {
+          CurrentChunk   = &Context->Chunks[Index];
+          ChunkRemaining = CurrentChunk->Length;
+          Sha256Init (&ChunkContext);
+        }
+      }
+
+      ExtentData += ReadSize;
+    }
+  }
+
+  return FileSize == 0 && Index == Context->ChunkCount;
+}
@@ -26,16 +26,58 @@
 
 #include "OcAppleDiskImageLibInternal.h"
 
+STATIC
 BOOLEAN
-OcAppleDiskImageInitializeContext (
+InternalReadImageData (
+  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable OPTIONAL,
+  IN  EFI_FILE_PROTOCOL                  *File OPTIONAL,
+  IN  UINTN                              Offset,
+  IN  UINTN                              Size,
+  OUT VOID                               *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  ASSERT ((ExtentTable != NULL) != (File != NULL));
+
+  if (ExtentTable != NULL) {
+    return OcAppleRamDiskRead (ExtentTable, Offset, Size, Buffer);
+  }
+
+  if (Offset > MAX_UINT32 || Size > MAX_UINT32) {
+    return FALSE;
+  }
+
+  Status = GetFileData (File, (UINT32)Offset, (UINT32)Size, Buffer);
+  return !EFI_ERROR (Status);
+}
+
+/**
+  Parse disk image trailer and plist either from RAM disk or from file.
+
+  @param[out] Context      Disk image context to initialise.
+  @param[in]  ExtentTable  RAM disk with the image, or NULL to use File.
+  @param[in]  File         File with the image, or NULL to use ExtentTable.
+  @param[in]  FileSize     Disk image size.
+  @param[out] Trailer      Parsed trailer.
+  @param[out] PlistData    On success, plist data, must be freed by the caller.
+                           Freed right after parsing when NULL.
+
+  @retval TRUE on success.
+**/
+STATIC
+BOOLEAN
+InternalInitializeContext (
   OUT OC_APPLE_DISK_IMAGE_CONTEXT        *Context,
-  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
-  IN  UINTN                              FileSize
+  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable OPTIONAL,
+  IN  EFI_FILE_PROTOCOL                  *File OPTIONAL,
+  IN  UINTN                              FileSize,
+  OUT APPLE_DISK_IMAGE_TRAILER           *Trailer,
+  OUT CHAR8                              **PlistData OPTIONAL
   )
 {
   BOOLEAN                     Result;
   UINTN                       TrailerOffset;
-  APPLE_DISK_IMAGE_TRAILER    Trailer;
   UINT32                      DmgBlockCount;
   APPLE_DISK_IMAGE_BLOCK_DATA **DmgBlocks;
   UINT32                      SwappedSig;
@@ -50,33 +92,34 @@ OcAppleDiskImageInitializeContext (
   UINT64                      XmlLength;
   UINT64                      SectorCount;
 
-  CHAR8                       *PlistData;
+  CHAR8                       *Plist;
 
   ASSERT (Context != NULL);
-  ASSERT (ExtentTable != NULL);
   ASSERT (FileSize > 0);
+  ASSERT (Trailer != NULL);
 
-  if (FileSize <= sizeof (Trailer)) {
+  if (FileSize <= sizeof (*Trailer)) {
     DEBUG ((
       DEBUG_INFO,
       "OCBD: DMG file size error: %u/%u\n",
       FileSize,
-      (UINT32) sizeof (Trailer)
+      (UINT32) sizeof (*Trailer)
       ));
     return FALSE;
   }
 
   SwappedSig = SwapBytes32 (APPLE_DISK_IMAGE_MAGIC);
 
-  TrailerOffset = (FileSize - sizeof (Trailer));
+  TrailerOffset = (FileSize - sizeof (*Trailer));
 
-  Result = OcAppleRamDiskRead (
+  Result = InternalReadImageData (
              ExtentTable,
+             File,
              TrailerOffset,
-             sizeof (Trailer),
-             &Trailer
+             sizeof (*Trailer),
+             Trailer
              );
-  if (!Result || (Trailer.Signature != SwappedSig)) {
+  if (!Result || (Trailer->Signature != SwappedSig)) {
     DEBUG ((
       DEBUG_INFO,
       "OCBD: DMG trailer error: %d - %Lx/%Lx - %X/%X\n",
@@ -84,21 +127,21 @@ OcAppleDiskImageInitializeContext (
       (UINT64) TrailerOffset,
       (UINT64) FileSize,
       SwappedSig,
-      Trailer.Signature
+      Trailer->Signature
       ));
     return FALSE;
   }
 
-  HeaderSize            = SwapBytes32 (Trailer.HeaderSize);
-  DataForkOffset        = SwapBytes64 (Trailer.DataForkOffset);
-  DataForkLength        = SwapBytes64 (Trailer.DataForkLength);
-  SegmentCount          = SwapBytes32 (Trailer.SegmentCount);
-  XmlOffset             = SwapBytes64 (Trailer.XmlOffset);
-  XmlLength             = SwapBytes64 (Trailer.XmlLength);
-  SectorCount           = SwapBytes64 (Trailer.SectorCount);
-  DataForkChecksum.Size = SwapBytes32 (Trailer.DataForkChecksum.Size);
+  HeaderSize            = SwapBytes32 (Trailer->HeaderSize);
+  DataForkOffset        = SwapBytes64 (Trailer->DataForkOffset);
+  DataForkLength        = SwapBytes64 (Trailer->DataForkLength);
+  SegmentCount          = SwapBytes32 (Trailer->SegmentCount);
+  XmlOffset             = SwapBytes64 (Trailer->XmlOffset);
+  XmlLength             = SwapBytes64 (Trailer->XmlLength);
+  SectorCount           = SwapBytes64 (Trailer->SectorCount);
+  DataForkChecksum.Size = SwapBytes32 (Trailer->DataForkChecksum.Size);
 
-  if ((HeaderSize != sizeof (Trailer))
+  if ((HeaderSize != sizeof (*Trailer))
    || (XmlLength == 0)
    || (XmlLength > MAX_UINT32)
    || (DataForkChecksum.Size > (sizeof (DataForkChecksum.Data) * 8))
@@ -149,26 +192,27 @@ OcAppleDiskImageInitializeContext (
     return FALSE;
   }
 
-  PlistData = AllocatePool ((UINT32)XmlLength);
-  if (PlistData == NULL) {
+  Plist = AllocatePool ((UINT32)XmlLength);
+  if (Plist == NULL) {
     DEBUG ((DEBUG_INFO, "OCBD: DMG plist alloc error: %Lu\n", XmlLength));
     return FALSE;
   }
 
-  Result = OcAppleRamDiskRead (
+  Result = InternalReadImageData (
              ExtentTable,
+             File,
              (UINTN)XmlOffset,
              (UINTN)XmlLength,
-             PlistData
+             Plist
              );
   if (!Result) {
     DEBUG ((DEBUG_INFO, "OCBD: DMG plist read error: %Lu %Lu\n", XmlOffset, XmlLength));
-    FreePool (PlistData);
+    FreePool (Plist);
     return FALSE;
   }
 
   Result = InternalParsePlist (
-             PlistData,
+             Plist,
              (UINT32)XmlLength,
              (UINTN)SectorCount,
              (UINTN)DataForkOffset,
@@ -177,13 +221,18 @@ OcAppleDiskImageInitializeContext (
              &DmgBlocks
              );
 
-  FreePool (PlistData);
-
   if (!Result) {
     DEBUG ((DEBUG_INFO, "OCBD: DMG plist parse error: %Lu %Lu\n", XmlOffset, XmlLength));
+    FreePool (Plist);
     return FALSE;
   }
 
+  if (PlistData != NULL) {
+    *PlistData = Plist;
+  } else {
+    FreePool (Plist);
+  }
+
   Context->ExtentTable = ExtentTable;
   Context->BlockCount  = DmgBlockCount;
   Context->Blocks      = DmgBlocks;
@@ -192,11 +241,59 @@ OcAppleDiskImageInitializeContext (
   return TRUE;
 }
 
+BOOLEAN
+OcAppleDiskImageInitializeContext (
+  OUT OC_APPLE_DISK_IMAGE_CONTEXT        *Context,
+  IN  CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
+  IN  UINTN                              FileSize
+  )
+{
+  APPLE_DISK_IMAGE_TRAILER  Trailer;
+
+  ASSERT (ExtentTable != NULL);
+
+  return InternalInitializeContext (
+           Context,
+           ExtentTable,
+           NULL,
+           FileSize,
+           &Trailer,
+           NULL
+           );
+}
+
+STATIC
+BOOLEAN
+InternalCompareImageData (
+  IN CONST APPLE_RAM_DISK_EXTENT_TABLE  *ExtentTable,
+  IN UINTN                              Offset,
+  IN UINTN                              Size,
+  IN CONST VOID                         *Data
+  )
+{
+  BOOLEAN  Result;
+  VOID     *Buffer;
+
+  Buffer = AllocatePool (Size);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  Result = OcAppleRamDiskRead (ExtentTable, Offset, Size, Buffer);
+  if (Result) {
+    Result = CompareMem (Buffer, Data, Size) == 0;
+  }
+
+  FreePool (Buffer);
+  return Result;
+}
+
 BOOLEAN
 OcAppleDiskImageInitializeFromFile (
-  OUT OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
-  IN  EFI_FILE_PROTOCOL            *File,
-  IN  BOOLEAN                      AvoidHighMem
+  OUT    OC_APPLE_DISK_IMAGE_CONTEXT  *Context,
+  IN     EFI_FILE_PROTOCOL            *File,
+  IN OUT OC_APPLE_CHUNKLIST_CONTEXT   *ChunklistContext OPTIONAL,
+  IN     BOOLEAN                      AvoidHighMem
   )
 {
   EFI_STATUS                        Status;
@@ -204,6 +301,8 @@ OcAppleDiskImageInitializeFromFile (
 
   UINT32                            FileSize;
   CONST APPLE_RAM_DISK_EXTENT_TABLE *ExtentTable;
+  APPLE_DISK_IMAGE_TRAILER          Trailer;
+  CHAR8                             *PlistData;
 
   ASSERT (Context != NULL);
   ASSERT (File != NULL);
@@ -214,28 +313,72 @@ OcAppleDiskImageInitializeFromFile (
     return FALSE;
   }
 
+  //
+  // Parse the trailer and the plist off the file first, so that malformed
+  // images are rejected before reading the whole of them.
+  //
+  Result = InternalInitializeContext (
+             Context,
+             NULL,
+             File,
+             FileSize,
+             &Trailer,
+             &PlistData
+             );
+  if (!Result) {
+    DEBUG ((DEBUG_INFO, "OCBD: Failed to initialise DMG context\n"));
+    return FALSE;
+  }
+
   ExtentTable = OcAppleRamDiskAllocate (FileSize, EfiACPIMemoryNVS, AvoidHighMem);
   if (ExtentTable == NULL) {
     DEBUG ((DEBUG_INFO, "OCBD: Failed to allocate DMG data\n"));
+
+    FreePool (PlistData);
+    OcAppleDiskImageFreeContext (Context);
     return FALSE;
   }
 
-  Result = OcAppleRamDiskLoadFile (ExtentTable, File, FileSize);
-  if (!Result) {
-    DEBUG ((DEBUG_INFO, "OCBD: Failed to load DMG file\n"));
+  if (ChunklistContext != NULL) {
+    Result = OcAppleChunklistLoadFile (ChunklistContext, ExtentTable, File, FileSize);
+  } else {
+    Result = OcAppleRamDiskLoadFile (ExtentTable, File, FileSize);
+  }
 
-    OcAppleRamDiskFree (ExtentTable);
-    return FALSE;
+  //
+  // The loaded image must be the one the context was parsed from,
+  // otherwise the block map is not covered by the chunklist.
+  //
+  if (Result) {
+    Result = InternalCompareImageData (
+               ExtentTable,
+               FileSize - sizeof (Trailer),
+               sizeof (Trailer),
+               &Trailer
+               );
   }
 
-  Result = OcAppleDiskImageInitializeContext (Context, ExtentTable, FileSize);
+  if (Result) {
+    Result = InternalCompareImageData (
+               ExtentTable,
+               (UINTN)SwapBytes64 (Trailer.XmlOffset),
+               (UINTN)SwapBytes64 (Trailer.XmlLength),
+               PlistData
+               );
+  }
+
+  FreePool (PlistData);
+
   if (!Result) {
-    DEBUG ((DEBUG_INFO, "OCBD: Failed to initialise DMG context\n"));
+    DEBUG ((DEBUG_INFO, "OCBD: Failed to load DMG file\n"));
 
     OcAppleRamDiskFree (ExtentTable);
+    OcAppleDiskImageFreeContext (Context);
     return FALSE;
   }
 
+  Context->ExtentTable = ExtentTable;
+
   return TRUE;
 }
 
@@ -15,6 +15,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Base.h>
 
 #include <IndustryStandard/AppleIntelCpuInfo.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/OcDebugLogLib.h>
 #include <Library/OcAppleKernelLib.h>
@@ -96,37 +97,27 @@ mAppleIntelCPUPowerManagementPatch2 = {
   .Skip        = 0
 };
 
+STATIC
 RETURN_STATUS
-PatchAppleCpuPmCfgLock (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchAppleCpuPmCfgLock (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
   RETURN_STATUS       Status2;
-  PATCHER_CONTEXT     Patcher;
-
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.driver.AppleIntelCPUPowerManagement"
-    );
 
+  Status = PatcherApplyGenericPatch (Patcher, &mAppleIntelCPUPowerManagementPatch);
   if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mAppleIntelCPUPowerManagementPatch);
-    if (!RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch v1 success com.apple.driver.AppleIntelCPUPowerManagement\n"));
-    }
+    DEBUG ((DEBUG_INFO, "OCAK: Patch v1 success com.apple.driver.AppleIntelCPUPowerManagement\n"));
+  }
 
-    Status2 = PatcherApplyGenericPatch (&Patcher, &mAppleIntelCPUPowerManagementPatch2);
-    if (!RETURN_ERROR (Status2)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch v2 success com.apple.driver.AppleIntelCPUPowerManagement\n"));
-    }
+  Status2 = PatcherApplyGenericPatch (Patcher, &mAppleIntelCPUPowerManagementPatch2);
+  if (!RETURN_ERROR (Status2)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Patch v2 success com.apple.driver.AppleIntelCPUPowerManagement\n"));
+  }
 
-    if (RETURN_ERROR (Status) && RETURN_ERROR (Status2)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patches com.apple.driver.AppleIntelCPUPowerManagement - %r/%r\n", Status, Status2));
-    }
-  } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.driver.AppleIntelCPUPowerManagement - %r\n", Status));
+  if (RETURN_ERROR (Status) && RETURN_ERROR (Status2)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patches com.apple.driver.AppleIntelCPUPowerManagement - %r/%r\n", Status, Status2));
   }
 
   //
@@ -586,33 +577,23 @@ mRemoveUsbLimitIoP1Patch = {
   .Limit       = 4096
 };
 
+STATIC
 RETURN_STATUS
-PatchUsbXhciPortLimit (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchUsbXhciPortLimit1 (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT  Patcher;
 
   //
   // On 10.14.4 and newer IOUSBHostFamily also needs limit removal.
   // Thanks to ydeng discovering this.
   //
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.iokit.IOUSBHostFamily"
-    );
-
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mRemoveUsbLimitIoP1Patch);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply P1 patch com.apple.iokit.IOUSBHostFamily - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOUSBHostFamily\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mRemoveUsbLimitIoP1Patch);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply P1 patch com.apple.iokit.IOUSBHostFamily - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.iokit.IOUSBHostFamily - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOUSBHostFamily\n"));
   }
 
   //
@@ -637,46 +618,47 @@ PatchUsbXhciPortLimit (
   // C~F are filled as many times as many USB Hubs are there on the port.
   //
 
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.driver.usb.AppleUSBXHCI"
-    );
+  return Status;
+}
 
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mRemoveUsbLimitV2Patch);
-    if (!RETURN_ERROR (Status)) {
-      //
-      // We do not need to patch com.apple.driver.usb.AppleUSBXHCI if this patch was successful.
-      // Only legacy systems require com.apple.driver.usb.AppleUSBXHCI to be patched.
-      //
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.usb.AppleUSBXHCI\n"));
-      return RETURN_SUCCESS;
-    }
+STATIC
+RETURN_STATUS
+InternalPatchUsbXhciPortLimit2 (
+  IN OUT PATCHER_CONTEXT  *Patcher
+  )
+{
+  RETURN_STATUS       Status;
 
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.usb.AppleUSBXHCI - %r\n", Status));
+  Status = PatcherApplyGenericPatch (Patcher, &mRemoveUsbLimitV2Patch);
+  if (!RETURN_ERROR (Status)) {
+    //
+    // We do not need to patch com.apple.driver.usb.AppleUSBXHCI if this patch was successful.
+    // Only legacy systems require com.apple.driver.usb.AppleUSBXHCI to be patched.
+    //
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.usb.AppleUSBXHCI\n"));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.driver.usb.AppleUSBXHCI - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.usb.AppleUSBXHCI - %r\n", Status));
   }
 
+  return Status;
+}
+
+STATIC
+RETURN_STATUS
+InternalPatchUsbXhciPortLimit3 (
+  IN OUT PATCHER_CONTEXT  *Patcher
+  )
+{
+  RETURN_STATUS       Status;
+
   //
   // If we are here, we are on legacy 10.13 or below, try the oldest patch.
   //
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.driver.usb.AppleUSBXHCIPCI"
-    );
-
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mRemoveUsbLimitV1Patch);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.usb.AppleUSBXHCIPCI - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.usb.AppleUSBXHCIPCI\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mRemoveUsbLimitV1Patch);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.usb.AppleUSBXHCIPCI - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.driver.usb.AppleUSBXHCIPCI - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.usb.AppleUSBXHCIPCI\n"));
   }
 
   return Status;
@@ -734,36 +716,26 @@ mIOAHCIBlockStoragePatchV2 = {
   .Skip        = 0
 };
 
+STATIC
 RETURN_STATUS
-PatchThirdPartyDriveSupport (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchThirdPartyDriveSupport (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT  Patcher;
-
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.iokit.IOAHCIBlockStorage"
-    );
 
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mIOAHCIBlockStoragePatchV1);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOAHCIBlockStorage V1 - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOAHCIBlockStorage V1\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mIOAHCIBlockStoragePatchV1);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOAHCIBlockStorage V1 - %r\n", Status));
+  } else {
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOAHCIBlockStorage V1\n"));
+  }
 
-    Status = PatcherApplyGenericPatch (&Patcher, &mIOAHCIBlockStoragePatchV2);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOAHCIBlockStorage V2 - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOAHCIBlockStorage V2\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mIOAHCIBlockStoragePatchV2);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOAHCIBlockStorage V2 - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.iokit.IOAHCIBlockStorage - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOAHCIBlockStorage V2\n"));
   }
 
   return Status;
@@ -795,29 +767,19 @@ mIOAHCIPortPatch = {
   .Skip    = 0
 };
 
+STATIC
 RETURN_STATUS
-PatchForceInternalDiskIcons (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchForceInternalDiskIcons (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT     Patcher;
-
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.driver.AppleAHCIPort"
-    );
 
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mIOAHCIPortPatch);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.AppleAHCIPort - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.AppleAHCIPort\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mIOAHCIPortPatch);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.driver.AppleAHCIPort - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.driver.AppleAHCIPort - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.driver.AppleAHCIPort\n"));
   }
 
   return Status;
@@ -849,29 +811,19 @@ mAppleIoMapperPatch = {
   .Skip        = 0
 };
 
+STATIC
 RETURN_STATUS
-PatchAppleIoMapperSupport (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchAppleIoMapperSupport (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT     Patcher;
-
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.iokit.IOPCIFamily"
-    );
 
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mAppleIoMapperPatch);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOPCIFamily AppleIoMapper - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOPCIFamily AppleIoMapper\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mAppleIoMapperPatch);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOPCIFamily AppleIoMapper - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.iokit.IOPCIFamily for AppleIoMapper - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOPCIFamily AppleIoMapper\n"));
   }
 
   return Status;
@@ -904,29 +856,19 @@ mIncreasePciBarSizePatch = {
   .Limit       = EFI_PAGE_SIZE
 };
 
+STATIC
 RETURN_STATUS
-PatchIncreasePciBarSize (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchIncreasePciBarSize (
+  IN OUT PATCHER_CONTEXT  *Patcher
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT     Patcher;
 
-  Status = PatcherInitContextFromPrelinked (
-    &Patcher,
-    Context,
-    "com.apple.iokit.IOPCIFamily"
-    );
-
-  if (!RETURN_ERROR (Status)) {
-    Status = PatcherApplyGenericPatch (&Patcher, &mIncreasePciBarSizePatch);
-    if (RETURN_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOPCIFamily IncreasePciBarSize - %r\n", Status));
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOPCIFamily IncreasePciBarSize\n"));
-    }
+  Status = PatcherApplyGenericPatch (Patcher, &mIncreasePciBarSizePatch);
+  if (RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply patch com.apple.iokit.IOPCIFamily IncreasePciBarSize - %r\n", Status));
   } else {
-    DEBUG ((DEBUG_INFO, "OCAK: Failed to find com.apple.iokit.IOPCIFamily for IncreasePciBarSize - %r\n", Status));
+    DEBUG ((DEBUG_INFO, "OCAK: Patch success com.apple.iokit.IOPCIFamily IncreasePciBarSize\n"));
   }
 
   return Status;
@@ -1181,42 +1123,43 @@ mCustomSmbiosGuidPatch = {
   .Skip    = 0
 };
 
+STATIC
 RETURN_STATUS
-PatchCustomSmbiosGuid (
-  IN OUT PRELINKED_CONTEXT  *Context
+InternalPatchCustomSmbiosGuid (
+  IN OUT PATCHER_CONTEXT  *Patcher,
+  IN     CONST CHAR8      *Identifier
   )
 {
   RETURN_STATUS       Status;
-  PATCHER_CONTEXT     Patcher;
-  UINT32              Index;
-  
-  STATIC CONST CHAR8 *Kexts[] = {
-    "com.apple.driver.AppleSMBIOS",
-    "com.apple.driver.AppleACPIPlatform"
-  };
-  
-  for (Index = 0; Index < ARRAY_SIZE (Kexts); ++Index) {
-    Status = PatcherInitContextFromPrelinked (
-      &Patcher,
-      Context,
-      Kexts[Index]
-      );
-    
-    if (!RETURN_ERROR (Status)) {
-      Status = PatcherApplyGenericPatch (&Patcher, &mCustomSmbiosGuidPatch);
-      if (!RETURN_ERROR (Status)) {
-        DEBUG ((DEBUG_INFO, "OCAK: SMBIOS Patch success %a\n", Kexts[Index]));
-      } else {
-        DEBUG ((DEBUG_INFO, "OCAK: Failed to apply SMBIOS patch %a - %r\n", Kexts[Index], Status));
-      }
-    } else {
-      DEBUG ((DEBUG_INFO, "OCAK: Failed to find SMBIOS kext %a - %r\n", Kexts[Index], Status));
-    }
+
+  Status = PatcherApplyGenericPatch (Patcher, &mCustomSmbiosGuidPatch);
+  if (!RETURN_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "OCAK: SMBIOS Patch success %a\n", Identifier));
+  } else {
+    DEBUG ((DEBUG_INFO, "OCAK: Failed to apply SMBIOS patch %a - %r\n", Identifier, Status));
   }
 
   return Status;
 }
 
+STATIC
+RETURN_STATUS
+InternalPatchAppleSmbiosGuid (
+  IN OUT PATCHER_CONTEXT  *Patcher
+  )
+{
+  return InternalPatchCustomSmbiosGuid (Patcher, "com.apple.driver.AppleSMBIOS");
+}
+
+STATIC
+RETURN_STATUS
+InternalPatchAcpiPlatformSmbiosGuid (
+  IN OUT PATCHER_CONTEXT  *Patcher
+  )
+{
+  return InternalPatchCustomSmbiosGuid (Patcher, "com.apple.driver.AppleACPIPlatform");
+}
+
 STATIC
 UINT8
 mPanicKextDumpPatchFind[] = {
@@ -1436,3 +1379,511 @@ PatchPowerStateTimeout (
 
   return Status;
 }
+
+//
+// Maximum amount of base symbols a single quirk step resolves.
+//
+#define KERNEL_QUIRK_MAX_SYMBOLS  3
+
+//
+// Maximum amount of base symbols resolved for a single target image.
+//
+#define KERNEL_QUIRK_MAX_TARGET_SYMBOLS  16
+
+//
+// Step is only applied when the previous step failed, and its status
+// replaces the status of the previous step.
+//
+#define KERNEL_QUIRK_STEP_FALLBACK  BIT0
+
+//
+// Step failure does not fail the quirk, e.g. when the patch target
+// is missing on some macOS versions.
+//
+#define KERNEL_QUIRK_STEP_OPTIONAL  BIT1
+
+typedef
+RETURN_STATUS
+(*KERNEL_QUIRK_PATCH_FUNCTION) (
+  IN OUT PATCHER_CONTEXT  *Patcher
+  );
+
+//
+// Single quirk application step for one target image.
+//
+typedef struct {
+  //
+  // Quirk this step belongs to.
+  //
+  KERNEL_QUIRK_NAME            Name;
+  //
+  // Kext bundle identifier or NULL for the kernel.
+  //
+  CONST CHAR8                  *Identifier;
+  //
+  // Patch function.
+  //
+  KERNEL_QUIRK_PATCH_FUNCTION  PatchFunction;
+  //
+  // Base symbols used by the patch function, NULL terminated.
+  // The first one defines the application order within the image.
+  //
+  CONST CHAR8                  *Symbols[KERNEL_QUIRK_MAX_SYMBOLS + 1];
+  //
+  // KERNEL_QUIRK_STEP_* flags.
+  //
+  UINT32                       Flags;
+} KERNEL_QUIRK_STEP;
+
+STATIC
+CONST KERNEL_QUIRK_STEP
+mKernelQuirkSteps[] = {
+  {
+    KernelQuirkAppleCpuPmCfgLock,
+    "com.apple.driver.AppleIntelCPUPowerManagement",
+    InternalPatchAppleCpuPmCfgLock,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkAppleXcpmCfgLock,
+    NULL,
+    PatchAppleXcpmCfgLock,
+    { "_xcpm_core_scope_msrs", "_xcpm_idle", "_xcpm_cst_control_evaluate", NULL },
+    0
+  },
+  {
+    KernelQuirkAppleXcpmExtraMsrs,
+    NULL,
+    PatchAppleXcpmExtraMsrs,
+    { "_xcpm_pkg_scope_msrs", "_xcpm_SMT_scope_msrs", NULL },
+    0
+  },
+  {
+    KernelQuirkAppleXcpmForceBoost,
+    NULL,
+    PatchAppleXcpmForceBoost,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkCustomSmbiosGuid,
+    "com.apple.driver.AppleSMBIOS",
+    InternalPatchAppleSmbiosGuid,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkCustomSmbiosGuid,
+    "com.apple.driver.AppleACPIPlatform",
+    InternalPatchAcpiPlatformSmbiosGuid,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkDisableIoMapper,
+    "com.apple.iokit.IOPCIFamily",
+    InternalPatchAppleIoMapperSupport,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkExternalDiskIcons,
+    "com.apple.driver.AppleAHCIPort",
+    InternalPatchForceInternalDiskIcons,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkIncreasePciBarSize,
+    "com.apple.iokit.IOPCIFamily",
+    InternalPatchIncreasePciBarSize,
+    { "__ZN17IOPCIConfigurator24probeBaseAddressRegisterEP16IOPCIConfigEntryjj", NULL },
+    0
+  },
+  {
+    KernelQuirkLapicKernelPanic,
+    NULL,
+    PatchLapicKernelPanic,
+    { "_lapic_interrupt", NULL },
+    0
+  },
+  {
+    KernelQuirkPanicNoKextDump,
+    NULL,
+    PatchPanicKextDump,
+    { "__ZN6OSKext19printKextPanicListsEPFiPKczE", NULL },
+    0
+  },
+  {
+    KernelQuirkPowerTimeoutKernelPanic,
+    NULL,
+    PatchPowerStateTimeout,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkThirdPartyDrives,
+    "com.apple.iokit.IOAHCIBlockStorage",
+    InternalPatchThirdPartyDriveSupport,
+    { NULL },
+    0
+  },
+  {
+    KernelQuirkXhciPortLimit,
+    "com.apple.iokit.IOUSBHostFamily",
+    InternalPatchUsbXhciPortLimit1,
+    { "__ZN16AppleUSBHostPort15setPortLocationEj", NULL },
+    KERNEL_QUIRK_STEP_OPTIONAL
+  },
+  {
+    KernelQuirkXhciPortLimit,
+    "com.apple.driver.usb.AppleUSBXHCI",
+    InternalPatchUsbXhciPortLimit2,
+    { "__ZN12AppleUSBXHCI11createPortsEv", NULL },
+    0
+  },
+  {
+    KernelQuirkXhciPortLimit,
+    "com.apple.driver.usb.AppleUSBXHCIPCI",
+    InternalPatchUsbXhciPortLimit3,
+    { "__ZN15AppleUSBXHCIPCI11createPortsEv", NULL },
+    KERNEL_QUIRK_STEP_FALLBACK
+  }
+};
+
+/**
+  Check whether two quirk steps target the same image.
+
+  @param[in] Identifier1  First identifier or NULL for the kernel.
+  @param[in] Identifier2  Second identifier or NULL for the kernel.
+
+  @retval TRUE when identifiers match.
+**/
+STATIC
+BOOLEAN
+InternalIsSameQuirkTarget (
+  IN CONST CHAR8  *Identifier1 OPTIONAL,
+  IN CONST CHAR8  *Identifier2 OPTIONAL
+  )
+{
+  if (Identifier1 == NULL || Identifier2 == NULL) {
+    return Identifier1 == Identifier2;
+  }
+
+  return AsciiStrCmp (Identifier1, Identifier2) == 0;
+}
+
+/**
+  Obtain the address defining step application order within the image.
+
+  @param[in] Step     Quirk step.
+  @param[in] Patcher  Patcher context with resolved symbols.
+
+  @return  Base symbol address or MAX_UINTN when the step has no base.
+**/
+STATIC
+UINTN
+InternalGetQuirkStepOrder (
+  IN CONST KERNEL_QUIRK_STEP  *Step,
+  IN OUT   PATCHER_CONTEXT    *Patcher
+  )
+{
+  RETURN_STATUS  Status;
+  UINT8          *Address;
+
+  if (Step->Symbols[0] == NULL) {
+    return MAX_UINTN;
+  }
+
+  Status = PatcherGetSymbolAddress (Patcher, Step->Symbols[0], &Address);
+  if (RETURN_ERROR (Status)) {
+    return MAX_UINTN;
+  }
+
+  return (UINTN) Address;
+}
+
+/**
+  Apply all enabled steps targeting one image.
+
+  @param[in,out] Patcher     Patcher context for the image.
+  @param[in]     Steps       Step indices in mKernelQuirkSteps.
+  @param[in]     StepCount   Amount of steps.
+  @param[in,out] StepStatus  Per-step status in mKernelQuirkSteps order.
+**/
+STATIC
+VOID
+InternalApplyQuirkSteps (
+  IN OUT PATCHER_CONTEXT  *Patcher,
+  IN     UINT32           *Steps,
+  IN     UINT32           StepCount,
+  IN OUT RETURN_STATUS    *StepStatus
+  )
+{
+  PATCHER_SYMBOL  Symbols[KERNEL_QUIRK_MAX_TARGET_SYMBOLS];
+  UINTN           Order[ARRAY_SIZE (mKernelQuirkSteps)];
+  UINT32          SymbolCount;
+  UINT32          Index;
+  UINT32          Index2;
+  UINT32          Index3;
+  UINT32          Step;
+  UINTN           StepOrder;
+  CONST CHAR8     *Name;
+  PATCHER_SYMBOL  *PrevSymbols;
+  UINT32          PrevSymbolCount;
+
+  PrevSymbols     = Patcher->Symbols;
+  PrevSymbolCount = Patcher->SymbolCount;
+
+  //
+  // Resolve all base symbols of this image in one symbol table pass.
+  //
+  SymbolCount = 0;
+  for (Index = 0; Index < StepCount; ++Index) {
+    for (Index2 = 0; mKernelQuirkSteps[Steps[Index]].Symbols[Index2] != NULL; ++Index2) {
+      Name = mKernelQuirkSteps[Steps[Index]].Symbols[Index2];
+
+      for (Index3 = 0; Index3 < SymbolCount; ++Index3) {
+        if (AsciiStrCmp (Symbols[Index3].Name, Name) == 0) {
+          break;
+        }
+      }
+
+      if (Index3 == SymbolCount && SymbolCount < ARRAY_SIZE (Symbols)) {
+        Symbols[SymbolCount].Name    = Name;
+        Symbols[SymbolCount].Address = NULL;
+        ++SymbolCount;
+      }
+    }
+  }
+
+  if (SymbolCount > 0) {
+    PatcherResolveSymbols (Patcher, Symbols, SymbolCount);
+  }
+
+  //
+  // Order steps by their base address with insertion sort, which is stable
+  // and keeps baseless steps in table order at the end.
+  //
+  for (Index = 0; Index < StepCount; ++Index) {
+    Order[Index] = InternalGetQuirkStepOrder (&mKernelQuirkSteps[Steps[Index]], Patcher);
+  }
+
+  for (Index = 1; Index < StepCount; ++Index) {
+    Step      = Steps[Index];
+    StepOrder = Order[Index];
+    Index2    = Index;
+    while (Index2 > 0 && Order[Index2 - 1] > StepOrder) {
+      Steps[Index2] = Steps[Index2 - 1];
+      Order[Index2] = Order[Index2 - 1];
+      --Index2;
+    }
+    Steps[Index2] = Step;
+    Order[Index2] = StepOrder;
+  }
+
+  for (Index = 0; Index < StepCount; ++Index) {
+    Step = Steps[Index];
+
+    if ((mKernelQuirkSteps[Step].Flags & KERNEL_QUIRK_STEP_FALLBACK) != 0
+      && Step > 0
+      && !RETURN_ERROR (StepStatus[Step - 1])) {
+      StepStatus[Step] = RETURN_SUCCESS;
+      continue;
+    }
+
+    StepStatus[Step] = mKernelQuirkSteps[Step].PatchFunction (Patcher);
+  }
+
+  Patcher->Symbols     = PrevSymbols;
+  Patcher->SymbolCount = PrevSymbolCount;
+}
+
+RETURN_STATUS
+KernelApplyQuirks (
+  IN OUT PRELINKED_CONTEXT  *Prelinked OPTIONAL,
+  IN OUT PATCHER_CONTEXT    *KernelPatcher OPTIONAL,
+  IN     CONST BOOLEAN      *Quirks
+  )
+{
+  RETURN_STATUS    Status;
+  RETURN_STATUS    StepStatus[ARRAY_SIZE (mKernelQuirkSteps)];
+  RETURN_STATUS    QuirkStatus[KernelQuirkMax];
+  BOOLEAN          Scheduled[ARRAY_SIZE (mKernelQuirkSteps)];
+  UINT32           Steps[ARRAY_SIZE (mKernelQuirkSteps)];
+  UINT32           StepCount;
+  UINT32           Index;
+  UINT32           Index2;
+  PATCHER_CONTEXT  Patcher;
+  PATCHER_CONTEXT  *Target;
+  CONST CHAR8      *Identifier;
+
+  ASSERT (Quirks != NULL);
+
+  for (Index = 0; Index < ARRAY_SIZE (mKernelQuirkSteps); ++Index) {
+    ASSERT (mKernelQuirkSteps[Index].Name < KernelQuirkMax);
+    Scheduled[Index]  = !Quirks[mKernelQuirkSteps[Index].Name];
+    StepStatus[Index] = RETURN_NOT_STARTED;
+  }
+
+  //
+  // Group steps by target image so that every image is initialised
+  // and has its symbols resolved only once.
+  //
+  for (Index = 0; Index < ARRAY_SIZE (mKernelQuirkSteps); ++Index) {
+    if (Scheduled[Index]) {
+      continue;
+    }
+
+    Identifier = mKernelQuirkSteps[Index].Identifier;
+    StepCount  = 0;
+    for (Index2 = Index; Index2 < ARRAY_SIZE (mKernelQuirkSteps); ++Index2) {
+      if (!Scheduled[Index2]
+        && InternalIsSameQuirkTarget (Identifier, mKernelQuirkSteps[Index2].Identifier)) {
+        Scheduled[Index2] = TRUE;
+        Steps[StepCount]  = Index2;
+        ++StepCount;
+      }
+    }
+
+    if (Identifier == NULL) {
+      Target = KernelPatcher;
+      Status = Target != NULL ? RETURN_SUCCESS : RETURN_NOT_FOUND;
+    } else {
+      Target = &Patcher;
+      Status = Prelinked != NULL
+        ? PatcherInitContextFromPrelinked (Target, Prelinked, Identifier)
+        : RETURN_NOT_FOUND;
+    }
+
+    if (RETURN_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_INFO,
+        "OCAK: Failed to find %a for quirks - %r\n",
+        Identifier != NULL ? Identifier : "kernel",
+        Status
+        ));
+      for (Index2 = 0; Index2 < StepCount; ++Index2) {
+        StepStatus[Steps[Index2]] = Status;
+      }
+      continue;
+    }
+
+    InternalApplyQuirkSteps (Target, Steps, StepCount, StepStatus);
+  }
+
+  //
+  // Aggregate status per quirk and report the last failed quirk.
+  // Optional steps never fail their quirk, and a step followed by
+  // a fallback is superseded by the fallback status.
+  //
+  for (Index = 0; Index < KernelQuirkMax; ++Index) {
+    QuirkStatus[Index] = RETURN_SUCCESS;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mKernelQuirkSteps); ++Index) {
+    if (StepStatus[Index] == RETURN_NOT_STARTED
+      || !RETURN_ERROR (StepStatus[Index])
+      || (mKernelQuirkSteps[Index].Flags & KERNEL_QUIRK_STEP_OPTIONAL) != 0) {
+      continue;
+    }
+
+    if (Index + 1 < ARRAY_SIZE (mKernelQuirkSteps)
+      && (mKernelQuirkSteps[Index + 1].Flags & KERNEL_QUIRK_STEP_FALLBACK) != 0
+      && mKernelQuirkSteps[Index + 1].Name == mKernelQuirkSteps[Index].Name
+      && StepStatus[Index + 1] != RETURN_NOT_STARTED) {
+      continue;
+    }
+
+    QuirkStatus[mKernelQuirkSteps[Index].Name] = StepStatus[Index];
+  }
+
+  Status = RETURN_SUCCESS;
+  for (Index = 0; Index < KernelQuirkMax; ++Index) {
+    if (RETURN_ERROR (QuirkStatus[Index])) {
+      Status = QuirkStatus[Index];
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Apply single kext quirk.
+
+  @param[in,out] Context  Prelinked kernel context.
+  @param[in]     Name     Quirk name.
+
+  @return  RETURN_SUCCESS on success.
+**/
+STATIC
+RETURN_STATUS
+InternalApplyKextQuirk (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     KERNEL_QUIRK_NAME  Name
+  )
+{
+  BOOLEAN  Quirks[KernelQuirkMax];
+
+  ZeroMem (Quirks, sizeof (Quirks));
+  Quirks[Name] = TRUE;
+
+  return KernelApplyQuirks (Context, NULL, Quirks);
+}
+
+RETURN_STATUS
+PatchAppleCpuPmCfgLock (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkAppleCpuPmCfgLock);
+}
+
+RETURN_STATUS
+PatchUsbXhciPortLimit (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkXhciPortLimit);
+}
+
+RETURN_STATUS
+PatchThirdPartyDriveSupport (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkThirdPartyDrives);
+}
+
+RETURN_STATUS
+PatchForceInternalDiskIcons (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkExternalDiskIcons);
+}
+
+RETURN_STATUS
+PatchAppleIoMapperSupport (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkDisableIoMapper);
+}
+
+RETURN_STATUS
+PatchIncreasePciBarSize (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkIncreasePciBarSize);
+}
+
+RETURN_STATUS
+PatchCustomSmbiosGuid (
+  IN OUT PRELINKED_CONTEXT  *Context
+  )
+{
+  return InternalApplyKextQuirk (Context, KernelQuirkCustomSmbiosGuid);
+}
@@ -24,6 +24,7 @@
 #include <Library/OcCompressionLib.h>
 #include <Library/OcFileLib.h>
 #include <Library/OcGuardLib.h>
+#include <Library/OcPerfLib.h>
 
 //
 // Pick a reasonable maximum to fit.
@@ -301,7 +302,13 @@ ReadAppleKernelImage (
         //
         // Loop into updated image in Buffer.
         //
+        OcPerfBegin (OC_PERF_PHASE_KERNEL_DECOMPRESS);
         *KernelSize = ParseCompressedHeader (File, Buffer, Offset, AllocatedSize, ReservedSize);
+        OcPerfEnd (
+          OC_PERF_PHASE_KERNEL_DECOMPRESS,
+          *KernelSize,
+          *KernelSize != 0 ? EFI_SUCCESS : EFI_INVALID_PARAMETER
+          );
         if (*KernelSize != 0) {
           DEBUG ((DEBUG_VERBOSE, "Compressed result has %08X magic\n", *(UINT32 *) Buffer));
           continue;
@@ -334,6 +341,8 @@ ReadAppleKernel (
     return RETURN_INVALID_PARAMETER;
   }
 
+  OcPerfBegin (OC_PERF_PHASE_KERNEL_READ);
+
   Status = ReadAppleKernelImage (
     File,
     Kernel,
@@ -343,6 +352,8 @@ ReadAppleKernel (
     0
     );
 
+  OcPerfEnd (OC_PERF_PHASE_KERNEL_READ, *KernelSize, Status);
+
   if (RETURN_ERROR (Status)) {
     FreePool (*Kernel);
   }
@@ -41,6 +41,8 @@ PatcherInitContextFromPrelinked (
   }
 
   CopyMem (Context, &Kext->Context, sizeof (*Context));
+  Context->Symbols     = NULL;
+  Context->SymbolCount = 0;
   return RETURN_SUCCESS;
 }
 
@@ -78,6 +80,8 @@ PatcherInitContextFromBuffer (
 
   Context->VirtualBase = Segment->VirtualAddress - Segment->FileOffset;
   Context->VirtualKmod = 0;
+  Context->Symbols     = NULL;
+  Context->SymbolCount = 0;
 
   return RETURN_SUCCESS;
 }
@@ -94,6 +98,17 @@ PatcherGetSymbolAddress (
   UINT32         Offset;
   UINT32         Index;
 
+  for (Index = 0; Index < Context->SymbolCount; ++Index) {
+    if (AsciiStrCmp (Name, Context->Symbols[Index].Name) == 0) {
+      if (Context->Symbols[Index].Address == NULL) {
+        return RETURN_NOT_FOUND;
+      }
+
+      *Address = Context->Symbols[Index].Address;
+      return RETURN_SUCCESS;
+    }
+  }
+
   Index = 0;
   while (TRUE) {
     Symbol = MachoGetSymbolByIndex64 (&Context->MachContext, Index);
@@ -118,6 +133,61 @@ PatcherGetSymbolAddress (
   return RETURN_SUCCESS;
 }
 
+VOID
+PatcherResolveSymbols (
+  IN OUT PATCHER_CONTEXT    *Context,
+  IN OUT PATCHER_SYMBOL     *Symbols,
+  IN     UINT32             SymbolCount
+  )
+{
+  MACH_NLIST_64  *Symbol;
+  CONST CHAR8    *SymbolName;
+  UINT32         Offset;
+  UINT32         Index;
+  UINT32         Index2;
+  UINT32         Remaining;
+
+  ASSERT (Context != NULL);
+  ASSERT (Symbols != NULL || SymbolCount == 0);
+
+  for (Index2 = 0; Index2 < SymbolCount; ++Index2) {
+    Symbols[Index2].Address = NULL;
+  }
+
+  Remaining = SymbolCount;
+  for (Index = 0; Remaining > 0; ++Index) {
+    Symbol = MachoGetSymbolByIndex64 (&Context->MachContext, Index);
+    if (Symbol == NULL) {
+      break;
+    }
+
+    SymbolName = MachoGetSymbolName64 (&Context->MachContext, Symbol);
+    if (SymbolName == NULL) {
+      continue;
+    }
+
+    for (Index2 = 0; Index2 < SymbolCount; ++Index2) {
+      //
+      // First match wins similarly to PatcherGetSymbolAddress.
+      //
+      if (Symbols[Index2].Address != NULL
+        || Symbols[Index2].Name[0] != SymbolName[0]
+        || AsciiStrCmp (Symbols[Index2].Name, SymbolName) != 0) {
+        continue;
+      }
+
+      if (MachoSymbolGetFileOffset64 (&Context->MachContext, Symbol, &Offset, NULL)) {
+        Symbols[Index2].Address = (UINT8 *)MachoGetMachHeader64 (&Context->MachContext) + Offset;
+        --Remaining;
+      }
+      break;
+    }
+  }
+
+  Context->Symbols     = Symbols;
+  Context->SymbolCount = SymbolCount;
+}
+
 RETURN_STATUS
 PatcherApplyGenericPatch (
   IN OUT PATCHER_CONTEXT        *Context,
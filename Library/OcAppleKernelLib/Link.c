@@ -21,9 +21,11 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcStringLib.h>
 
 #include "PrelinkedInternal.h"
 
@@ -321,7 +323,7 @@ InternalSolveSymbolNonWeak64 (
       // KXLD_WEAK_TEST_SYMBOL might have been resolved by the resolving code
       // at the end of InternalSolveSymbol64. 
       //
-      Result = AsciiStrCmp (
+      Result = OcAsciiStrCmp (
                  MachoGetSymbolName64 (&Kext->Context.MachContext, Symbol),
                  KXLD_WEAK_TEST_SYMBOL
                  );
@@ -425,7 +427,7 @@ InternalSolveSymbol64 (
     if (Value == 0) {
       for (Index = 0; Index < NumUndefinedSymbols; ++Index) {
         WeakTestSymbol = &UndefinedSymbols[Index];
-        Result = AsciiStrCmp (
+        Result = OcAsciiStrCmp (
                    MachoGetSymbolName64 (
                      &Kext->Context.MachContext,
                      WeakTestSymbol
@@ -465,6 +467,37 @@ InternalSolveSymbol64 (
 // Relocations
 //
 
+//
+// Relocation target of an external symbol, resolved once per kext.
+//
+typedef struct {
+  UINT64                 Target;
+  CONST PRELINKED_VTABLE *Vtable;
+  BOOLEAN                TargetResolved;
+  BOOLEAN                VtableResolved;
+} PRELINKED_RELOCATION_SYMBOL;
+
+//
+// Relocation to be applied, ordered by the address it patches.
+//
+typedef struct {
+  UINT64  Address;
+  UINT32  Index;
+} PRELINKED_RELOCATION_FIXUP;
+
+typedef struct {
+  //
+  // Resolved targets indexed by symbol number.
+  //
+  PRELINKED_RELOCATION_SYMBOL  *Symbols;
+  UINT32                       NumSymbols;
+  //
+  // Fixup scratch buffer, large enough for any relocation table of the kext.
+  //
+  PRELINKED_RELOCATION_FIXUP   *Fixups;
+  UINT32                       MaxFixups;
+} PRELINKED_RELOCATION_PLAN;
+
 /**
   Calculate the target address' displacement for the Intel 64 platform.
   Instruction will be patched with the resulting address.
@@ -509,6 +542,7 @@ InternalCalculateDisplacementIntel64 (
 
   @param[in,out] Context          Prelinking context.
   @param[in]     Kext             KEXT prelinking context.
+  @param[in,out] Plan             Relocation plan caching symbol targets.
   @param[in]     LoadAddress      The address to be linked against.
   @param[in]     Relocation       The Relocation to be resolved.
   @param[in]     NextRelocation   The Relocation following Relocation.
@@ -525,6 +559,7 @@ BOOLEAN
 InternalCalculateTargetsIntel64 (
   IN     PRELINKED_CONTEXT           *Context,
   IN OUT PRELINKED_KEXT              *Kext,
+  IN OUT PRELINKED_RELOCATION_PLAN   *Plan,
   IN     UINT64                      LoadAddress,
   IN     CONST MACH_RELOCATION_INFO  *Relocation,
   IN     CONST MACH_RELOCATION_INFO  *NextRelocation  OPTIONAL,
@@ -537,10 +572,11 @@ InternalCalculateTargetsIntel64 (
 
   OC_MACHO_CONTEXT      *MachoContext;
 
-  UINT64                TargetAddress;
-  MACH_NLIST_64         *Symbol;
-  CONST CHAR8           *Name;
-  MACH_SECTION_64       *Section;
+  UINT64                      TargetAddress;
+  MACH_NLIST_64               *Symbol;
+  CONST CHAR8                 *Name;
+  MACH_SECTION_64             *Section;
+  PRELINKED_RELOCATION_SYMBOL *Resolved;
   UINT64                PairAddress;
   UINT64                PairDummy;
 
@@ -563,32 +599,59 @@ InternalCalculateTargetsIntel64 (
   // section's boundary.
   //
   if (Relocation->Extern != 0) {
-    Symbol = MachoGetSymbolByIndex64 (
-                MachoContext,
-                Relocation->SymbolNumber
-                );
-    if (Symbol == NULL) {
+    if (Relocation->SymbolNumber >= Plan->NumSymbols) {
       return FALSE;
     }
-
-    Name = MachoGetSymbolName64 (MachoContext, Symbol);
     //
-    // If this symbol is a padslot that has already been replaced, then the
-    // only way a relocation entry can still reference it is if there is a
-    // vtable that has not been patched.  The vtable patcher uses the
-    // MetaClass structure to find classes for patching, so an unpatched
-    // vtable means that there is an OSObject-dervied class that is missing
-    // its OSDeclare/OSDefine macros.
-    // - FIXME: This cannot currently be checked with the means of this
-    //          library.  KXLD creates copies of patched VTable symbols, marks
-    //          the originals patched and then updates the referencing reloc.
+    // IOKit kexts reference the same external symbols from many places,
+    // so only resolve every symbol once.
     //
+    Resolved = &Plan->Symbols[Relocation->SymbolNumber];
+    if (Resolved->TargetResolved && (Vtable == NULL || Resolved->VtableResolved)) {
+      ++Kext->NumberOfCachedRelocationSymbols;
+    } else {
+      Symbol = MachoGetSymbolByIndex64 (
+                  MachoContext,
+                  Relocation->SymbolNumber
+                  );
+      if (Symbol == NULL) {
+        return FALSE;
+      }
 
-    if ((Vtable != NULL) && MachoSymbolNameIsVtable64 (Name)) {
-      *Vtable = InternalGetOcVtableByName (Context, Kext, Name);
+      if (Vtable != NULL && !Resolved->VtableResolved) {
+        Name = MachoGetSymbolName64 (MachoContext, Symbol);
+        //
+        // If this symbol is a padslot that has already been replaced, then the
+        // only way a relocation entry can still reference it is if there is a
+        // vtable that has not been patched.  The vtable patcher uses the
+        // MetaClass structure to find classes for patching, so an unpatched
+        // vtable means that there is an OSObject-dervied class that is missing
+        // its OSDeclare/OSDefine macros.
+        // - FIXME: This cannot currently be checked with the means of this
+        //          library.  KXLD creates copies of patched VTable symbols, marks
+        //          the originals patched and then updates the referencing reloc.
+        //
+        if (MachoSymbolNameIsVtable64 (Name)) {
+          Resolved->Vtable = InternalGetOcVtableByName (Context, Kext, Name);
+        }
+
+        Resolved->VtableResolved = TRUE;
+      }
+
+      if (!Resolved->TargetResolved) {
+        Resolved->Target         = Symbol->Value;
+        Resolved->TargetResolved = TRUE;
+        ++Kext->NumberOfResolvedRelocationSymbols;
+      } else {
+        ++Kext->NumberOfCachedRelocationSymbols;
+      }
+    }
+
+    if (Vtable != NULL) {
+      *Vtable = Resolved->Vtable;
     }
 
-    TargetAddress = Symbol->Value;
+    TargetAddress = Resolved->Target;
   } else {
     if ((Relocation->SymbolNumber == NO_SECT)
      || (Relocation->SymbolNumber > MAX_SECT)) {
@@ -622,6 +685,7 @@ InternalCalculateTargetsIntel64 (
     Success = InternalCalculateTargetsIntel64 (
                 Context,
                 Kext,
+                Plan,
                 LoadAddress,
                 NextRelocation,
                 NULL,
@@ -681,6 +745,7 @@ InternalIsDirectPureVirtualCall64 (
 
   @param[in,out] Context         Prelinking context.
   @param[in]     Kext            KEXT prelinking context.
+  @param[in,out] Plan            Relocation plan caching symbol targets.
   @param[in]     LoadAddress      The address to be linked against.
   @param[in]     RelocationBase  The Relocations base address.
   @param[in]     Relocation      The Relocation to be processed.
@@ -699,12 +764,13 @@ InternalIsDirectPureVirtualCall64 (
 STATIC
 UINTN
 InternalRelocateRelocationIntel64 (
-  IN PRELINKED_CONTEXT           *Context,
-  IN PRELINKED_KEXT              *Kext,
-  IN UINT64                      LoadAddress,
-  IN UINT64                      RelocationBase,
-  IN CONST MACH_RELOCATION_INFO  *Relocation,
-  IN CONST MACH_RELOCATION_INFO  *NextRelocation  OPTIONAL
+  IN     PRELINKED_CONTEXT           *Context,
+  IN     PRELINKED_KEXT              *Kext,
+  IN OUT PRELINKED_RELOCATION_PLAN   *Plan,
+  IN     UINT64                      LoadAddress,
+  IN     UINT64                      RelocationBase,
+  IN     CONST MACH_RELOCATION_INFO  *Relocation,
+  IN     CONST MACH_RELOCATION_INFO  *NextRelocation  OPTIONAL
   )
 {
   UINTN           ReturnValue;
@@ -761,6 +827,7 @@ InternalRelocateRelocationIntel64 (
   Result = InternalCalculateTargetsIntel64 (
              Context,
              Kext,
+             Plan,
              LoadAddress,
              Relocation,
              NextRelocation,
@@ -938,12 +1005,108 @@ InternalRelocateRelocationIntel64 (
   return ReturnValue;
 }
 
+/**
+  Returns whether relocation of Type consumes the following Relocation.
+  Matches the pair detection of InternalRelocateRelocationIntel64.
+
+  @param[in] Type  The Relocation's type.
+
+**/
+STATIC
+BOOLEAN
+InternalRelocationSkipsNextIntel64 (
+  IN UINT8  Type
+  )
+{
+  return Type == MachX8664RelocGot
+    || Type == MachX8664RelocGotLoad
+    || Type == MachX8664RelocSubtractor;
+}
+
+/**
+  Returns whether fixup First is to be applied after fixup Second.
+
+**/
+STATIC
+BOOLEAN
+InternalRelocationFixupGreater (
+  IN CONST PRELINKED_RELOCATION_FIXUP  *First,
+  IN CONST PRELINKED_RELOCATION_FIXUP  *Second
+  )
+{
+  if (First->Address != Second->Address) {
+    return First->Address > Second->Address;
+  }
+
+  return First->Index > Second->Index;
+}
+
+/**
+  Sorts Fixups by the address they patch with heap sort.  Linkers commonly
+  emit relocations in descending address order, which rules out insertion
+  sort.
+
+  @param[in,out] Fixups     The fixups to sort.
+  @param[in]     NumFixups  Number of fixups in Fixups.
+
+**/
+STATIC
+VOID
+InternalSortRelocationFixups (
+  IN OUT PRELINKED_RELOCATION_FIXUP  *Fixups,
+  IN     UINT32                      NumFixups
+  )
+{
+  PRELINKED_RELOCATION_FIXUP  Fixup;
+  UINT32                      Start;
+  UINT32                      End;
+  UINT32                      Root;
+  UINT32                      Child;
+
+  if (NumFixups < 2) {
+    return;
+  }
+
+  Start = NumFixups / 2;
+  End   = NumFixups;
+
+  while (End > 1) {
+    if (Start > 0) {
+      --Start;
+    } else {
+      --End;
+      CopyMem (&Fixup, &Fixups[End], sizeof (Fixup));
+      CopyMem (&Fixups[End], &Fixups[0], sizeof (Fixup));
+      CopyMem (&Fixups[0], &Fixup, sizeof (Fixup));
+    }
+
+    Root = Start;
+    while ((Child = 2 * Root + 1) < End) {
+      if (Child + 1 < End
+        && InternalRelocationFixupGreater (&Fixups[Child + 1], &Fixups[Child])) {
+        ++Child;
+      }
+
+      if (!InternalRelocationFixupGreater (&Fixups[Child], &Fixups[Root])) {
+        break;
+      }
+
+      CopyMem (&Fixup, &Fixups[Root], sizeof (Fixup));
+      CopyMem (&Fixups[Root], &Fixups[Child], sizeof (Fixup));
+      CopyMem (&Fixups[Child], &Fixup, sizeof (Fixup));
+      Root = Child;
+    }
+  }
+}
+
 /**
   Relocates all Mach-O Relocations and copies the ones to be preserved after
-  prelinking to TargetRelocations.
+  prelinking to TargetRelocations.  Relocations are applied in the order of
+  the addresses they patch rather than in file order.
 
   @param[in,out] Context            Prelinking context.
   @param[in]     Kext               KEXT prelinking context.
+  @param[in,out] Plan               Relocation plan caching symbol targets.
   @param[in]     LoadAddress        The address to be linked against.
                                     dependencies.
   @param[in]     RelocationBase     The Relocations base address.
@@ -959,29 +1122,41 @@ InternalRelocateRelocationIntel64 (
 STATIC
 BOOLEAN
 InternalRelocateAndCopyRelocations64 (
-  IN  PRELINKED_CONTEXT           *Context,
-  IN  PRELINKED_KEXT              *Kext,
-  IN  UINT64                      LoadAddress,
-  IN  UINT64                      RelocationBase,
-  IN  CONST MACH_RELOCATION_INFO  *SourceRelocations,
-  IN  OUT UINT32                  *NumRelocations,
-  OUT MACH_RELOCATION_INFO        *TargetRelocations
+  IN     PRELINKED_CONTEXT           *Context,
+  IN     PRELINKED_KEXT              *Kext,
+  IN OUT PRELINKED_RELOCATION_PLAN   *Plan,
+  IN     UINT64                      LoadAddress,
+  IN     UINT64                      RelocationBase,
+  IN     CONST MACH_RELOCATION_INFO  *SourceRelocations,
+  IN OUT UINT32                      *NumRelocations,
+  OUT    MACH_RELOCATION_INFO        *TargetRelocations
   )
 {
   UINT32                     PreservedRelocations;
 
   UINT32                     Index;
+  UINT32                     RelocationIndex;
+  UINT32                     NumFixups;
+  UINT8                      Type;
   CONST MACH_RELOCATION_INFO *NextRelocation;
   UINTN                      Result;
   MACH_RELOCATION_INFO       *Relocation;
 
   ASSERT (Kext != NULL);
+  ASSERT (Plan != NULL);
   ASSERT (SourceRelocations != NULL);
   ASSERT (NumRelocations != NULL);
   ASSERT (TargetRelocations != NULL);
+  ASSERT (*NumRelocations <= Plan->MaxFixups);
 
   PreservedRelocations = 0;
+  NumFixups            = 0;
 
+  //
+  // Plan the fixups and copy the Relocations to be preserved in file order.
+  // Whether a Relocation is preserved or pairs with the next one only
+  // depends on its type.
+  //
   for (Index = 0; Index < *NumRelocations; ++Index) {
     //
     // Assertion: Not i386.  Scattered Relocations are only supported by i386.
@@ -996,31 +1171,15 @@ InternalRelocateAndCopyRelocations64 (
       continue;
     }
 
-    NextRelocation = &SourceRelocations[Index + 1];
-    //
-    // The last Relocation does not have a successor.
-    //
-    if (Index == (*NumRelocations - 1)) {
-      NextRelocation = NULL;
-    }
-    //
-    // Relocate the relocation.
-    //
-    Result = InternalRelocateRelocationIntel64 (
-               Context,
-               Kext,
-               LoadAddress,
-               RelocationBase,
-               &SourceRelocations[Index],
-               NextRelocation
-               );
-    if (Result == MAX_UINTN) {
-      return FALSE;
-    }
+    Plan->Fixups[NumFixups].Address = RelocationBase + (UINT32) SourceRelocations[Index].Address;
+    Plan->Fixups[NumFixups].Index   = Index;
+    ++NumFixups;
+
+    Type = (UINT8) SourceRelocations[Index].Type;
     //
     // Copy the Relocation to the destination buffer if it shall be preserved.
     //
-    if ((Result & ~(UINTN)BIT31) != 0) {
+    if (MachoPreserveRelocationIntel64 (Type)) {
       Relocation = &TargetRelocations[PreservedRelocations];
 
       CopyMem (Relocation, &SourceRelocations[Index], sizeof (*Relocation));
@@ -1042,14 +1201,53 @@ InternalRelocateAndCopyRelocations64 (
       ++PreservedRelocations;
     }
     //
-    // Skip the next Relocation as instructed by
-    // InternalRelocateRelocationIntel64().
+    // Skip the next Relocation as InternalRelocateRelocationIntel64() will.
     //
-    if ((Result & BIT31) != 0) {
+    if (InternalRelocationSkipsNextIntel64 (Type)) {
       ++Index;
     }
   }
 
+  InternalSortRelocationFixups (Plan->Fixups, NumFixups);
+
+  for (Index = 0; Index < NumFixups; ++Index) {
+    RelocationIndex = Plan->Fixups[Index].Index;
+
+    NextRelocation = &SourceRelocations[RelocationIndex + 1];
+    //
+    // The last Relocation does not have a successor.
+    //
+    if (RelocationIndex == (*NumRelocations - 1)) {
+      NextRelocation = NULL;
+    }
+    //
+    // Relocate the relocation.
+    //
+    Result = InternalRelocateRelocationIntel64 (
+               Context,
+               Kext,
+               Plan,
+               LoadAddress,
+               RelocationBase,
+               &SourceRelocations[RelocationIndex],
+               NextRelocation
+               );
+    if (Result == MAX_UINTN) {
+      return FALSE;
+    }
+
+    ASSERT (
+      ((Result & BIT31) != 0)
+      == InternalRelocationSkipsNextIntel64 ((UINT8) SourceRelocations[RelocationIndex].Type)
+      );
+    ASSERT (
+      ((Result & ~(UINTN)BIT31) != 0)
+      == MachoPreserveRelocationIntel64 ((UINT8) SourceRelocations[RelocationIndex].Type)
+      );
+
+    ++Kext->NumberOfRelocationFixups;
+  }
+
   *NumRelocations = PreservedRelocations;
 
   return TRUE;
@@ -1287,6 +1485,9 @@ InternalPrelinkKext64 (
   UINT32                     KmodInfoOffset;
   KMOD_INFO_64_V1            *KmodInfo;
 
+  PRELINKED_RELOCATION_PLAN  RelocationPlan;
+  UINTN                      RelocationPlanSize;
+
   ASSERT (Context != NULL);
   ASSERT (Kext != NULL);
   ASSERT (LoadAddress != 0);
@@ -1470,6 +1671,39 @@ InternalPrelinkKext64 (
                        (UINTN)LinkEdit + RelocationsOffset
                        );
   //
+  // Plan the relocations with the symbol targets shared between local and
+  // external relocations, and fixup scratch fitting either table.
+  //
+  RelocationPlan.NumSymbols = NumSymbols;
+  RelocationPlan.MaxFixups  = MAX (
+                                DySymtab->NumOfLocalRelocations,
+                                DySymtab->NumExternalRelocations
+                                );
+
+  if (OcOverflowMulUN (NumSymbols, sizeof (*RelocationPlan.Symbols), &RelocationPlanSize)) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  RelocationPlan.Symbols = AllocateZeroPool (RelocationPlanSize);
+  if (RelocationPlan.Symbols == NULL) {
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  if (OcOverflowMulUN (RelocationPlan.MaxFixups, sizeof (*RelocationPlan.Fixups), &RelocationPlanSize)) {
+    FreePool (RelocationPlan.Symbols);
+    return RETURN_UNSUPPORTED;
+  }
+
+  RelocationPlan.Fixups = AllocatePool (MAX (RelocationPlanSize, sizeof (*RelocationPlan.Fixups)));
+  if (RelocationPlan.Fixups == NULL) {
+    FreePool (RelocationPlan.Symbols);
+    return RETURN_OUT_OF_RESOURCES;
+  }
+
+  Kext->NumberOfResolvedRelocationSymbols = 0;
+  Kext->NumberOfCachedRelocationSymbols   = 0;
+  Kext->NumberOfRelocationFixups          = 0;
+  //
   // Relocate and copy local and external relocations.
   //
   Relocations    = MachoContext->LocalRelocations;
@@ -1477,30 +1711,44 @@ InternalPrelinkKext64 (
   Result = InternalRelocateAndCopyRelocations64 (
              Context,
              Kext,
+             &RelocationPlan,
              LoadAddress,
              FirstSegment->VirtualAddress,
              Relocations,
              &NumRelocations,
              &TargetRelocation[0]
              );
-  if (!Result) {
-    return RETURN_LOAD_ERROR;
+
+  if (Result) {
+    Relocations     = MachoContext->ExternRelocations;
+    NumRelocations2 = DySymtab->NumExternalRelocations;
+    Result = InternalRelocateAndCopyRelocations64 (
+               Context,
+               Kext,
+               &RelocationPlan,
+               LoadAddress,
+               FirstSegment->VirtualAddress,
+               Relocations,
+               &NumRelocations2,
+               &TargetRelocation[NumRelocations]
+               );
   }
 
-  Relocations     = MachoContext->ExternRelocations;
-  NumRelocations2 = DySymtab->NumExternalRelocations;
-  Result = InternalRelocateAndCopyRelocations64 (
-             Context,
-             Kext,
-             LoadAddress,
-             FirstSegment->VirtualAddress,
-             Relocations,
-             &NumRelocations2,
-             &TargetRelocation[NumRelocations]
-             );
+  FreePool (RelocationPlan.Fixups);
+  FreePool (RelocationPlan.Symbols);
+
   if (!Result) {
     return RETURN_LOAD_ERROR;
   }
+
+  DEBUG ((
+    DEBUG_VERBOSE,
+    "OCAK: Relocated %a - %u symbols resolved, %u cached, %u fixups applied\n",
+    Kext->Identifier,
+    Kext->NumberOfResolvedRelocationSymbols,
+    Kext->NumberOfCachedRelocationSymbols,
+    Kext->NumberOfRelocationFixups
+    ));
   NumRelocations += NumRelocations2;
   RelocationsSize = (NumRelocations * sizeof (MACH_RELOCATION_INFO));
   //
@@ -22,6 +22,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcPerfLib.h>
 #include <Library/OcStringLib.h>
 
 #include "PrelinkedInternal.h"
@@ -67,11 +68,11 @@ PrelinkedFindLastLoadAddress (
         continue;
       }
 
-      if (LoadAddress == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_LOAD_ADDR_KEY) == 0) {
+      if (LoadAddress == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_LOAD_ADDR_KEY) == 0) {
         if (!PlistIntegerValue (KextPlistValue, &LoadAddress, sizeof (LoadAddress), TRUE)) {
           return 0;
         }
-      } else if (LoadSize == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SIZE_KEY) == 0) {
+      } else if (LoadSize == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SIZE_KEY) == 0) {
         if (!PlistIntegerValue (KextPlistValue, &LoadSize, sizeof (LoadSize), TRUE)) {
           return 0;
         }
@@ -94,54 +95,93 @@ PrelinkedFindLastLoadAddress (
   return LoadAddress;
 }
 
+STATIC
+CONST MACH_NLIST_64 *
+PrelinkedFindKmodSymbol (
+  IN OC_MACHO_CONTEXT     *ExecutableContext,
+  IN CONST MACH_NLIST_64  *Symbols,
+  IN UINT32               NumSymbols
+  )
+{
+  CONST CHAR8  *SymbolName;
+  UINT32       Index;
+
+  for (Index = 0; Index < NumSymbols; ++Index) {
+    if ((Symbols[Index].Type & MACH_N_TYPE_STAB) == 0) {
+      SymbolName = MachoGetSymbolName64 (ExecutableContext, &Symbols[Index]);
+      if (SymbolName != NULL && OcAsciiStrCmp (SymbolName, "_kmod_info") == 0) {
+        return &Symbols[Index];
+      }
+    }
+  }
+
+  return NULL;
+}
+
 STATIC
 BOOLEAN
-PrelinkedFindKmodAddress (
+PrelinkedFindKmodOffset (
   IN  OC_MACHO_CONTEXT  *ExecutableContext,
-  IN  UINT64            LoadAddress,
-  IN  UINT32            Size,
-  OUT UINT64            *Kmod
+  OUT UINT64            *KmodOffset
   )
 {
-  MACH_NLIST_64            *Symbol;
-  CONST CHAR8              *SymbolName;
-  MACH_SEGMENT_COMMAND_64  *TextSegment;
-  UINT64                   Address;
-  UINT32                   Index;
-
-  Index = 0;
-  while (TRUE) {
-    Symbol = MachoGetSymbolByIndex64 (ExecutableContext, Index);
+  CONST MACH_NLIST_64      *SymbolTable;
+  CONST MACH_NLIST_64      *ExternalSymbols;
+  CONST MACH_NLIST_64      *Symbol;
+  MACH_SEGMENT_COMMAND_64  *FirstSegment;
+  UINT32                   NumSymbols;
+  UINT32                   NumExternalSymbols;
+
+  *KmodOffset = 0;
+
+  NumSymbols = MachoGetSymbolTable (
+    ExecutableContext,
+    &SymbolTable,
+    NULL,
+    NULL,
+    NULL,
+    &ExternalSymbols,
+    &NumExternalSymbols,
+    NULL,
+    NULL
+    );
+  if (NumSymbols == 0) {
+    return TRUE;
+  }
+
+  //
+  // kmod_info is exported, so only check all symbols for unusual kexts.
+  //
+  Symbol = NULL;
+  if (NumExternalSymbols > 0) {
+    Symbol = PrelinkedFindKmodSymbol (ExecutableContext, ExternalSymbols, NumExternalSymbols);
+  }
+
+  if (Symbol == NULL) {
+    Symbol = PrelinkedFindKmodSymbol (ExecutableContext, SymbolTable, NumSymbols);
     if (Symbol == NULL) {
-      *Kmod = 0;
       return TRUE;
     }
+  }
 
-    if ((Symbol->Type & MACH_N_TYPE_STAB) == 0) {
-      SymbolName = MachoGetSymbolName64 (ExecutableContext, Symbol);
-      if (SymbolName && AsciiStrCmp (SymbolName, "_kmod_info") == 0) {
-        if (!MachoIsSymbolValueInRange64 (ExecutableContext, Symbol)) {
-          return FALSE;
-        }
-        break;
-      }
-    }
-
-    Index++;
+  if (!MachoIsSymbolValueInRange64 (ExecutableContext, Symbol)) {
+    return FALSE;
   }
 
-  TextSegment = MachoGetSegmentByName64 (ExecutableContext, "__TEXT");
-  if (TextSegment == NULL || TextSegment->FileOffset > TextSegment->VirtualAddress) {
+  if (MachoGetSegmentByName64 (ExecutableContext, "__TEXT") == NULL) {
     return FALSE;
   }
 
-  Address = TextSegment->VirtualAddress - TextSegment->FileOffset;
-  if (OcOverflowTriAddU64 (Address, LoadAddress, Symbol->Value, &Address)
-    || Address > LoadAddress + Size - sizeof (KMOD_INFO_64_V1)) {
+  //
+  // Once expanded every segment has the same difference between its address
+  // and file offset, equal to the first segment address.
+  //
+  FirstSegment = MachoGetNextSegment64 (ExecutableContext, NULL);
+  if (FirstSegment == NULL
+    || OcOverflowAddU64 (FirstSegment->VirtualAddress, Symbol->Value, KmodOffset)) {
     return FALSE;
   }
 
-  *Kmod = Address;
   return TRUE;
 }
 
@@ -237,7 +277,8 @@ PrelinkedContextInit (
     return RETURN_NOT_FOUND;
   }
 
-  Context->PrelinkedInfo = AllocateCopyPool (
+  Context->PrelinkedInfoSize = (UINT32) Context->PrelinkedInfoSection->Size;
+  Context->PrelinkedInfo     = AllocateCopyPool (
     (UINTN)Context->PrelinkedInfoSection->Size,
     &Context->Prelinked[Context->PrelinkedInfoSection->Offset]
     );
@@ -264,7 +305,7 @@ PrelinkedContextInit (
       continue;
     }
 
-    if (AsciiStrCmp (PrelinkedInfoRootKey, PRELINK_INFO_DICTIONARY_KEY) == 0) {
+    if (OcAsciiStrCmp (PrelinkedInfoRootKey, PRELINK_INFO_DICTIONARY_KEY) == 0) {
       if (PlistNodeCast (Context->KextList, PLIST_NODE_TYPE_ARRAY) != NULL) {
         Context->PrelinkedLastLoadAddress = PrelinkedFindLastLoadAddress (Context->KextList);
         if (Context->PrelinkedLastLoadAddress != 0) {
@@ -403,6 +444,87 @@ PrelinkedInjectPrepare (
   return RETURN_SUCCESS;
 }
 
+RETURN_STATUS
+PrelinkedInjectPlan (
+  IN OUT PRELINKED_CONTEXT      *Context,
+  IN     PRELINKED_KEXT_LAYOUT  *Kexts,
+  IN     UINT32                 NumKexts
+  )
+{
+  PRELINKED_KEXT_PREFLIGHT  *Preflight;
+  UINT32                    Index;
+  UINT32                    TextSize;
+  UINT32                    InfoSize;
+  UINT32                    SlotSize;
+  UINT32                    NewSize;
+  BOOLEAN                   Failed;
+
+  ASSERT (Context != NULL);
+  ASSERT (Kexts != NULL || NumKexts == 0);
+
+  //
+  // Regenerated plist keeps all the existing kexts.
+  //
+  TextSize = 0;
+  InfoSize = Context->PrelinkedInfoSize;
+  Failed   = FALSE;
+
+  for (Index = 0; Index < NumKexts && !Failed; ++Index) {
+    //
+    // Same reserve for new fields as in PrelinkedReserveKextSize.
+    //
+    Failed |= OcOverflowTriAddU32 (InfoSize, Kexts[Index].InfoPlistSize, 512, &InfoSize);
+
+    Preflight = Kexts[Index].Preflight;
+    if (Preflight == NULL) {
+      continue;
+    }
+
+    SlotSize = MACHO_ALIGN (Preflight->VmSize);
+    if (SlotSize == 0) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Failed |= OcOverflowAddU32 (Context->PrelinkedSize, TextSize, &Preflight->SlotOffset);
+    Failed |= OcOverflowAddU64 (Context->PrelinkedLastAddress, TextSize, &Preflight->SlotAddress);
+    Failed |= OcOverflowAddU64 (Context->PrelinkedLastLoadAddress, TextSize, &Preflight->SlotLoadAddress);
+    Failed |= OcOverflowAddU32 (TextSize, SlotSize, &TextSize);
+    Preflight->SlotSize = SlotSize;
+  }
+
+  Failed |= InfoSize > MAX_UINT32 - MACHO_PAGE_SIZE;
+  if (!Failed) {
+    InfoSize = MACHO_ALIGN (InfoSize);
+    Failed   = OcOverflowTriAddU32 (Context->PrelinkedSize, TextSize, InfoSize, &NewSize)
+      || NewSize > Context->PrelinkedAllocSize;
+  }
+
+  if (Failed) {
+    for (Index = 0; Index < NumKexts; ++Index) {
+      if (Kexts[Index].Preflight != NULL) {
+        Kexts[Index].Preflight->SlotSize = 0;
+      }
+    }
+
+    return RETURN_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // Grow PRELINK_TEXT once for all the slots, which are filled at injection.
+  //
+  ZeroMem (&Context->Prelinked[Context->PrelinkedSize], TextSize);
+
+  Context->PrelinkedSize                  += TextSize;
+  Context->PrelinkedLastAddress           += TextSize;
+  Context->PrelinkedLastLoadAddress       += TextSize;
+  Context->PrelinkedTextSegment->Size     += TextSize;
+  Context->PrelinkedTextSegment->FileSize += TextSize;
+  Context->PrelinkedTextSection->Size     += TextSize;
+  Context->PrelinkedInfoPlannedSize        = InfoSize;
+
+  return RETURN_SUCCESS;
+}
+
 RETURN_STATUS
 PrelinkedInjectComplete (
   IN OUT PRELINKED_CONTEXT  *Context
@@ -422,6 +544,16 @@ PrelinkedInjectComplete (
   //
   ExportedInfoSize++;
 
+  if (Context->PrelinkedInfoPlannedSize != 0
+    && MACHO_ALIGN (ExportedInfoSize) > Context->PrelinkedInfoPlannedSize) {
+    DEBUG ((
+      DEBUG_INFO,
+      "OCAK: Prelinked info %u exceeds planned %u\n",
+      ExportedInfoSize,
+      Context->PrelinkedInfoPlannedSize
+      ));
+  }
+
   if (OcOverflowAddU32 (Context->PrelinkedSize, MACHO_ALIGN (ExportedInfoSize), &NewSize)
     || NewSize > Context->PrelinkedAllocSize) {
     FreePool (ExportedInfo);
@@ -456,14 +588,41 @@ PrelinkedInjectComplete (
 }
 
 RETURN_STATUS
-PrelinkedReserveKextSize (
-  IN OUT UINT32       *ReservedSize,
-  IN     UINT32       InfoPlistSize,
-  IN     UINT8        *Executable,
-  IN     UINT32       ExecutableSize OPTIONAL
+PrelinkedPreflightKext (
+  OUT PRELINKED_KEXT_PREFLIGHT  *Preflight,
+  IN  CONST UINT8               *Executable,
+  IN  UINT32                    ExecutableSize
+  )
+{
+  ASSERT (Preflight != NULL);
+  ASSERT (Executable != NULL);
+  ASSERT (ExecutableSize > 0);
+
+  if (!MachoInitializeContext (&Preflight->MachContext, (UINT8 *) Executable, ExecutableSize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Preflight->VmSize          = MachoGetVmSize64 (&Preflight->MachContext);
+  Preflight->SlotOffset      = 0;
+  Preflight->SlotSize        = 0;
+  Preflight->SlotAddress     = 0;
+  Preflight->SlotLoadAddress = 0;
+
+  if (!PrelinkedFindKmodOffset (&Preflight->MachContext, &Preflight->KmodOffset)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+RETURN_STATUS
+PrelinkedReserveKextSizeEx (
+  IN OUT UINT32                    *ReservedSize,
+  IN     UINT32                    InfoPlistSize,
+  IN     PRELINKED_KEXT_PREFLIGHT  *Preflight OPTIONAL
   )
 {
-  OC_MACHO_CONTEXT  Context;
+  UINT32  ExecutableSize;
 
   //
   // For new fields.
@@ -473,14 +632,10 @@ PrelinkedReserveKextSize (
   }
 
   InfoPlistSize  = MACHO_ALIGN (InfoPlistSize);
+  ExecutableSize = 0;
 
-  if (Executable != NULL) {
-    ASSERT (ExecutableSize > 0);
-    if (!MachoInitializeContext (&Context, Executable, ExecutableSize)) {
-      return RETURN_INVALID_PARAMETER;
-    }
-
-    ExecutableSize = MachoGetVmSize64 (&Context);
+  if (Preflight != NULL) {
+    ExecutableSize = Preflight->VmSize;
     if (ExecutableSize == 0) {
       return RETURN_INVALID_PARAMETER;
     }
@@ -495,18 +650,40 @@ PrelinkedReserveKextSize (
 }
 
 RETURN_STATUS
-PrelinkedInjectKext (
+PrelinkedReserveKextSize (
+  IN OUT UINT32       *ReservedSize,
+  IN     UINT32       InfoPlistSize,
+  IN     UINT8        *Executable,
+  IN     UINT32       ExecutableSize OPTIONAL
+  )
+{
+  RETURN_STATUS             Status;
+  PRELINKED_KEXT_PREFLIGHT  Preflight;
+
+  if (Executable == NULL) {
+    return PrelinkedReserveKextSizeEx (ReservedSize, InfoPlistSize, NULL);
+  }
+
+  Status = PrelinkedPreflightKext (&Preflight, Executable, ExecutableSize);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  return PrelinkedReserveKextSizeEx (ReservedSize, InfoPlistSize, &Preflight);
+}
+
+STATIC
+RETURN_STATUS
+InternalPrelinkedInjectKext (
   IN OUT PRELINKED_CONTEXT  *Context,
   IN     CONST CHAR8        *BundlePath,
   IN     CONST CHAR8        *InfoPlist,
   IN     UINT32             InfoPlistSize,
-  IN     CONST CHAR8        *ExecutablePath OPTIONAL,
-  IN     CONST UINT8        *Executable OPTIONAL,
-  IN     UINT32             ExecutableSize OPTIONAL
+  IN     CONST CHAR8               *ExecutablePath OPTIONAL,
+  IN     PRELINKED_KEXT_PREFLIGHT  *Preflight OPTIONAL
   )
 {
   RETURN_STATUS     Status;
-  BOOLEAN           Result;
 
   XML_DOCUMENT      *InfoPlistDocument;
   XML_NODE          *InfoPlistRoot;
@@ -516,9 +693,14 @@ PrelinkedInjectKext (
   CONST CHAR8       *TmpKeyValue;
   UINT32            FieldCount;
   UINT32            FieldIndex;
+  UINT32            ExecutableSize;
   UINT32            NewInfoPlistSize;
   UINT32            NewPrelinkedSize;
   UINT32            AlignedExecutableSize;
+  UINT32            SlotOffset;
+  UINT32            SlotSize;
+  UINT64            SlotAddress;
+  UINT64            SlotLoadAddress;
   BOOLEAN           Failed;
   UINT64            KmodAddress;
   PRELINKED_KEXT    *PrelinkedKext;
@@ -534,40 +716,65 @@ PrelinkedInjectKext (
   //
   // Copy executable to prelinkedkernel.
   //
-  if (Executable != NULL) {
-    ASSERT (ExecutableSize > 0);
-    if (!MachoInitializeContext (&ExecutableContext, (UINT8 *)Executable, ExecutableSize)) {
-      DEBUG ((DEBUG_INFO, "OCK: Injected kext %a/%a is not a supported executable\n", BundlePath, ExecutablePath));
-      return RETURN_INVALID_PARAMETER;
+  if (Preflight != NULL) {
+    //
+    // Planned kexts go to their slot, others are appended to PRELINK_TEXT.
+    //
+    if (Preflight->SlotSize != 0) {
+      SlotOffset      = Preflight->SlotOffset;
+      SlotSize        = Preflight->SlotSize;
+      SlotAddress     = Preflight->SlotAddress;
+      SlotLoadAddress = Preflight->SlotLoadAddress;
+    } else {
+      SlotOffset      = Context->PrelinkedSize;
+      SlotSize        = Context->PrelinkedAllocSize - Context->PrelinkedSize;
+      SlotAddress     = Context->PrelinkedLastAddress;
+      SlotLoadAddress = Context->PrelinkedLastLoadAddress;
     }
 
     ExecutableSize = MachoExpandImage64 (
-      &ExecutableContext,
-      &Context->Prelinked[Context->PrelinkedSize],
-      Context->PrelinkedAllocSize - Context->PrelinkedSize,
+      &Preflight->MachContext,
+      &Context->Prelinked[SlotOffset],
+      SlotSize,
       TRUE
       );
 
     AlignedExecutableSize = MACHO_ALIGN (ExecutableSize);
 
-    if (OcOverflowAddU32 (Context->PrelinkedSize, AlignedExecutableSize, &NewPrelinkedSize)
+    if (OcOverflowAddU32 (SlotOffset, AlignedExecutableSize, &NewPrelinkedSize)
       || NewPrelinkedSize > Context->PrelinkedAllocSize
+      || AlignedExecutableSize > SlotSize
       || ExecutableSize == 0) {
       return RETURN_BUFFER_TOO_SMALL;
     }
 
-    ZeroMem (
-      &Context->Prelinked[Context->PrelinkedSize + ExecutableSize],
-      AlignedExecutableSize - ExecutableSize
-      );
+    //
+    // Planned slots are zeroed and accounted for in advance.
+    //
+    if (Preflight->SlotSize != 0) {
+      AlignedExecutableSize = SlotSize;
+    } else {
+      ZeroMem (
+        &Context->Prelinked[SlotOffset + ExecutableSize],
+        AlignedExecutableSize - ExecutableSize
+        );
+    }
 
-    if (!MachoInitializeContext (&ExecutableContext, &Context->Prelinked[Context->PrelinkedSize], ExecutableSize)) {
+    if (!MachoInitializeContext (&ExecutableContext, &Context->Prelinked[SlotOffset], ExecutableSize)) {
       return RETURN_INVALID_PARAMETER;
     }
 
-    Result = PrelinkedFindKmodAddress (&ExecutableContext, Context->PrelinkedLastLoadAddress, ExecutableSize, &KmodAddress);
-    if (!Result) {
-      return RETURN_INVALID_PARAMETER;
+    //
+    // kmod_info offset was resolved by the preflight, so only verify that
+    // the structure fits the expanded image.
+    //
+    KmodAddress = 0;
+    if (Preflight->KmodOffset != 0) {
+      if (ExecutableSize < sizeof (KMOD_INFO_64_V1)
+        || Preflight->KmodOffset > ExecutableSize - sizeof (KMOD_INFO_64_V1)
+        || OcOverflowAddU64 (SlotLoadAddress, Preflight->KmodOffset, &KmodAddress)) {
+        return RETURN_INVALID_PARAMETER;
+      }
     }
   }
 
@@ -598,7 +805,7 @@ PrelinkedInjectKext (
   // code in debug mode to diagnose it.
   //
   DEBUG_CODE_BEGIN ();
-  if (Executable == NULL) {
+  if (Preflight == NULL) {
     FieldCount = PlistDictChildren (InfoPlistRoot);
     for (FieldIndex = 0; FieldIndex < FieldCount; ++FieldIndex) {
       TmpKeyValue = PlistKeyValue (PlistDictChild (InfoPlistRoot, FieldIndex, NULL));
@@ -606,7 +813,7 @@ PrelinkedInjectKext (
         continue;
       }
 
-      if (AsciiStrCmp (TmpKeyValue, INFO_BUNDLE_EXECUTABLE_KEY) == 0) {
+      if (OcAsciiStrCmp (TmpKeyValue, INFO_BUNDLE_EXECUTABLE_KEY) == 0) {
         DEBUG ((DEBUG_ERROR, "OCK: Plist-only kext has %a key\n", INFO_BUNDLE_EXECUTABLE_KEY));
         ASSERT (FALSE);
         CpuDeadLoop ();
@@ -618,13 +825,13 @@ PrelinkedInjectKext (
   Failed = FALSE;
   Failed |= XmlNodeAppend (InfoPlistRoot, "key", NULL, PRELINK_INFO_BUNDLE_PATH_KEY) == NULL;
   Failed |= XmlNodeAppend (InfoPlistRoot, "string", NULL, BundlePath) == NULL;
-  if (Executable != NULL) {
+  if (Preflight != NULL) {
     Failed |= XmlNodeAppend (InfoPlistRoot, "key", NULL, PRELINK_INFO_EXECUTABLE_RELATIVE_PATH_KEY) == NULL;
     Failed |= XmlNodeAppend (InfoPlistRoot, "string", NULL, ExecutablePath) == NULL;
-    Failed |= !AsciiUint64ToLowerHex (ExecutableSourceAddrStr, sizeof (ExecutableSourceAddrStr), Context->PrelinkedLastAddress);
+    Failed |= !AsciiUint64ToLowerHex (ExecutableSourceAddrStr, sizeof (ExecutableSourceAddrStr), SlotAddress);
     Failed |= XmlNodeAppend (InfoPlistRoot, "key", NULL, PRELINK_INFO_EXECUTABLE_SOURCE_ADDR_KEY) == NULL;
     Failed |= XmlNodeAppend (InfoPlistRoot, "integer", PRELINK_INFO_INTEGER_ATTRIBUTES, ExecutableSourceAddrStr) == NULL;
-    Failed |= !AsciiUint64ToLowerHex (ExecutableLoadAddrStr, sizeof (ExecutableLoadAddrStr), Context->PrelinkedLastLoadAddress);
+    Failed |= !AsciiUint64ToLowerHex (ExecutableLoadAddrStr, sizeof (ExecutableLoadAddrStr), SlotLoadAddress);
     Failed |= XmlNodeAppend (InfoPlistRoot, "key", NULL, PRELINK_INFO_EXECUTABLE_LOAD_ADDR_KEY) == NULL;
     Failed |= XmlNodeAppend (InfoPlistRoot, "integer", PRELINK_INFO_INTEGER_ATTRIBUTES, ExecutableLoadAddrStr) == NULL;
     Failed |= !AsciiUint64ToLowerHex (ExecutableSizeStr, sizeof (ExecutableSizeStr), AlignedExecutableSize);
@@ -641,14 +848,20 @@ PrelinkedInjectKext (
     return RETURN_OUT_OF_RESOURCES;
   }
 
-  if (Executable != NULL) {
+  if (Preflight != NULL) {
+    OcPerfBegin (OC_PERF_PHASE_KEXT_LINK);
     PrelinkedKext = InternalLinkPrelinkedKext (
       Context,
       &ExecutableContext,
       InfoPlistRoot,
-      Context->PrelinkedLastLoadAddress,
+      SlotLoadAddress,
       KmodAddress
       );
+    OcPerfEnd (
+      OC_PERF_PHASE_KEXT_LINK,
+      ExecutableSize,
+      PrelinkedKext != NULL ? EFI_SUCCESS : EFI_INVALID_PARAMETER
+      );
 
     if (PrelinkedKext == NULL) {
       XmlDocumentFree (InfoPlistDocument);
@@ -660,12 +873,14 @@ PrelinkedInjectKext (
     // XNU assumes that load size and source size are same, so we should append
     // whatever is bigger to all sizes.
     //
-    Context->PrelinkedSize                  += AlignedExecutableSize;
-    Context->PrelinkedLastAddress           += AlignedExecutableSize;
-    Context->PrelinkedLastLoadAddress       += AlignedExecutableSize;
-    Context->PrelinkedTextSegment->Size     += AlignedExecutableSize;
-    Context->PrelinkedTextSegment->FileSize += AlignedExecutableSize;
-    Context->PrelinkedTextSection->Size     += AlignedExecutableSize;
+    if (Preflight->SlotSize == 0) {
+      Context->PrelinkedSize                  += AlignedExecutableSize;
+      Context->PrelinkedLastAddress           += AlignedExecutableSize;
+      Context->PrelinkedLastLoadAddress       += AlignedExecutableSize;
+      Context->PrelinkedTextSegment->Size     += AlignedExecutableSize;
+      Context->PrelinkedTextSegment->FileSize += AlignedExecutableSize;
+      Context->PrelinkedTextSection->Size     += AlignedExecutableSize;
+    }
   }
 
   //
@@ -708,3 +923,73 @@ PrelinkedInjectKext (
 
   return RETURN_SUCCESS;
 }
+
+RETURN_STATUS
+PrelinkedInjectKext (
+  IN OUT PRELINKED_CONTEXT  *Context,
+  IN     CONST CHAR8        *BundlePath,
+  IN     CONST CHAR8        *InfoPlist,
+  IN     UINT32             InfoPlistSize,
+  IN     CONST CHAR8        *ExecutablePath OPTIONAL,
+  IN     CONST UINT8        *Executable OPTIONAL,
+  IN     UINT32             ExecutableSize OPTIONAL
+  )
+{
+  RETURN_STATUS             Status;
+  PRELINKED_KEXT_PREFLIGHT  Preflight;
+
+  OcPerfBegin (OC_PERF_PHASE_KEXT_INJECT);
+
+  Status = RETURN_SUCCESS;
+  if (Executable != NULL) {
+    Status = PrelinkedPreflightKext (&Preflight, Executable, ExecutableSize);
+    if (RETURN_ERROR (Status)) {
+      DEBUG ((DEBUG_INFO, "OCK: Injected kext %a/%a is not a supported executable\n", BundlePath, ExecutablePath));
+    }
+  }
+
+  if (!RETURN_ERROR (Status)) {
+    Status = InternalPrelinkedInjectKext (
+      Context,
+      BundlePath,
+      InfoPlist,
+      InfoPlistSize,
+      ExecutablePath,
+      Executable != NULL ? &Preflight : NULL
+      );
+  }
+
+  OcPerfEnd (OC_PERF_PHASE_KEXT_INJECT, InfoPlistSize + ExecutableSize, Status);
+
+  return Status;
+}
+
+RETURN_STATUS
+PrelinkedInjectKextEx (
+  IN OUT PRELINKED_CONTEXT         *Context,
+  IN     CONST CHAR8               *BundlePath,
+  IN     CONST CHAR8               *InfoPlist,
+  IN     UINT32                    InfoPlistSize,
+  IN     CONST CHAR8               *ExecutablePath OPTIONAL,
+  IN     PRELINKED_KEXT_PREFLIGHT  *Preflight OPTIONAL
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         ExecutableSize;
+
+  OcPerfBegin (OC_PERF_PHASE_KEXT_INJECT);
+
+  Status = InternalPrelinkedInjectKext (
+    Context,
+    BundlePath,
+    InfoPlist,
+    InfoPlistSize,
+    ExecutablePath,
+    Preflight
+    );
+
+  ExecutableSize = Preflight != NULL ? MachoGetFileSize (&Preflight->MachContext) : 0;
+  OcPerfEnd (OC_PERF_PHASE_KEXT_INJECT, InfoPlistSize + ExecutableSize, Status);
+
+  return Status;
+}
@@ -121,6 +121,13 @@ struct PRELINKED_KEXT_ {
   // Scanned vtable buffer. Iterated with GET_NEXT_PRELINKED_VTABLE.
   //
   PRELINKED_VTABLE         *LinkedVtables;
+  //
+  // Relocation statistics of the last link: distinct symbol targets
+  // resolved, repeated references served from the cache and fixups applied.
+  //
+  UINT32                   NumberOfResolvedRelocationSymbols;
+  UINT32                   NumberOfCachedRelocationSymbols;
+  UINT32                   NumberOfRelocationFixups;
 };
 
 //
@@ -266,7 +273,7 @@ STATIC_ASSERT (
   );
 
 typedef struct {
-  CONST MACH_NLIST_64 *Smcp;
+  CONST MACHO_CXX_CLASS *Class;
   CONST MACH_NLIST_64 *Vtable;
   UINT64              *VtableData;
   CONST MACH_NLIST_64 *MetaVtable;
@@ -20,6 +20,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcStringLib.h>
 #include <Library/OcXmlLib.h>
 
 #include "PrelinkedInternal.h"
@@ -75,25 +76,25 @@ InternalCreatePrelinkedKext (
       continue;
     }
 
-    if (KextIdentifier == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_IDENTIFIER_KEY) == 0) {
+    if (KextIdentifier == NULL && OcAsciiStrCmp (KextPlistKey, INFO_BUNDLE_IDENTIFIER_KEY) == 0) {
       KextIdentifier = XmlNodeContent (KextPlistValue);
       if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_STRING) == NULL || KextIdentifier == NULL) {
         break;
       }
-      if (!Found && AsciiStrCmp (KextIdentifier, Identifier) == 0) {
+      if (!Found && OcAsciiStrCmp (KextIdentifier, Identifier) == 0) {
         Found = TRUE;
       }
-    } else if (BundleLibraries == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_LIBRARIES_KEY) == 0) {
+    } else if (BundleLibraries == NULL && OcAsciiStrCmp (KextPlistKey, INFO_BUNDLE_LIBRARIES_KEY) == 0) {
       if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_DICT) == NULL) {
         break;
       }
       BundleLibraries = KextPlistValue;
-    } else if (BundleLibraries64 == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_LIBRARIES_64_KEY) == 0) {
+    } else if (BundleLibraries64 == NULL && OcAsciiStrCmp (KextPlistKey, INFO_BUNDLE_LIBRARIES_64_KEY) == 0) {
       if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_DICT) == NULL) {
         break;
       }
       BundleLibraries64 = BundleLibraries = KextPlistValue;
-    } else if (CompatibleVersion == NULL && AsciiStrCmp (KextPlistKey, INFO_BUNDLE_COMPATIBLE_VERSION_KEY) == 0) {
+    } else if (CompatibleVersion == NULL && OcAsciiStrCmp (KextPlistKey, INFO_BUNDLE_COMPATIBLE_VERSION_KEY) == 0) {
       if (PlistNodeCast (KextPlistValue, PLIST_NODE_TYPE_STRING) == NULL) {
         break;
       }
@@ -101,19 +102,19 @@ InternalCreatePrelinkedKext (
       if (CompatibleVersion == NULL) {
         break;
       }
-    } else if (Prelinked != NULL && VirtualBase == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_LOAD_ADDR_KEY) == 0) {
+    } else if (Prelinked != NULL && VirtualBase == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_LOAD_ADDR_KEY) == 0) {
       if (!PlistIntegerValue (KextPlistValue, &VirtualBase, sizeof (VirtualBase), TRUE)) {
         break;
       }
-    } else if (Prelinked != NULL && VirtualKmod == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_KMOD_INFO_KEY) == 0) {
+    } else if (Prelinked != NULL && VirtualKmod == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_KMOD_INFO_KEY) == 0) {
       if (!PlistIntegerValue (KextPlistValue, &VirtualKmod, sizeof (VirtualKmod), TRUE)) {
         break;
       }
-    } else if (Prelinked != NULL && SourceBase == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SOURCE_ADDR_KEY) == 0) {
+    } else if (Prelinked != NULL && SourceBase == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SOURCE_ADDR_KEY) == 0) {
       if (!PlistIntegerValue (KextPlistValue, &SourceBase, sizeof (SourceBase), TRUE)) {
         break;
       }
-    } else if (Prelinked != NULL && SourceSize == 0 && AsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SIZE_KEY) == 0) {
+    } else if (Prelinked != NULL && SourceSize == 0 && OcAsciiStrCmp (KextPlistKey, PRELINK_INFO_EXECUTABLE_SIZE_KEY) == 0) {
       if (!PlistIntegerValue (KextPlistValue, &SourceSize, sizeof (SourceSize), TRUE)) {
         break;
       }
@@ -294,12 +295,12 @@ InternalScanBuildLinkedSymbolTable (
     if (!Result) {
       WalkerBottom->Value  = Symbol->Value;
       WalkerBottom->Name   = Kext->StringTable + Symbol->UnifiedName.StringIndex;
-      WalkerBottom->Length = (UINT32)AsciiStrLen (WalkerBottom->Name);
+      WalkerBottom->Length = (UINT32)OcAsciiStrLen (WalkerBottom->Name);
       ++WalkerBottom;
     } else {
       WalkerTop->Value  = Symbol->Value;
       WalkerTop->Name   = Kext->StringTable + Symbol->UnifiedName.StringIndex;
-      WalkerTop->Length = (UINT32)AsciiStrLen (WalkerTop->Name);
+      WalkerTop->Length = (UINT32)OcAsciiStrLen (WalkerTop->Name);
       --WalkerTop;
 
       ++NumCxxSymbols;
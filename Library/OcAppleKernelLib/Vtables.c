@@ -18,6 +18,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <IndustryStandard/AppleMachoImage.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcAppleKernelLib.h>
@@ -551,38 +552,36 @@ InternalInitializeVtablePatchData (
   return FALSE;
 }
 
+STATIC
 BOOLEAN
-InternalPatchByVtables64 (
+InternalPatchByVtablesWorker64 (
   IN     PRELINKED_CONTEXT         *Context,
-  IN OUT PRELINKED_KEXT            *Kext
+  IN OUT PRELINKED_KEXT            *Kext,
+  IN     CONST MACHO_CXX_CLASS     *Classes,
+  IN     UINT32                    NumClasses
   )
 {
   OC_VTABLE_PATCH_ENTRY *Entries;
   OC_VTABLE_PATCH_ENTRY *EntryWalker;
   UINT32                MaxSize;
 
-  OC_MACHO_CONTEXT     *MachoContext;
-  CONST MACH_HEADER_64 *MachHeader;
-  UINT32               Index;
-  UINT32               NumTables;
-  UINT32               NumEntries;
-  UINT32               NumEntriesTemp;
-  UINT32               NumPatched;
-  BOOLEAN              Result;
-  CONST MACH_NLIST_64  *Smcp;
-  CONST CHAR8          *Name;
-  CONST MACH_NLIST_64  *MetaClass;
+  OC_MACHO_CONTEXT       *MachoContext;
+  UINT32                 Index;
+  UINT32                 NumTables;
+  UINT32                 NumEntries;
+  UINT32                 NumEntriesTemp;
+  UINT32                 NumPatched;
+  BOOLEAN                Result;
+  CONST MACHO_CXX_CLASS  *Class;
+  CONST MACHO_CXX_CLASS  *SuperClass;
   CONST PRELINKED_VTABLE *SuperVtable;
   CONST PRELINKED_VTABLE *MetaVtable;
-  CONST VOID           *OcSymbolDummy;
-  MACH_NLIST_64        *SymbolDummy;
-  CHAR8                ClassName[SYM_MAX_NAME_LEN];
-  CHAR8                SuperClassName[SYM_MAX_NAME_LEN];
-  CHAR8                VtableName[SYM_MAX_NAME_LEN];
-  CHAR8                SuperVtableName[SYM_MAX_NAME_LEN];
-  CHAR8                FinalSymbolName[SYM_MAX_NAME_LEN];
-  BOOLEAN              SuccessfulIteration;
-  PRELINKED_VTABLE     *CurrentVtable;
+  CONST VOID             *OcSymbolDummy;
+  CHAR8                  SuperClassName[SYM_MAX_NAME_LEN];
+  CHAR8                  SuperVtableName[SYM_MAX_NAME_LEN];
+  CHAR8                  FinalSymbolName[SYM_MAX_NAME_LEN];
+  BOOLEAN                SuccessfulIteration;
+  PRELINKED_VTABLE       *CurrentVtable;
   //
   // LinkBuffer is at least as big as __LINKEDIT, so it can store all symbols.
   //
@@ -590,80 +589,71 @@ InternalPatchByVtables64 (
   MaxSize = Context->LinkBufferSize;
 
   MachoContext = &Kext->Context.MachContext;
-
-  MachHeader = MachoGetMachHeader64 (MachoContext);
-  ASSERT (MachHeader != NULL);
   //
-  // Retrieve all SMCPs.
+  // Retrieve all classes with SMCPs.
   //
   EntryWalker = Entries;
   NumTables   = 0;
   NumEntries  = 0;
 
-  for (
-    Index = 0;
-    (Smcp = MachoGetSymbolByIndex64 (MachoContext, Index)) != NULL;
-    ++Index
-    ) {
-    Name = MachoGetSymbolName64 (MachoContext, Smcp);
-    if (((Smcp->Type & MACH_N_TYPE_STAB) == 0)
-     && MachoSymbolNameIsSmcp64 (MachoContext, Name)) {
-      if (MaxSize < sizeof (*EntryWalker)) {
-        return FALSE;
-      }
-      //
-      // We walk over the super metaclass pointer symbols because classes
-      // with them are the only ones that need patching.  Then we double the
-      // number of vtables we're expecting, because every pointer will have a
-      // class vtable and a MetaClass vtable.
-      //
-      Result = MachoGetVtableSymbolsFromSmcp64 (
-                 MachoContext,
-                 Name,
-                 &EntryWalker->Vtable,
-                 &EntryWalker->MetaVtable
-                 );
-      if (!Result) {
-        return FALSE;
-      }
+  for (Index = 0; Index < NumClasses; ++Index) {
+    Class = &Classes[Index];
+    //
+    // We walk over the super metaclass pointer symbols because classes
+    // with them are the only ones that need patching.  Then we double the
+    // number of vtables we're expecting, because every pointer will have a
+    // class vtable and a MetaClass vtable.
+    //
+    if (Class->Smcp == NULL) {
+      continue;
+    }
 
-      EntryWalker->Smcp = Smcp;
+    if ((Class->Vtable == NULL) || (Class->MetaVtable == NULL)) {
+      return FALSE;
+    }
 
-      Result = InternalInitializeVtablePatchData (
-                 MachoContext,
-                 EntryWalker->Vtable,
-                 &MaxSize,
-                 &EntryWalker->VtableData,
-                 &NumEntriesTemp,
-                 &EntryWalker->MetaSymsIndex,
-                 EntryWalker->SolveSymbols
-                 );
-      if (!Result) {
-        return FALSE;
-      }
+    if (MaxSize < sizeof (*EntryWalker)) {
+      return FALSE;
+    }
 
-      NumEntries += NumEntriesTemp;
+    EntryWalker->Class      = Class;
+    EntryWalker->Vtable     = Class->Vtable;
+    EntryWalker->MetaVtable = Class->MetaVtable;
+
+    Result = InternalInitializeVtablePatchData (
+               MachoContext,
+               EntryWalker->Vtable,
+               &MaxSize,
+               &EntryWalker->VtableData,
+               &NumEntriesTemp,
+               &EntryWalker->MetaSymsIndex,
+               EntryWalker->SolveSymbols
+               );
+    if (!Result) {
+      return FALSE;
+    }
 
-      Result = InternalInitializeVtablePatchData (
-                 MachoContext,
-                 EntryWalker->MetaVtable,
-                 &MaxSize,
-                 &EntryWalker->MetaVtableData,
-                 &NumEntriesTemp,
-                 &EntryWalker->NumSolveSymbols,
-                 &EntryWalker->SolveSymbols[EntryWalker->MetaSymsIndex]
-                 );
-      if (!Result) {
-        return FALSE;
-      }
+    NumEntries += NumEntriesTemp;
+
+    Result = InternalInitializeVtablePatchData (
+               MachoContext,
+               EntryWalker->MetaVtable,
+               &MaxSize,
+               &EntryWalker->MetaVtableData,
+               &NumEntriesTemp,
+               &EntryWalker->NumSolveSymbols,
+               &EntryWalker->SolveSymbols[EntryWalker->MetaSymsIndex]
+               );
+    if (!Result) {
+      return FALSE;
+    }
 
-      NumEntries += NumEntriesTemp;
+    NumEntries += NumEntriesTemp;
 
-      EntryWalker->NumSolveSymbols += EntryWalker->MetaSymsIndex;
-      ++NumTables;
+    EntryWalker->NumSolveSymbols += EntryWalker->MetaSymsIndex;
+    ++NumTables;
 
-      EntryWalker = GET_NEXT_OC_VTABLE_PATCH_ENTRY (EntryWalker);
-    }
+    EntryWalker = GET_NEXT_OC_VTABLE_PATCH_ENTRY (EntryWalker);
   }
   //
   // One structure contains two VTables, hence (NumTables * 2).
@@ -690,65 +680,25 @@ InternalPatchByVtables64 (
       Index < NumTables;
       ++Index, EntryWalker = GET_NEXT_OC_VTABLE_PATCH_ENTRY (EntryWalker)
       ) {
-      Smcp = EntryWalker->Smcp;
-      if (Smcp == NULL) {
+      Class = EntryWalker->Class;
+      if (Class == NULL) {
         continue;
       }
-
-      Name = MachoGetSymbolName64 (MachoContext, Smcp);
-      //
-      // We walk over the super metaclass pointer symbols because classes
-      // with them are the only ones that need patching.  Then we double the
-      // number of vtables we're expecting, because every pointer will have a
-      // class vtable and a MetaClass vtable.
-      //
-      ASSERT (MachoSymbolNameIsSmcp64 (MachoContext, Name));
       //
-      // Get the class name from the smc pointer
+      // The super class is retrieved from the SMCP's meta class symbol.
       //
-      Result = MachoGetClassNameFromSuperMetaClassPointer (
-                 MachoContext,
-                 Name,
-                 sizeof (ClassName),
-                 ClassName
-                 );
-      if (!Result) {
-        return FALSE;
-      }
-      //
-      // Get the vtable name from the class name
-      //
-      Result = MachoGetVtableNameFromClassName (
-                 ClassName,
-                 sizeof (VtableName),
-                 VtableName
-                 );
-      if (!Result) {
-        return FALSE;
-      }
-      //
-      // Find the SMCP's meta class symbol
-      //
-      MetaClass = MachoGetMetaclassSymbolFromSmcpSymbol64 (
-                    MachoContext,
-                    Smcp
-                    );
-      if (MetaClass == NULL) {
-        return FALSE;
-      }
-      //
-      // Get the super class name from the super metaclass
-      //
-      Result = MachoGetClassNameFromMetaClassPointer (
-                 MachoContext,
-                 MachoGetSymbolName64 (MachoContext, MetaClass),
-                 sizeof (SuperClassName),
-                 SuperClassName
-                 );
-      if (!Result) {
+      if ((Class->SuperMetaClass == NULL)
+       || (Class->SuperClassNameLength >= sizeof (SuperClassName))) {
         return FALSE;
       }
 
+      CopyMem (
+        SuperClassName,
+        Class->SuperClassName,
+        Class->SuperClassNameLength
+        );
+      SuperClassName[Class->SuperClassNameLength] = '\0';
+
       Result = MachoGetVtableNameFromClassName (
         SuperClassName,
         sizeof (SuperVtableName),
@@ -795,11 +745,13 @@ InternalPatchByVtables64 (
         return FALSE;
       }
 
-      SymbolDummy = MachoGetLocalDefinedSymbolByName (
-                  MachoContext,
-                  FinalSymbolName
-                  );
-      if (SymbolDummy != NULL) {
+      SuperClass = MachoGetCxxClass (
+                     Classes,
+                     NumClasses,
+                     Class->SuperClassName,
+                     Class->SuperClassNameLength
+                     );
+      if ((SuperClass != NULL) && (SuperClass->FinalSymbol != NULL)) {
         return FALSE;
       }
       //
@@ -821,21 +773,12 @@ InternalPatchByVtables64 (
 
       CurrentVtable = GET_NEXT_PRELINKED_VTABLE (CurrentVtable);
       //
-      // Get the meta vtable name from the class name
+      // The meta vtable name is the one of the class's meta vtable symbol.
       //
-      Result = MachoGetMetaVtableNameFromClassName (
-                 ClassName,
-                 sizeof (VtableName),
-                 VtableName
-                 );
-      if (!Result) {
-        return FALSE;
-      }
-
       MetaVtable = InternalGetOcVtableByName (
                      Context,
                      Kext,
-                     VtableName
+                     MachoGetSymbolName64 (MachoContext, EntryWalker->MetaVtable)
                      );
       if (MetaVtable != NULL) {
         return FALSE;
@@ -877,7 +820,7 @@ InternalPatchByVtables64 (
 
       Kext->NumberOfVtables += 2;
 
-      EntryWalker->Smcp = NULL;
+      EntryWalker->Class = NULL;
 
       ++NumPatched;
       SuccessfulIteration = TRUE;
@@ -893,3 +836,61 @@ InternalPatchByVtables64 (
 
   return TRUE;
 }
+
+BOOLEAN
+InternalPatchByVtables64 (
+  IN     PRELINKED_CONTEXT         *Context,
+  IN OUT PRELINKED_KEXT            *Kext
+  )
+{
+  OC_MACHO_CONTEXT      *MachoContext;
+  CONST MACH_NLIST_64   *SymbolTable;
+  MACHO_CXX_CLASS       *Classes;
+  UINT32                NumSymbols;
+  UINT32                NumClasses;
+  BOOLEAN               Result;
+
+  MachoContext = &Kext->Context.MachContext;
+  //
+  // Collect the class metadata once, so that patching does not need to
+  // synthesize names and scan the symbol table for every class.
+  //
+  NumSymbols = MachoGetSymbolTable (
+                 MachoContext,
+                 &SymbolTable,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL,
+                 NULL
+                 );
+  if (NumSymbols == 0) {
+    return InternalPatchByVtablesWorker64 (Context, Kext, NULL, 0);
+  }
+
+  Classes = AllocatePool (NumSymbols * sizeof (*Classes));
+  if (Classes == NULL) {
+    return FALSE;
+  }
+
+  Result = MachoBuildCxxClassTable64 (
+             MachoContext,
+             NumSymbols,
+             Classes,
+             &NumClasses
+             );
+  if (Result) {
+    Result = InternalPatchByVtablesWorker64 (
+               Context,
+               Kext,
+               Classes,
+               NumClasses
+               );
+  }
+
+  FreePool (Classes);
+
+  return Result;
+}
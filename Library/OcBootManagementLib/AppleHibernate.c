@@ -39,7 +39,6 @@ OcActivateHibernateWake (
   AppleRTCHibernateVars    RtcVars;
   BOOLEAN                  HasHibernateInfo;
   BOOLEAN                  HasHibernateInfoInRTC;
-  UINT8                    Index;
   UINT8                    *RtcRawVars;
   EFI_DEVICE_PATH_PROTOCOL *BootImagePath;
   EFI_DEVICE_PATH_PROTOCOL *RemainingPath;
@@ -51,6 +50,7 @@ OcActivateHibernateWake (
 
   HasHibernateInfo = FALSE;
   HasHibernateInfoInRTC = FALSE;
+  RtcRawVars = (UINT8 *) &RtcVars;
 
   //
   // If legacy boot-switch-vars exists (NVRAM working), then use it.
@@ -119,10 +119,7 @@ OcActivateHibernateWake (
   // Work with RTC memory if allowed.
   //
   if (HibernateMask & HIBERNATE_MODE_RTC) {
-    RtcRawVars = (UINT8 *) &RtcVars;
-    for (Index = 0; Index < sizeof (AppleRTCHibernateVars); Index++) {
-      RtcRawVars[Index] = OcRtcRead (Index + 128);
-    }
+    OcRtcReadBlock (128, sizeof (AppleRTCHibernateVars), RtcRawVars);
 
     HasHibernateInfoInRTC = RtcVars.signature[0] == 'A'
                          && RtcVars.signature[1] == 'A'
@@ -201,9 +198,7 @@ OcActivateHibernateWake (
     RtcVars.signature[2] = 'A';
     RtcVars.signature[3] = 'D';
 
-    for (Index = 0; Index < sizeof(AppleRTCHibernateVars); Index++) {
-      OcRtcWrite (Index + 128, RtcRawVars[Index]);
-    }
+    OcRtcWriteBlock (128, sizeof (AppleRTCHibernateVars), RtcRawVars, FALSE);
   }
 
   //
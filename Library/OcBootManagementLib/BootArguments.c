@@ -18,6 +18,7 @@
 #include <Library/DebugLib.h>
 #include <Library/OcBootManagementLib.h>
 #include <Library/OcMiscLib.h>
+#include <Library/OcStringLib.h>
 #include <Library/UefiLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
@@ -74,7 +75,7 @@ OcGetArgumentFromCmd (
 {
   CHAR8 *Str;
 
-  Str = AsciiStrStr (CommandLine, Argument);
+  Str = OcAsciiStrStr (CommandLine, Argument);
 
   //
   // Invalidate found boot arg if:
@@ -101,7 +102,7 @@ OcRemoveArgumentFromCmd (
   Match = NULL;
 
   do {
-    Match = AsciiStrStr (CommandLine, Argument);
+    Match = OcAsciiStrStr (CommandLine, Argument);
     if (Match && (Match == CommandLine || *(Match - 1) == ' ')) {
       while (*Match != ' ' && *Match != '\0') {
         *Match++ = ' ';
@@ -168,23 +168,13 @@ InternalGetRecoveryOsBooter (
   )
 {
   EFI_STATUS                       Status;
-  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
   EFI_FILE_PROTOCOL                *Root;
   EFI_FILE_PROTOCOL                *Recovery;
   UINTN                            FilePathSize;
   EFI_DEVICE_PATH_PROTOCOL         *TmpPath;
   UINTN                            TmpPathSize;
 
-  Status = gBS->HandleProtocol (
-    Device,
-    &gEfiSimpleFileSystemProtocolGuid,
-    (VOID **) &FileSystem
-    );
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Status = FileSystem->OpenVolume (FileSystem, &Root);
+  Status = OcFileCacheOpenVolume (Device, &Root);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -403,7 +393,7 @@ InternalPrepareScanInfo (
     Status = EFI_NOT_FOUND;
 
     if (Context->NumCustomBootPaths > 0) {
-      Status = SimpleFs->OpenVolume (SimpleFs, &Root);
+      Status = OcFileCacheOpenVolume (DevPathScanInfo->Device, &Root);
       if (!EFI_ERROR (Status)) {
         Status = OcGetBooterFromPredefinedNameList (
                    DevPathScanInfo->Device,
@@ -22,6 +22,7 @@
 #include <Library/OcBootManagementLib.h>
 #include <Library/OcDevicePathLib.h>
 #include <Library/OcFileLib.h>
+#include <Library/OcPerfLib.h>
 #include <Library/OcStringLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
@@ -173,8 +174,9 @@ OcFreeBootEntries (
   FreePool (BootEntries);
 }
 
+STATIC
 EFI_STATUS
-OcScanForBootEntries (
+InternalOcScanForBootEntries (
   IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
   IN  OC_PICKER_CONTEXT           *Context,
   OUT OC_BOOT_ENTRY               **BootEntries,
@@ -444,6 +446,40 @@ OcScanForBootEntries (
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+OcScanForBootEntries (
+  IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
+  IN  OC_PICKER_CONTEXT           *Context,
+  OUT OC_BOOT_ENTRY               **BootEntries,
+  OUT UINTN                       *Count,
+  OUT UINTN                       *AllocCount OPTIONAL,
+  IN  BOOLEAN                     Describe
+  )
+{
+  EFI_STATUS  Status;
+
+  OcPerfBegin (OC_PERF_PHASE_SCAN);
+
+  //
+  // Every scan starts with fresh directory listings, which are then shared
+  // by boot policy, recovery and custom path lookups on each volume.
+  //
+  OcFileCacheInvalidate (NULL);
+
+  Status = InternalOcScanForBootEntries (
+    BootPolicy,
+    Context,
+    BootEntries,
+    Count,
+    AllocCount,
+    Describe
+    );
+
+  OcPerfEnd (OC_PERF_PHASE_SCAN, EFI_ERROR (Status) ? 0 : (UINT32) *Count, Status);
+
+  return Status;
+}
+
 EFI_STATUS
 OcLoadBootEntry (
   IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
@@ -108,38 +108,32 @@ InternalGetFirstDeviceBootFilePath (
 }
 
 STATIC
-EFI_DEVICE_PATH_PROTOCOL *
-InternalGetDiskImageBootFile (
-  OUT INTERNAL_DMG_LOAD_CONTEXT   *Context,
-  IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
+BOOLEAN
+InternalVerifyDmgChunklist (
   IN  UINT32                      Policy,
-  IN  UINTN                       DmgFileSize,
   IN  VOID                        *ChunklistBuffer OPTIONAL,
-  IN  UINT32                      ChunklistBufferSize OPTIONAL
+  IN  UINT32                      ChunklistBufferSize OPTIONAL,
+  OUT OC_APPLE_CHUNKLIST_CONTEXT  *ChunklistContext,
+  OUT BOOLEAN                     *VerifyData
   )
 {
-  EFI_DEVICE_PATH_PROTOCOL       *DevPath;
-
   BOOLEAN                        Result;
-  OC_APPLE_CHUNKLIST_CONTEXT     ChunklistContext;
 
-  CONST EFI_DEVICE_PATH_PROTOCOL *DmgDevicePath;
-  UINTN                          DmgDevicePathSize;
+  ASSERT (ChunklistContext != NULL);
+  ASSERT (VerifyData != NULL);
 
-  ASSERT (Context != NULL);
-  ASSERT (BootPolicy != NULL);
-  ASSERT (DmgFileSize > 0);
+  *VerifyData = FALSE;
 
   if (ChunklistBuffer == NULL) {
     if ((Policy & OC_LOAD_REQUIRE_APPLE_SIGN) != 0) {
       DEBUG ((DEBUG_WARN, "Missing DMG signature, aborting\n"));
-      return NULL;
+      return FALSE;
     }
   } else if ((Policy & (OC_LOAD_VERIFY_APPLE_SIGN | OC_LOAD_REQUIRE_TRUSTED_KEY)) != 0) {
     ASSERT (ChunklistBufferSize > 0);
 
     Result = OcAppleChunklistInitializeContext (
-                &ChunklistContext,
+                ChunklistContext,
                 ChunklistBuffer,
                 ChunklistBufferSize
                 );
@@ -148,7 +142,7 @@ InternalGetDiskImageBootFile (
         DEBUG_INFO,
         "OCB: Failed to initialise DMG Chunklist context\n"
         ));
-      return NULL;
+      return FALSE;
     }
 
     if ((Policy & OC_LOAD_REQUIRE_TRUSTED_KEY) != 0) {
@@ -158,38 +152,47 @@ InternalGetDiskImageBootFile (
       //
       if ((Policy & OC_LOAD_TRUST_APPLE_V1_KEY) != 0) {
         Result = OcAppleChunklistVerifySignature (
-                   &ChunklistContext,
+                   ChunklistContext,
                    PkDataBase[0].PublicKey
                    );
       }
 
       if (!Result && ((Policy & OC_LOAD_TRUST_APPLE_V2_KEY) != 0)) {
         Result = OcAppleChunklistVerifySignature (
-                   &ChunklistContext,
+                   ChunklistContext,
                    PkDataBase[1].PublicKey
                    );
       }
 
       if (!Result) {
         DEBUG ((DEBUG_WARN, "DMG is not trusted, aborting\n"));
-        return NULL;
+        return FALSE;
       }
     }
 
-    Result = OcAppleDiskImageVerifyData (
-               Context->DmgContext,
-               &ChunklistContext
-               );
-    if (!Result) {
-      DEBUG ((DEBUG_WARN, "DMG has been altered\n"));
-      //
-      // FIXME: Warn user instead of aborting when OC_LOAD_REQUIRE_TRUSTED_KEY
-      //        is not set.
-      //
-      return NULL;
-    }
+    *VerifyData = TRUE;
   }
 
+  return TRUE;
+}
+
+STATIC
+EFI_DEVICE_PATH_PROTOCOL *
+InternalGetDiskImageBootFile (
+  OUT INTERNAL_DMG_LOAD_CONTEXT   *Context,
+  IN  APPLE_BOOT_POLICY_PROTOCOL  *BootPolicy,
+  IN  UINTN                       DmgFileSize
+  )
+{
+  EFI_DEVICE_PATH_PROTOCOL       *DevPath;
+
+  CONST EFI_DEVICE_PATH_PROTOCOL *DmgDevicePath;
+  UINTN                          DmgDevicePathSize;
+
+  ASSERT (Context != NULL);
+  ASSERT (BootPolicy != NULL);
+  ASSERT (DmgFileSize > 0);
+
   Context->BlockIoHandle = OcAppleDiskImageInstallBlockIo (
                              Context->DmgContext,
                              DmgFileSize,
@@ -340,6 +343,8 @@ InternalLoadDmg (
   EFI_FILE_PROTOCOL        *ChunklistFile;
   UINT32                   ChunklistFileSize;
   VOID                     *ChunklistBuffer;
+  OC_APPLE_CHUNKLIST_CONTEXT ChunklistContext;
+  BOOLEAN                  VerifyData;
 
   CHAR16 *DevPathText;
 
@@ -409,25 +414,6 @@ InternalLoadDmg (
     return NULL;
   }
 
-  Context->DmgContext = AllocatePool (sizeof (*Context->DmgContext));
-  if (Context->DmgContext == NULL) {
-    DEBUG ((DEBUG_INFO, "OCB: Failed to allocate DMG context\n"));
-    return NULL;
-  }
-
-  Result = OcAppleDiskImageInitializeFromFile (Context->DmgContext, DmgFile, AvoidHighMem);
-
-  DmgFile->Close (DmgFile);
-
-  if (!Result) {
-    DEBUG ((DEBUG_INFO, "OCB: Failed to initialise DMG from file\n"));
-
-    FreePool (DmgFileInfo);
-    FreePool (Context->DmgContext);
-    DmgDir->Close (DmgDir);
-    return NULL;
-  }
-
   ChunklistBuffer   = NULL;
   ChunklistFileSize = 0;
 
@@ -471,13 +457,67 @@ InternalLoadDmg (
 
   DmgDir->Close (DmgDir);
 
+  //
+  // Check the chunklist before loading the DMG, so that the chunks are
+  // verified as the DMG is read instead of in a separate pass afterwards.
+  //
+  Result = InternalVerifyDmgChunklist (
+             Policy,
+             ChunklistBuffer,
+             ChunklistFileSize,
+             &ChunklistContext,
+             &VerifyData
+             );
+  if (!Result) {
+    if (ChunklistBuffer != NULL) {
+      FreePool (ChunklistBuffer);
+    }
+
+    DmgFile->Close (DmgFile);
+    return NULL;
+  }
+
+  Context->DmgContext = AllocatePool (sizeof (*Context->DmgContext));
+  if (Context->DmgContext == NULL) {
+    DEBUG ((DEBUG_INFO, "OCB: Failed to allocate DMG context\n"));
+
+    if (ChunklistBuffer != NULL) {
+      FreePool (ChunklistBuffer);
+    }
+
+    DmgFile->Close (DmgFile);
+    return NULL;
+  }
+
+  Result = OcAppleDiskImageInitializeFromFile (
+             Context->DmgContext,
+             DmgFile,
+             VerifyData ? &ChunklistContext : NULL,
+             AvoidHighMem
+             );
+
+  DmgFile->Close (DmgFile);
+
+  if (ChunklistBuffer != NULL) {
+    FreePool (ChunklistBuffer);
+  }
+
+  if (!Result) {
+    //
+    // Altered chunks are reported by OcAppleChunklistLoadFile.
+    // FIXME: Warn user instead of aborting on altered DMG when
+    //        OC_LOAD_REQUIRE_TRUSTED_KEY is not set.
+    //
+    DEBUG ((DEBUG_INFO, "OCB: Failed to load DMG from file\n"));
+
+    FreePool (Context->DmgContext);
+    return NULL;
+  }
+
   DevPath = InternalGetDiskImageBootFile (
               Context,
               BootPolicy,
-              Policy,
-              DmgFileSize,
-              ChunklistBuffer,
-              ChunklistFileSize
+              DmgFileSize
               );
   Context->DevicePath = DevPath;
 
@@ -488,10 +528,6 @@ InternalLoadDmg (
     FreePool (Context->DmgContext);
   }
 
-  if (ChunklistBuffer != NULL) {
-    FreePool (ChunklistBuffer);
-  }
-
   return DevPath;
 }
 
@@ -0,0 +1,110 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_COMPRESSION_INTERNAL_H
+#define OC_COMPRESSION_INTERNAL_H
+
+#include <Library/OcCompressionLib.h>
+
+//
+// Codec stream contexts share the interface below.
+//
+// Drain functions consume input from *Src and *SrcLen, updating them, and
+// produce up to DstLen bytes into Dst, returning the produced size in *Produced.
+// They return:
+//   RETURN_SUCCESS          - DstLen bytes were produced.
+//   RETURN_NOT_READY        - more input is needed to produce further output.
+//   RETURN_END_OF_FILE      - compressed stream end was reached.
+//   RETURN_VOLUME_CORRUPTED - compressed stream is invalid or truncated.
+//
+
+VOID *
+InternalLzssStreamInit (
+  VOID
+  );
+
+VOID
+InternalLzssStreamReset (
+  IN OUT VOID  *Context
+  );
+
+RETURN_STATUS
+InternalLzssStreamDrain (
+  IN OUT VOID         *Context,
+  IN OUT CONST UINT8  **Src,
+  IN OUT UINT32       *SrcLen,
+  IN     BOOLEAN      Final,
+     OUT UINT8        *Dst,
+  IN     UINT32       DstLen,
+     OUT UINT32       *Produced
+  );
+
+VOID
+InternalLzssStreamFree (
+  IN OUT VOID  *Context
+  );
+
+VOID *
+InternalLzvnStreamInit (
+  VOID
+  );
+
+VOID
+InternalLzvnStreamReset (
+  IN OUT VOID  *Context
+  );
+
+RETURN_STATUS
+InternalLzvnStreamDrain (
+  IN OUT VOID         *Context,
+  IN OUT CONST UINT8  **Src,
+  IN OUT UINT32       *SrcLen,
+  IN     BOOLEAN      Final,
+     OUT UINT8        *Dst,
+  IN     UINT32       DstLen,
+     OUT UINT32       *Produced
+  );
+
+VOID
+InternalLzvnStreamFree (
+  IN OUT VOID  *Context
+  );
+
+VOID *
+InternalZlibStreamInit (
+  VOID
+  );
+
+VOID
+InternalZlibStreamReset (
+  IN OUT VOID  *Context
+  );
+
+RETURN_STATUS
+InternalZlibStreamDrain (
+  IN OUT VOID         *Context,
+  IN OUT CONST UINT8  **Src,
+  IN OUT UINT32       *SrcLen,
+  IN     BOOLEAN      Final,
+     OUT UINT8        *Dst,
+  IN     UINT32       DstLen,
+     OUT UINT32       *Produced
+  );
+
+VOID
+InternalZlibStreamFree (
+  IN OUT VOID  *Context
+  );
+
+#endif // OC_COMPRESSION_INTERNAL_H
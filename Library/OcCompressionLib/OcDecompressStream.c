@@ -0,0 +1,248 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Base.h>
+
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcCompressionLib.h>
+
+#include "OcCompressionInternal.h"
+
+//
+// Scratch buffer size used for skipping decompressed data.
+//
+#define OC_DECOMPRESS_SKIP_CHUNK  512U
+
+struct OC_DECOMPRESS_STREAM_ {
+  OC_COMPRESSION_TYPE  Type;
+  VOID                 *Context;
+  CONST UINT8          *Input;
+  UINT32               InputSize;
+  BOOLEAN              Final;
+  BOOLEAN              Finished;
+  UINT64               Offset;
+};
+
+OC_DECOMPRESS_STREAM *
+OcDecompressStreamInit (
+  IN OC_COMPRESSION_TYPE  Type
+  )
+{
+  OC_DECOMPRESS_STREAM  *Stream;
+
+  Stream = AllocateZeroPool (sizeof (*Stream));
+  if (Stream == NULL) {
+    return NULL;
+  }
+
+  Stream->Type = Type;
+
+  switch (Type) {
+    case OcCompressionLzss:
+      Stream->Context = InternalLzssStreamInit ();
+      break;
+    case OcCompressionLzvn:
+      Stream->Context = InternalLzvnStreamInit ();
+      break;
+    case OcCompressionZlib:
+      Stream->Context = InternalZlibStreamInit ();
+      break;
+    default:
+      break;
+  }
+
+  if (Stream->Context == NULL) {
+    FreePool (Stream);
+    return NULL;
+  }
+
+  return Stream;
+}
+
+VOID
+OcDecompressStreamReset (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream
+  )
+{
+  switch (Stream->Type) {
+    case OcCompressionLzss:
+      InternalLzssStreamReset (Stream->Context);
+      break;
+    case OcCompressionLzvn:
+      InternalLzvnStreamReset (Stream->Context);
+      break;
+    case OcCompressionZlib:
+      InternalZlibStreamReset (Stream->Context);
+      break;
+  }
+
+  Stream->Input     = NULL;
+  Stream->InputSize = 0;
+  Stream->Final     = FALSE;
+  Stream->Finished  = FALSE;
+  Stream->Offset    = 0;
+}
+
+RETURN_STATUS
+OcDecompressStreamFeed (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     CONST UINT8           *Src,
+  IN     UINT32                SrcLen,
+  IN     BOOLEAN               Final
+  )
+{
+  if (Stream->InputSize != 0) {
+    return RETURN_ALREADY_STARTED;
+  }
+
+  if (Stream->Final || SrcLen > OC_COMPRESSION_MAX_LENGTH) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Stream->Input     = Src;
+  Stream->InputSize = SrcLen;
+  Stream->Final     = Final;
+  return RETURN_SUCCESS;
+}
+
+RETURN_STATUS
+OcDecompressStreamDrain (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+     OUT UINT8                 *Dst,
+  IN     UINT32                DstLen,
+     OUT UINT32                *Produced
+  )
+{
+  RETURN_STATUS  Status;
+
+  *Produced = 0;
+
+  if (DstLen > OC_COMPRESSION_MAX_LENGTH) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Stream->Finished) {
+    return RETURN_END_OF_FILE;
+  }
+
+  if (DstLen == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  switch (Stream->Type) {
+    case OcCompressionLzss:
+      Status = InternalLzssStreamDrain (
+        Stream->Context,
+        &Stream->Input,
+        &Stream->InputSize,
+        Stream->Final,
+        Dst,
+        DstLen,
+        Produced
+        );
+      break;
+    case OcCompressionLzvn:
+      Status = InternalLzvnStreamDrain (
+        Stream->Context,
+        &Stream->Input,
+        &Stream->InputSize,
+        Stream->Final,
+        Dst,
+        DstLen,
+        Produced
+        );
+      break;
+    case OcCompressionZlib:
+      Status = InternalZlibStreamDrain (
+        Stream->Context,
+        &Stream->Input,
+        &Stream->InputSize,
+        Stream->Final,
+        Dst,
+        DstLen,
+        Produced
+        );
+      break;
+    default:
+      Status = RETURN_UNSUPPORTED;
+      break;
+  }
+
+  Stream->Offset += *Produced;
+
+  if (Status == RETURN_END_OF_FILE || Status == RETURN_VOLUME_CORRUPTED) {
+    Stream->Finished = TRUE;
+  }
+
+  return Status;
+}
+
+RETURN_STATUS
+OcDecompressStreamSkip (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream,
+  IN     UINT32                Length,
+     OUT UINT32                *Skipped
+  )
+{
+  RETURN_STATUS  Status;
+  UINT8          Scratch[OC_DECOMPRESS_SKIP_CHUNK];
+  UINT32         Produced;
+
+  *Skipped = 0;
+  Status   = RETURN_SUCCESS;
+
+  while (*Skipped < Length) {
+    Status = OcDecompressStreamDrain (
+      Stream,
+      Scratch,
+      MIN (Length - *Skipped, sizeof (Scratch)),
+      &Produced
+      );
+    *Skipped += Produced;
+    if (RETURN_ERROR (Status)) {
+      break;
+    }
+  }
+
+  return Status;
+}
+
+UINT64
+OcDecompressStreamOffset (
+  IN CONST OC_DECOMPRESS_STREAM  *Stream
+  )
+{
+  return Stream->Offset;
+}
+
+VOID
+OcDecompressStreamFree (
+  IN OUT OC_DECOMPRESS_STREAM  *Stream
+  )
+{
+  switch (Stream->Type) {
+    case OcCompressionLzss:
+      InternalLzssStreamFree (Stream->Context);
+      break;
+    case OcCompressionLzvn:
+      InternalLzvnStreamFree (Stream->Context);
+      break;
+    case OcCompressionZlib:
+      InternalZlibStreamFree (Stream->Context);
+      break;
+  }
+
+  FreePool (Stream);
+}
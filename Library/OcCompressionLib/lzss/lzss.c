@@ -107,6 +107,7 @@ u_int32_t decompress_lzss(
     }
 
     dst = dststart;
+    bzero(text_buf, sizeof(text_buf));
     memset(text_buf, ' ', N - F);
     r = N - F;
     flags = 0;
@@ -137,6 +138,143 @@ u_int32_t decompress_lzss(
     return (u_int32_t)(dst - dststart);
 }
 
+/*
+ * Resumable variant of decompress_lzss. All the state of the loop above
+ * is kept in the context, so that input may arrive in arbitrary chunks,
+ * and output may be drained in arbitrary chunks, including in the middle
+ * of a match.
+ */
+struct decode_stream {
+    /* ring buffer of size N, with extra F-1 bytes to aid string comparison */
+    u_int8_t text_buf[N + F - 1];
+    int r;
+    unsigned int flags;
+    /* partially expanded match */
+    int match_position, match_length;
+    /* first byte of a match reference split across input chunks, or -1 */
+    int pending;
+};
+
+void lzss_stream_reset(void *context)
+{
+    struct decode_stream *sp = context;
+
+    /* same initial ring contents as the encoder in init_state */
+    bzero(sp->text_buf, sizeof(sp->text_buf));
+    memset(sp->text_buf, ' ', N - F);
+    sp->r = N - F;
+    sp->flags = 0;
+    sp->match_position = 0;
+    sp->match_length = 0;
+    sp->pending = -1;
+}
+
+void *lzss_stream_init(void)
+{
+    struct decode_stream *sp;
+
+    sp = malloc(sizeof(*sp));
+    if (sp != NULL) {
+        lzss_stream_reset(sp);
+    }
+
+    return sp;
+}
+
+RETURN_STATUS lzss_stream_drain(
+    void            * context,
+    const u_int8_t ** src,
+    u_int32_t       * srclen,
+    BOOLEAN           final,
+    u_int8_t        * dst,
+    u_int32_t         dstlen,
+    u_int32_t       * produced)
+{
+    struct decode_stream *sp = context;
+    u_int8_t * dststart = dst;
+    const u_int8_t * dstend = dst + dstlen;
+    const u_int8_t * srcptr = *src;
+    const u_int8_t * srcend = srcptr + *srclen;
+    int  i, j, r;
+    u_int8_t c;
+    unsigned int flags;
+    RETURN_STATUS status;
+
+    r = sp->r;
+    flags = sp->flags;
+    i = sp->match_position;
+    j = sp->match_length;
+
+    for ( ; ; ) {
+        while (j > 0 && dst < dstend) {
+            c = sp->text_buf[i++ & (N - 1)];
+            *dst++ = c;
+            sp->text_buf[r++] = c;
+            r &= (N - 1);
+            j--;
+        }
+        if (dst == dstend) {
+            status = RETURN_SUCCESS;
+            break;
+        }
+        if ((flags & 0xFF00) == 0) {
+            if (srcptr == srcend) {
+                status = RETURN_NOT_READY;
+                break;
+            }
+            flags = *srcptr++ | 0xFF00;  /* uses higher byte cleverly */
+        }   /* to count eight */
+        if (flags & 1) {
+            if (srcptr == srcend) {
+                status = RETURN_NOT_READY;
+                break;
+            }
+            c = *srcptr++;
+            *dst++ = c;
+            sp->text_buf[r++] = c;
+            r &= (N - 1);
+        } else {
+            if (sp->pending < 0) {
+                if (srcptr == srcend) {
+                    status = RETURN_NOT_READY;
+                    break;
+                }
+                sp->pending = *srcptr++;
+            }
+            if (srcptr == srcend) {
+                status = RETURN_NOT_READY;
+                break;
+            }
+            j  = *srcptr++;
+            i  = sp->pending | ((j & 0xF0) << 4);
+            j  = (j & 0x0F) + THRESHOLD + 1;
+            sp->pending = -1;
+        }
+        flags >>= 1;
+    }
+
+    /* the format has no end marker, input end is stream end */
+    if (status == RETURN_NOT_READY && final) {
+        status = RETURN_END_OF_FILE;
+    }
+
+    sp->r = r;
+    sp->flags = flags;
+    sp->match_position = i & (N - 1);
+    sp->match_length = j;
+
+    *srclen -= (u_int32_t)(srcptr - *src);
+    *src = srcptr;
+    *produced = (u_int32_t)(dst - dststart);
+
+    return status;
+}
+
+void lzss_stream_free(void *context)
+{
+    free(context);
+}
+
 /*
  * initialize state, mostly the trees
  *
@@ -148,10 +286,14 @@ u_int32_t decompress_lzss(
  * Note there are 256 trees. */
 static void init_state(struct encode_state *sp)
 {
+    int  i;
+
     bzero(sp, sizeof(*sp));
     memset(&sp->text_buf[0], ' ', N - F);
-    bzero(&sp->rchild[N + 1], 256 * sizeof(sp->rchild[0]));
-    bzero(&sp->parent[0], N * sizeof(sp->parent[0]));
+    for (i = N + 1; i <= N + 256; i++)
+        sp->rchild[i] = NIL;
+    for (i = 0; i < N; i++)
+        sp->parent[i] = NIL;
 }
 
 /*
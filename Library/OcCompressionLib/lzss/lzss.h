@@ -19,6 +19,8 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcCompressionLib.h>
 
+#include "../OcCompressionInternal.h"
+
 typedef UINT8  u_int8_t;
 typedef UINT16 u_int16_t;
 typedef UINT32 u_int32_t;
@@ -29,6 +31,10 @@ typedef INT32 int32_t;
 
 #define compress_lzss CompressLZSS
 #define decompress_lzss DecompressLZSS
+#define lzss_stream_init InternalLzssStreamInit
+#define lzss_stream_reset InternalLzssStreamReset
+#define lzss_stream_drain InternalLzssStreamDrain
+#define lzss_stream_free InternalLzssStreamFree
 
 #ifdef memset
 #undef memset
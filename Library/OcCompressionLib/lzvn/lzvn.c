@@ -615,6 +615,9 @@ sml_m:
   if (src_len <= opc_len)
     return; // source truncated
   M = (size_t)extract(opc, 0, 4);
+  //  No previous match distance, the match would read unwritten output.
+  if (D == 0)
+    goto invalid_match_distance;
   PTR_LEN_INC(src_ptr, src_len, opc_len);
   goto copy_match;
 
@@ -633,6 +636,9 @@ lrg_m:
   if (src_len <= opc_len)
     return; // source truncated
   M = src_ptr[1] + 16;
+  //  No previous match distance, the match would read unwritten output.
+  if (D == 0)
+    goto invalid_match_distance;
   PTR_LEN_INC(src_ptr, src_len, opc_len);
   goto copy_match;
 
@@ -843,3 +849,174 @@ size_t lzvn_decode_buffer(unsigned char *dst, size_t dst_size,
   // This is how much we decompressed
   return dstate.dst - dst;
 }
+
+//  Resumable decoder. Matches may reference up to 64 KB of earlier output,
+//  so the decoder writes into an internal window, which keeps at least that
+//  much history when it slides, and output is copied out from there.
+//  Opcodes must be contiguous in the source, so an opcode split between
+//  input chunks is carried over in a small buffer until it is complete.
+
+//  Maximum match distance.
+#define LZVN_STREAM_HISTORY  0x10000
+//  Decoding window size, including history.
+#define LZVN_STREAM_WINDOW   (4 * LZVN_STREAM_HISTORY)
+//  Carry buffer size, larger than any opcode with its literal (at most 274
+//  bytes including the next opcode byte).
+#define LZVN_STREAM_CARRY    512
+
+typedef struct {
+  lzvn_decoder_state state;
+  unsigned char *window;
+  size_t carry_size;
+  unsigned char carry[LZVN_STREAM_CARRY];
+} lzvn_stream;
+
+void lzvn_stream_reset(void *context) {
+  lzvn_stream *stream = context;
+  unsigned char *window = stream->window;
+
+  memset(&stream->state, 0x00, sizeof(stream->state));
+  stream->state.dst_begin = window;
+  stream->state.dst = window;
+  stream->state.dst_end = window;
+  stream->carry_size = 0;
+}
+
+void *lzvn_stream_init(void) {
+  lzvn_stream *stream;
+
+  stream = AllocatePool(sizeof(*stream));
+  if (stream == NULL)
+    return NULL;
+
+  stream->window = AllocatePool(LZVN_STREAM_WINDOW);
+  if (stream->window == NULL) {
+    FreePool(stream);
+    return NULL;
+  }
+
+  lzvn_stream_reset(stream);
+  return stream;
+}
+
+RETURN_STATUS lzvn_stream_drain(void *context, const unsigned char **src,
+                                uint32_t *src_size, BOOLEAN final,
+                                unsigned char *dst, uint32_t dst_size,
+                                uint32_t *produced) {
+  lzvn_stream *stream = context;
+  lzvn_decoder_state *state = &stream->state;
+  unsigned char *window_end = stream->window + LZVN_STREAM_WINDOW;
+  unsigned char *dst_start;
+  const unsigned char *src_start;
+  size_t L, M, D;
+  size_t carried;
+  size_t used;
+  size_t left;
+  size_t n;
+
+  *produced = 0;
+
+  while (*produced < dst_size) {
+    // Slide the window keeping the history for matches.
+    if (state->dst == window_end) {
+      memmove(stream->window, window_end - LZVN_STREAM_HISTORY,
+              LZVN_STREAM_HISTORY);
+      state->dst = stream->window + LZVN_STREAM_HISTORY;
+    }
+
+    // Decode from the carried opcode topped up with new input,
+    // or directly from the input.
+    carried = stream->carry_size;
+    if (carried > 0) {
+      n = LZVN_STREAM_CARRY - carried;
+      if (n > *src_size)
+        n = *src_size;
+      memcpy(stream->carry + carried, *src, n);
+      stream->carry_size += n;
+      *src += n;
+      *src_size -= (uint32_t)n;
+      state->src = stream->carry;
+      state->src_end = stream->carry + stream->carry_size;
+    } else {
+      state->src = *src;
+      state->src_end = *src + *src_size;
+    }
+
+    n = window_end - state->dst;
+    if (n > dst_size - *produced)
+      n = dst_size - *produced;
+    dst_start = state->dst;
+    state->dst_end = dst_start + n;
+
+    // A resumed partial match is dropped from the state when the source
+    // is truncated, restore it in this case.
+    src_start = state->src;
+    L = state->L;
+    M = state->M;
+    D = state->D;
+
+    lzvn_decode(state);
+
+    if (state->src == src_start && state->dst == dst_start) {
+      state->L = L;
+      state->M = M;
+      state->D = D;
+    }
+
+    n = state->dst - dst_start;
+    memcpy(dst + *produced, dst_start, n);
+    *produced += (uint32_t)n;
+
+    used = state->src - (carried > 0 ? stream->carry : *src);
+    left = state->src_end - state->src;
+    if (carried > 0) {
+      if (used >= carried) {
+        // The carried opcode is done, return the rest to the input
+        // and continue decoding from there.
+        *src -= left;
+        *src_size += (uint32_t)left;
+        stream->carry_size = 0;
+        if (state->end_of_stream)
+          return RETURN_END_OF_FILE;
+        continue;
+      } else {
+        memmove(stream->carry, stream->carry + used, left);
+        stream->carry_size = left;
+      }
+    } else {
+      *src += used;
+      *src_size -= (uint32_t)used;
+    }
+
+    if (state->end_of_stream)
+      return RETURN_END_OF_FILE;
+
+    if (state->dst == state->dst_end)
+      continue;
+
+    // Decoder stopped before filling the output, the next opcode is either
+    // invalid or incomplete.
+    if (stream->carry_size == LZVN_STREAM_CARRY ||
+        (stream->carry_size == 0 && left >= LZVN_STREAM_CARRY))
+      return RETURN_VOLUME_CORRUPTED;
+
+    if (stream->carry_size == 0) {
+      memcpy(stream->carry, *src, left);
+      stream->carry_size = left;
+      *src += left;
+      *src_size -= (uint32_t)left;
+    }
+
+    if (*src_size == 0)
+      return final ? RETURN_VOLUME_CORRUPTED : RETURN_NOT_READY;
+  }
+
+  return RETURN_SUCCESS;
+}
+
+void lzvn_stream_free(void *context) {
+  lzvn_stream *stream = context;
+
+  FreePool(stream->window);
+  FreePool(stream);
+}
@@ -16,8 +16,11 @@
 #define LZVN_H
 
 #include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcCompressionLib.h>
 
+#include "../OcCompressionInternal.h"
+
 typedef UINT16 uint16_t;
 typedef UINT32 uint32_t;
 typedef UINT64 uint64_t;
@@ -30,6 +33,10 @@ typedef UINTN size_t;
 typedef UINTN uintmax_t;
 
 #define lzvn_decode_buffer DecompressLZVN
+#define lzvn_stream_init InternalLzvnStreamInit
+#define lzvn_stream_reset InternalLzvnStreamReset
+#define lzvn_stream_drain InternalLzvnStreamDrain
+#define lzvn_stream_free InternalLzvnStreamFree
 
 #ifdef memset
 #undef memset
@@ -39,7 +46,12 @@ typedef UINTN uintmax_t;
 #undef memcpy
 #endif
 
+#ifdef memmove
+#undef memmove
+#endif
+
 #define memset(Dst, Value, Size) SetMem ((Dst), (Size), (UINT8)(Value))
 #define memcpy(Dst, Src, Size) CopyMem ((Dst), (Src), (Size))
+#define memmove(Dst, Src, Size) CopyMem ((Dst), (Src), (Size))
 
 #endif /* LZVN_H */
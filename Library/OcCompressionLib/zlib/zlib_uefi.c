@@ -17,6 +17,8 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcCompressionLib.h>
 
+#include "../OcCompressionInternal.h"
+
 voidpf ZLIB_INTERNAL zcalloc (opaque, items, size)
     voidpf opaque;
     unsigned items;
@@ -79,3 +81,85 @@ DecompressZLIB (
 }
 
 #endif // OC_USE_SSH_ZLIB
+
+VOID *
+InternalZlibStreamInit (
+  VOID
+  )
+{
+  z_stream  *Stream;
+
+  Stream = AllocateZeroPool (sizeof (*Stream));
+  if (Stream == NULL) {
+    return NULL;
+  }
+
+  if (inflateInit (Stream) != Z_OK) {
+    FreePool (Stream);
+    return NULL;
+  }
+
+  return Stream;
+}
+
+VOID
+InternalZlibStreamReset (
+  IN OUT VOID  *Context
+  )
+{
+  //
+  // Unlike inflateInit this keeps the window allocated by previous inflate calls.
+  //
+  inflateReset ((z_stream *) Context);
+}
+
+RETURN_STATUS
+InternalZlibStreamDrain (
+  IN OUT VOID         *Context,
+  IN OUT CONST UINT8  **Src,
+  IN OUT UINT32       *SrcLen,
+  IN     BOOLEAN      Final,
+     OUT UINT8        *Dst,
+  IN     UINT32       DstLen,
+     OUT UINT32       *Produced
+  )
+{
+  z_stream  *Stream;
+  INTN      Result;
+
+  Stream = (z_stream *) Context;
+
+  Stream->next_in   = (Bytef *) *Src;
+  Stream->avail_in  = *SrcLen;
+  Stream->next_out  = Dst;
+  Stream->avail_out = DstLen;
+
+  Result = inflate (Stream, Z_NO_FLUSH);
+
+  *Src      = Stream->next_in;
+  *SrcLen   = Stream->avail_in;
+  *Produced = DstLen - Stream->avail_out;
+
+  if (Result == Z_STREAM_END) {
+    return RETURN_END_OF_FILE;
+  }
+
+  if (Result != Z_OK && Result != Z_BUF_ERROR) {
+    return RETURN_VOLUME_CORRUPTED;
+  }
+
+  if (Stream->avail_out == 0) {
+    return RETURN_SUCCESS;
+  }
+
+  return Final ? RETURN_VOLUME_CORRUPTED : RETURN_NOT_READY;
+}
+
+VOID
+InternalZlibStreamFree (
+  IN OUT VOID  *Context
+  )
+{
+  inflateEnd ((z_stream *) Context);
+  FreePool (Context);
+}
@@ -13,6 +13,7 @@
 **/
 
 #include <Library/OcConfigurationLib.h>
+#include <Library/OcPerfLib.h>
 
 OC_STRUCTORS       (OC_ACPI_ADD_ENTRY, ())
 OC_ARRAY_STRUCTORS (OC_ACPI_ADD_ARRAY)
@@ -606,9 +607,13 @@ OcConfigurationInit (
 {
   BOOLEAN  Success;
 
+  OcPerfBegin (OC_PERF_PHASE_CONFIG_PARSE);
+
   OC_GLOBAL_CONFIG_CONSTRUCT (Config, sizeof (*Config));
   Success = ParseSerialized (Config, &mRootConfigurationInfo, Buffer, Size);
 
+  OcPerfEnd (OC_PERF_PHASE_CONFIG_PARSE, Size, Success ? EFI_SUCCESS : EFI_UNSUPPORTED);
+
   if (!Success) {
     OC_GLOBAL_CONFIG_DESTRUCT (Config, sizeof (*Config));
     return EFI_UNSUPPORTED;
@@ -14,6 +14,7 @@
 
 #include <Protocol/ConsoleControl.h>
 #include <Protocol/GraphicsOutput.h>
+#include <Protocol/SimpleTextIn.h>
 #include <Protocol/SimpleTextOut.h>
 
 #include <Library/BaseMemoryLib.h>
@@ -80,6 +81,171 @@ STATIC
 EFI_CONSOLE_CONTROL_PROTOCOL
 mOriginalConsoleControlProtocol;
 
+//
+// Original attribute and cursor position functions, hooked with coalescing.
+//
+STATIC
+EFI_TEXT_SET_ATTRIBUTE
+mOriginalSetAttribute;
+
+STATIC
+EFI_TEXT_SET_CURSOR_POSITION
+mOriginalSetCursorPosition;
+
+//
+// Original mode, reset and cursor functions, hooked with coalescing.
+//
+STATIC
+EFI_TEXT_SET_MODE
+mOriginalSetMode;
+
+STATIC
+EFI_TEXT_RESET
+mOriginalReset;
+
+STATIC
+EFI_TEXT_ENABLE_CURSOR
+mOriginalEnableCursor;
+
+//
+// Restore GOP resolution after ClearScreen.
+//
+STATIC
+BOOLEAN
+mSanitiseClearScreen = FALSE;
+
+//
+// Staging buffer for OutputString. Tabs are expanded into it in chunks,
+// and with coalescing enabled consecutive writes are accumulated until
+// a line end, a full buffer, or an explicit flush.
+//
+#define OC_CONSOLE_STAGING_SIZE  256
+
+STATIC
+CHAR16
+mStagingBuffer[OC_CONSOLE_STAGING_SIZE];
+
+STATIC
+UINTN
+mStagingLength;
+
+STATIC
+EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL *
+mStagingThis;
+
+//
+// Set while staging buffer is being used to protect from nested output,
+// e.g. from an event notification.
+//
+STATIC
+BOOLEAN
+mStagingBusy;
+
+//
+// Coalesce consecutive OutputString calls.
+//
+STATIC
+BOOLEAN
+mCoalesceOutput = FALSE;
+
+//
+// Cached console GOP instance and the handle it was obtained from.
+//
+STATIC
+EFI_GRAPHICS_OUTPUT_PROTOCOL *
+mConsoleGraphicsOutput;
+
+STATIC
+EFI_HANDLE
+mConsoleGraphicsOutputHandle;
+
+/**
+  Obtain GOP installed on console output handle, cached across calls.
+
+  @retval GOP instance or NULL.
+**/
+STATIC
+EFI_GRAPHICS_OUTPUT_PROTOCOL *
+InternalGetConsoleGop (
+  VOID
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_GRAPHICS_OUTPUT_PROTOCOL  *GraphicsOutput;
+
+  if (mConsoleGraphicsOutput != NULL
+    && mConsoleGraphicsOutputHandle == gST->ConsoleOutHandle) {
+    return mConsoleGraphicsOutput;
+  }
+
+  Status = gBS->HandleProtocol (
+    gST->ConsoleOutHandle,
+    &gEfiGraphicsOutputProtocolGuid,
+    (VOID **) &GraphicsOutput
+    );
+
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  mConsoleGraphicsOutput       = GraphicsOutput;
+  mConsoleGraphicsOutputHandle = gST->ConsoleOutHandle;
+
+  return GraphicsOutput;
+}
+
+/**
+  Drop cached console GOP, e.g. after reconnecting console drivers.
+**/
+STATIC
+VOID
+InternalInvalidateConsoleGop (
+  VOID
+  )
+{
+  mConsoleGraphicsOutput       = NULL;
+  mConsoleGraphicsOutputHandle = NULL;
+}
+
+/**
+  Write staged output to the original OutputString.
+
+  @retval EFI_SUCCESS on success or when nothing is staged.
+**/
+STATIC
+EFI_STATUS
+InternalFlushStaging (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (mStagingLength == 0) {
+    return EFI_SUCCESS;
+  }
+
+  mStagingBuffer[mStagingLength] = CHAR_NULL;
+  mStagingLength = 0;
+
+  Status = mOriginalOutputString (mStagingThis, mStagingBuffer);
+
+  return Status;
+}
+
+/**
+  Discard staged output, which the caller is about to erase.
+**/
+STATIC
+VOID
+InternalDropStaging (
+  VOID
+  )
+{
+  if (!mStagingBusy) {
+    mStagingLength = 0;
+  }
+}
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -88,41 +254,120 @@ ControlledOutputString (
   IN CHAR16                           *String
   )
 {
-  UINTN       Index;
-  UINTN       Length;
-  CHAR16      *StringCopy;
   EFI_STATUS  Status;
+  CHAR16      Char;
+  BOOLEAN     LineEnd;
 
-  if (mConsoleMode == EfiConsoleControlScreenText || !mIgnoreTextInGraphics) {
-    if (mReplaceTabWithSpace) {
-      Length = StrLen(String);
-      if (Length == MAX_UINTN) {
-        return EFI_UNSUPPORTED;
-      }
+  if (mConsoleMode != EfiConsoleControlScreenText && mIgnoreTextInGraphics) {
+    return EFI_UNSUPPORTED;
+  }
 
-      StringCopy = AllocatePool((Length + 1) * sizeof(CHAR16));
-      if (StringCopy == NULL) {
-        return mOriginalOutputString (This, String);
-      }
-      for (Index = 0; Index < Length; Index++) {
-        if (String[Index] == '\t') {
-          StringCopy[Index] = ' ';
-        }
-        else {
-          StringCopy[Index] = String[Index];
-        }
-      }
-      StringCopy[Length] = 0;
-      Status = mOriginalOutputString (This, StringCopy);
-      FreePool(StringCopy);
-      return Status;
+  if ((!mReplaceTabWithSpace && !mCoalesceOutput) || mStagingBusy) {
+    return mOriginalOutputString (This, String);
+  }
+
+  mStagingBusy = TRUE;
+
+  Status = EFI_SUCCESS;
+  if (mStagingThis != This) {
+    Status       = InternalFlushStaging ();
+    mStagingThis = This;
+  }
+
+  LineEnd = FALSE;
+  while (!EFI_ERROR (Status) && *String != CHAR_NULL) {
+    //
+    // Reserve space for the terminator.
+    //
+    if (mStagingLength == ARRAY_SIZE (mStagingBuffer) - 1) {
+      Status = InternalFlushStaging ();
+      continue;
     }
-    else {
-      return mOriginalOutputString (This, String);
+
+    Char = *String++;
+    if (Char == CHAR_TAB && mReplaceTabWithSpace) {
+      Char = L' ';
+    } else if (Char == CHAR_LINEFEED) {
+      LineEnd = TRUE;
     }
+
+    mStagingBuffer[mStagingLength++] = Char;
   }
 
-  return EFI_UNSUPPORTED;
+  if (!EFI_ERROR (Status) && (!mCoalesceOutput || LineEnd)) {
+    Status = InternalFlushStaging ();
+  }
+
+  mStagingBusy = FALSE;
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+ControlledSetAttribute (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Attribute
+  )
+{
+  OcConsoleFlushOutput ();
+  return mOriginalSetAttribute (This, Attribute);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+ControlledSetCursorPosition (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            Column,
+  IN UINTN                            Row
+  )
+{
+  OcConsoleFlushOutput ();
+  return mOriginalSetCursorPosition (This, Column, Row);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+ControlledEnableCursor (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          Visible
+  )
+{
+  OcConsoleFlushOutput ();
+  return mOriginalEnableCursor (This, Visible);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+ControlledSetMode (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN UINTN                            ModeNumber
+  )
+{
+  //
+  // Mode change clears the screen.
+  //
+  InternalDropStaging ();
+  return mOriginalSetMode (This, ModeNumber);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+ControlledReset (
+  IN EFI_SIMPLE_TEXT_OUTPUT_PROTOCOL  *This,
+  IN BOOLEAN                          ExtendedVerification
+  )
+{
+  //
+  // Reset clears the screen.
+  //
+  InternalDropStaging ();
+  return mOriginalReset (This, ExtendedVerification);
 }
 
 STATIC
@@ -136,16 +381,18 @@ ControlledClearScreen (
   EFI_GRAPHICS_OUTPUT_PROTOCOL          *GraphicsOutput;
   UINT32                                Mode;
 
-  Status = gBS->HandleProtocol (
-    gST->ConsoleOutHandle,
-    &gEfiGraphicsOutputProtocolGuid,
-    (VOID **) &GraphicsOutput
-    );
+  //
+  // Staged text would be erased right away, drop it.
+  //
+  InternalDropStaging ();
 
-  if (!EFI_ERROR (Status)) {
+  if (!mSanitiseClearScreen) {
+    return mOriginalClearScreen (This);
+  }
+
+  GraphicsOutput = InternalGetConsoleGop ();
+  if (GraphicsOutput != NULL) {
     Mode = GraphicsOutput->Mode->Mode;
-  } else {
-    GraphicsOutput = NULL;
   }
 
   //
@@ -219,16 +466,17 @@ ConsoleControlSetMode (
 
   DEBUG ((DEBUG_INFO, "OCC: Setting cc mode %d -> %d\n", mConsoleMode, Mode));
 
+  //
+  // Staged text belongs to the previous mode.
+  //
+  OcConsoleFlushOutput ();
+
   mConsoleMode = Mode;
 
   if (mClearScreenOnModeSwitch && Mode == EfiConsoleControlScreenText) {
-    Status = gBS->HandleProtocol (
-      gST->ConsoleOutHandle,
-      &gEfiGraphicsOutputProtocolGuid,
-      (VOID **) &GraphicsOutput
-      );
+    GraphicsOutput = InternalGetConsoleGop ();
 
-    if (!EFI_ERROR (Status)) {
+    if (GraphicsOutput != NULL) {
       Background.Red   = 0;
       Background.Green = 0;
       Background.Blue  = 0;
@@ -263,7 +511,7 @@ ConsoleControlSetMode (
   // on platforms that require IgnoreTextOutput quirk, and this is the extension
   // of its implementation.
   //
-  if (Mode == EfiConsoleControlScreenGraphics && mOriginalOutputString != NULL) {
+  if (Mode == EfiConsoleControlScreenGraphics && (mIgnoreTextInGraphics || mReplaceTabWithSpace)) {
     OcConsoleDisableCursor ();
   }
 
@@ -376,17 +624,96 @@ OcConsoleControlConfigure (
   mClearScreenOnModeSwitch = ClearScreenOnModeSwitch;
   mReplaceTabWithSpace     = ReplaceTabWithSpace;
 
-  if (IgnoreTextOutput || ReplaceTabWithSpace) {
+  if ((IgnoreTextOutput || ReplaceTabWithSpace)
+    && gST->ConOut->OutputString != ControlledOutputString) {
     mOriginalOutputString     = gST->ConOut->OutputString;
     gST->ConOut->OutputString = ControlledOutputString;
   }
 
-  if (SanitiseClearScreen) {
+  mSanitiseClearScreen     = SanitiseClearScreen;
+
+  if (SanitiseClearScreen
+    && gST->ConOut->ClearScreen != ControlledClearScreen) {
     mOriginalClearScreen      = gST->ConOut->ClearScreen;
     gST->ConOut->ClearScreen  = ControlledClearScreen;
   }
 }
 
+VOID
+OcConsoleControlSetCoalescing (
+  IN BOOLEAN  Enable
+  )
+{
+  DEBUG ((DEBUG_INFO, "OCC: Configuring output coalescing %d\n", Enable));
+
+  if (!Enable) {
+    OcConsoleFlushOutput ();
+    mCoalesceOutput = FALSE;
+    return;
+  }
+
+  if (gST->ConOut->OutputString != ControlledOutputString) {
+    mOriginalOutputString     = gST->ConOut->OutputString;
+    gST->ConOut->OutputString = ControlledOutputString;
+  }
+
+  //
+  // Attribute and cursor changes must not overtake staged text.
+  //
+  if (gST->ConOut->SetAttribute != ControlledSetAttribute) {
+    mOriginalSetAttribute     = gST->ConOut->SetAttribute;
+    gST->ConOut->SetAttribute = ControlledSetAttribute;
+  }
+
+  if (gST->ConOut->SetCursorPosition != ControlledSetCursorPosition) {
+    mOriginalSetCursorPosition     = gST->ConOut->SetCursorPosition;
+    gST->ConOut->SetCursorPosition = ControlledSetCursorPosition;
+  }
+
+  if (gST->ConOut->EnableCursor != ControlledEnableCursor) {
+    mOriginalEnableCursor     = gST->ConOut->EnableCursor;
+    gST->ConOut->EnableCursor = ControlledEnableCursor;
+  }
+
+  //
+  // Staged text must not be printed onto a freshly cleared screen.
+  //
+  if (gST->ConOut->ClearScreen != ControlledClearScreen) {
+    mOriginalClearScreen     = gST->ConOut->ClearScreen;
+    gST->ConOut->ClearScreen = ControlledClearScreen;
+  }
+
+  if (gST->ConOut->SetMode != ControlledSetMode) {
+    mOriginalSetMode     = gST->ConOut->SetMode;
+    gST->ConOut->SetMode = ControlledSetMode;
+  }
+
+  if (gST->ConOut->Reset != ControlledReset) {
+    mOriginalReset     = gST->ConOut->Reset;
+    gST->ConOut->Reset = ControlledReset;
+  }
+
+  mCoalesceOutput = TRUE;
+}
+
+EFI_STATUS
+OcConsoleFlushOutput (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if (mStagingBusy) {
+    return EFI_SUCCESS;
+  }
+
+  mStagingBusy = TRUE;
+  Status       = InternalFlushStaging ();
+  mStagingBusy = FALSE;
+
+  return Status;
+}
+
 EFI_STATUS
 OcConsoleControlSetBehaviour (
   IN OC_CONSOLE_CONTROL_BEHAVIOUR  Behaviour
@@ -759,6 +1086,9 @@ SetConsoleResolution (
     &HandleBuffer
     );
   if (!EFI_ERROR (Status)) {
+    OcConsoleFlushOutput ();
+    InternalInvalidateConsoleGop ();
+
     for (Index = 0; Index < HandleCount; ++Index) {
       gBS->DisconnectController (HandleBuffer[Index], NULL, NULL);
     }
@@ -879,6 +1209,8 @@ SetConsoleMode (
     Height
     ));
 
+  OcConsoleFlushOutput ();
+
   Status = gST->ConOut->SetMode (gST->ConOut, (UINTN) ModeNumber);
   if (EFI_ERROR (Status)) {
     DEBUG ((
@@ -574,7 +574,8 @@ BigNumPowMod (
   IN     UINT32            B,
   IN     CONST OC_BN_WORD  *N,
   IN     OC_BN_WORD        N0Inv,
-  IN     CONST OC_BN_WORD  *RSqrMod
+  IN     CONST OC_BN_WORD  *RSqrMod,
+  IN OUT OC_BN_WORD        *Scratch OPTIONAL
   )
 {
   OC_BN_WORD *ATmp;
@@ -595,10 +596,13 @@ BigNumPowMod (
     return FALSE;
   }
 
-  ATmp = AllocatePool ((UINTN)NumWords * OC_BN_WORD_SIZE);
+  ATmp = Scratch;
   if (ATmp == NULL) {
-    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure in ModPow\n"));
-    return FALSE;
+    ATmp = AllocatePool ((UINTN)NumWords * OC_BN_WORD_SIZE);
+    if (ATmp == NULL) {
+      DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure in ModPow\n"));
+      return FALSE;
+    }
   }
   //
   // Convert A into the Montgomery Domain.
@@ -654,6 +658,9 @@ BigNumPowMod (
     BigNumSub (Result, NumWords, Result, N);
   }
 
-  FreePool (ATmp);
+  if (Scratch == NULL) {
+    FreePool (ATmp);
+  }
+
   return TRUE;
 }
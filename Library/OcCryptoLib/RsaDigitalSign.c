@@ -138,6 +138,95 @@ SigVerifyShaHashBySize (
   return CompareMem (DataDigest, Hash, HashSize);
 }
 
+/**
+  Verify decrypted RSA PKCS1.5 signature encoding against an expected hash.
+
+  @param[in] Signature      The decrypted RSA signature, big-endian.
+  @param[in] SignatureSize  Size, in bytes, of Signature.
+  @param[in] Padding        The DER encoding prefix of the digest.
+  @param[in] PaddingSize    Size, in bytes, of Padding.
+  @param[in] Hash           The Hash digest of the signed data.
+  @param[in] HashSize       Size, in bytes, of Hash.
+
+  @returns  Whether the signature encoding matches the expected hash.
+
+**/
+STATIC
+BOOLEAN
+InternalRsaVerifyPkcsEncoding (
+  IN CONST UINT8  *Signature,
+  IN UINTN        SignatureSize,
+  IN CONST UINT8  *Padding,
+  IN UINTN        PaddingSize,
+  IN CONST UINT8  *Hash,
+  IN UINTN        HashSize
+  )
+{
+  INTN   CmpResult;
+  UINTN  DigestSize;
+  UINTN  Index;
+
+  //
+  // From RFC 3447, 9.2 EMSA-PKCS1-v1_5:
+  //
+  // 5. Concatenate PS, the DER encoding T, and other padding to form the
+  //    encoded message EM as
+  // 
+  //     EM = 0x00 || 0x01 || PS || 0x00 || T.
+  //
+
+  //
+  // 3. If emLen < tLen + 11, output "intended encoded message length too
+  //    short" and stop.
+  //
+  // The additions cannot overflow because both PaddingSize and HashSize are
+  // sane at this point.
+  //
+  DigestSize = PaddingSize + HashSize;
+  if (SignatureSize < DigestSize + 11) {
+    return FALSE;
+  }
+
+  if (Signature[0] != 0x00 || Signature[1] != 0x01) {
+    return FALSE;
+  }
+  //
+  // 4. Generate an octet string PS consisting of emLen - tLen - 3 octets with
+  //    hexadecimal value 0xff.  The length of PS will be at least 8 octets.
+  //
+  // The additions and subtractions cannot overflow as per 3.
+  //
+  for (Index = 2; Index < SignatureSize - DigestSize - 3 + 2; ++Index) {
+    if (Signature[Index] != 0xFF) {
+      return FALSE;
+    }
+  }
+
+  if (Signature[Index] != 0x00) {
+    return FALSE;
+  }
+
+  ++Index;
+
+  CmpResult = CompareMem (&Signature[Index], Padding, PaddingSize);
+  if (CmpResult != 0) {
+    return FALSE;
+  }
+
+  Index += PaddingSize;
+
+  CmpResult = CompareMem (&Signature[Index], Hash, HashSize);
+  if (CmpResult != 0) {
+    return FALSE;
+  }
+  //
+  // The code above must have covered the entire Signature range.
+  //
+  ASSERT (Index + HashSize == SignatureSize);
+
+  return TRUE;
+}
+
 /**
   Verify a RSA PKCS1.5 signature against an expected hash.
 
@@ -151,6 +240,8 @@ SigVerifyShaHashBySize (
   @param[in] Hash           The Hash digest of the signed data.
   @param[in] HashSize       Size, in bytes, of Hash.
   @param[in] Algorithm      The RSA algorithm used.
+  @param[in] Scratch        Scratch buffer of 3 * NumWords Words. If NULL, it
+                            is allocated from pool.
 
   @returns  Whether the signature has been successfully verified as valid.
 
@@ -167,21 +258,21 @@ RsaVerifySigHashFromProcessed (
   IN UINTN             SignatureSize,
   IN CONST UINT8       *Hash,
   IN UINTN             HashSize,
-  IN OC_SIG_HASH_TYPE  Algorithm
+  IN OC_SIG_HASH_TYPE  Algorithm,
+  IN OUT OC_BN_WORD    *Scratch OPTIONAL
   )
 {
   BOOLEAN     Result;
-  INTN        CmpResult;
 
   UINTN       ModulusSize;
 
   VOID        *Memory;
   OC_BN_WORD  *EncryptedSigNum;
   OC_BN_WORD  *DecryptedSigNum;
+  OC_BN_WORD  *PowModScratch;
 
   CONST UINT8 *Padding;
   UINTN       PaddingSize;
-  UINTN       DigestSize;
   UINTN       Index;
 
   OC_BN_WORD  Tmp;
@@ -254,14 +345,23 @@ RsaVerifySigHashFromProcessed (
     return FALSE;
   }
 
-  Memory = AllocatePool (2 * ModulusSize);
+  STATIC_ASSERT (
+    OC_BN_MAX_SIZE <= MAX_UINTN / 3,
+    "An overflow verification must be added"
+    );
+
+  Memory = Scratch;
   if (Memory == NULL) {
-    DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure\n"));
-    return FALSE;
+    Memory = AllocatePool (3 * ModulusSize);
+    if (Memory == NULL) {
+      DEBUG ((DEBUG_INFO, "OCCR: Memory allocation failure\n"));
+      return FALSE;
+    }
   }
 
   EncryptedSigNum = Memory;
   DecryptedSigNum = (OC_BN_WORD *)((UINTN)EncryptedSigNum + ModulusSize);
+  PowModScratch   = (OC_BN_WORD *)((UINTN)DecryptedSigNum + ModulusSize);
 
   BigNumParseBuffer (
     EncryptedSigNum,
@@ -277,94 +377,40 @@ RsaVerifySigHashFromProcessed (
              Exponent,
              N,
              N0Inv,
-             RSqrMod
+             RSqrMod,
+             PowModScratch
              );
-  if (!Result) {
-    FreePool (Memory);
-    return FALSE;
-  }
-  //
-  // Convert the result to a big-endian byte array.
-  // Re-use EncryptedSigNum as it is not required anymore.
-  // FIXME: Doing this as part of the comparison could speed up the process
-  //        and clean up the code.
-  //
-  Index = NumWords;
-  while (Index > 0) {
-    --Index;
-    Tmp = BigNumSwapWord (
-            DecryptedSigNum[NumWords - 1 - Index]
-            );
-    EncryptedSigNum[Index] = Tmp;
-  }
-  Signature = (UINT8 *)EncryptedSigNum;
-
-  //
-  // From RFC 3447, 9.2 EMSA-PKCS1-v1_5:
-  //
-  // 5. Concatenate PS, the DER encoding T, and other padding to form the
-  //    encoded message EM as
-  // 
-  //     EM = 0x00 || 0x01 || PS || 0x00 || T.
-  //
-
-  //
-  // 3. If emLen < tLen + 11, output "intended encoded message length too
-  //    short" and stop.
-  //
-  // The additions cannot overflow because both PaddingSize and HashSize are
-  // sane at this point.
-  //
-  DigestSize = PaddingSize + HashSize;
-  if (SignatureSize < DigestSize + 11) {
-    FreePool (Memory);
-    return FALSE;
-  }
-
-  if (Signature[0] != 0x00 || Signature[1] != 0x01) {
-    FreePool (Memory);
-    return FALSE;
-  }
-  //
-  // 4. Generate an octet string PS consisting of emLen - tLen - 3 octets with
-  //    hexadecimal value 0xff.  The length of PS will be at least 8 octets.
-  //
-  // The additions and subtractions cannot overflow as per 3.
-  //
-  for (Index = 2; Index < SignatureSize - DigestSize - 3 + 2; ++Index) {
-    if (Signature[Index] != 0xFF) {
-      FreePool (Memory);
-      return FALSE;
+  if (Result) {
+    //
+    // Convert the result to a big-endian byte array.
+    // Re-use EncryptedSigNum as it is not required anymore.
+    // FIXME: Doing this as part of the comparison could speed up the process
+    //        and clean up the code.
+    //
+    Index = NumWords;
+    while (Index > 0) {
+      --Index;
+      Tmp = BigNumSwapWord (
+              DecryptedSigNum[NumWords - 1 - Index]
+              );
+      EncryptedSigNum[Index] = Tmp;
     }
-  }
 
-  if (Signature[Index] != 0x00) {
-    FreePool (Memory);
-    return FALSE;
-  }
-
-  ++Index;
-
-  CmpResult = CompareMem (&Signature[Index], Padding, PaddingSize);
-  if (CmpResult != 0) {
-    FreePool (Memory);
-    return FALSE;
+    Result = InternalRsaVerifyPkcsEncoding (
+               (UINT8 *)EncryptedSigNum,
+               SignatureSize,
+               Padding,
+               PaddingSize,
+               Hash,
+               HashSize
+               );
   }
 
-  Index += PaddingSize;
-
-  CmpResult = CompareMem (&Signature[Index], Hash, HashSize);
-  if (CmpResult != 0) {
+  if (Scratch == NULL) {
     FreePool (Memory);
-    return FALSE;
   }
-  //
-  // The code above must have covered the entire Signature range.
-  //
-  ASSERT (Index + HashSize == SignatureSize);
 
-  FreePool (Memory);
-  return TRUE;
+  return Result;
 }
 
 /**
@@ -382,6 +428,8 @@ RsaVerifySigHashFromProcessed (
   @param[in] Data           The signed data to verify.
   @param[in] DataSize       Size, in bytes, of Data.
   @param[in] Algorithm      The RSA algorithm used.
+  @param[in] Scratch        Scratch buffer of 3 * NumWords Words. If NULL, it
+                            is allocated from pool.
 
   @returns  Whether the signature has been successfully verified as valid.
 
@@ -398,7 +446,8 @@ RsaVerifySigDataFromProcessed (
   IN UINTN             SignatureSize,
   IN CONST UINT8       *Data,
   IN UINTN             DataSize,
-  IN OC_SIG_HASH_TYPE  Algorithm
+  IN OC_SIG_HASH_TYPE  Algorithm,
+  IN OUT OC_BN_WORD    *Scratch OPTIONAL
   )
 {
   UINT8 Hash[OC_MAX_SHA_DIGEST_SIZE];
@@ -460,10 +509,143 @@ RsaVerifySigDataFromProcessed (
            SignatureSize,
            Hash,
            HashSize,
-           Algorithm
+           Algorithm,
+           Scratch
            );
 }
 
+//
+// Montgomery parameters derived from raw moduli, which are verified with
+// the same few keys during a boot.  Like the rest of UEFI, the cache and
+// the scratch buffer are not thread-safe.
+//
+#define OC_RSA_MONT_CACHE_SIZE  4U
+
+typedef struct {
+  UINT8            ModulusHash[SHA256_DIGEST_SIZE];
+  UINTN            ModulusSize;
+  UINT32           LastUse;
+  OC_BN_WORD       N0Inv;
+  //
+  // N followed by RSqrMod, allocated from pool.
+  //
+  OC_BN_WORD       *N;
+  OC_BN_WORD       *RSqrMod;
+} OC_RSA_MONT_CONTEXT;
+
+STATIC OC_RSA_MONT_CONTEXT  mRsaMontCache[OC_RSA_MONT_CACHE_SIZE];
+STATIC UINT32               mRsaMontCacheClock;
+
+STATIC OC_BN_WORD           *mRsaScratch;
+STATIC UINTN                mRsaScratchSize;
+
+/**
+  Get Montgomery parameters for a raw modulus, calculating them on cache miss.
+
+  @param[in] Modulus      The RSA modulus, big-endian.
+  @param[in] ModulusSize  Size, in bytes, of Modulus.
+  @param[in] NumWords     The number of Words of Modulus.
+
+  @returns  Cached Montgomery parameters or NULL.
+
+**/
+STATIC
+OC_RSA_MONT_CONTEXT *
+InternalRsaGetMontContext (
+  IN CONST UINT8      *Modulus,
+  IN UINTN            ModulusSize,
+  IN OC_BN_NUM_WORDS  NumWords
+  )
+{
+  UINT8                ModulusHash[SHA256_DIGEST_SIZE];
+  OC_RSA_MONT_CONTEXT  *Entry;
+  OC_BN_WORD           *N;
+  OC_BN_WORD           *RSqrMod;
+  OC_BN_WORD           N0Inv;
+  UINT32               Index;
+
+  Sha256 (ModulusHash, Modulus, ModulusSize);
+
+  ++mRsaMontCacheClock;
+
+  Entry = &mRsaMontCache[0];
+  for (Index = 0; Index < OC_RSA_MONT_CACHE_SIZE; ++Index) {
+    if (mRsaMontCache[Index].N != NULL
+      && mRsaMontCache[Index].ModulusSize == ModulusSize
+      && CompareMem (mRsaMontCache[Index].ModulusHash, ModulusHash, sizeof (ModulusHash)) == 0) {
+      mRsaMontCache[Index].LastUse = mRsaMontCacheClock;
+      return &mRsaMontCache[Index];
+    }
+
+    //
+    // Remember the least recently used entry for replacement.
+    //
+    if (mRsaMontCache[Index].N == NULL
+      || (Entry->N != NULL && mRsaMontCache[Index].LastUse < Entry->LastUse)) {
+      Entry = &mRsaMontCache[Index];
+    }
+  }
+
+  STATIC_ASSERT (
+    OC_BN_MAX_SIZE <= MAX_UINTN / 2,
+    "An overflow verification must be added"
+    );
+
+  N = AllocatePool (2 * ModulusSize);
+  if (N == NULL) {
+    return NULL;
+  }
+
+  RSqrMod = (OC_BN_WORD *)((UINTN)N + ModulusSize);
+
+  BigNumParseBuffer (N, NumWords, Modulus, ModulusSize);
+
+  N0Inv = BigNumCalculateMontParams (RSqrMod, NumWords, N);
+  if (N0Inv == 0) {
+    FreePool (N);
+    return NULL;
+  }
+
+  if (Entry->N != NULL) {
+    FreePool (Entry->N);
+  }
+
+  CopyMem (Entry->ModulusHash, ModulusHash, sizeof (ModulusHash));
+  Entry->ModulusSize = ModulusSize;
+  Entry->LastUse     = mRsaMontCacheClock;
+  Entry->N0Inv       = N0Inv;
+  Entry->N           = N;
+  Entry->RSqrMod     = RSqrMod;
+
+  return Entry;
+}
+
+/**
+  Get scratch buffer for verification, reused across calls.
+
+  @param[in] Size  Size, in bytes, of the scratch buffer.
+
+  @returns  Scratch buffer or NULL.
+
+**/
+STATIC
+OC_BN_WORD *
+InternalRsaGetScratch (
+  IN UINTN  Size
+  )
+{
+  if (Size > mRsaScratchSize) {
+    if (mRsaScratch != NULL) {
+      FreePool (mRsaScratch);
+    }
+
+    mRsaScratch     = AllocatePool (Size);
+    mRsaScratchSize = mRsaScratch != NULL ? Size : 0;
+  }
+
+  return mRsaScratch;
+}
+
 BOOLEAN
 RsaVerifySigDataFromData (
   IN CONST UINT8       *Modulus,
@@ -476,15 +658,11 @@ RsaVerifySigDataFromData (
   IN OC_SIG_HASH_TYPE  Algorithm
   )
 {
-  UINTN           ModulusNumWordsTmp;
-  OC_BN_NUM_WORDS ModulusNumWords;
+  UINTN                 ModulusNumWordsTmp;
+  OC_BN_NUM_WORDS       ModulusNumWords;
 
-  VOID            *Memory;
-  OC_BN_WORD      *N;
-  OC_BN_WORD      *RSqrMod;
-
-  OC_BN_WORD      N0Inv;
-  BOOLEAN         Result;
+  OC_RSA_MONT_CONTEXT   *MontContext;
+  OC_BN_WORD            *Scratch;
 
   ASSERT (Modulus != NULL);
   ASSERT (ModulusSize > 0);
@@ -502,42 +680,29 @@ RsaVerifySigDataFromData (
 
   ModulusNumWords = (OC_BN_NUM_WORDS)ModulusNumWordsTmp;
 
-  STATIC_ASSERT (
-    OC_BN_MAX_SIZE <= MAX_UINTN / 2,
-    "An overflow verification must be added"
-    );
-
-  Memory = AllocatePool (2 * ModulusSize);
-  if (Memory == NULL) {
+  MontContext = InternalRsaGetMontContext (Modulus, ModulusSize, ModulusNumWords);
+  if (MontContext == NULL) {
     return FALSE;
   }
 
-  N       = (OC_BN_WORD *)Memory;
-  RSqrMod = (OC_BN_WORD *)((UINTN)N + ModulusSize);
-
-  BigNumParseBuffer (N, ModulusNumWords, Modulus, ModulusSize);
-
-  N0Inv = BigNumCalculateMontParams (RSqrMod, ModulusNumWords, N);
-  if (N0Inv == 0) {
-    FreePool (Memory);
+  Scratch = InternalRsaGetScratch (3 * ModulusSize);
+  if (Scratch == NULL) {
     return FALSE;
   }
 
-  Result = RsaVerifySigDataFromProcessed (
-             N,
-             ModulusNumWords,
-             N0Inv,
-             RSqrMod,
-             Exponent,
-             Signature,
-             SignatureSize,
-             Data,
-             DataSize,
-             Algorithm
-             );
-
-  FreePool (Memory);
-  return Result;
+  return RsaVerifySigDataFromProcessed (
+           MontContext->N,
+           ModulusNumWords,
+           MontContext->N0Inv,
+           MontContext->RSqrMod,
+           Exponent,
+           Signature,
+           SignatureSize,
+           Data,
+           DataSize,
+           Algorithm,
+           Scratch
+           );
 }
 
 BOOLEAN
@@ -574,7 +739,8 @@ RsaVerifySigHashFromKey (
            SignatureSize,
            Hash,
            HashSize,
-           Algorithm
+           Algorithm,
+           NULL
            );
 }
 
@@ -612,6 +778,7 @@ RsaVerifySigDataFromKey (
            SignatureSize,
            Data,
            DataSize,
-           Algorithm
+           Algorithm,
+           NULL
            );
 }
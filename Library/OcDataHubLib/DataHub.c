@@ -15,6 +15,122 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 DATA_HUB_INSTANCE mPrivateData;
 
+/**
+  CHANGE: Allocate zeroed storage for a data entry from the record pool.
+  Records are never freed, so they are carved out of bigger chunks
+  to avoid a pool allocation per logged record.
+
+  @param Private    Data hub instance.
+  @param Size       Entry size in bytes.
+
+  @retval Allocated entry or NULL.
+**/
+STATIC
+VOID *
+DataHubAllocateEntry (
+  IN OUT DATA_HUB_INSTANCE  *Private,
+  IN     UINTN              Size
+  )
+{
+  VOID  *Entry;
+
+  Size = ALIGN_VALUE (Size, sizeof (UINT64));
+
+  if (Size > DATA_HUB_POOL_CHUNK_SIZE / 2) {
+    return AllocateZeroPool (Size);
+  }
+
+  if (Private->PoolChunk == NULL
+    || DATA_HUB_POOL_CHUNK_SIZE - Private->PoolChunkUsed < Size) {
+    //
+    // Remaining space in the previous chunk is wasted, which is
+    // fine as records are small compared to the chunk size.
+    //
+    Private->PoolChunk = AllocateZeroPool (DATA_HUB_POOL_CHUNK_SIZE);
+    if (Private->PoolChunk == NULL) {
+      return NULL;
+    }
+    Private->PoolChunkUsed = 0;
+  }
+
+  Entry = Private->PoolChunk + Private->PoolChunkUsed;
+  Private->PoolChunkUsed += Size;
+  return Entry;
+}
+
+/**
+  CHANGE: Ensure there is space for one more entry in the record table.
+
+  @param Private    Data hub instance.
+
+  @retval TRUE on success.
+**/
+STATIC
+BOOLEAN
+DataHubReserveEntrySlot (
+  IN OUT DATA_HUB_INSTANCE  *Private
+  )
+{
+  EFI_DATA_ENTRY  **NewEntries;
+  UINTN           NewCapacity;
+
+  if (Private->EntryCount < Private->EntryCapacity) {
+    return TRUE;
+  }
+
+  if (Private->EntryCapacity == 0) {
+    NewCapacity = DATA_HUB_INITIAL_RECORD_COUNT;
+  } else {
+    NewCapacity = Private->EntryCapacity * 2;
+  }
+
+  NewEntries = ReallocatePool (
+    Private->EntryCapacity * sizeof (Private->Entries[0]),
+    NewCapacity * sizeof (Private->Entries[0]),
+    Private->Entries
+    );
+  if (NewEntries == NULL) {
+    return FALSE;
+  }
+
+  Private->Entries       = NewEntries;
+  Private->EntryCapacity = NewCapacity;
+  return TRUE;
+}
+
+/**
+  CHANGE: Obtain log time for a new record. Within a batch the time
+  is only requested once and shared by all the records.
+
+  @param Private    Data hub instance.
+  @param LogTime    Resulting log time.
+**/
+STATIC
+VOID
+DataHubGetLogTime (
+  IN OUT DATA_HUB_INSTANCE  *Private,
+  OUT    EFI_TIME           *LogTime
+  )
+{
+  if (Private->BatchActive && Private->BatchTimeValid) {
+    CopyMem (LogTime, &Private->BatchTime, sizeof (*LogTime));
+    return;
+  }
+
+  //
+  // First try to get log time at TPL level <= TPL_CALLBACK.
+  //
+  ZeroMem (LogTime, sizeof (*LogTime));
+  if (EfiGetCurrentTpl() <= TPL_CALLBACK) {
+    gRT->GetTime (LogTime, NULL);
+
+    if (Private->BatchActive) {
+      CopyMem (&Private->BatchTime, LogTime, sizeof (Private->BatchTime));
+      Private->BatchTimeValid = TRUE;
+    }
+  }
+}
+
 /**
   Log data record into the data logging hub
 
@@ -63,13 +179,7 @@ DataHubLogData (
   RecordSize  = sizeof (EFI_DATA_RECORD_HEADER) + RawDataSize;
   TotalSize   = sizeof (EFI_DATA_ENTRY) + RecordSize;
 
-  //
-  // First try to get log time at TPL level <= TPL_CALLBACK.
-  //
-  ZeroMem (&LogTime, sizeof (LogTime));
-  if (EfiGetCurrentTpl() <= TPL_CALLBACK) {
-    gRT->GetTime (&LogTime, NULL);
-  }
+  DataHubGetLogTime (Private, &LogTime);
 
   //
   // The Logging action is the critical section, so it is locked.
@@ -84,15 +194,18 @@ DataHubLogData (
     return Status;
   }
 
-  LogEntry = AllocatePool (TotalSize);
+  if (!DataHubReserveEntrySlot (Private)) {
+    EfiReleaseLock (&Private->DataLock);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  LogEntry = DataHubAllocateEntry (Private, TotalSize);
 
   if (LogEntry == NULL) {
     EfiReleaseLock (&Private->DataLock);
     return EFI_OUT_OF_RESOURCES;
   }
 
-  ZeroMem (LogEntry, TotalSize);
-
   Record  = (EFI_DATA_RECORD_HEADER *) (LogEntry + 1);
   Raw     = (VOID *) (Record + 1);
 
@@ -114,12 +227,13 @@ DataHubLogData (
   CopyMem (&Record->LogTime, &LogTime, sizeof (LogTime));
 
   //
-  // Insert log into the internal linked list.
+  // Insert log into the internal record table.
   //
   LogEntry->Signature   = EFI_DATA_ENTRY_SIGNATURE;
   LogEntry->Record      = Record;
   LogEntry->RecordSize  = sizeof (EFI_DATA_ENTRY) + RawDataSize;
-  InsertTailList (&Private->DataListHead, &LogEntry->Link);
+  Private->Entries[Private->EntryCount] = LogEntry;
+  ++Private->EntryCount;
 
   CopyMem (Raw, RawData, RawDataSize);
 
@@ -143,72 +257,79 @@ DataHubLogData (
 }
 
 /**
-  Search the Head doubly linked list for the passed in MTC. Return the
-  matching element in Head and the MTC on the next entry.
+  Search the record table for the passed in MTC. Return the matching
+  record and the MTC on the next entry.
+
+  CHANGE: Records are looked up by their index in the MTC-ordered table
+  instead of scanning a linked list from its head, so enumerating all
+  records is linear.
 
-  @param Head             Head of Data Log linked list.
+  @param Private          Data hub instance.
   @param ClassFilter      Only match the MTC if it is in the same Class as the
                           ClassFilter.
   @param PtrCurrentMTC    On IN contians MTC to search for. On OUT contians next
                           MTC in the data log list or zero if at end of the list.
 
-  @retval EFI_DATA_LOG_ENTRY  Return pointer to data log data from Head list.
+  @retval EFI_DATA_LOG_ENTRY  Return pointer to data log data from the table.
   @retval NULL                If no data record exists.
 
 **/
 EFI_DATA_RECORD_HEADER *
 GetNextDataRecord (
-  IN  LIST_ENTRY          *Head,
+  IN  DATA_HUB_INSTANCE   *Private,
   IN  UINT64              ClassFilter,
   IN OUT  UINT64          *PtrCurrentMTC
   )
 
 {
-  EFI_DATA_ENTRY          *LogEntry;
-  LIST_ENTRY              *Link;
-  BOOLEAN                 ReturnFirstEntry;
+  UINTN                   Index;
   EFI_DATA_RECORD_HEADER  *Record;
-  EFI_DATA_ENTRY          *NextLogEntry;
 
-  //
-  // If MonotonicCount == 0 just return the first one
-  //
-  ReturnFirstEntry  = (BOOLEAN) (*PtrCurrentMTC == 0);
+  if (*PtrCurrentMTC == 0) {
+    //
+    // If MonotonicCount == 0 just return the first one
+    //
+    for (Index = 0; Index < Private->EntryCount; ++Index) {
+      if ((Private->Entries[Index]->Record->DataRecordClass & ClassFilter) != 0) {
+        break;
+      }
+    }
 
-  Record            = NULL;
-  for (Link = GetFirstNode(Head); Link != Head; Link = GetNextNode(Head, Link)) {
-    LogEntry = DATA_ENTRY_FROM_LINK (Link);
-    if ((LogEntry->Record->DataRecordClass & ClassFilter) == 0) {
+    if (Index == Private->EntryCount) {
+      return NULL;
+    }
+  } else {
+    if (*PtrCurrentMTC <= Private->BaseMonotonicCount
+      || *PtrCurrentMTC - Private->BaseMonotonicCount > Private->EntryCount) {
+      return NULL;
+    }
+
+    Index = (UINTN) (*PtrCurrentMTC - Private->BaseMonotonicCount - 1);
+
+    if ((Private->Entries[Index]->Record->DataRecordClass & ClassFilter) == 0) {
       //
       // Skip any entry that does not have the correct ClassFilter
       //
-      continue;
+      return NULL;
     }
+  }
 
-    if ((LogEntry->Record->LogMonotonicCount == *PtrCurrentMTC) || ReturnFirstEntry) {
-      //
-      // Return record to the user
-      //
-      Record = LogEntry->Record;
+  //
+  // Return record to the user
+  //
+  Record = Private->Entries[Index]->Record;
 
+  //
+  // Calculate the next MTC value. If there is no next entry set
+  // MTC to zero.
+  //
+  *PtrCurrentMTC = 0;
+  for (++Index; Index < Private->EntryCount; ++Index) {
+    if ((Private->Entries[Index]->Record->DataRecordClass & ClassFilter) != 0) {
       //
-      // Calculate the next MTC value. If there is no next entry set
-      // MTC to zero.
-      //
-      *PtrCurrentMTC = 0;
-      for (Link = GetNextNode(Head, Link); Link != Head; Link = GetNextNode(Head, Link)) {
-        NextLogEntry = DATA_ENTRY_FROM_LINK (Link);
-        if ((NextLogEntry->Record->DataRecordClass & ClassFilter) != 0) {
-          //
-          // Return the MTC of the next thing to search for if found
-          //
-          *PtrCurrentMTC = NextLogEntry->Record->LogMonotonicCount;
-          break;
-        }
-      }
-      //
-      // Record found exit loop and return
+      // Return the MTC of the next thing to search for if found
       //
+      *PtrCurrentMTC = Private->Entries[Index]->Record->LogMonotonicCount;
       break;
     }
   }
@@ -300,7 +421,7 @@ DataHubGetNextRecord (
   // If FilterDriverEvent is NULL, then return the next record
   //
   if (FilterDriverEvent == NULL) {
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -328,7 +449,7 @@ DataHubGetNextRecord (
   // Retrieve the next record or the first record.
   //
   if (*MonotonicCount != 0 || FilterDriver->GetNextMonotonicCount == 0) {
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -357,7 +478,7 @@ DataHubGetNextRecord (
   // Retrieve the last record successfuly read again, but do not return it since
   // it has already been returned before.
   //
-  *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+  *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
   if (*Record == NULL) {
     return EFI_NOT_FOUND;
   }
@@ -371,7 +492,7 @@ DataHubGetNextRecord (
     //
     // Retrieve the record after the last record successfuly read
     //
-    *Record = GetNextDataRecord (&Private->DataListHead, ClassFilter, MonotonicCount);
+    *Record = GetNextDataRecord (Private, ClassFilter, MonotonicCount);
     if (*Record == NULL) {
       return EFI_NOT_FOUND;
     }
@@ -543,7 +664,6 @@ DataHubInstall (
   // Initialize Private Data in CORE_LOGGING_HUB_INSTANCE that is
   // required by this protocol
   //
-  InitializeListHead (&mPrivateData.DataListHead);
   InitializeListHead (&mPrivateData.FilterDriverListHead);
 
   EfiInitializeLock (&mPrivateData.DataLock, TPL_NOTIFY);
@@ -561,6 +681,16 @@ DataHubInstall (
     mPrivateData.GlobalMonotonicCount = LShiftU64 ((UINT64) HighMontonicCount, 32);
   }
   //
+  // CHANGE: Drop records from a previous instance on reinstallation.
+  //  Record table storage is reused.
+  //
+  mPrivateData.BaseMonotonicCount = mPrivateData.GlobalMonotonicCount;
+  mPrivateData.EntryCount         = 0;
+  mPrivateData.PoolChunk          = NULL;
+  mPrivateData.PoolChunkUsed      = 0;
+  mPrivateData.BatchActive        = FALSE;
+  mPrivateData.BatchTimeValid     = FALSE;
+  //
   // Make a new handle and install the protocol
   //
   mPrivateData.Handle = NULL;
@@ -580,3 +710,28 @@ DataHubInstall (
   return &mPrivateData.DataHub;
 }
 
+/**
+  CHANGE: Start or finish a batch of records logged into this data hub.
+  All records logged within a batch share a single log time, which avoids
+  calling GetTime runtime service for every record.
+
+  @param DataHub  Data hub protocol instance.
+  @param Start    TRUE to start a batch, FALSE to finish it.
+
+  @retval TRUE when DataHub is produced by this driver.
+**/
+BOOLEAN
+DataHubSetBatch (
+  IN EFI_DATA_HUB_PROTOCOL  *DataHub,
+  IN BOOLEAN                Start
+  )
+{
+  if (DataHub != &mPrivateData.DataHub
+    || mPrivateData.Signature != DATA_HUB_INSTANCE_SIGNATURE) {
+    return FALSE;
+  }
+
+  mPrivateData.BatchActive    = Start;
+  mPrivateData.BatchTimeValid = FALSE;
+  return TRUE;
+}
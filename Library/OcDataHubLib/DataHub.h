@@ -24,6 +24,31 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 
+//
+// Private data structure to contain the data log. One record per
+//  structure. Record is a copy of the data passed in.
+//
+#define EFI_DATA_ENTRY_SIGNATURE  SIGNATURE_32 ('D', 'r', 'e', 'c')
+typedef struct {
+  UINT32                  Signature;
+
+  EFI_DATA_RECORD_HEADER  *Record;
+
+  UINTN                   RecordSize;
+
+} EFI_DATA_ENTRY;
+
+//
+// CHANGE: Records are carved out of pooled chunks of this size instead of
+// being allocated one by one. Bigger records get a dedicated allocation.
+//
+#define DATA_HUB_POOL_CHUNK_SIZE      SIZE_16KB
+
+//
+// CHANGE: Initial capacity of the MTC-indexed record table.
+//
+#define DATA_HUB_INITIAL_RECORD_COUNT 64
+
 #define DATA_HUB_INSTANCE_SIGNATURE SIGNATURE_32 ('D', 'H', 'u', 'b')
 typedef struct {
   UINT32                Signature;
@@ -51,10 +76,33 @@ typedef struct {
   UINT64                GlobalMonotonicCount;
 
   //
-  // List of EFI_DATA_ENTRY structures. This is the data log! The list
-  //  must be in assending order of LogMonotonicCount.
+  // CHANGE: Monotonic count preceding the first logged record.
+  //  Record with index I has LogMonotonicCount equal to
+  //  BaseMonotonicCount + I + 1.
   //
-  LIST_ENTRY            DataListHead;
+  UINT64                BaseMonotonicCount;
+
+  //
+  // CHANGE: Table of EFI_DATA_ENTRY structures indexed by monotonic count.
+  //  This is the data log! The table is in assending order of
+  //  LogMonotonicCount and replaces the original linked list.
+  //
+  EFI_DATA_ENTRY        **Entries;
+  UINTN                 EntryCount;
+  UINTN                 EntryCapacity;
+
+  //
+  // CHANGE: Current chunk records are allocated from.
+  //
+  UINT8                 *PoolChunk;
+  UINTN                 PoolChunkUsed;
+
+  //
+  // CHANGE: Log time shared by all records logged within a batch.
+  //
+  BOOLEAN               BatchActive;
+  BOOLEAN               BatchTimeValid;
+  EFI_TIME              BatchTime;
 
   //
   // List of EFI_DATA_HUB_FILTER_DRIVER structures. Represents all
@@ -66,23 +114,6 @@ typedef struct {
 
 #define DATA_HUB_INSTANCE_FROM_THIS(this) CR (this, DATA_HUB_INSTANCE, DataHub, DATA_HUB_INSTANCE_SIGNATURE)
 
-//
-// Private data structure to contain the data log. One record per
-//  structure. Head pointer to the list is the Log member of
-//  EFI_DATA_ENTRY. Record is a copy of the data passed in.
-//
-#define EFI_DATA_ENTRY_SIGNATURE  SIGNATURE_32 ('D', 'r', 'e', 'c')
-typedef struct {
-  UINT32                  Signature;
-  LIST_ENTRY              Link;
-
-  EFI_DATA_RECORD_HEADER  *Record;
-
-  UINTN                   RecordSize;
-
-} EFI_DATA_ENTRY;
-
-#define DATA_ENTRY_FROM_LINK(link)  CR (link, EFI_DATA_ENTRY, Link, EFI_DATA_ENTRY_SIGNATURE)
 
 //
 // Private data to contain the filter driver Event and it's
@@ -44,6 +44,16 @@ DataHubInstall (
   VOID
   );
 
+/**
+  Start or finish a batch of records logged into our data hub.
+
+**/
+BOOLEAN
+DataHubSetBatch (
+  IN EFI_DATA_HUB_PROTOCOL  *DataHub,
+  IN BOOLEAN                Start
+  );
+
 EFI_DATA_HUB_PROTOCOL *
 OcDataHubInstallProtocol (
   IN BOOLEAN  Reinstall
@@ -259,6 +269,12 @@ UpdateDataHub (
 {
   GUID                   SystemId;
 
+  //
+  // Let our data hub share one log time across all the records.
+  // This is a no-op for firmware-provided data hub instances.
+  //
+  DataHubSetBatch (DataHub, TRUE);
+
   DataHubSetAppleMiscAscii (DataHub, OC_PLATFORM_NAME, Data->PlatformName);
   DataHubSetAppleMiscUnicode (DataHub, OC_SYSTEM_PRODUCT_NAME, Data->SystemProductName);
   DataHubSetAppleMiscUnicode (DataHub, OC_SYSTEM_SERIAL_NUMBER, Data->SystemSerialNumber);
@@ -289,5 +305,7 @@ UpdateDataHub (
   DataHubSetAppleMiscData (DataHub, OC_SMC_BRANCH, Data->SmcBranch, OC_SMC_BRANCH_SIZE);
   DataHubSetAppleMiscData (DataHub, OC_SMC_PLATFORM, Data->SmcPlatform, OC_SMC_PLATFORM_SIZE);
 
+  DataHubSetBatch (DataHub, FALSE);
+
   return EFI_SUCCESS;
 }
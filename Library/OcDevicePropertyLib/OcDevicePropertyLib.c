@@ -25,7 +25,6 @@
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
-#include <Library/PrintLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/OcGuardLib.h>
@@ -55,6 +54,14 @@ typedef struct {
 #define APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE  768
 #define APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM   0x10000
 
+//
+// Initial chunk buffer size, enough for most property sets without regrowing.
+//
+#define APPLE_PATH_PROPERTY_VARIABLE_GUESS_SIZE  (8 * APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE)
+
+#define APPLE_PATH_PROPERTIES_INDEX_OFFSET     (ARRAY_SIZE (APPLE_PATH_PROPERTIES_VARIABLE_NAME) - 1)
+#define APPLE_PATH_PROPERTIES_NAME_LENGTH      (APPLE_PATH_PROPERTIES_INDEX_OFFSET + 5)
+
 #define EFI_DEVICE_PATH_PROPERTY_NODE_SIGNATURE  \
   SIGNATURE_32 ('D', 'p', 'n', '\0')
 
@@ -582,138 +589,323 @@ DppDbGetPropertyBuffer (
   return EFI_SUCCESS;
 }
 
-// InternalReadEfiVariableProperties
+// APPLE_PATH_PROPERTIES_CHUNKS
+typedef struct {
+  UINT8    *Data;            ///< Concatenated chunk contents.
+  UINTN    Size;             ///< Total size of all chunks.
+  UINT32   NumberOfChunks;   ///< Number of chunks present in NVRAM.
+  UINT32   Attributes;       ///< Attributes of the first chunk.
+  BOOLEAN  Uniform;          ///< All chunks but last are of maximum size.
+} APPLE_PATH_PROPERTIES_CHUNKS;
+
+// InternalInitPathPropertiesName
+STATIC
+VOID
+InternalInitPathPropertiesName (
+  OUT CHAR16  *VariableName
+  )
+{
+  CopyMem (
+    VariableName,
+    APPLE_PATH_PROPERTIES_VARIABLE_NAME,
+    APPLE_PATH_PROPERTIES_INDEX_OFFSET * sizeof (CHAR16)
+    );
+  VariableName[APPLE_PATH_PROPERTIES_INDEX_OFFSET + 4] = L'\0';
+}
+
+// InternalSetPathPropertiesIndex
+STATIC
+VOID
+InternalSetPathPropertiesIndex (
+  IN OUT CHAR16  *VariableName,
+  IN     UINT32  Index
+  )
+{
+  STATIC CONST CHAR16 mHexDigits[] = L"0123456789abcdef";
+  CHAR16              *Digits;
+
+  //
+  // Same as %04x, only the index digits are updated for each chunk.
+  //
+  Digits    = &VariableName[APPLE_PATH_PROPERTIES_INDEX_OFFSET];
+  Digits[0] = mHexDigits[(Index >> 12U) & 0xFU];
+  Digits[1] = mHexDigits[(Index >> 8U) & 0xFU];
+  Digits[2] = mHexDigits[(Index >> 4U) & 0xFU];
+  Digits[3] = mHexDigits[Index & 0xFU];
+}
+
+// InternalLoadPathPropertiesChunks
 STATIC
 EFI_STATUS
-InternalReadEfiVariableProperties (
-  IN EFI_GUID                   *VendorGuid,
-  IN BOOLEAN                    DeleteVariables,
-  IN DEVICE_PATH_PROPERTY_DATA  *DevicePathPropertyData
+InternalLoadPathPropertiesChunks (
+  IN  EFI_GUID                      *VendorGuid,
+  OUT APPLE_PATH_PROPERTIES_CHUNKS  *Chunks
   )
 {
-  EFI_STATUS                           Status;
+  EFI_STATUS  Status;
+  CHAR16      VariableName[APPLE_PATH_PROPERTIES_NAME_LENGTH];
+  UINT8       *Data;
+  UINT8       *NewData;
+  UINTN       AllocatedSize;
+  UINTN       NewSize;
+  UINTN       DataSize;
+  UINTN       LastDataSize;
+  UINT32      Attributes;
+
+  ZeroMem (Chunks, sizeof (*Chunks));
+
+  AllocatedSize = APPLE_PATH_PROPERTY_VARIABLE_GUESS_SIZE;
+  Data          = AllocatePool (AllocatedSize);
+  if (Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-  CHAR16                               IndexBuffer[5];
-  UINT32                               NumberOfVariables;
-  UINT32                               VariableIndex;
-  CHAR16                               VariableName[64];
-  UINTN                                DataSize;
-  UINTN                                BufferSize;
-  UINTN                                CurrentBufferSize;
-  EFI_DEVICE_PATH_PROPERTY_BUFFER      *Buffer;
-  UINT8                                *BufferPtr;
-  EFI_DEVICE_PATH_PROPERTY_BUFFER_NODE *BufferNode;
-  UINTN                                NodeIndex;
-  UINTN                                Index;
-  EFI_DEVICE_PATH_PROPERTY_DATA        *NameData;
-  EFI_DEVICE_PATH_PROPERTY_DATA        *ValueData;
-  UINT32                               Attributes;
-
-  NumberOfVariables = 0;
-  BufferSize        = 0;
-  Status = EFI_BUFFER_TOO_SMALL;
-
-  while (Status == EFI_BUFFER_TOO_SMALL && NumberOfVariables < APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM) {
-    UnicodeSPrint (
-      &IndexBuffer[0],
-      sizeof (IndexBuffer),
-      L"%04x",
-      NumberOfVariables
-      );
+  InternalInitPathPropertiesName (VariableName);
+  Chunks->Uniform = TRUE;
+  LastDataSize    = APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE;
+  Status          = EFI_SUCCESS;
 
-    StrCpyS (VariableName, ARRAY_SIZE (VariableName), APPLE_PATH_PROPERTIES_VARIABLE_NAME);
-    StrCatS (VariableName, ARRAY_SIZE (VariableName), IndexBuffer);
+  //
+  // Chunks are read directly into the remaining buffer space, so a single
+  // GetVariable call per chunk is needed unless the buffer is exhausted.
+  // NumberOfChunks check is an extra caution here, writing 0x10000 variables
+  // to NVRAM is pretty much impossible.
+  //
+  while (Chunks->NumberOfChunks < APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM) {
+    InternalSetPathPropertiesIndex (VariableName, Chunks->NumberOfChunks);
 
-    DataSize = 0;
+    DataSize = AllocatedSize - Chunks->Size;
     Status   = gRT->GetVariable (
                       VariableName,
                       VendorGuid,
-                      NULL,
+                      &Attributes,
                       &DataSize,
-                      NULL
+                      Data + Chunks->Size
                       );
 
-    ++NumberOfVariables;
-    if (OcOverflowAddUN (BufferSize, DataSize, &BufferSize)) {
-      //
-      // Should never trigger due to BufferSize being 4G at least.
-      //
-      return EFI_OUT_OF_RESOURCES;
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      if (OcOverflowAddUN (Chunks->Size, DataSize, &NewSize)) {
+        //
+        // Should never trigger due to BufferSize being 4G at least.
+        //
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      NewSize = MAX (NewSize, AllocatedSize * 2);
+      NewData = ReallocatePool (AllocatedSize, NewSize, Data);
+      if (NewData == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      Data          = NewData;
+      AllocatedSize = NewSize;
+      continue;
     }
-    //
-    // NumberOfVariables check is an extra caution here, writing 0x10000 variables
-    // to NVRAM is pretty much impossible.
-    //
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (Chunks->NumberOfChunks == 0) {
+      Chunks->Attributes = Attributes;
+    }
+
+    if (LastDataSize != APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE
+      || DataSize > APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE
+      || Attributes != Chunks->Attributes) {
+      Chunks->Uniform = FALSE;
+    }
+
+    LastDataSize  = DataSize;
+    Chunks->Size += DataSize;
+    ++Chunks->NumberOfChunks;
   }
 
+  if (Status == EFI_NOT_FOUND) {
+    Status = EFI_SUCCESS;
+  }
+
+  if (EFI_ERROR (Status) || Chunks->Size == 0) {
+    FreePool (Data);
+    Chunks->Size = 0;
+    return Status;
+  }
+
+  Chunks->Data = Data;
+  return EFI_SUCCESS;
+}
+
+// InternalDeletePathPropertiesChunks
+STATIC
+EFI_STATUS
+InternalDeletePathPropertiesChunks (
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINT32    FirstIndex,
+  IN UINT32    NumberOfChunks
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      VariableName[APPLE_PATH_PROPERTIES_NAME_LENGTH];
+  UINT32      Index;
+
+  InternalInitPathPropertiesName (VariableName);
+
   //
-  // Discard low size with forced approval.
+  // Deleting a missing chunk stops the sequence, which lets the caller pass
+  // APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM when the chunk count is unknown.
   //
-  if (BufferSize < sizeof (EFI_DEVICE_PATH_PROPERTY_BUFFER)) {
-    return EFI_SUCCESS;
-  }
+  for (Index = FirstIndex; Index < NumberOfChunks; ++Index) {
+    InternalSetPathPropertiesIndex (VariableName, Index);
 
-  Buffer = AllocateZeroPool (BufferSize);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+    Status = gRT->SetVariable (VariableName, VendorGuid, Attributes, 0, NULL);
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    }
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
   }
 
-  BufferPtr = (UINT8 *) Buffer;
-  CurrentBufferSize = BufferSize;
-  Status = EFI_SUCCESS;
+  return EFI_SUCCESS;
+}
 
-  for (VariableIndex = 0; VariableIndex < NumberOfVariables; ++VariableIndex) {
-    UnicodeSPrint (
-      &IndexBuffer[0],
-      sizeof (IndexBuffer),
-      L"%04x",
-      VariableIndex
-      );
+// InternalWriteEfiVariableProperties
+STATIC
+EFI_STATUS
+InternalWriteEfiVariableProperties (
+  IN EFI_GUID                      *VendorGuid,
+  IN UINT32                        Attributes,
+  IN CONST UINT8                   *Data,
+  IN UINTN                         DataSize,
+  IN APPLE_PATH_PROPERTIES_CHUNKS  *Previous  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      VariableName[APPLE_PATH_PROPERTIES_NAME_LENGTH];
+  UINT32      Index;
+  UINTN       Offset;
+  UINTN       ChunkSize;
+  BOOLEAN     Compare;
 
-    StrCpyS (VariableName, ARRAY_SIZE (VariableName), APPLE_PATH_PROPERTIES_VARIABLE_NAME);
-    StrCatS (VariableName, ARRAY_SIZE (VariableName), IndexBuffer);
+  //
+  // Unchanged chunks are compared against the previously loaded contents
+  // and skipped, which is only possible when they were split the same way.
+  //
+  Compare = Previous != NULL
+    && Previous->Data != NULL
+    && Previous->Uniform
+    && Previous->Attributes == Attributes;
 
-    DataSize = CurrentBufferSize;
-    Status   = gRT->GetVariable (
+  InternalInitPathPropertiesName (VariableName);
+
+  Index  = 0;
+  Offset = 0;
+
+  while (Index < APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM && Offset < DataSize) {
+    ChunkSize = MIN (DataSize - Offset, APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE);
+
+    if (!Compare
+      || Index >= Previous->NumberOfChunks
+      || MIN (Previous->Size - Offset, APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE) != ChunkSize
+      || CompareMem (Previous->Data + Offset, Data + Offset, ChunkSize) != 0) {
+      InternalSetPathPropertiesIndex (VariableName, Index);
+
+      Status = gRT->SetVariable (
                       VariableName,
                       VendorGuid,
-                      &Attributes,
-                      &DataSize,
-                      BufferPtr
+                      Attributes,
+                      ChunkSize,
+                      (VOID *) (Data + Offset)
                       );
 
-    if (EFI_ERROR (Status)) {
-      break;
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
     }
 
-    if (DeleteVariables) {
-      Status = gRT->SetVariable (VariableName, VendorGuid, Attributes, 0, NULL);
+    Offset += ChunkSize;
+    ++Index;
+  }
 
-      if (EFI_ERROR (Status)) {
-        break;
+  if (Offset != DataSize) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  return InternalDeletePathPropertiesChunks (
+    VendorGuid,
+    Attributes,
+    Index,
+    Previous != NULL ? Previous->NumberOfChunks : APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM
+    );
+}
+
+// InternalReadEfiVariableProperties
+STATIC
+EFI_STATUS
+InternalReadEfiVariableProperties (
+  IN  EFI_GUID                      *VendorGuid,
+  IN  BOOLEAN                       DeleteVariables,
+  IN  DEVICE_PATH_PROPERTY_DATA     *DevicePathPropertyData,
+  OUT APPLE_PATH_PROPERTIES_CHUNKS  *Chunks  OPTIONAL
+  )
+{
+  EFI_STATUS                           Status;
+
+  APPLE_PATH_PROPERTIES_CHUNKS         LocalChunks;
+  UINTN                                DataSize;
+  EFI_DEVICE_PATH_PROPERTY_BUFFER      *Buffer;
+  EFI_DEVICE_PATH_PROPERTY_BUFFER_NODE *BufferNode;
+  UINTN                                NodeIndex;
+  UINTN                                Index;
+  EFI_DEVICE_PATH_PROPERTY_DATA        *NameData;
+  EFI_DEVICE_PATH_PROPERTY_DATA        *ValueData;
+
+  if (Chunks == NULL) {
+    Chunks = &LocalChunks;
+  }
+
+  Status = InternalLoadPathPropertiesChunks (VendorGuid, Chunks);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (DeleteVariables && Chunks->NumberOfChunks > 0) {
+    Status = InternalDeletePathPropertiesChunks (
+      VendorGuid,
+      Chunks->Attributes,
+      0,
+      Chunks->NumberOfChunks
+      );
+
+    if (EFI_ERROR (Status)) {
+      if (Chunks->Data != NULL) {
+        FreePool (Chunks->Data);
+        Chunks->Data = NULL;
       }
+      return Status;
     }
-
-    BufferPtr         += DataSize;
-    CurrentBufferSize -= DataSize;
   }
 
+  Buffer = (EFI_DEVICE_PATH_PROPERTY_BUFFER *) Chunks->Data;
+
   //
   // Force success on format mismatch, this slightly differs from Apple implementation,
   // where variable read failure results in error unless EFI_NOT_FOUND.
   //
-  if (Buffer->Size != BufferSize
+  if (Chunks->Size < sizeof (EFI_DEVICE_PATH_PROPERTY_BUFFER)
+    || Buffer->Size != Chunks->Size
     || Buffer->Version != EFI_DEVICE_PATH_PROPERTY_DATABASE_VERSION
     || Buffer->NumberOfNodes == 0) {
-    FreePool (Buffer);
+    if (Chunks == &LocalChunks && Chunks->Data != NULL) {
+      FreePool (Chunks->Data);
+    }
     return EFI_SUCCESS;
   }
 
-  if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
-    return Status;
-  }
-
   //
   // TODO: while this does not seem exploitable, we should sanity check the input data.
   //
@@ -763,7 +955,9 @@ InternalReadEfiVariableProperties (
                    );
   }
 
-  FreePool (Buffer);
+  if (Chunks == &LocalChunks) {
+    FreePool (Chunks->Data);
+  }
 
   return EFI_SUCCESS;
 }
@@ -785,14 +979,9 @@ OcDevicePathPropertyInstallProtocol (
 
   EFI_DEVICE_PATH_PROPERTY_BUFFER             *Buffer;
   EFI_DEVICE_PATH_PROPERTY_DATABASE_PROTOCOL  *Protocol;
-  UINT8                                       *BufferPtr;
   DEVICE_PATH_PROPERTY_DATA                   *DevicePathPropertyData;
   UINTN                                       DataSize;
-  UINT32                                      VariableIndex;
-  CHAR16                                      IndexBuffer[5];
-  CHAR16                                      VariableName[64];
-  UINTN                                       VariableSize;
-  UINT32                                      Attributes;
+  APPLE_PATH_PROPERTIES_CHUNKS                VendorChunks;
   EFI_HANDLE                                  Handle;
 
   if (Reinstall) {
@@ -829,10 +1018,14 @@ OcDevicePathPropertyInstallProtocol (
   InitializeListHead (&DevicePathPropertyData->Nodes);
 
   if (PcdGetBool (PcNvramInitDevicePropertyDatabase)) {
+    //
+    // Vendor chunks are kept to only rewrite the changed ones below.
+    //
     Status = InternalReadEfiVariableProperties (
                &gAppleVendorVariableGuid,
                FALSE,
-               DevicePathPropertyData
+               DevicePathPropertyData,
+               &VendorChunks
                );
 
     if (EFI_ERROR (Status)) {
@@ -845,15 +1038,11 @@ OcDevicePathPropertyInstallProtocol (
     Status = InternalReadEfiVariableProperties (
                &gAppleBootVariableGuid,
                TRUE,
-               DevicePathPropertyData
+               DevicePathPropertyData,
+               NULL
                );
 
-    if (EFI_ERROR (Status)) {
-      FreePool (DevicePathPropertyData);
-      return NULL;
-    }
-
-    if (DevicePathPropertyData->Modified) {
+    if (!EFI_ERROR (Status) && DevicePathPropertyData->Modified) {
       DataSize = 0;
       Status   = DppDbGetPropertyBuffer (
                    &DevicePathPropertyData->Protocol,
@@ -861,113 +1050,43 @@ OcDevicePathPropertyInstallProtocol (
                    &DataSize
                    );
 
-      if (Status != EFI_BUFFER_TOO_SMALL) {
-        FreePool (DevicePathPropertyData);
-        return NULL;
-      }
-
-      Buffer = AllocateZeroPool (DataSize);
-      if (Buffer == NULL) {
-        FreePool (DevicePathPropertyData);
-        return NULL;
-      }
-
-      Status = DppDbGetPropertyBuffer (
-                 &DevicePathPropertyData->Protocol,
-                 Buffer,
-                 &DataSize
-                 );
-      if (EFI_ERROR (Status)) {
-        FreePool (Buffer);
-        FreePool (DevicePathPropertyData);
-        return NULL;
-      }
-
-      VariableIndex = 0;
-      Attributes = (EFI_VARIABLE_NON_VOLATILE
-                  | EFI_VARIABLE_BOOTSERVICE_ACCESS
-                  | EFI_VARIABLE_RUNTIME_ACCESS);
-      BufferPtr = (UINT8 *) Buffer;
-
-      while (VariableIndex < APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM && DataSize > 0) {
-        UnicodeSPrint (
-          &IndexBuffer[0],
-          sizeof (IndexBuffer),
-          L"%04x",
-          VariableIndex
-          );
-
-        StrCpyS (VariableName, ARRAY_SIZE (VariableName), APPLE_PATH_PROPERTIES_VARIABLE_NAME);
-        StrCatS (VariableName, ARRAY_SIZE (VariableName), IndexBuffer);
-
-        VariableSize = MIN (
-                         DataSize,
-                         APPLE_PATH_PROPERTY_VARIABLE_MAX_SIZE
-                         );
-
-        Status = gRT->SetVariable (
-                        VariableName,
-                        &gAppleVendorVariableGuid,
-                        Attributes,
-                        VariableSize,
-                        BufferPtr
-                        );
+      if (Status == EFI_BUFFER_TOO_SMALL) {
+        Buffer = AllocateZeroPool (DataSize);
+        if (Buffer != NULL) {
+          Status = DppDbGetPropertyBuffer (
+                     &DevicePathPropertyData->Protocol,
+                     Buffer,
+                     &DataSize
+                     );
 
-        if (EFI_ERROR (Status)) {
-          break;
+          if (!EFI_ERROR (Status)) {
+            Status = InternalWriteEfiVariableProperties (
+                       &gAppleVendorVariableGuid,
+                       EFI_VARIABLE_NON_VOLATILE
+                         | EFI_VARIABLE_BOOTSERVICE_ACCESS
+                         | EFI_VARIABLE_RUNTIME_ACCESS,
+                       (UINT8 *) Buffer,
+                       DataSize,
+                       &VendorChunks
+                       );
+          }
+
+          FreePool (Buffer);
+        } else {
+          Status = EFI_OUT_OF_RESOURCES;
         }
-
-        BufferPtr += VariableSize;
-        DataSize  -= VariableSize;
-        ++VariableIndex;
-      }
-
-      FreePool (Buffer);
-      if (EFI_ERROR (Status) || DataSize != 0) {
-        FreePool (DevicePathPropertyData);
-        return NULL;
+      } else {
+        Status = EFI_DEVICE_ERROR;
       }
+    }
 
-      while (!EFI_ERROR (Status) && VariableIndex < APPLE_PATH_PROPERTY_VARIABLE_MAX_NUM) {
-        UnicodeSPrint (
-          &IndexBuffer[0],
-          sizeof (IndexBuffer),
-          L"%04x",
-          VariableIndex
-          );
-
-        StrCpyS (VariableName, ARRAY_SIZE (VariableName), APPLE_PATH_PROPERTIES_VARIABLE_NAME);
-        StrCatS (VariableName, ARRAY_SIZE (VariableName), IndexBuffer);
-
-        VariableSize = 0;
-        Status       = gRT->GetVariable (
-                              VariableName,
-                              &gAppleVendorVariableGuid,
-                              &Attributes,
-                              &VariableSize,
-                              NULL
-                              );
-
-        if (Status != EFI_BUFFER_TOO_SMALL) {
-          Status = EFI_SUCCESS;
-          break;
-        }
-
-        Status       = gRT->SetVariable (
-                              VariableName,
-                              &gAppleVendorVariableGuid,
-                              Attributes,
-                              0,
-                              NULL
-                              );
-
-        ++VariableIndex;
-      }
+    if (VendorChunks.Data != NULL) {
+      FreePool (VendorChunks.Data);
+    }
 
-      if (EFI_ERROR (Status)) {
-        FreePool (DevicePathPropertyData);
-        return NULL;
-      }
+    if (EFI_ERROR (Status)) {
+      FreePool (DevicePathPropertyData);
+      return NULL;
     }
 
     DevicePathPropertyData->Modified = FALSE;
@@ -0,0 +1,917 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/FileInfo.h>
+
+#include <Protocol/BlockIo.h>
+#include <Protocol/SimpleFileSystem.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcFileLib.h>
+#include <Library/OcStringLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+//
+// Directories with more entries are not cached.
+//
+#define INTERNAL_FILE_CACHE_MAX_ENTRIES      512U
+
+//
+// Amount of directories cached per volume.
+//
+#define INTERNAL_FILE_CACHE_MAX_DIRECTORIES  64U
+
+//
+// Initial directory entry buffer size, grown on demand.
+//
+#define INTERNAL_FILE_CACHE_ENTRY_SIZE       (SIZE_OF_EFI_FILE_INFO + 256 * sizeof (CHAR16))
+
+#define INTERNAL_FILE_CACHE_FILE_SIGNATURE  \
+  SIGNATURE_32 ('O', 'F', 'C', 'f')
+
+#define INTERNAL_FILE_CACHE_FROM_PROTOCOL(This) \
+  CR (                                  \
+    This,                               \
+    INTERNAL_FILE_CACHE_FILE,           \
+    Protocol,                           \
+    INTERNAL_FILE_CACHE_FILE_SIGNATURE  \
+    )
+
+typedef struct INTERNAL_FILE_CACHE_DIRECTORY_ INTERNAL_FILE_CACHE_DIRECTORY;
+
+struct INTERNAL_FILE_CACHE_DIRECTORY_ {
+  INTERNAL_FILE_CACHE_DIRECTORY  *Next;
+  //
+  // Normalised absolute path without trailing separator, empty for root.
+  //
+  CHAR16                         *Path;
+  //
+  // EFI_SUCCESS when the listing is complete, EFI_NOT_FOUND when the directory
+  // does not exist, and EFI_UNSUPPORTED when it cannot be cached.
+  //
+  EFI_STATUS                     Status;
+  UINTN                          NumEntries;
+  EFI_FILE_INFO                  **Entries;
+};
+
+typedef struct INTERNAL_FILE_CACHE_VOLUME_ INTERNAL_FILE_CACHE_VOLUME;
+
+struct INTERNAL_FILE_CACHE_VOLUME_ {
+  INTERNAL_FILE_CACHE_VOLUME       *Next;
+  EFI_HANDLE                       Device;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_BLOCK_IO_PROTOCOL            *BlockIo;
+  UINT32                           MediaId;
+  UINTN                            NumDirectories;
+  INTERNAL_FILE_CACHE_DIRECTORY    *Directories;
+};
+
+typedef struct {
+  UINT32                      Signature;
+  EFI_FILE_PROTOCOL           *File;
+  INTERNAL_FILE_CACHE_VOLUME  *Volume;
+  //
+  // Normalised absolute path or NULL when it cannot be tracked.
+  //
+  CHAR16                      *Path;
+  EFI_FILE_PROTOCOL           Protocol;
+} INTERNAL_FILE_CACHE_FILE;
+
+//
+// Volume caches are kept for the lifetime of the module, as cached file
+// handles reference them, and are looked up by device handle. Nothing is
+// attached to the device handles, so detached devices leave no dangling
+// protocol behind, and reused handles are detected by their protocols.
+//
+STATIC INTERNAL_FILE_CACHE_VOLUME  *mInternalFileCacheVolumes;
+
+STATIC
+VOID
+InternalFileCacheFlush (
+  IN OUT INTERNAL_FILE_CACHE_VOLUME  *Volume
+  )
+{
+  INTERNAL_FILE_CACHE_DIRECTORY  *Directory;
+  UINTN                          Index;
+
+  while (Volume->Directories != NULL) {
+    Directory           = Volume->Directories;
+    Volume->Directories = Directory->Next;
+
+    for (Index = 0; Index < Directory->NumEntries; ++Index) {
+      FreePool (Directory->Entries[Index]);
+    }
+
+    if (Directory->Entries != NULL) {
+      FreePool (Directory->Entries);
+    }
+
+    FreePool (Directory->Path);
+    FreePool (Directory);
+  }
+
+  Volume->NumDirectories = 0;
+}
+
+STATIC
+VOID
+InternalFileCacheCheckMedia (
+  IN OUT INTERNAL_FILE_CACHE_VOLUME  *Volume
+  )
+{
+  if (Volume->BlockIo == NULL) {
+    return;
+  }
+
+  if (!Volume->BlockIo->Media->MediaPresent
+    || Volume->BlockIo->Media->MediaId != Volume->MediaId) {
+    DEBUG ((DEBUG_VERBOSE, "OCF: Media changed, dropping file cache\n"));
+    InternalFileCacheFlush (Volume);
+    Volume->MediaId = Volume->BlockIo->Media->MediaId;
+  }
+}
+
+/**
+  Append FileName to a normalised BasePath.
+
+  Only names which are guaranteed to match directory listings are supported:
+  non-ASCII characters, FAT short names and trailing dots or spaces are
+  left to the file system driver.
+
+  @param[in]  BasePath  Normalised path of the directory FileName is relative to.
+  @param[in]  FileName  File name as passed to EFI_FILE_PROTOCOL.Open.
+
+  @retval normalised path or NULL.
+**/
+STATIC
+CHAR16 *
+InternalFileCacheJoinPath (
+  IN CONST CHAR16  *BasePath,
+  IN CONST CHAR16  *FileName
+  )
+{
+  CHAR16  *Path;
+  UINTN   BaseLength;
+  UINTN   Length;
+  UINTN   Index;
+  UINTN   Start;
+
+  BaseLength = OcStrLen (BasePath);
+  Path       = AllocatePool ((BaseLength + OcStrLen (FileName) + 2) * sizeof (CHAR16));
+  if (Path == NULL) {
+    return NULL;
+  }
+
+  Length = 0;
+  if (FileName[0] != L'\\') {
+    CopyMem (Path, BasePath, BaseLength * sizeof (CHAR16));
+    Length = BaseLength;
+  }
+
+  Index = 0;
+  while (FileName[Index] != L'\0') {
+    if (FileName[Index] == L'\\') {
+      ++Index;
+      continue;
+    }
+
+    Start = Index;
+    while (FileName[Index] != L'\0' && FileName[Index] != L'\\') {
+      if (FileName[Index] >= 0x80 || FileName[Index] == L'~') {
+        FreePool (Path);
+        return NULL;
+      }
+      ++Index;
+    }
+
+    if (Index - Start == 1 && FileName[Start] == L'.') {
+      continue;
+    }
+
+    if (Index - Start == 2 && FileName[Start] == L'.' && FileName[Start + 1] == L'.') {
+      if (Length == 0) {
+        FreePool (Path);
+        return NULL;
+      }
+
+      do {
+        --Length;
+      } while (Path[Length] != L'\\');
+      continue;
+    }
+
+    if (FileName[Index - 1] == L'.' || FileName[Index - 1] == L' ') {
+      FreePool (Path);
+      return NULL;
+    }
+
+    Path[Length++] = L'\\';
+    CopyMem (&Path[Length], &FileName[Start], (Index - Start) * sizeof (CHAR16));
+    Length += Index - Start;
+  }
+
+  Path[Length] = L'\0';
+
+  return Path;
+}
+
+STATIC
+BOOLEAN
+InternalFileCacheNameEqual (
+  IN CONST CHAR16  *Name,
+  IN CONST CHAR16  *Component,
+  IN UINTN         ComponentLength
+  )
+{
+  UINTN   Index;
+  CHAR16  Left;
+  CHAR16  Right;
+
+  for (Index = 0; Index < ComponentLength; ++Index) {
+    Left  = Name[Index];
+    Right = Component[Index];
+
+    if (Left >= L'a' && Left <= L'z') {
+      Left -= L'a' - L'A';
+    }
+
+    if (Right >= L'a' && Right <= L'z') {
+      Right -= L'a' - L'A';
+    }
+
+    if (Left != Right) {
+      return FALSE;
+    }
+  }
+
+  return Name[ComponentLength] == L'\0';
+}
+
+STATIC
+EFI_STATUS
+InternalFileCacheListDirectory (
+  IN OUT INTERNAL_FILE_CACHE_DIRECTORY  *Directory,
+  IN     EFI_FILE_PROTOCOL              *Handle
+  )
+{
+  EFI_STATUS     Status;
+  EFI_FILE_INFO  *Buffer;
+  EFI_FILE_INFO  *Entry;
+  EFI_FILE_INFO  **Entries;
+  UINTN          BufferSize;
+  UINTN          Size;
+  UINTN          Capacity;
+
+  BufferSize = INTERNAL_FILE_CACHE_ENTRY_SIZE;
+  Buffer     = AllocatePool (BufferSize);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Capacity = 0;
+
+  while (TRUE) {
+    Size   = BufferSize;
+    Status = Handle->Read (Handle, &Size, Buffer);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      FreePool (Buffer);
+      BufferSize = Size;
+      Buffer     = AllocatePool (BufferSize);
+      if (Buffer == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+      continue;
+    }
+
+    if (EFI_ERROR (Status) || Size == 0) {
+      break;
+    }
+
+    if (Size < SIZE_OF_EFI_FILE_INFO) {
+      Status = EFI_VOLUME_CORRUPTED;
+      break;
+    }
+
+    if (Directory->NumEntries == INTERNAL_FILE_CACHE_MAX_ENTRIES) {
+      Status = EFI_UNSUPPORTED;
+      break;
+    }
+
+    if (Directory->NumEntries == Capacity) {
+      Entries = ReallocatePool (
+        Capacity * sizeof (*Entries),
+        MAX (Capacity * 2, 16) * sizeof (*Entries),
+        Directory->Entries
+        );
+      if (Entries == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      Directory->Entries = Entries;
+      Capacity           = MAX (Capacity * 2, 16);
+    }
+
+    Entry = AllocateCopyPool (Size, Buffer);
+    if (Entry == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+
+    //
+    // Make sure the name is terminated for comparison.
+    //
+    *(CHAR16 *) ((UINT8 *) Entry + Size - sizeof (CHAR16)) = L'\0';
+    Entry->Size = Size;
+
+    Directory->Entries[Directory->NumEntries] = Entry;
+    ++Directory->NumEntries;
+  }
+
+  FreePool (Buffer);
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+InternalFileCacheLookup (
+  IN OUT INTERNAL_FILE_CACHE_VOLUME  *Volume,
+  IN     CONST CHAR16                *Path,
+  IN     UINTN                       PathLength,
+     OUT EFI_FILE_INFO               **FileInfo
+  );
+
+STATIC
+EFI_STATUS
+InternalFileCacheGetDirectory (
+  IN OUT INTERNAL_FILE_CACHE_VOLUME     *Volume,
+  IN     CONST CHAR16                   *Path,
+  IN     UINTN                          PathLength,
+     OUT INTERNAL_FILE_CACHE_DIRECTORY  **Directory
+  )
+{
+  EFI_STATUS                     Status;
+  INTERNAL_FILE_CACHE_DIRECTORY  *NewDirectory;
+  EFI_FILE_INFO                  *FileInfo;
+  EFI_FILE_PROTOCOL              *RootHandle;
+  EFI_FILE_PROTOCOL              *DirectoryHandle;
+  UINTN                          Index;
+
+  for (NewDirectory = Volume->Directories; NewDirectory != NULL; NewDirectory = NewDirectory->Next) {
+    if (StrnCmp (NewDirectory->Path, Path, PathLength) == 0
+      && NewDirectory->Path[PathLength] == L'\0') {
+      *Directory = NewDirectory;
+      return EFI_SUCCESS;
+    }
+  }
+
+  //
+  // Parent listings tell whether this directory exists before trying to open it.
+  //
+  if (PathLength > 0) {
+    Status = InternalFileCacheLookup (Volume, Path, PathLength, &FileInfo);
+    if (Status == EFI_SUCCESS && (FileInfo->Attribute & EFI_FILE_DIRECTORY) == 0) {
+      Status = EFI_NOT_FOUND;
+    }
+  } else {
+    Status = EFI_SUCCESS;
+  }
+
+  if (Volume->NumDirectories == INTERNAL_FILE_CACHE_MAX_DIRECTORIES) {
+    return Status == EFI_NOT_FOUND ? EFI_NOT_FOUND : EFI_UNSUPPORTED;
+  }
+
+  NewDirectory = AllocateZeroPool (sizeof (*NewDirectory));
+  if (NewDirectory == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  NewDirectory->Path = AllocatePool ((PathLength + 1) * sizeof (CHAR16));
+  if (NewDirectory->Path == NULL) {
+    FreePool (NewDirectory);
+    return EFI_UNSUPPORTED;
+  }
+
+  CopyMem (NewDirectory->Path, Path, PathLength * sizeof (CHAR16));
+  NewDirectory->Path[PathLength] = L'\0';
+
+  if (Status == EFI_NOT_FOUND) {
+    NewDirectory->Status = EFI_NOT_FOUND;
+  } else {
+    //
+    // Absolute paths are only valid relative to the volume root,
+    // any other handle may be a regular file.
+    //
+    Status = Volume->FileSystem->OpenVolume (Volume->FileSystem, &RootHandle);
+    if (!EFI_ERROR (Status)) {
+      if (PathLength == 0) {
+        DirectoryHandle = RootHandle;
+      } else {
+        Status = RootHandle->Open (RootHandle, &DirectoryHandle, NewDirectory->Path, EFI_FILE_MODE_READ, 0);
+        RootHandle->Close (RootHandle);
+      }
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = InternalFileCacheListDirectory (NewDirectory, DirectoryHandle);
+      DirectoryHandle->Close (DirectoryHandle);
+    }
+
+    if (Status != EFI_SUCCESS) {
+      //
+      // Failed listings are kept to avoid retrying them, but never answer lookups.
+      //
+      DEBUG ((DEBUG_VERBOSE, "OCF: Not caching directory %s - %r\n", NewDirectory->Path, Status));
+      NewDirectory->Status = Status == EFI_NOT_FOUND ? EFI_NOT_FOUND : EFI_UNSUPPORTED;
+
+      for (Index = 0; Index < NewDirectory->NumEntries; ++Index) {
+        FreePool (NewDirectory->Entries[Index]);
+      }
+
+      if (NewDirectory->Entries != NULL) {
+        FreePool (NewDirectory->Entries);
+        NewDirectory->Entries = NULL;
+      }
+
+      NewDirectory->NumEntries = 0;
+    }
+  }
+
+  NewDirectory->Next  = Volume->Directories;
+  Volume->Directories = NewDirectory;
+  ++Volume->NumDirectories;
+
+  *Directory = NewDirectory;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find directory entry for a normalised non-root path.
+
+  @param[in,out]  Volume      Volume cache.
+  @param[in]      Path        Normalised path, not necessarily terminated.
+  @param[in]      PathLength  Path length in characters.
+  @param[out]     FileInfo    Cached directory entry on success.
+
+  @retval EFI_SUCCESS      Path exists.
+  @retval EFI_NOT_FOUND    Path definitely does not exist.
+  @retval EFI_UNSUPPORTED  Path existence is unknown.
+**/
+STATIC
+EFI_STATUS
+InternalFileCacheLookup (
+  IN OUT INTERNAL_FILE_CACHE_VOLUME  *Volume,
+  IN     CONST CHAR16                *Path,
+  IN     UINTN                       PathLength,
+     OUT EFI_FILE_INFO               **FileInfo
+  )
+{
+  EFI_STATUS                     Status;
+  INTERNAL_FILE_CACHE_DIRECTORY  *Directory;
+  EFI_FILE_INFO                  *Entry;
+  UINTN                          ParentLength;
+  UINTN                          Index;
+
+  ASSERT (PathLength > 0);
+
+  ParentLength = PathLength - 1;
+  while (Path[ParentLength] != L'\\') {
+    --ParentLength;
+  }
+
+  Status = InternalFileCacheGetDirectory (Volume, Path, ParentLength, &Directory);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (EFI_ERROR (Directory->Status)) {
+    return Directory->Status;
+  }
+
+  //
+  // Prefer exact name match as the file system may be case sensitive.
+  //
+  *FileInfo = NULL;
+  for (Index = 0; Index < Directory->NumEntries; ++Index) {
+    Entry = Directory->Entries[Index];
+    if (StrnCmp (Entry->FileName, &Path[ParentLength + 1], PathLength - ParentLength - 1) == 0
+      && Entry->FileName[PathLength - ParentLength - 1] == L'\0') {
+      *FileInfo = Entry;
+      return EFI_SUCCESS;
+    }
+
+    if (*FileInfo == NULL
+      && InternalFileCacheNameEqual (
+        Entry->FileName,
+        &Path[ParentLength + 1],
+        PathLength - ParentLength - 1
+        )) {
+      *FileInfo = Entry;
+    }
+  }
+
+  return *FileInfo != NULL ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+STATIC
+EFI_FILE_PROTOCOL *
+InternalFileCacheCreateFile (
+  IN INTERNAL_FILE_CACHE_VOLUME  *Volume,
+  IN EFI_FILE_PROTOCOL           *File,
+  IN CHAR16                      *Path  OPTIONAL
+  );
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheOpen (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT EFI_FILE_PROTOCOL  **NewHandle,
+  IN  CHAR16             *FileName,
+  IN  UINT64             OpenMode,
+  IN  UINT64             Attributes
+  )
+{
+  EFI_STATUS                Status;
+  INTERNAL_FILE_CACHE_FILE  *Data;
+  CHAR16                    *Path;
+  EFI_FILE_INFO             *FileInfo;
+  EFI_FILE_PROTOCOL         *NewFile;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  InternalFileCacheCheckMedia (Data->Volume);
+
+  Path = NULL;
+  if (Data->Path != NULL && FileName != NULL) {
+    Path = InternalFileCacheJoinPath (Data->Path, FileName);
+  }
+
+  if (OpenMode != EFI_FILE_MODE_READ) {
+    InternalFileCacheFlush (Data->Volume);
+  } else if (Path != NULL && Path[0] != L'\0') {
+    Status = InternalFileCacheLookup (Data->Volume, Path, OcStrLen (Path), &FileInfo);
+    if (Status == EFI_NOT_FOUND) {
+      FreePool (Path);
+      return EFI_NOT_FOUND;
+    }
+  }
+
+  Status = Data->File->Open (Data->File, &NewFile, FileName, OpenMode, Attributes);
+  if (EFI_ERROR (Status)) {
+    if (Path != NULL) {
+      FreePool (Path);
+    }
+    return Status;
+  }
+
+  *NewHandle = InternalFileCacheCreateFile (Data->Volume, NewFile, Path);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheClose (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  EFI_STATUS                Status;
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  Status = Data->File->Close (Data->File);
+  if (Data->Path != NULL) {
+    FreePool (Data->Path);
+  }
+  FreePool (Data);
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheDelete (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  EFI_STATUS                Status;
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  InternalFileCacheFlush (Data->Volume);
+
+  Status = Data->File->Delete (Data->File);
+  if (Data->Path != NULL) {
+    FreePool (Data->Path);
+  }
+  FreePool (Data);
+
+  return Status;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheRead (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+     OUT VOID               *Buffer
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  return Data->File->Read (Data->File, BufferSize, Buffer);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheWrite (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN OUT UINTN              *BufferSize,
+  IN     VOID               *Buffer
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  InternalFileCacheFlush (Data->Volume);
+
+  return Data->File->Write (Data->File, BufferSize, Buffer);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheGetPosition (
+  IN  EFI_FILE_PROTOCOL  *This,
+  OUT UINT64             *Position
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  return Data->File->GetPosition (Data->File, Position);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheSetPosition (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN UINT64             Position
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  return Data->File->SetPosition (Data->File, Position);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheGetInfo (
+  IN     EFI_FILE_PROTOCOL  *This,
+  IN     EFI_GUID           *InformationType,
+  IN OUT UINTN              *BufferSize,
+     OUT VOID               *Buffer
+  )
+{
+  EFI_STATUS                Status;
+  INTERNAL_FILE_CACHE_FILE  *Data;
+  EFI_FILE_INFO             *FileInfo;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  if (Data->Path != NULL
+    && Data->Path[0] != L'\0'
+    && CompareGuid (InformationType, &gEfiFileInfoGuid)) {
+    InternalFileCacheCheckMedia (Data->Volume);
+
+    Status = InternalFileCacheLookup (
+      Data->Volume,
+      Data->Path,
+      OcStrLen (Data->Path),
+      &FileInfo
+      );
+    if (Status == EFI_SUCCESS) {
+      if (*BufferSize < FileInfo->Size) {
+        *BufferSize = (UINTN) FileInfo->Size;
+        return EFI_BUFFER_TOO_SMALL;
+      }
+
+      *BufferSize = (UINTN) FileInfo->Size;
+      CopyMem (Buffer, FileInfo, *BufferSize);
+      return EFI_SUCCESS;
+    }
+  }
+
+  return Data->File->GetInfo (Data->File, InformationType, BufferSize, Buffer);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheSetInfo (
+  IN EFI_FILE_PROTOCOL  *This,
+  IN EFI_GUID           *InformationType,
+  IN UINTN              BufferSize,
+  IN VOID               *Buffer
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  InternalFileCacheFlush (Data->Volume);
+
+  return Data->File->SetInfo (Data->File, InformationType, BufferSize, Buffer);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+InternalFileCacheFlushFile (
+  IN EFI_FILE_PROTOCOL  *This
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = INTERNAL_FILE_CACHE_FROM_PROTOCOL (This);
+
+  InternalFileCacheFlush (Data->Volume);
+
+  return Data->File->Flush (Data->File);
+}
+
+STATIC
+CONST
+EFI_FILE_PROTOCOL
+mInternalFileCacheProtocolTemplate = {
+  .Revision    = EFI_FILE_PROTOCOL_REVISION,
+  .Open        = InternalFileCacheOpen,
+  .Close       = InternalFileCacheClose,
+  .Delete      = InternalFileCacheDelete,
+  .Read        = InternalFileCacheRead,
+  .Write       = InternalFileCacheWrite,
+  .GetPosition = InternalFileCacheGetPosition,
+  .SetPosition = InternalFileCacheSetPosition,
+  .GetInfo     = InternalFileCacheGetInfo,
+  .SetInfo     = InternalFileCacheSetInfo,
+  .Flush       = InternalFileCacheFlushFile
+};
+
+/**
+  Wrap file handle into a caching one. When out of memory the original
+  handle is returned, which stays functional just without caching.
+
+  @param[in]  Volume  Volume cache.
+  @param[in]  File    Original file handle, owned by the wrapper.
+  @param[in]  Path    Normalised file path, owned by the wrapper.
+
+  @retval file handle.
+**/
+STATIC
+EFI_FILE_PROTOCOL *
+InternalFileCacheCreateFile (
+  IN INTERNAL_FILE_CACHE_VOLUME  *Volume,
+  IN EFI_FILE_PROTOCOL           *File,
+  IN CHAR16                      *Path  OPTIONAL
+  )
+{
+  INTERNAL_FILE_CACHE_FILE  *Data;
+
+  Data = AllocatePool (sizeof (*Data));
+  if (Data == NULL) {
+    if (Path != NULL) {
+      FreePool (Path);
+    }
+    return File;
+  }
+
+  Data->Signature = INTERNAL_FILE_CACHE_FILE_SIGNATURE;
+  Data->File      = File;
+  Data->Volume    = Volume;
+  Data->Path      = Path;
+  CopyMem (&Data->Protocol, &mInternalFileCacheProtocolTemplate, sizeof (Data->Protocol));
+
+  return &Data->Protocol;
+}
+
+EFI_STATUS
+OcFileCacheOpenVolume (
+  IN  EFI_HANDLE         Device,
+  OUT EFI_FILE_PROTOCOL  **Root
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_BLOCK_IO_PROTOCOL            *BlockIo;
+  INTERNAL_FILE_CACHE_VOLUME       *Volume;
+  EFI_FILE_PROTOCOL                *RealRoot;
+  CHAR16                           *Path;
+
+  Status = gBS->HandleProtocol (
+    Device,
+    &gEfiSimpleFileSystemProtocolGuid,
+    (VOID **) &FileSystem
+    );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = FileSystem->OpenVolume (FileSystem, &RealRoot);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = gBS->HandleProtocol (
+    Device,
+    &gEfiBlockIoProtocolGuid,
+    (VOID **) &BlockIo
+    );
+  if (EFI_ERROR (Status)) {
+    BlockIo = NULL;
+  }
+
+  for (Volume = mInternalFileCacheVolumes; Volume != NULL; Volume = Volume->Next) {
+    if (Volume->Device == Device) {
+      break;
+    }
+  }
+
+  if (Volume == NULL) {
+    Volume = AllocateZeroPool (sizeof (*Volume));
+    if (Volume == NULL) {
+      *Root = RealRoot;
+      return EFI_SUCCESS;
+    }
+
+    Volume->Device            = Device;
+    Volume->Next              = mInternalFileCacheVolumes;
+    mInternalFileCacheVolumes = Volume;
+  } else if (Volume->FileSystem != FileSystem || Volume->BlockIo != BlockIo) {
+    //
+    // File system driver was reconnected or the handle was reused.
+    //
+    InternalFileCacheFlush (Volume);
+  }
+
+  Volume->FileSystem = FileSystem;
+  Volume->BlockIo    = BlockIo;
+  if (Volume->Directories == NULL && BlockIo != NULL) {
+    Volume->MediaId = BlockIo->Media->MediaId;
+  }
+
+  InternalFileCacheCheckMedia (Volume);
+
+  Path = AllocateZeroPool (sizeof (CHAR16));
+  if (Path == NULL) {
+    *Root = RealRoot;
+    return EFI_SUCCESS;
+  }
+
+  *Root = InternalFileCacheCreateFile (Volume, RealRoot, Path);
+  return EFI_SUCCESS;
+}
+
+VOID
+OcFileCacheInvalidate (
+  IN EFI_HANDLE  Device  OPTIONAL
+  )
+{
+  INTERNAL_FILE_CACHE_VOLUME  *Volume;
+
+  for (Volume = mInternalFileCacheVolumes; Volume != NULL; Volume = Volume->Next) {
+    if (Device == NULL || Volume->Device == Device) {
+      InternalFileCacheFlush (Volume);
+    }
+  }
+}
@@ -28,6 +28,11 @@
 #include <Library/OcDevicePathLib.h>
 #include <Library/OcFileLib.h>
 
+//
+// Initial buffer size for single call information reads.
+//
+#define OC_FILE_INFO_GUESS_SIZE  (SIZE_OF_EFI_FILE_INFO + 128 * sizeof (CHAR16))
+
 VOID *
 GetFileInfo (
   IN  EFI_FILE_PROTOCOL  *File,
@@ -41,38 +46,53 @@ GetFileInfo (
   UINTN      FileInfoSize;
   EFI_STATUS Status;
 
-  FileInfoSize   = 0;
-  FileInfoBuffer = NULL;
+  //
+  // Most information fits the guessed size, so try reading it at once
+  // and only fall back to the size probe when the buffer is too small.
+  //
+  FileInfoSize   = MAX (MinFileInfoSize, OC_FILE_INFO_GUESS_SIZE);
+  FileInfoBuffer = AllocateZeroPool (FileInfoSize);
+
+  if (FileInfoBuffer == NULL) {
+    return NULL;
+  }
 
   Status = File->GetInfo (
                    File,
                    InformationType,
                    &FileInfoSize,
-                   NULL
+                   FileInfoBuffer
                    );
 
-  if (Status == EFI_BUFFER_TOO_SMALL && FileInfoSize >= MinFileInfoSize) {
-    FileInfoBuffer = AllocateZeroPool (FileInfoSize);
-
-    if (FileInfoBuffer != NULL) {
-      Status = File->GetInfo (
-                       File,
-                       InformationType,
-                       &FileInfoSize,
-                       FileInfoBuffer
-                       );
-
-      if (!EFI_ERROR (Status)) {
-        if (RealFileInfoSize != NULL) {
-          *RealFileInfoSize = FileInfoSize;
-        }
-      } else {
-        FreePool (FileInfoBuffer);
-
-        FileInfoBuffer = NULL;
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    FreePool (FileInfoBuffer);
+    FileInfoBuffer = NULL;
+
+    if (FileInfoSize >= MinFileInfoSize) {
+      FileInfoBuffer = AllocateZeroPool (FileInfoSize);
+
+      if (FileInfoBuffer != NULL) {
+        Status = File->GetInfo (
+                         File,
+                         InformationType,
+                         &FileInfoSize,
+                         FileInfoBuffer
+                         );
       }
     }
   }
 
+  if (FileInfoBuffer != NULL) {
+    if (!EFI_ERROR (Status) && FileInfoSize >= MinFileInfoSize) {
+      if (RealFileInfoSize != NULL) {
+        *RealFileInfoSize = FileInfoSize;
+      }
+    } else {
+      FreePool (FileInfoBuffer);
+
+      FileInfoBuffer = NULL;
+    }
+  }
+
   return FileInfoBuffer;
-}
\ No newline at end of file
+}
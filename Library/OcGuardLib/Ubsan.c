@@ -1185,10 +1185,13 @@ Report(bool isFatal, const char *pFormat, ...)
 
 	va_start(ap, pFormat);
 #if defined(_KERNEL)
-	if (isFatal || alwaysFatal)
+	// OC change: printing to console is slow, so queue non-fatal reports.
+	if (isFatal || alwaysFatal) {
+		InternalUbsanFlushReports();
 		vpanic(pFormat, ap);
-	else
-		vprintf(pFormat, ap);
+	} else {
+		InternalUbsanQueueReport(pFormat, ap);
+	}
 #else
 	if (ubsan_flags == -1) {
 		char buf[1024];
@@ -1277,6 +1280,14 @@ isAlreadyReported(struct CSourceLocation *pLocation)
 
 	pLine = &pLocation->mLine;
 
+#if defined(_KERNEL)
+	// OC change: count every hit, and avoid the locked exchange for locations
+	// already reported, as these are the ones firing in hot loops.
+	InternalUbsanTrackLocation(pLocation, pLocation->mFilename, *pLine & (uint32_t)~ACK_REPORTED, pLocation->mColumn);
+	if (ISSET(*pLine, ACK_REPORTED))
+		return true;
+#endif
+
 	do {
 		siOldValue = *pLine;
 	} while (__sync_val_compare_and_swap(pLine, siOldValue, siOldValue | ACK_REPORTED) != siOldValue);
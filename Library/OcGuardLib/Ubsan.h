@@ -33,6 +33,14 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define HAVE_UBSAN_SUPPORT 1
 #endif
 
+// Runtime is built with every clang image, yet reports only come from the ones
+// compiled with -fsanitize. Older compilers cannot tell, define it manually.
+#if defined(HAVE_UBSAN_SUPPORT) && !defined(HAVE_UBSAN_INSTRUMENTATION) && defined(__has_feature)
+#if __has_feature(undefined_behavior_sanitizer)
+#define HAVE_UBSAN_INSTRUMENTATION 1
+#endif
+#endif
+
 
 // Mark long double as supported (since we may use softfp).
 #ifndef __HAVE_LONG_DOUBLE
@@ -93,11 +101,13 @@ typedef __SSIZE_TYPE__ ssize_t;
 #define true TRUE
 #endif
 
-// Provide va_list declarations.
+// Provide va_list declarations unless stdarg.h is already included.
+#ifndef va_start
 #define va_list VA_LIST
 #define va_start VA_START
 #define va_end VA_END
 #define va_arg VA_ARG
+#endif
 
 // Printing macros are not supported in EDK2.
 #ifndef PRIx8
@@ -211,8 +221,14 @@ int EFIAPI tfp_sprintf(char *str, const char *fmt, ...) __printflike(2, 3);
 #define vpanic(f, v) \
   do { vprintf (f, v); do { } while (1); } while (0)
 
+// Deduplicated report queue, see UbsanReport.c.
+void InternalUbsanTrackLocation(const void *Location, const char *FileName, uint32_t Line, uint32_t Column);
+void InternalUbsanQueueReport(const char *Format, va_list Args);
+void InternalUbsanFlushReports(void);
+
 // Avoid implementing memcpy as a function to avoid LTO conflicts.
-#define memcpy(Dst, Src, Size) do { gBS->CopyMem(Dst, Src, Size); } while (0)
+// Parenthesised not to expand CopyMem when it is a function-like macro.
+#define memcpy(Dst, Src, Size) do { (gBS->CopyMem)(Dst, Src, Size); } while (0)
 
 // Forcing VOID for those as the return types actually differ.
 #define strlcpy(Dst, Src, Size) do { AsciiStrnCpyS (Dst, Size, Src, AsciiStrLen (Src)); } while (0)
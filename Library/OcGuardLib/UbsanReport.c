@@ -0,0 +1,313 @@
+/** @file
+
+OcGuardLib
+
+Copyright (c) 2020, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include "Ubsan.h"
+
+#include <Library/OcGuardLib.h>
+
+#ifdef HAVE_UBSAN_SUPPORT
+
+//
+// Failing source locations, hashed by their descriptor address.
+// Must be a power of two.
+//
+#define UBSAN_LOCATION_SLOTS  256U
+#define UBSAN_LOCATION_PROBES 16U
+
+//
+// Queued reports printed at once when the queue fills up,
+// when a fatal report happens, and when the image is unloaded.
+//
+#define UBSAN_REPORT_SLOTS    32U
+#define UBSAN_REPORT_LENGTH   256U
+
+typedef struct {
+  CONST VOID   *Location;
+  CONST CHAR8  *FileName;
+  UINT32       Line;
+  UINT32       Column;
+  UINT64       Hits;
+} UBSAN_LOCATION_ENTRY;
+
+STATIC UBSAN_LOCATION_ENTRY  mUbsanLocations[UBSAN_LOCATION_SLOTS];
+STATIC UINT32                mUbsanLocationCount;
+STATIC UINT64                mUbsanUntrackedHits;
+
+STATIC CHAR8                 mUbsanReports[UBSAN_REPORT_SLOTS][UBSAN_REPORT_LENGTH];
+STATIC UINT32                mUbsanReportHead;
+STATIC UINT32                mUbsanReportCount;
+STATIC UINT32                mUbsanReportTotal;
+
+STATIC EFI_EVENT             mUbsanExitBootServicesEvent;
+STATIC BOOLEAN               mUbsanExitedBootServices;
+
+STATIC
+VOID
+InternalUbsanPrint (
+  IN CONST CHAR8  *Format,
+  ...
+  ) __printflike(1, 2);
+
+STATIC
+VOID
+InternalUbsanPrint (
+  IN CONST CHAR8  *Format,
+  ...
+  )
+{
+  VA_LIST  Args;
+
+  VA_START (Args, Format);
+  vprintf (Format, Args);
+  VA_END (Args);
+}
+
+VOID
+InternalUbsanFlushReports (
+  VOID
+  )
+{
+  UINT32  Index;
+
+  //
+  // Console is no longer available after ExitBootServices, keep the reports.
+  //
+  if (mUbsanExitedBootServices) {
+    return;
+  }
+
+  for (Index = 0; Index < mUbsanReportCount; ++Index) {
+    InternalUbsanPrint (
+      "%s",
+      mUbsanReports[(mUbsanReportHead + Index) % UBSAN_REPORT_SLOTS]
+      );
+  }
+
+  mUbsanReportHead  = (mUbsanReportHead + mUbsanReportCount) % UBSAN_REPORT_SLOTS;
+  mUbsanReportCount = 0;
+}
+
+STATIC
+VOID
+EFIAPI
+InternalUbsanExitBootServices (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  //
+  // Printing allocates memory, which is not allowed here. Whatever is still
+  // queued is dropped.
+  //
+  mUbsanExitedBootServices = TRUE;
+}
+
+VOID
+InternalUbsanTrackLocation (
+  IN CONST VOID   *Location,
+  IN CONST CHAR8  *FileName,
+  IN UINT32       Line,
+  IN UINT32       Column
+  )
+{
+  UINT32  Index;
+  UINT32  Probe;
+
+  Index = (UINT32) (((UINT64) (UINTN) Location * 0x9E3779B97F4A7C15ULL) >> 32U)
+    & (UBSAN_LOCATION_SLOTS - 1);
+
+  //
+  // This is called for every failed check, so keep the probe sequence short
+  // and just count the hits once the table is crowded.
+  //
+  for (Probe = 0; Probe < UBSAN_LOCATION_PROBES; ++Probe) {
+    if (mUbsanLocations[Index].Location == Location) {
+      ++mUbsanLocations[Index].Hits;
+      return;
+    }
+
+    if (mUbsanLocations[Index].Location == NULL) {
+      mUbsanLocations[Index].Location = Location;
+      mUbsanLocations[Index].FileName = FileName;
+      mUbsanLocations[Index].Line     = Line;
+      mUbsanLocations[Index].Column   = Column;
+      mUbsanLocations[Index].Hits     = 1;
+      ++mUbsanLocationCount;
+      return;
+    }
+
+    Index = (Index + 1) & (UBSAN_LOCATION_SLOTS - 1);
+  }
+
+  ++mUbsanUntrackedHits;
+}
+
+VOID
+InternalUbsanQueueReport (
+  IN CONST CHAR8  *Format,
+  IN VA_LIST      Args
+  )
+{
+  //
+  // Without the ExitBootServices event queued reports may never be printed.
+  //
+  if (mUbsanExitBootServicesEvent == NULL) {
+    vprintf (Format, Args);
+    ++mUbsanReportTotal;
+    return;
+  }
+
+  if (mUbsanReportCount == UBSAN_REPORT_SLOTS) {
+    InternalUbsanFlushReports ();
+
+    //
+    // Overwrite the oldest report when it cannot be printed.
+    //
+    if (mUbsanReportCount == UBSAN_REPORT_SLOTS) {
+      mUbsanReportHead = (mUbsanReportHead + 1) % UBSAN_REPORT_SLOTS;
+      --mUbsanReportCount;
+    }
+  }
+
+  tfp_vsnprintf (
+    mUbsanReports[(mUbsanReportHead + mUbsanReportCount) % UBSAN_REPORT_SLOTS],
+    UBSAN_REPORT_LENGTH,
+    Format,
+    Args
+    );
+
+  ++mUbsanReportCount;
+  ++mUbsanReportTotal;
+}
+
+VOID
+OcUbsanDumpReports (
+  VOID
+  )
+{
+  UINT32  Index;
+
+  InternalUbsanFlushReports ();
+
+  if (mUbsanLocationCount == 0 || mUbsanExitedBootServices) {
+    return;
+  }
+
+  InternalUbsanPrint (
+    "UBSan: %" PRIu32 " report(s) from %" PRIu32 " location(s)\n",
+    mUbsanReportTotal,
+    mUbsanLocationCount
+    );
+
+  for (Index = 0; Index < UBSAN_LOCATION_SLOTS; ++Index) {
+    if (mUbsanLocations[Index].Location != NULL) {
+      InternalUbsanPrint (
+        "UBSan: %s:%" PRIu32 ":%" PRIu32 " failed %" PRIu64 " time(s)\n",
+        mUbsanLocations[Index].FileName,
+        mUbsanLocations[Index].Line,
+        mUbsanLocations[Index].Column,
+        mUbsanLocations[Index].Hits
+        );
+    }
+  }
+
+  if (mUbsanUntrackedHits > 0) {
+    InternalUbsanPrint (
+      "UBSan: %" PRIu64 " failure(s) at untracked locations\n",
+      mUbsanUntrackedHits
+      );
+  }
+}
+
+EFI_STATUS
+EFIAPI
+OcGuardLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+#ifdef HAVE_UBSAN_INSTRUMENTATION
+  EFI_STATUS  Status;
+
+  //
+  // Reports may come at any TPL and even after ExitBootServices, so the event
+  // cannot be created on first report. Images without instrumentation never
+  // report and need no event.
+  //
+  Status = gBS->CreateEvent (
+    EVT_SIGNAL_EXIT_BOOT_SERVICES,
+    TPL_CALLBACK,
+    InternalUbsanExitBootServices,
+    NULL,
+    &mUbsanExitBootServicesEvent
+    );
+  if (EFI_ERROR (Status)) {
+    mUbsanExitBootServicesEvent = NULL;
+  }
+#endif
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcGuardLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  OcUbsanDumpReports ();
+
+  if (mUbsanExitBootServicesEvent != NULL) {
+    gBS->CloseEvent (mUbsanExitBootServicesEvent);
+    mUbsanExitBootServicesEvent = NULL;
+  }
+
+  return EFI_SUCCESS;
+}
+
+#else
+
+VOID
+OcUbsanDumpReports (
+  VOID
+  )
+{
+}
+
+EFI_STATUS
+EFIAPI
+OcGuardLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+OcGuardLibDestructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  return EFI_SUCCESS;
+}
+
+#endif // HAVE_UBSAN_SUPPORT
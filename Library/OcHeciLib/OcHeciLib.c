@@ -20,6 +20,27 @@
 #include <IndustryStandard/HeciMsg.h>
 #include <IndustryStandard/HeciClientMsg.h>
 
+//
+// Default timeout for a single HECI read in microseconds.
+//
+#define HECI_READ_TIMEOUT        SECONDS_TO_MICROSECONDS (5)
+
+//
+// Interval between non-blocking HECI read attempts in microseconds.
+//
+#define HECI_READ_POLL_INTERVAL  100
+
+//
+// Client responses kept while waiting for flow control from ME.
+//
+#define HECI_PENDING_MESSAGE_MAX   4
+#define HECI_PENDING_MESSAGE_SIZE  512
+
+typedef struct {
+  UINT32  Length;
+  UINT32  Data[HECI_PENDING_MESSAGE_SIZE / sizeof (UINT32)];
+} HECI_PENDING_MESSAGE;
+
 STATIC UINT8 mCurrentMeClientRequestedReceiveMsg;
 STATIC UINT8 mCurrentMeClientCanReceiveMsg;
 STATIC UINT8 mCurrentMeClientAddress;
@@ -29,6 +50,22 @@ STATIC EFI_HECI2_PROTOCOL *mHeci2;
 STATIC BOOLEAN mSendingHeciCommand;
 STATIC BOOLEAN mSendingHeciCommandPerClient;
 
+STATIC UINT32 mHeciReadTimeout = HECI_READ_TIMEOUT;
+
+STATIC HECI_PENDING_MESSAGE mPendingMessages[HECI_PENDING_MESSAGE_MAX];
+STATIC UINT32 mPendingMessageStart;
+STATIC UINT32 mPendingMessageCount;
+
+//
+// ME client map and properties do not change after ME initialisation,
+// so they are only requested once.
+//
+STATIC BOOLEAN mMeClientMapValid;
+STATIC UINT8 mMeClientMap[HBM_ME_CLIENT_MAX];
+STATIC UINT8 mMeClientActiveCount;
+STATIC UINT8 mMeClientPropertiesValid[HBM_ME_CLIENT_MAX / OC_CHAR_BIT];
+STATIC HECI_CLIENT_PROPERTIES mMeClientProperties[HBM_ME_CLIENT_MAX];
+
 EFI_STATUS
 HeciReadMessage (
   IN      UINT32           Blocking,
@@ -57,6 +94,50 @@ HeciReadMessage (
   return EFI_NOT_FOUND;
 }
 
+EFI_STATUS
+HeciReadMessageWithTimeout (
+  IN      UINT32           *MessageBody,
+  IN OUT  UINT32           *Length,
+  IN      UINT32           Timeout
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Size;
+  UINT32      Elapsed;
+
+  Size    = *Length;
+  Elapsed = 0;
+
+  while (TRUE) {
+    *Length = Size;
+    Status  = HeciReadMessage (
+      NON_BLOCKING,
+      MessageBody,
+      Length
+      );
+
+    if (Status != EFI_NOT_READY && Status != EFI_TIMEOUT) {
+      return Status;
+    }
+
+    if (Elapsed >= Timeout) {
+      *Length = 0;
+      return EFI_TIMEOUT;
+    }
+
+    gBS->Stall (HECI_READ_POLL_INTERVAL);
+    Elapsed += HECI_READ_POLL_INTERVAL;
+  }
+}
+
+VOID
+HeciSetReadTimeout (
+  IN UINT32  Timeout
+  )
+{
+  mHeciReadTimeout = Timeout;
+}
+
 EFI_STATUS
 HeciSendMessage (
   IN      UINT32           *Message,
@@ -127,28 +208,174 @@ HeciLocateProtocol (
   return Status;
 }
 
+/**
+  Check whether the message is a flow control message granting
+  the host a credit to send to the current ME client.
+
+  @param[in] Message  Message body.
+  @param[in] Length   Message length.
+
+  @retval TRUE when the message is flow control for the current client.
+**/
+STATIC
+BOOLEAN
+HeciIsClientFlowControl (
+  IN CONST VOID  *Message,
+  IN UINT32      Length
+  )
+{
+  CONST HBM_FLOW_CONTROL  *Command;
+
+  Command = (CONST HBM_FLOW_CONTROL *) Message;
+
+  return mSendingHeciCommandPerClient
+    && Length == sizeof (*Command)
+    && Command->Command.Fields.Command == FLOW_CONTROL
+    && Command->MeAddress == mCurrentMeClientAddress;
+}
+
+/**
+  Drop all client responses received but not yet consumed.
+**/
+STATIC
+VOID
+HeciResetPendingMessages (
+  VOID
+  )
+{
+  mPendingMessageStart = 0;
+  mPendingMessageCount = 0;
+}
+
+/**
+  Receive next message from ME and account flow control messages
+  for the current client.
+
+  When WantFlowControl is TRUE, this returns as soon as a flow control
+  message is received, and client responses received before it are
+  kept to be returned by later calls. Otherwise kept responses are
+  returned first, and flow control messages are only accounted.
+
+  @param[out]    Message          Message buffer, ignored for flow control.
+  @param[in,out] Length           Message buffer size on input,
+                                  message size on output.
+  @param[in]     WantFlowControl  Wait for flow control instead of data.
+
+  @retval EFI_SUCCESS on success.
+**/
+STATIC
+EFI_STATUS
+HeciReceiveMessage (
+  OUT    VOID     *Message  OPTIONAL,
+  IN OUT UINT32   *Length   OPTIONAL,
+  IN     BOOLEAN  WantFlowControl
+  )
+{
+  EFI_STATUS            Status;
+  HECI_PENDING_MESSAGE  *Pending;
+  UINT32                Buffer[HECI_PENDING_MESSAGE_SIZE / sizeof (UINT32)];
+  UINT32                Size;
+
+  if (!WantFlowControl && !mSendingHeciCommand && mPendingMessageCount > 0) {
+    Pending = &mPendingMessages[mPendingMessageStart];
+    *Length = MIN (*Length, Pending->Length);
+    CopyMem (Message, Pending->Data, *Length);
+    mPendingMessageStart = (mPendingMessageStart + 1) % HECI_PENDING_MESSAGE_MAX;
+    --mPendingMessageCount;
+    return EFI_SUCCESS;
+  }
+
+  while (TRUE) {
+    if (!WantFlowControl) {
+      //
+      // Read responses directly, flow control is small enough to fit any.
+      //
+      Size   = *Length;
+      Status = HeciReadMessageWithTimeout ((UINT32 *) Message, &Size, mHeciReadTimeout);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      if (HeciIsClientFlowControl (Message, Size)) {
+        ++mCurrentMeClientCanReceiveMsg;
+        continue;
+      }
+
+      *Length = Size;
+      return EFI_SUCCESS;
+    }
+
+    Size   = sizeof (Buffer);
+    Status = HeciReadMessageWithTimeout (Buffer, &Size, mHeciReadTimeout);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (HeciIsClientFlowControl (Buffer, Size)) {
+      ++mCurrentMeClientCanReceiveMsg;
+      return EFI_SUCCESS;
+    }
+
+    //
+    // ME responded to an earlier request before granting the credit, keep it.
+    //
+    if (mPendingMessageCount == HECI_PENDING_MESSAGE_MAX) {
+      DEBUG ((DEBUG_INFO, "OCME: Dropping %u byte response, too many pending\n", Size));
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Pending = &mPendingMessages[(mPendingMessageStart + mPendingMessageCount) % HECI_PENDING_MESSAGE_MAX];
+    Pending->Length = Size;
+    CopyMem (Pending->Data, Buffer, Size);
+    ++mPendingMessageCount;
+  }
+}
+
 VOID
 HeciUpdateReceiveMsgStatus (
   VOID
   )
+{
+  if (mSendingHeciCommandPerClient) {
+    HeciReceiveMessage (NULL, NULL, TRUE);
+  }
+}
+
+EFI_STATUS
+HeciGrantReceiveCredits (
+  IN UINT8  Count
+  )
 {
   EFI_STATUS        Status;
-  UINT32            Size;
   HBM_FLOW_CONTROL  Command;
 
-  if (mSendingHeciCommandPerClient) {
+  if (!mSendingHeciCommandPerClient) {
+    return EFI_NOT_READY;
+  }
+
+  Status = EFI_SUCCESS;
+
+  while (mCurrentMeClientRequestedReceiveMsg < Count) {
     ZeroMem (&Command, sizeof (Command));
-    Size = sizeof (Command);
-    Status = HeciReadMessage (
-      BLOCKING,
+    Command.Command.Fields.Command = FLOW_CONTROL;
+    Command.MeAddress              = mCurrentMeClientAddress;
+    Command.HostAddress            = HBM_CLIENT_ADDRESS;
+
+    Status = HeciSendMessage (
       (UINT32 *) &Command,
-      &Size
+      sizeof (Command),
+      HBM_HOST_ADDRESS,
+      HBM_ME_ADDRESS
       );
 
-    if (!EFI_ERROR (Status) && Command.Command.Fields.Command == FLOW_CONTROL) {
-      ++mCurrentMeClientCanReceiveMsg;
+    if (EFI_ERROR (Status)) {
+      break;
     }
+
+    ++mCurrentMeClientRequestedReceiveMsg;
   }
+
+  return Status;
 }
 
 EFI_STATUS
@@ -170,8 +397,11 @@ HeciGetResponse (
     //
     // Note, this was reworked to make more sense.
     // https://github.com/osy86/OpenCorePkg/commit/8f7188d41876109aec2fe3a721f69daf979dd268.diff
+    // Credits granted in advance with HeciGrantReceiveCredits and responses
+    // received while waiting for flow control are used first.
     //
-    if (!mCurrentMeClientRequestedReceiveMsg) {
+    if (!mCurrentMeClientRequestedReceiveMsg
+      && (mSendingHeciCommand || mPendingMessageCount == 0)) {
       ZeroMem (&Command, sizeof (Command));
       Command.Command.Fields.Command = FLOW_CONTROL;
       Command.MeAddress              = mCurrentMeClientAddress;
@@ -189,13 +419,13 @@ HeciGetResponse (
       }
     }
 
-    Status = HeciReadMessage (
-      BLOCKING,
+    Status = HeciReceiveMessage (
       MessageData,
-      &ResponseSize
+      &ResponseSize,
+      FALSE
       );
 
-    if (!EFI_ERROR (Status)) {
+    if (!EFI_ERROR (Status) && mCurrentMeClientRequestedReceiveMsg > 0) {
       --mCurrentMeClientRequestedReceiveMsg;
     }
   }
@@ -260,6 +490,12 @@ HeciGetClientMap (
     return Status;
   }
 
+  if (mMeClientMapValid) {
+    CopyMem (ClientMap, mMeClientMap, mMeClientActiveCount);
+    *ClientActiveCount = mMeClientActiveCount;
+    return EFI_SUCCESS;
+  }
+
   STATIC_ASSERT (sizeof (Command.Request)  == 4, "Invalid ME command size");
   STATIC_ASSERT (sizeof (Command.Response) == 36, "Invalid ME command size");
 
@@ -290,6 +526,10 @@ HeciGetClientMap (
     ++ValidAddressesPtr;
   }
 
+  CopyMem (mMeClientMap, ClientMap, *ClientActiveCount);
+  mMeClientActiveCount = *ClientActiveCount;
+  mMeClientMapValid    = TRUE;
+
   return Status;
 }
 
@@ -307,6 +547,11 @@ HeciGetClientProperties (
     return Status;
   }
 
+  if ((mMeClientPropertiesValid[Address / OC_CHAR_BIT] & (1U << (Address % OC_CHAR_BIT))) != 0) {
+    CopyMem (Properties, &mMeClientProperties[Address], sizeof (*Properties));
+    return EFI_SUCCESS;
+  }
+
   STATIC_ASSERT (sizeof (Command.Request)  == 4, "Invalid ME command size");
   STATIC_ASSERT (sizeof (Command.Response) == 28, "Invalid ME command size");
 
@@ -326,6 +571,11 @@ HeciGetClientProperties (
     sizeof (*Properties)
     );
 
+  if (!EFI_ERROR (Status)) {
+    CopyMem (&mMeClientProperties[Address], Properties, sizeof (*Properties));
+    mMeClientPropertiesValid[Address / OC_CHAR_BIT] |= (UINT8) (1U << (Address % OC_CHAR_BIT));
+  }
+
   return Status;
 }
 
@@ -375,6 +625,7 @@ HeciConnectToClient (
       mCurrentMeClientRequestedReceiveMsg = 0;
       mCurrentMeClientCanReceiveMsg       = 0;
       mCurrentMeClientAddress             = Address;
+      HeciResetPendingMessages ();
       return EFI_SUCCESS;
   }
 }
@@ -401,7 +652,7 @@ HeciSendMessagePerClient (
       mCurrentMeClientAddress
       );
 
-    if (!EFI_ERROR (Status)) {
+    if (!EFI_ERROR (Status) && mCurrentMeClientCanReceiveMsg > 0) {
       --mCurrentMeClientCanReceiveMsg;
     }
   }
@@ -455,6 +706,7 @@ HeciDisconnectFromClients (
 
     if (!EFI_ERROR (Status)) {
       mSendingHeciCommandPerClient = FALSE;
+      HeciResetPendingMessages ();
     }
   }
 
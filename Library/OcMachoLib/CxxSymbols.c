@@ -618,3 +618,355 @@ MachoGetVtableSymbolsFromSmcp64 (
 
   return TRUE;
 }
+
+/**
+  Returns whether Name consists of Prefix, a non-empty body, and Suffix.
+
+  @param[in] Name          The name to evaluate.
+  @param[in] Length        Length of Name.
+  @param[in] Prefix        The expected prefix.
+  @param[in] PrefixLength  Length of Prefix.
+  @param[in] Suffix        The expected suffix.
+  @param[in] SuffixLength  Length of Suffix.
+
+**/
+STATIC
+BOOLEAN
+InternalCxxNameHasAffixes (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  IN CONST CHAR8  *Prefix,
+  IN UINTN        PrefixLength,
+  IN CONST CHAR8  *Suffix,
+  IN UINTN        SuffixLength
+  )
+{
+  return (Length > (PrefixLength + SuffixLength))
+      && (CompareMem (Name, Prefix, PrefixLength) == 0)
+      && (CompareMem (&Name[Length - SuffixLength], Suffix, SuffixLength) == 0);
+}
+
+/**
+  Initializes a class table entry from a symbol describing a C++ class.
+
+  @param[in,out] Context  Context of the Mach-O.
+  @param[in]     Symbol   The symbol to evaluate.
+  @param[out]    Class    The class table entry to initialize.
+
+  @returns  Whether Symbol describes a C++ class.
+
+**/
+STATIC
+BOOLEAN
+InternalInitializeCxxClass (
+  IN OUT OC_MACHO_CONTEXT     *Context,
+  IN     CONST MACH_NLIST_64  *Symbol,
+  OUT    MACHO_CXX_CLASS      *Class
+  )
+{
+  CONST CHAR8 *Name;
+  UINTN       Length;
+  UINTN       PrefixLength;
+  UINTN       SuffixLength;
+
+  if ((Symbol->Type & MACH_N_TYPE_STAB) != 0) {
+    return FALSE;
+  }
+
+  Name = MachoGetSymbolName64 (Context, Symbol);
+  if (!MachoSymbolNameIsCxx (Name)) {
+    return FALSE;
+  }
+
+  Length = AsciiStrLen (Name);
+  if (Length > MAX_UINT32) {
+    return FALSE;
+  }
+
+  ZeroMem (Class, sizeof (*Class));
+  //
+  // SMCPs are matched regardless of their storage, like the legacy lookup.
+  // VTables and final class symbols must be defined locally.
+  //
+  if (InternalCxxNameHasAffixes (
+        Name,
+        Length,
+        OSOBJ_PREFIX,
+        L_STR_LEN (OSOBJ_PREFIX),
+        SMCP_TOKEN,
+        L_STR_LEN (SMCP_TOKEN)
+        )) {
+    PrefixLength = L_STR_LEN (OSOBJ_PREFIX);
+    SuffixLength = L_STR_LEN (SMCP_TOKEN);
+    Class->Smcp  = Symbol;
+  } else if (!MachoSymbolIsLocalDefined (Context, Symbol)) {
+    return FALSE;
+  } else if (InternalCxxNameHasAffixes (
+               Name,
+               Length,
+               METACLASS_VTABLE_PREFIX,
+               L_STR_LEN (METACLASS_VTABLE_PREFIX),
+               METACLASS_VTABLE_SUFFIX,
+               L_STR_LEN (METACLASS_VTABLE_SUFFIX)
+               )) {
+    PrefixLength      = L_STR_LEN (METACLASS_VTABLE_PREFIX);
+    SuffixLength      = L_STR_LEN (METACLASS_VTABLE_SUFFIX);
+    Class->MetaVtable = Symbol;
+  } else if (InternalCxxNameHasAffixes (
+               Name,
+               Length,
+               VTABLE_PREFIX,
+               L_STR_LEN (VTABLE_PREFIX),
+               NULL,
+               0
+               )) {
+    PrefixLength  = L_STR_LEN (VTABLE_PREFIX);
+    SuffixLength  = 0;
+    Class->Vtable = Symbol;
+  } else if (InternalCxxNameHasAffixes (
+               Name,
+               Length,
+               OSOBJ_PREFIX,
+               L_STR_LEN (OSOBJ_PREFIX),
+               FINAL_CLASS_TOKEN,
+               L_STR_LEN (FINAL_CLASS_TOKEN)
+               )) {
+    PrefixLength       = L_STR_LEN (OSOBJ_PREFIX);
+    SuffixLength       = L_STR_LEN (FINAL_CLASS_TOKEN);
+    Class->FinalSymbol = Symbol;
+  } else {
+    return FALSE;
+  }
+
+  Class->ClassName       = &Name[PrefixLength];
+  Class->ClassNameLength = (UINT32)(Length - PrefixLength - SuffixLength);
+
+  return TRUE;
+}
+
+/**
+  Compares a class name against the name of a class table entry.
+  The order is by length first and is only meant for lookup.
+
+  @param[in] ClassName        The class name to compare.
+  @param[in] ClassNameLength  Length of ClassName.
+  @param[in] Class            The class table entry to compare against.
+
+**/
+STATIC
+INTN
+InternalCompareCxxClassName (
+  IN CONST CHAR8            *ClassName,
+  IN UINT32                 ClassNameLength,
+  IN CONST MACHO_CXX_CLASS  *Class
+  )
+{
+  if (ClassNameLength != Class->ClassNameLength) {
+    return (ClassNameLength < Class->ClassNameLength) ? -1 : 1;
+  }
+
+  return CompareMem (ClassName, Class->ClassName, ClassNameLength);
+}
+
+/**
+  Merges a symbol of a duplicate class table entry.  The symbol declared
+  first wins, like with a linear lookup by name.
+
+  @param[in,out] Target  The symbol to merge into.
+  @param[in]     Symbol  The symbol to merge.
+
+**/
+STATIC
+VOID
+InternalMergeCxxClassSymbol (
+  IN OUT CONST MACH_NLIST_64  **Target,
+  IN     CONST MACH_NLIST_64  *Symbol
+  )
+{
+  if ((Symbol != NULL) && ((*Target == NULL) || (Symbol < *Target))) {
+    *Target = Symbol;
+  }
+}
+
+/**
+  Collects the C++ class metadata of a Mach-O into a table sorted for
+  MachoGetCxxClass.  This replaces per-class name synthesis and symbol
+  lookups with one pass over the symbol table.
+
+  @param[in,out] Context     Context of the Mach-O.
+  @param[in]     MaxClasses  Number of entries Classes can hold.  The number
+                             of symbols is always sufficient.
+  @param[out]    Classes     Output buffer for the class table.
+  @param[out]    NumClasses  Number of classes stored in Classes.
+
+  @returns  Whether the table has been built successfully.
+
+**/
+BOOLEAN
+MachoBuildCxxClassTable64 (
+  IN OUT OC_MACHO_CONTEXT  *Context,
+  IN     UINT32            MaxClasses,
+  OUT    MACHO_CXX_CLASS   *Classes,
+  OUT    UINT32            *NumClasses
+  )
+{
+  CONST MACH_NLIST_64 *Symbol;
+  CONST MACH_NLIST_64 *MetaClass;
+  CONST CHAR8         *Name;
+  MACHO_CXX_CLASS     Class;
+  UINT32              Index;
+  UINT32              Index2;
+  UINT32              Gap;
+  UINT32              Count;
+
+  ASSERT (Context != NULL);
+  ASSERT (Classes != NULL || MaxClasses == 0);
+  ASSERT (NumClasses != NULL);
+  //
+  // Record one entry per C++ class symbol.
+  //
+  Count = 0;
+
+  for (
+    Index = 0;
+    (Symbol = MachoGetSymbolByIndex64 (Context, Index)) != NULL;
+    ++Index
+    ) {
+    if (InternalInitializeCxxClass (Context, Symbol, &Class)) {
+      if (Count == MaxClasses) {
+        return FALSE;
+      }
+
+      CopyMem (&Classes[Count], &Class, sizeof (Class));
+      ++Count;
+    }
+  }
+  //
+  // Sort the entries by class name.  Shell sort is used as the table
+  // is not expected to be larger than a few thousand entries.
+  //
+  for (Gap = Count / 2; Gap > 0; Gap /= 2) {
+    for (Index = Gap; Index < Count; ++Index) {
+      CopyMem (&Class, &Classes[Index], sizeof (Class));
+
+      for (
+        Index2 = Index;
+        (Index2 >= Gap)
+          && (InternalCompareCxxClassName (
+                Class.ClassName,
+                Class.ClassNameLength,
+                &Classes[Index2 - Gap]
+                ) < 0);
+        Index2 -= Gap
+        ) {
+        CopyMem (&Classes[Index2], &Classes[Index2 - Gap], sizeof (Class));
+      }
+
+      CopyMem (&Classes[Index2], &Class, sizeof (Class));
+    }
+  }
+  //
+  // Merge the entries of every class and resolve its super class.
+  //
+  Index2 = 0;
+
+  for (Index = 0; Index < Count; ++Index) {
+    if ((Index2 > 0)
+     && (InternalCompareCxxClassName (
+           Classes[Index].ClassName,
+           Classes[Index].ClassNameLength,
+           &Classes[Index2 - 1]
+           ) == 0)) {
+      InternalMergeCxxClassSymbol (&Classes[Index2 - 1].Smcp, Classes[Index].Smcp);
+      InternalMergeCxxClassSymbol (&Classes[Index2 - 1].Vtable, Classes[Index].Vtable);
+      InternalMergeCxxClassSymbol (&Classes[Index2 - 1].MetaVtable, Classes[Index].MetaVtable);
+      InternalMergeCxxClassSymbol (&Classes[Index2 - 1].FinalSymbol, Classes[Index].FinalSymbol);
+      continue;
+    }
+
+    if (Index2 != Index) {
+      CopyMem (&Classes[Index2], &Classes[Index], sizeof (Class));
+    }
+
+    ++Index2;
+  }
+
+  Count = Index2;
+
+  for (Index = 0; Index < Count; ++Index) {
+    if (Classes[Index].Smcp == NULL) {
+      continue;
+    }
+
+    MetaClass = MachoGetMetaclassSymbolFromSmcpSymbol64 (
+                  Context,
+                  Classes[Index].Smcp
+                  );
+    if (MetaClass == NULL) {
+      continue;
+    }
+
+    Name = MachoGetSymbolName64 (Context, MetaClass);
+
+    Classes[Index].SuperMetaClass       = MetaClass;
+    Classes[Index].SuperClassName       = &Name[L_STR_LEN (OSOBJ_PREFIX)];
+    Classes[Index].SuperClassNameLength = (UINT32)(
+      AsciiStrLen (Name) - L_STR_LEN (OSOBJ_PREFIX) - L_STR_LEN (METACLASS_TOKEN)
+      );
+  }
+
+  *NumClasses = Count;
+
+  return TRUE;
+}
+
+/**
+  Retrieves a class from a table built by MachoBuildCxxClassTable64.
+
+  @param[in] Classes          The class table to search.
+  @param[in] NumClasses       Number of classes in Classes.
+  @param[in] ClassName        Mangled class name, need not be terminated.
+  @param[in] ClassNameLength  Length of ClassName.
+
+  @retval NULL  The class is not defined by the Mach-O.
+
+**/
+CONST MACHO_CXX_CLASS *
+MachoGetCxxClass (
+  IN CONST MACHO_CXX_CLASS  *Classes,
+  IN UINT32                 NumClasses,
+  IN CONST CHAR8            *ClassName,
+  IN UINT32                 ClassNameLength
+  )
+{
+  UINT32 Low;
+  UINT32 High;
+  UINT32 Middle;
+  INTN   Result;
+
+  ASSERT (Classes != NULL || NumClasses == 0);
+  ASSERT (ClassName != NULL);
+
+  Low  = 0;
+  High = NumClasses;
+
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    Result = InternalCompareCxxClassName (
+               ClassName,
+               ClassNameLength,
+               &Classes[Middle]
+               );
+    if (Result == 0) {
+      return &Classes[Middle];
+    }
+
+    if (Result < 0) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
+  }
+
+  return NULL;
+}
@@ -20,6 +20,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/DebugLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMachoLib.h>
+#include <Library/OcStringLib.h>
 
 #include "OcMachoLibInternal.h"
 
@@ -494,7 +495,7 @@ InternalGetLocalDefinedSymbolByNameWorker (
     }
 
     TmpName = MachoGetSymbolName64 (Context, &SymbolTable[Index]);
-    if (AsciiStrCmp (Name, TmpName) == 0) {
+    if (OcAsciiStrCmp (Name, TmpName) == 0) {
       return &SymbolTable[Index];
     }
   }
@@ -0,0 +1,26 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_PERF_INTERNAL_H
+#define OC_PERF_INTERNAL_H
+
+#include <Library/OcPerfLib.h>
+
+//
+// Protocol installed by another image, which owns the trace.
+// NULL when records are kept in this image.
+//
+extern OC_PERF_PROTOCOL  *gOcPerfForward;
+
+#endif // OC_PERF_INTERNAL_H
@@ -0,0 +1,157 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/OcPerfLib.h>
+#include <Library/TimerLib.h>
+
+#include "OcPerfInternal.h"
+
+STATIC_ASSERT (sizeof (OC_PERF_RECORD) == 20, "Invalid perf record size");
+STATIC_ASSERT (sizeof (OC_PERF_TRACE_HEADER) == 24, "Invalid perf header size");
+STATIC_ASSERT ((OC_PERF_RECORD_MAX & (OC_PERF_RECORD_MAX - 1)) == 0, "Perf ring size must be a power of two");
+
+OC_PERF_PROTOCOL  *gOcPerfForward;
+
+//
+// Trace ring, preallocated to avoid allocations while recording.
+//
+STATIC OC_PERF_RECORD  mOcPerfRecords[OC_PERF_RECORD_MAX];
+
+//
+// Number of records ever added, next record goes to Total % OC_PERF_RECORD_MAX.
+//
+STATIC UINT32          mOcPerfTotal;
+
+//
+// Current phase nesting depth.
+//
+STATIC UINT8           mOcPerfDepth;
+
+VOID
+OcPerfAddRecord (
+  IN UINT16      Phase,
+  IN UINT8       Type,
+  IN UINT32      Size,
+  IN EFI_STATUS  Status
+  )
+{
+  OC_PERF_RECORD  *Record;
+
+  Record = &mOcPerfRecords[mOcPerfTotal & (OC_PERF_RECORD_MAX - 1)];
+
+  if (Type == OC_PERF_RECORD_END && mOcPerfDepth > 0) {
+    --mOcPerfDepth;
+  }
+
+  Record->Timestamp = GetPerformanceCounter ();
+  Record->Size      = Size;
+  Record->Status    = (UINT32) (Status & (OC_PERF_STATUS_ERROR - 1U));
+  if (EFI_ERROR (Status)) {
+    Record->Status |= OC_PERF_STATUS_ERROR;
+  }
+  Record->Phase     = Phase;
+  Record->Type      = Type;
+  Record->Depth     = mOcPerfDepth;
+
+  if (Type == OC_PERF_RECORD_BEGIN && mOcPerfDepth < MAX_UINT8) {
+    ++mOcPerfDepth;
+  }
+
+  ++mOcPerfTotal;
+}
+
+VOID
+OcPerfBegin (
+  IN UINT16  Phase
+  )
+{
+  if (gOcPerfForward != NULL) {
+    gOcPerfForward->AddRecord (gOcPerfForward, Phase, OC_PERF_RECORD_BEGIN, 0, EFI_SUCCESS);
+    return;
+  }
+
+  OcPerfAddRecord (Phase, OC_PERF_RECORD_BEGIN, 0, EFI_SUCCESS);
+}
+
+VOID
+OcPerfEnd (
+  IN UINT16      Phase,
+  IN UINT32      Size,
+  IN EFI_STATUS  Status
+  )
+{
+  if (gOcPerfForward != NULL) {
+    gOcPerfForward->AddRecord (gOcPerfForward, Phase, OC_PERF_RECORD_END, Size, Status);
+    return;
+  }
+
+  OcPerfAddRecord (Phase, OC_PERF_RECORD_END, Size, Status);
+}
+
+EFI_STATUS
+OcPerfExportTrace (
+     OUT VOID    *Buffer,
+  IN OUT UINT32  *BufferSize
+  )
+{
+  OC_PERF_TRACE_HEADER  Header;
+  UINT8                 *Walker;
+  UINT32                Count;
+  UINT32                First;
+  UINT32                Chunk;
+
+  if (*BufferSize < sizeof (Header)) {
+    *BufferSize = OC_PERF_TRACE_MAX_SIZE;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Count = MIN (mOcPerfTotal, OC_PERF_RECORD_MAX);
+  Count = MIN (Count, (UINT32) ((*BufferSize - sizeof (Header)) / sizeof (OC_PERF_RECORD)));
+  First = (mOcPerfTotal - Count) & (OC_PERF_RECORD_MAX - 1);
+
+  Header.Signature   = OC_PERF_TRACE_SIGNATURE;
+  Header.Version     = OC_PERF_TRACE_VERSION;
+  Header.RecordSize  = sizeof (OC_PERF_RECORD);
+  Header.Frequency   = GetPerformanceCounterProperties (NULL, NULL);
+  Header.RecordCount = Count;
+  Header.Dropped     = mOcPerfTotal - Count;
+
+  Walker = Buffer;
+  CopyMem (Walker, &Header, sizeof (Header));
+  Walker += sizeof (Header);
+
+  //
+  // Records may wrap around the ring end.
+  //
+  Chunk = MIN (Count, OC_PERF_RECORD_MAX - First);
+  CopyMem (Walker, &mOcPerfRecords[First], Chunk * sizeof (OC_PERF_RECORD));
+  Walker += Chunk * sizeof (OC_PERF_RECORD);
+  CopyMem (Walker, &mOcPerfRecords[0], (Count - Chunk) * sizeof (OC_PERF_RECORD));
+
+  *BufferSize = sizeof (Header) + Count * sizeof (OC_PERF_RECORD);
+  return EFI_SUCCESS;
+}
+
+VOID
+OcPerfReset (
+  VOID
+  )
+{
+  mOcPerfTotal = 0;
+  mOcPerfDepth = 0;
+}
@@ -0,0 +1,200 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Uefi.h>
+
+#include <Guid/OcVariables.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/OcFileLib.h>
+#include <Library/OcMiscLib.h>
+#include <Library/OcPerfLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "OcPerfInternal.h"
+
+STATIC
+VOID
+EFIAPI
+OcPerfProtocolAddRecord (
+  IN OC_PERF_PROTOCOL  *This,
+  IN UINT16            Phase,
+  IN UINT8             Type,
+  IN UINT32            Size,
+  IN EFI_STATUS        Status
+  )
+{
+  OcPerfAddRecord (Phase, Type, Size, Status);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+OcPerfProtocolExportTrace (
+  IN     OC_PERF_PROTOCOL  *This,
+     OUT VOID              *Buffer,
+  IN OUT UINT32            *BufferSize
+  )
+{
+  if (Buffer == NULL || BufferSize == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return OcPerfExportTrace (Buffer, BufferSize);
+}
+
+STATIC
+OC_PERF_PROTOCOL
+mOcPerfProtocol = {
+  OC_PERF_PROTOCOL_REVISION,
+  OcPerfProtocolAddRecord,
+  OcPerfProtocolExportTrace
+};
+
+OC_PERF_PROTOCOL *
+OcPerfInstallProtocol (
+  IN BOOLEAN  Reinstall
+  )
+{
+  EFI_STATUS        Status;
+  OC_PERF_PROTOCOL  *Protocol;
+
+  if (Reinstall) {
+    Status = UninstallAllProtocolInstances (&gOcPerfProtocolGuid);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "OCPERF: Uninstall failed: %r\n", Status));
+      return NULL;
+    }
+  } else {
+    Status = gBS->LocateProtocol (
+      &gOcPerfProtocolGuid,
+      NULL,
+      (VOID **) &Protocol
+      );
+
+    if (!EFI_ERROR (Status)) {
+      if (Protocol != &mOcPerfProtocol
+        && Protocol->Revision == OC_PERF_PROTOCOL_REVISION) {
+        gOcPerfForward = Protocol;
+      }
+      return Protocol;
+    }
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+    &gImageHandle,
+    &gOcPerfProtocolGuid,
+    (VOID *) &mOcPerfProtocol,
+    NULL
+    );
+
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  gOcPerfForward = NULL;
+  return &mOcPerfProtocol;
+}
+
+/**
+  Export the trace from its owner into a newly allocated buffer.
+
+  @param[in]  MaxSize     Maximum trace size.
+  @param[out] BufferSize  Exported trace size.
+
+  @retval trace buffer or NULL.
+**/
+STATIC
+VOID *
+OcPerfExportTraceCopy (
+  IN  UINT32  MaxSize,
+  OUT UINT32  *BufferSize
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Buffer;
+
+  *BufferSize = MIN (MaxSize, OC_PERF_TRACE_MAX_SIZE);
+  Buffer      = AllocatePool (*BufferSize);
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  if (gOcPerfForward != NULL) {
+    Status = gOcPerfForward->ExportTrace (gOcPerfForward, Buffer, BufferSize);
+  } else {
+    Status = OcPerfExportTrace (Buffer, BufferSize);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Buffer);
+    return NULL;
+  }
+
+  return Buffer;
+}
+
+EFI_STATUS
+OcPerfExportToFile (
+  IN EFI_FILE_PROTOCOL  *Root  OPTIONAL,
+  IN CONST CHAR16       *FileName
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Buffer;
+  UINT32      BufferSize;
+
+  Buffer = OcPerfExportTraceCopy (OC_PERF_TRACE_MAX_SIZE, &BufferSize);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = SetFileData (Root, FileName, Buffer, BufferSize);
+  DEBUG ((DEBUG_INFO, "OCPERF: Exported %u bytes of trace to %s - %r\n", BufferSize, FileName, Status));
+
+  FreePool (Buffer);
+  return Status;
+}
+
+EFI_STATUS
+OcPerfExportToNvram (
+  IN CONST CHAR16  *VariableName,
+  IN UINT32        MaxSize
+  )
+{
+  EFI_STATUS  Status;
+  VOID        *Buffer;
+  UINT32      BufferSize;
+
+  Buffer = OcPerfExportTraceCopy (MaxSize, &BufferSize);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gRT->SetVariable (
+    (CHAR16 *) VariableName,
+    &gOcVendorVariableGuid,
+    EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+    BufferSize,
+    Buffer
+    );
+  DEBUG ((DEBUG_INFO, "OCPERF: Exported %u bytes of trace to %s - %r\n", BufferSize, VariableName, Status));
+
+  FreePool (Buffer);
+  return Status;
+}
@@ -31,6 +31,20 @@ AsmAddRngJitter (
   IN UINT64  Value
   );
 
+/**
+  Generates a 64-bit seed value with RDSEED instruction.
+
+  @param[out]  Seed  Resulting seed value.
+
+  @retval TRUE   Seed was generated.
+  @retval FALSE  Entropy was not available at the moment.
+**/
+BOOLEAN
+EFIAPI
+AsmRdSeed64 (
+  OUT UINT64  *Seed
+  );
+
 //
 // Limited retry number when valid random data is returned.
 // Uses the recommended value defined in Section 7.3.17 of "Intel 64 and IA-32
@@ -38,15 +52,27 @@ AsmAddRngJitter (
 //
 #define RDRAND_RETRY_LIMIT           10
 
+//
+// RDSEED may underflow much more frequently than RDRAND, so give
+// it a larger limit before falling back to RDRAND.
+//
+#define RDSEED_RETRY_LIMIT           100
+
 //
 // Maximum amount of bytes emitted by PRNG before next reseed.
 //
 #define MAX_BYTES_TO_EMIT            1600000
 
 //
-// Maximum bytes in one buffer.
+// Maximum bytes in one buffer. Multiple ChaCha blocks are generated at once,
+// so that rekeying happens once per refill rather than once per block.
 //
-#define MAX_BYTES_IN_BUF             (16*64)
+#define MAX_BYTES_IN_BUF             (64*64)
+
+//
+// Amount of 64-bit words needed to seed ChaCha key and IV.
+//
+#define RNG_SEED_WORDS               ((CHACHA_KEY_SIZE + CHACHA_IV_SIZE + sizeof (UINT64) - 1) / sizeof (UINT64))
 
 /**
   Random Number Generator context.
@@ -57,6 +83,10 @@ typedef struct OC_RNG_CONTEXT_ {
   //
   BOOLEAN         HardwareRngAvailable;
   //
+  // Hardware seed generator (RDSEED) available.
+  //
+  BOOLEAN         HardwareSeedAvailable;
+  //
   // Done initialising pseudo random number generator.
   //
   BOOLEAN         PrngInitialised;
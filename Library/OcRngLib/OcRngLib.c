@@ -33,6 +33,77 @@
 
 STATIC OC_RNG_CONTEXT mRng;
 
+STATIC
+UINT64
+GetEntropyBits (
+  IN UINTN  Bits
+  )
+{
+  UINTN   Index;
+  UINT64  Entropy;
+  UINT64  Tmp;
+
+  //
+  // Uses non-deterministic CPU execution.
+  // REF: https://static.lwn.net/images/conf/rtlws11/random-hardware.pdf
+  // REF: https://www.osadl.org/fileadmin/dam/presentations/RTLWS11/okech-inherent-randomness.pdf
+  // REF: http://lkml.iu.edu/hypermail/linux/kernel/1909.3/03714.html
+  //
+  Entropy = 0;
+  for (Index = 0; Index < Bits; ++Index) {
+    Tmp = AsmReadTsc () + AsmAddRngJitter (AsmReadTsc ());
+    if ((Tmp & BIT0) != 0) {
+      Entropy |= LShiftU64 (1, Index);
+    }
+  }
+
+  return Entropy;
+}
+
+/**
+  Fill seed buffer from hardware in one burst. RDSEED is preferred as it
+  provides conditioned entropy directly, then RDRAND, then timing jitter.
+
+  @param[out]  Seed   Seed buffer.
+  @param[in]   Count  Amount of 64-bit words to generate.
+**/
+STATIC
+VOID
+GetHardwareSeed (
+  OUT UINT64  *Seed,
+  IN  UINTN   Count
+  )
+{
+  UINTN    Index;
+  UINTN    Retry;
+  BOOLEAN  Result;
+
+  for (Index = 0; Index < Count; ++Index) {
+    Result = FALSE;
+
+    if (mRng.HardwareSeedAvailable) {
+      for (Retry = 0; Retry < RDSEED_RETRY_LIMIT; ++Retry) {
+        Result = AsmRdSeed64 (&Seed[Index]);
+        if (Result) {
+          break;
+        }
+        //
+        // Let the entropy source refill.
+        //
+        CpuPause ();
+      }
+    }
+
+    if (!Result) {
+      Result = GetRandomNumber64 (&Seed[Index]);
+      if (!Result) {
+        ASSERT (FALSE);
+        CpuDeadLoop ();
+      }
+    }
+  }
+}
+
 STATIC
 VOID
 ChaChaRngStir (
@@ -44,12 +115,11 @@ ChaChaRngStir (
   //
 
   UINTN    Index;
-  UINT32   KeySeed[CHACHA_KEY_SIZE / sizeof (UINT32)];
-  UINT32   IvSeed[CHACHA_IV_SIZE / sizeof (UINT32)];
-  BOOLEAN  Result;
+  UINT64   Seed[RNG_SEED_WORDS];
+  UINT8    *SeedBytes;
 
-  STATIC_ASSERT (CHACHA_KEY_SIZE % sizeof (UINT32) == 0, "Unexpected key size");
-  STATIC_ASSERT (CHACHA_IV_SIZE % sizeof (UINT32) == 0, "Unexpected key size");
+  STATIC_ASSERT (sizeof (Seed) >= CHACHA_KEY_SIZE + CHACHA_IV_SIZE, "Unexpected seed size");
+  STATIC_ASSERT (MAX_BYTES_IN_BUF > CHACHA_KEY_SIZE + CHACHA_IV_SIZE, "Unexpected buffer size");
 
   ASSERT (BytesNeeded <= MAX_BYTES_TO_EMIT);
 
@@ -62,41 +132,25 @@ ChaChaRngStir (
   }
 
   //
-  // Generate seeds.
+  // Generate seeds in one go.
   //
-  for (Index = 0; Index < ARRAY_SIZE (KeySeed); ++Index) {
-    Result = GetRandomNumber32 (&KeySeed[Index]);
-    if (!Result) {
-      ASSERT (FALSE);
-      CpuDeadLoop ();
-    }
-  }
-
-  for (Index = 0; Index < ARRAY_SIZE (IvSeed); ++Index) {
-    Result = GetRandomNumber32 (&IvSeed[Index]);
-    if (!Result) {
-      ASSERT (FALSE);
-      CpuDeadLoop ();
-    }
-  }
+  GetHardwareSeed (Seed, ARRAY_SIZE (Seed));
+  SeedBytes = (UINT8 *) Seed;
 
   //
   // Reinitialize if we are making a second loop.
   //
   if (mRng.PrngInitialised) {
-    ZeroMem (mRng.Buffer, sizeof (mRng.Buffer));
+    ZeroMem (mRng.Buffer, CHACHA_KEY_SIZE + CHACHA_IV_SIZE);
     //
-    // Fill buffer with keystream.
+    // Fill key and IV with keystream.
     //
-    ChaChaCryptBuffer (&mRng.ChaCha, mRng.Buffer, mRng.Buffer, sizeof (mRng.Buffer));
+    ChaChaCryptBuffer (&mRng.ChaCha, mRng.Buffer, mRng.Buffer, CHACHA_KEY_SIZE + CHACHA_IV_SIZE);
     //
     // Mix in RNG data.
     //
-    for (Index = 0; Index < ARRAY_SIZE (KeySeed); ++Index) {
-      mRng.Buffer[Index] ^= KeySeed[Index];
-    }
-    for (Index = 0; Index < ARRAY_SIZE (IvSeed); ++Index) {
-      mRng.Buffer[ARRAY_SIZE (KeySeed) + Index] ^= KeySeed[Index];
+    for (Index = 0; Index < CHACHA_KEY_SIZE + CHACHA_IV_SIZE; ++Index) {
+      SeedBytes[Index] ^= mRng.Buffer[Index];
     }
   } else {
     mRng.PrngInitialised = TRUE;
@@ -105,10 +159,9 @@ ChaChaRngStir (
   //
   // Setup ChaCha context.
   //
-  ChaChaInitCtx (&mRng.ChaCha, (UINT8 *) KeySeed, (UINT8 *) IvSeed, 0);
+  ChaChaInitCtx (&mRng.ChaCha, &SeedBytes[0], &SeedBytes[CHACHA_KEY_SIZE], 0);
 
-  SecureZeroMem (KeySeed, sizeof (KeySeed));
-  SecureZeroMem (IvSeed, sizeof (IvSeed));
+  SecureZeroMem (Seed, sizeof (Seed));
 
   mRng.BytesTillReseed = MAX_BYTES_TO_EMIT - BytesNeeded;
   mRng.BytesInBuffer = 0;
@@ -133,6 +186,9 @@ ChaChaRngGenerate (
     if (mRng.BytesInBuffer > 0) {
       CurrentSize = MIN (Size, mRng.BytesInBuffer);
 
+      //
+      // Erase emitted data for backtracking resistance.
+      //
       CopyMem (Data, mRng.Buffer + sizeof (mRng.Buffer) - mRng.BytesInBuffer, CurrentSize);
       ZeroMem (mRng.Buffer + sizeof (mRng.Buffer) - mRng.BytesInBuffer, CurrentSize);
 
@@ -142,9 +198,10 @@ ChaChaRngGenerate (
     }
 
     if (mRng.BytesInBuffer == 0) {
-      ZeroMem (mRng.Buffer, sizeof (mRng.Buffer));
       //
-      // Fill buffer with keystream.
+      // Fill buffer with keystream. Emitted bytes are erased as they are
+      // consumed, and so are key and IV after rekeying, so the buffer
+      // is already zeroed at this point.
       //
       ChaChaCryptBuffer (&mRng.ChaCha, mRng.Buffer, mRng.Buffer, sizeof (mRng.Buffer));
       //
@@ -157,33 +214,6 @@ ChaChaRngGenerate (
   }
 }
 
-STATIC
-UINT64
-GetEntropyBits (
-  IN UINTN  Bits
-  )
-{
-  UINTN   Index;
-  UINT64  Entropy;
-  UINT64  Tmp;
-
-  //
-  // Uses non-deterministic CPU execution.
-  // REF: https://static.lwn.net/images/conf/rtlws11/random-hardware.pdf
-  // REF: https://www.osadl.org/fileadmin/dam/presentations/RTLWS11/okech-inherent-randomness.pdf
-  // REF: http://lkml.iu.edu/hypermail/linux/kernel/1909.3/03714.html
-  //
-  Entropy = 0;
-  for (Index = 0; Index < Bits; ++Index) {
-    Tmp = AsmReadTsc () + AsmAddRngJitter (AsmReadTsc ());
-    if ((Tmp & BIT0) != 0) {
-      Entropy |= LShiftU64 (1, Index);
-    }
-  }
-
-  return Entropy;
-}
-
 /**
   The constructor function checks whether or not RDRAND instruction is supported
   by the host hardware.
@@ -201,15 +231,34 @@ OcRngLibConstructor (
   VOID
   )
 {
-  CPUID_VERSION_INFO_ECX RegEcx;
+  UINT32                                       MaxLeaf;
+  CPUID_VERSION_INFO_ECX                       RegEcx;
+  CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_EBX  RegEbx;
 
   //
   // Determine RDRAND support by examining bit 30 of the ECX register returned by
   // CPUID. A value of 1 indicates that processor support RDRAND instruction.
   //
-  AsmCpuid (1, 0, 0, &RegEcx.Uint32, 0);
+  AsmCpuid (CPUID_SIGNATURE, &MaxLeaf, 0, 0, 0);
+  AsmCpuid (CPUID_VERSION_INFO, 0, 0, &RegEcx.Uint32, 0);
   mRng.HardwareRngAvailable = RegEcx.Bits.RDRAND != 0;
 
+  //
+  // Determine RDSEED support by examining bit 18 of the EBX register returned by
+  // CPUID leaf 7. RDSEED is used for bulk seeding when available.
+  //
+  if (MaxLeaf >= CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS) {
+    AsmCpuidEx (
+      CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS,
+      CPUID_STRUCTURED_EXTENDED_FEATURE_FLAGS_SUB_LEAF_INFO,
+      0,
+      &RegEbx.Uint32,
+      0,
+      0
+      );
+    mRng.HardwareSeedAvailable = RegEbx.Bits.RDSEED != 0;
+  }
+
   //
   // Initialize PRNG.
   //
@@ -16,6 +16,9 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 **/
 
+#include <Uefi.h>
+
+#include <Library/DebugLib.h>
 #include <Library/IoLib.h>
 #include <Library/OcRtcLib.h>
 
@@ -46,6 +49,32 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #define RTC_DATA_MASK             0x7F
 #define RTC_NMI_MASK              0x80
 
+//
+// Total RTC memory size over both banks.
+//
+#define RTC_TOTAL_SIZE            0x100
+
+//
+// Register D has no side effects on access, used for alternative port probing.
+//
+#define RTC_PROBE_REGISTER        0x0D
+
+//
+// Apple checksum layout. Checksums are CRC-16 (0xA001 reflected) over
+// bytes starting with APPLE_RTC_CHECKSUM_START up to the end of each bank,
+// stored big endian and excluded from the calculation.
+//
+#define APPLE_RTC_CHECKSUM_START       0x0E
+#define APPLE_RTC_CORE_CHECKSUM_ADDR   0x58
+#define APPLE_RTC_MAIN_CHECKSUM_ADDR   0xFE
+#define APPLE_RTC_CHECKSUM_POLYNOMIAL  0xA001
+
+//
+// Alternative port availability, probed once.
+//
+STATIC BOOLEAN  mRtcAltPortsProbed;
+STATIC BOOLEAN  mRtcAltPortsAvailable;
+
 UINT8
 OcRtcRead (
   IN  UINT8  Offset
@@ -137,3 +166,248 @@ OcRtcWriteIvy (
   IoWrite8 (RtcIndexPort, Offset & RTC_DATA_MASK);
   IoWrite8 (RtcDataPort, Value);
 }
+
+/**
+  Check whether alternative RTC ports are available. On Ivy Bridge and newer
+  PCH the alternative index register is readable, while on older chipsets
+  and other vendors the port is not decoded and reads back as 0xFF.
+
+  @retval TRUE when alternative ports can be used.
+**/
+STATIC
+BOOLEAN
+InternalRtcHasAltPorts (
+  VOID
+  )
+{
+  if (!mRtcAltPortsProbed) {
+    IoWrite8 (R_PCH_RTC_INDEX_ALT, RTC_PROBE_REGISTER);
+    mRtcAltPortsAvailable = (IoRead8 (R_PCH_RTC_INDEX_ALT) & RTC_DATA_MASK) == RTC_PROBE_REGISTER;
+    mRtcAltPortsProbed    = TRUE;
+
+    DEBUG ((DEBUG_VERBOSE, "OCRTC: Alternative ports available %d\n", mRtcAltPortsAvailable));
+  }
+
+  return mRtcAltPortsAvailable;
+}
+
+/**
+  Transfer a range of RTC memory. The range must not cross bank boundary.
+
+  @param[in]     Offset   Starting offset.
+  @param[in]     Size     Range size.
+  @param[in,out] Buffer   Data buffer.
+  @param[in]     Write    Write Buffer contents when TRUE, read otherwise.
+**/
+STATIC
+VOID
+InternalRtcTransferBank (
+  IN     UINT8    Offset,
+  IN     UINTN    Size,
+  IN OUT UINT8    *Buffer,
+  IN     BOOLEAN  Write
+  )
+{
+  UINT8  RtcIndexPort;
+  UINT8  RtcDataPort;
+  UINT8  RtcIndexNmi;
+  UINTN  Index;
+
+  ASSERT ((Offset & ~RTC_DATA_MASK) == (((UINTN) Offset + Size - 1) & ~RTC_DATA_MASK));
+
+  if (InternalRtcHasAltPorts ()) {
+    if (Offset < RTC_BANK_SIZE) {
+      RtcIndexPort  = R_PCH_RTC_INDEX_ALT;
+      RtcDataPort   = R_PCH_RTC_TARGET_ALT;
+    } else {
+      RtcIndexPort  = R_PCH_RTC_EXT_INDEX_ALT;
+      RtcDataPort   = R_PCH_RTC_EXT_TARGET_ALT;
+    }
+    RtcIndexNmi = 0;
+  } else {
+    if (Offset < RTC_BANK_SIZE) {
+      RtcIndexPort  = R_PCH_RTC_INDEX;
+      RtcDataPort   = R_PCH_RTC_TARGET;
+    } else {
+      RtcIndexPort  = R_PCH_RTC_EXT_INDEX;
+      RtcDataPort   = R_PCH_RTC_EXT_TARGET;
+    }
+    //
+    // NMI bit is preserved for the whole range.
+    //
+    RtcIndexNmi = IoRead8 (RtcIndexPort) & RTC_NMI_MASK;
+  }
+
+  for (Index = 0; Index < Size; ++Index) {
+    IoWrite8 (RtcIndexPort, ((Offset + (UINT8) Index) & RTC_DATA_MASK) | RtcIndexNmi);
+    if (Write) {
+      IoWrite8 (RtcDataPort, Buffer[Index]);
+    } else {
+      Buffer[Index] = IoRead8 (RtcDataPort);
+    }
+  }
+}
+
+/**
+  Transfer a range of RTC memory splitting it at bank boundary.
+
+  @param[in]     Offset   Starting offset.
+  @param[in]     Size     Range size.
+  @param[in,out] Buffer   Data buffer.
+  @param[in]     Write    Write Buffer contents when TRUE, read otherwise.
+**/
+STATIC
+VOID
+InternalRtcTransfer (
+  IN     UINT8    Offset,
+  IN     UINTN    Size,
+  IN OUT UINT8    *Buffer,
+  IN     BOOLEAN  Write
+  )
+{
+  UINTN  BankSize;
+
+  if (Offset < RTC_BANK_SIZE && Size > 0) {
+    BankSize = RTC_BANK_SIZE - Offset;
+    if (BankSize > Size) {
+      BankSize = Size;
+    }
+
+    InternalRtcTransferBank (Offset, BankSize, Buffer, Write);
+
+    Offset  = RTC_BANK_SIZE;
+    Buffer += BankSize;
+    Size   -= BankSize;
+  }
+
+  if (Size > 0) {
+    InternalRtcTransferBank (Offset, Size, Buffer, Write);
+  }
+}
+
+/**
+  Calculate Apple checksum for a bank and store it.
+
+  @param[in,out] Memory       Full RTC memory contents.
+  @param[in]     Start        Checksum start offset.
+  @param[in]     End          Checksum end offset, exclusive.
+  @param[in]     Address      Checksum storage offset within [Start, End).
+**/
+STATIC
+VOID
+InternalRtcUpdateChecksum (
+  IN OUT UINT8  *Memory,
+  IN     UINTN  Start,
+  IN     UINTN  End,
+  IN     UINTN  Address
+  )
+{
+  UINT16  Checksum;
+  UINTN   Index;
+  UINTN   Bit;
+
+  Checksum = 0;
+
+  for (Index = Start; Index < End; ++Index) {
+    if (Index == Address || Index == Address + 1) {
+      continue;
+    }
+
+    Checksum ^= Memory[Index];
+    for (Bit = 0; Bit < 8; ++Bit) {
+      if ((Checksum & 1U) != 0) {
+        Checksum = (UINT16) ((Checksum >> 1U) ^ APPLE_RTC_CHECKSUM_POLYNOMIAL);
+      } else {
+        Checksum >>= 1U;
+      }
+    }
+  }
+
+  Memory[Address]     = (UINT8) (Checksum >> 8U);
+  Memory[Address + 1] = (UINT8) Checksum;
+}
+
+EFI_STATUS
+OcRtcReadBlock (
+  IN  UINT8  Offset,
+  IN  UINTN  Size,
+  OUT UINT8  *Buffer
+  )
+{
+  if (Buffer == NULL || Size > RTC_TOTAL_SIZE - Offset) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  InternalRtcTransfer (Offset, Size, Buffer, FALSE);
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+OcRtcWriteBlock (
+  IN UINT8        Offset,
+  IN UINTN        Size,
+  IN CONST UINT8  *Buffer,
+  IN BOOLEAN      UpdateChecksum
+  )
+{
+  UINT8  Memory[RTC_TOTAL_SIZE];
+
+  if (Buffer == NULL || Size > RTC_TOTAL_SIZE - Offset) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Size == 0) {
+    return EFI_SUCCESS;
+  }
+
+  InternalRtcTransfer (Offset, Size, (UINT8 *) Buffer, TRUE);
+
+  if (!UpdateChecksum) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Recalculate checksums once for the whole block,
+  // and only for the banks it touched.
+  //
+  InternalRtcTransfer (
+    APPLE_RTC_CHECKSUM_START,
+    RTC_TOTAL_SIZE - APPLE_RTC_CHECKSUM_START,
+    &Memory[APPLE_RTC_CHECKSUM_START],
+    FALSE
+    );
+
+  if (Offset < RTC_BANK_SIZE
+    && (UINTN) Offset + Size > APPLE_RTC_CHECKSUM_START) {
+    InternalRtcUpdateChecksum (
+      Memory,
+      APPLE_RTC_CHECKSUM_START,
+      RTC_BANK_SIZE,
+      APPLE_RTC_CORE_CHECKSUM_ADDR
+      );
+    InternalRtcTransfer (
+      APPLE_RTC_CORE_CHECKSUM_ADDR,
+      sizeof (UINT16),
+      &Memory[APPLE_RTC_CORE_CHECKSUM_ADDR],
+      TRUE
+      );
+  }
+
+  if ((UINTN) Offset + Size > RTC_BANK_SIZE) {
+    InternalRtcUpdateChecksum (
+      Memory,
+      RTC_BANK_SIZE,
+      RTC_TOTAL_SIZE,
+      APPLE_RTC_MAIN_CHECKSUM_ADDR
+      );
+    InternalRtcTransfer (
+      APPLE_RTC_MAIN_CHECKSUM_ADDR,
+      sizeof (UINT16),
+      &Memory[APPLE_RTC_MAIN_CHECKSUM_ADDR],
+      TRUE
+      );
+  }
+
+  return EFI_SUCCESS;
+}
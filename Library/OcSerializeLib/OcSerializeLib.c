@@ -19,6 +19,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/OcSerializeLib.h>
 #include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
+#include <Library/OcStringLib.h>
 
 OC_SCHEMA *
 LookupConfigSchema (
@@ -44,7 +45,7 @@ LookupConfigSchema (
 
   while (Start <= End) {
     Curr = (Start + End) / 2;
-    Cmp = AsciiStrCmp (SortedList[Curr].Name, Name);
+    Cmp = OcAsciiStrCmp (SortedList[Curr].Name, Name);
 
     if (Cmp == 0) {
       return &SortedList[Curr];
@@ -235,7 +236,7 @@ ParseSerializedMap (
 
   for (Index = 0; Index < DictSize; Index++) {
     CurrentKey = PlistKeyValue (PlistDictChild (Node, Index, &ChildNode));
-    CurrentKeyLen = CurrentKey != NULL ? (UINT32) (AsciiStrLen (CurrentKey) + 1) : 0;
+    CurrentKeyLen = CurrentKey != NULL ? (UINT32) (OcAsciiStrLen (CurrentKey) + 1) : 0;
 
     if (CurrentKeyLen == 0) {
       DEBUG ((DEBUG_INFO, "OCS: No get serialized key at %u index!\n", Index));
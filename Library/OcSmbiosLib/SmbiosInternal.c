@@ -570,3 +570,475 @@ SmbiosGetStructureCount (
 
   return Count;
 }
+
+//
+// String of a structure being rebuilt.
+//
+typedef struct {
+  CONST CHAR8  *String;
+  UINT32       Length;
+} OC_SMBIOS_DIFF_STRING;
+
+/**
+  Check whether any override targets the structure.
+
+  @param[in] Overrides      Field overrides.
+  @param[in] OverrideCount  Number of field overrides.
+  @param[in] Type           Structure type.
+  @param[in] Index          Structure index within its type.
+
+  @retval TRUE when structure needs to be rebuilt.
+**/
+STATIC
+BOOLEAN
+SmbiosDiffIsDirty (
+  IN CONST OC_SMBIOS_OVERRIDE  *Overrides,
+  IN UINT32                    OverrideCount,
+  IN SMBIOS_TYPE               Type,
+  IN UINT16                    Index
+  )
+{
+  UINT32  OverrideIndex;
+
+  for (OverrideIndex = 0; OverrideIndex < OverrideCount; ++OverrideIndex) {
+    if (Overrides[OverrideIndex].Type == Type && Overrides[OverrideIndex].Index == Index) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Obtain override string length following SmbiosOverrideString rules.
+
+  @param[in] String  Override string, optional.
+
+  @retval string length to write or 0 to drop the string.
+**/
+STATIC
+UINT32
+SmbiosDiffStringLength (
+  IN CONST CHAR8  *String  OPTIONAL
+  )
+{
+  UINT32  Length;
+
+  if (String == NULL) {
+    return 0;
+  }
+
+  Length = (UINT32) AsciiStrLen (String);
+  if (Length > SMBIOS_STRING_MAX_LENGTH) {
+    Length = SMBIOS_STRING_MAX_LENGTH;
+  }
+
+  while (Length > 0 && String[Length - 1] == ' ') {
+    Length--;
+  }
+
+  return Length;
+}
+
+/**
+  Copy contiguous original structures in one go.
+
+  @param[in,out] Table  Current table buffer.
+  @param[in]     Run    First structure to copy.
+  @param[in]     Size   Total structure size to copy.
+
+  @retval EFI_SUCCESS on success.
+**/
+STATIC
+EFI_STATUS
+SmbiosDiffFlush (
+  IN OUT OC_SMBIOS_TABLE  *Table,
+  IN     CONST UINT8      *Run,
+  IN     UINT32           Size
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Size == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = SmbiosExtendTable (Table, Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  CopyMem (Table->CurrentPtr.Raw, Run, Size);
+  Table->CurrentPtr.Raw += Size;
+  Table->CurrentStrPtr   = (CHAR8 *) Table->CurrentPtr.Raw;
+
+  return EFI_SUCCESS;
+}
+
+//
+// String fields of the structures with string overrides.
+//
+STATIC CONST UINT8 mSmbiosDiffType0Strings[] = {
+  OFFSET_OF (SMBIOS_TABLE_TYPE0, Vendor),
+  OFFSET_OF (SMBIOS_TABLE_TYPE0, BiosVersion),
+  OFFSET_OF (SMBIOS_TABLE_TYPE0, BiosReleaseDate)
+};
+
+STATIC CONST UINT8 mSmbiosDiffType1Strings[] = {
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, Manufacturer),
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, ProductName),
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, Version),
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, SerialNumber),
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, SKUNumber),
+  OFFSET_OF (SMBIOS_TABLE_TYPE1, Family)
+};
+
+STATIC CONST UINT8 mSmbiosDiffType2Strings[] = {
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, Manufacturer),
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, ProductName),
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, Version),
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, SerialNumber),
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, AssetTag),
+  OFFSET_OF (SMBIOS_TABLE_TYPE2, LocationInChassis)
+};
+
+STATIC CONST UINT8 mSmbiosDiffType3Strings[] = {
+  OFFSET_OF (SMBIOS_TABLE_TYPE3, Manufacturer),
+  OFFSET_OF (SMBIOS_TABLE_TYPE3, Version),
+  OFFSET_OF (SMBIOS_TABLE_TYPE3, SerialNumber),
+  OFFSET_OF (SMBIOS_TABLE_TYPE3, AssetTag)
+};
+
+/**
+  Check whether a string is referenced by any string field besides
+  the overridden one. Strings of structures with unknown string fields
+  are always considered shared.
+
+  @param[in] Structure        Structure formatted area.
+  @param[in] FormattedLength  Formatted area length.
+  @param[in] FieldOffset      Overridden field offset.
+  @param[in] StringIndex      String index referenced by the field.
+
+  @retval TRUE when the string is referenced by another field.
+**/
+STATIC
+BOOLEAN
+SmbiosDiffIsStringShared (
+  IN CONST UINT8  *Structure,
+  IN UINT8        FormattedLength,
+  IN UINT8        FieldOffset,
+  IN UINT8        StringIndex
+  )
+{
+  CONST UINT8  *Fields;
+  UINT32       FieldCount;
+  UINT32       Index;
+  UINT32       SkuOffset;
+
+  switch (((CONST SMBIOS_STRUCTURE *) Structure)->Type) {
+    case SMBIOS_TYPE_BIOS_INFORMATION:
+      Fields     = mSmbiosDiffType0Strings;
+      FieldCount = ARRAY_SIZE (mSmbiosDiffType0Strings);
+      break;
+    case SMBIOS_TYPE_SYSTEM_INFORMATION:
+      Fields     = mSmbiosDiffType1Strings;
+      FieldCount = ARRAY_SIZE (mSmbiosDiffType1Strings);
+      break;
+    case SMBIOS_TYPE_BASEBOARD_INFORMATION:
+      Fields     = mSmbiosDiffType2Strings;
+      FieldCount = ARRAY_SIZE (mSmbiosDiffType2Strings);
+      break;
+    case SMBIOS_TYPE_SYSTEM_ENCLOSURE:
+      Fields     = mSmbiosDiffType3Strings;
+      FieldCount = ARRAY_SIZE (mSmbiosDiffType3Strings);
+
+      //
+      // SKUNumber follows the contained elements array.
+      //
+      if (OFFSET_OF (SMBIOS_TABLE_TYPE3, ContainedElements) <= FormattedLength) {
+        SkuOffset = OFFSET_OF (SMBIOS_TABLE_TYPE3, ContainedElements)
+          + (UINT32) Structure[OFFSET_OF (SMBIOS_TABLE_TYPE3, ContainedElementCount)]
+          * Structure[OFFSET_OF (SMBIOS_TABLE_TYPE3, ContainedElementRecordLength)];
+        if (SkuOffset < FormattedLength
+          && SkuOffset != FieldOffset
+          && Structure[SkuOffset] == StringIndex) {
+          return TRUE;
+        }
+      }
+      break;
+    default:
+      return TRUE;
+  }
+
+  for (Index = 0; Index < FieldCount; ++Index) {
+    if (Fields[Index] < FormattedLength
+      && Fields[Index] != FieldOffset
+      && Structure[Fields[Index]] == StringIndex) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Rebuild original structure applying overrides.
+
+  @param[in,out] Table          Current table buffer.
+  @param[in]     Original       Original structure.
+  @param[in]     Length         Original structure size with strings.
+  @param[in]     Overrides      Field overrides.
+  @param[in]     OverrideCount  Number of field overrides.
+  @param[in]     Index          Structure index within its type.
+
+  @retval EFI_SUCCESS on success.
+**/
+STATIC
+EFI_STATUS
+SmbiosDiffRebuild (
+  IN OUT OC_SMBIOS_TABLE                 *Table,
+  IN     APPLE_SMBIOS_STRUCTURE_POINTER  Original,
+  IN     UINT32                          Length,
+  IN     CONST OC_SMBIOS_OVERRIDE        *Overrides,
+  IN     UINT32                          OverrideCount,
+  IN     UINT16                          Index
+  )
+{
+  EFI_STATUS             Status;
+  OC_SMBIOS_DIFF_STRING  Strings[MAX_UINT8];
+  UINT32                 StringCount;
+  UINT32                 StringIndex;
+  UINT32                 OverrideIndex;
+  UINT32                 ExtraSize;
+  UINT8                  FormattedLength;
+  CONST CHAR8            *Walker;
+  UINT8                  *Target;
+  UINT8                  *Field;
+
+  FormattedLength = Original.Standard.Hdr->Length;
+
+  //
+  // Collect original strings, validated by SmbiosGetStructureLength.
+  //
+  StringCount = 0;
+  Walker      = (CONST CHAR8 *) Original.Raw + FormattedLength;
+  while (*Walker != '\0' && StringCount < ARRAY_SIZE (Strings)) {
+    Strings[StringCount].String = Walker;
+    Strings[StringCount].Length = (UINT32) AsciiStrLen (Walker);
+    Walker += Strings[StringCount].Length + 1;
+    ++StringCount;
+  }
+
+  ExtraSize = 0;
+  for (OverrideIndex = 0; OverrideIndex < OverrideCount; ++OverrideIndex) {
+    if (Overrides[OverrideIndex].Type == Original.Standard.Hdr->Type
+      && Overrides[OverrideIndex].Index == Index
+      && Overrides[OverrideIndex].Size == 0) {
+      ExtraSize += SmbiosDiffStringLength (Overrides[OverrideIndex].Value) + 1;
+    }
+  }
+
+  Status = SmbiosExtendTable (Table, Length + ExtraSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Target = Table->CurrentPtr.Raw;
+  CopyMem (Target, Original.Raw, FormattedLength);
+
+  for (OverrideIndex = 0; OverrideIndex < OverrideCount; ++OverrideIndex) {
+    if (Overrides[OverrideIndex].Type != Original.Standard.Hdr->Type
+      || Overrides[OverrideIndex].Index != Index) {
+      continue;
+    }
+
+    if (Overrides[OverrideIndex].Size > 0) {
+      if ((UINT32) Overrides[OverrideIndex].Offset + Overrides[OverrideIndex].Size <= FormattedLength) {
+        CopyMem (
+          Target + Overrides[OverrideIndex].Offset,
+          Overrides[OverrideIndex].Value,
+          Overrides[OverrideIndex].Size
+          );
+      }
+      continue;
+    }
+
+    if (Overrides[OverrideIndex].Offset + sizeof (SMBIOS_TABLE_STRING) > FormattedLength) {
+      continue;
+    }
+
+    //
+    // Replace referenced string in place to keep other string indices intact,
+    // unless another field references the same deduplicated string.
+    // Append a new one otherwise. Dropped strings stay unreferenced.
+    //
+    Field = Target + Overrides[OverrideIndex].Offset;
+    if (SmbiosDiffStringLength (Overrides[OverrideIndex].Value) == 0) {
+      *Field = 0;
+    } else if (*Field != 0 && *Field <= StringCount
+      && !SmbiosDiffIsStringShared (Target, FormattedLength, Overrides[OverrideIndex].Offset, *Field)) {
+      Strings[*Field - 1].String = Overrides[OverrideIndex].Value;
+      Strings[*Field - 1].Length = SmbiosDiffStringLength (Overrides[OverrideIndex].Value);
+    } else if (StringCount < ARRAY_SIZE (Strings)) {
+      Strings[StringCount].String = Overrides[OverrideIndex].Value;
+      Strings[StringCount].Length = SmbiosDiffStringLength (Overrides[OverrideIndex].Value);
+      ++StringCount;
+      *Field = (UINT8) StringCount;
+    }
+  }
+
+  Target += FormattedLength;
+  for (StringIndex = 0; StringIndex < StringCount; ++StringIndex) {
+    CopyMem (Target, Strings[StringIndex].String, Strings[StringIndex].Length);
+    Target   += Strings[StringIndex].Length;
+    *Target++ = '\0';
+  }
+
+  //
+  // Structures without strings end with double zero.
+  //
+  if (StringCount == 0) {
+    *Target++ = '\0';
+  }
+  *Target++ = '\0';
+
+  DEBUG_CODE_BEGIN();
+  SmbiosDebugAnyStructure (Table->CurrentPtr);
+  DEBUG_CODE_END();
+
+  Table->CurrentPtr.Raw = Target;
+  Table->CurrentStrPtr  = (CHAR8 *) Target;
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+SmbiosDiffTable (
+  IN OUT OC_SMBIOS_TABLE                 *Table,
+  IN     APPLE_SMBIOS_STRUCTURE_POINTER  Original,
+  IN     UINT32                          OriginalSize,
+  IN     CONST OC_SMBIOS_OVERRIDE        *Overrides,
+  IN     UINT32                          OverrideCount,
+  OUT    OC_SMBIOS_PATCH_STATS           *Stats  OPTIONAL
+  )
+{
+  EFI_STATUS     Status;
+  UINT16         TypeIndices[MAX_UINT8 + 1];
+  UINT8          DirtyTypes[(MAX_UINT8 + 1) / 8];
+  UINT8          DroppedTypes[(MAX_UINT8 + 1) / 8];
+  UINT32         OverrideIndex;
+  UINT32         Length;
+  UINT32         RebuildOffset;
+  CONST UINT8    *Run;
+  UINT32         RunSize;
+  SMBIOS_TYPE    Type;
+  SMBIOS_HANDLE  MaxHandle;
+  BOOLEAN        Dropped;
+  BOOLEAN        Dirty;
+
+  ZeroMem (TypeIndices, sizeof (TypeIndices));
+  ZeroMem (DirtyTypes, sizeof (DirtyTypes));
+  ZeroMem (DroppedTypes, sizeof (DroppedTypes));
+
+  for (OverrideIndex = 0; OverrideIndex < OverrideCount; ++OverrideIndex) {
+    Type = Overrides[OverrideIndex].Type;
+    if (Overrides[OverrideIndex].Index == 0) {
+      DroppedTypes[Type / 8] |= (UINT8) (1U << (Type % 8));
+    } else {
+      DirtyTypes[Type / 8] |= (UINT8) (1U << (Type % 8));
+    }
+  }
+
+  Run       = NULL;
+  RunSize   = 0;
+  MaxHandle = 0;
+
+  while (OriginalSize >= sizeof (SMBIOS_STRUCTURE)) {
+    Length = SmbiosGetStructureLength (Original, OriginalSize);
+    if (Length == 0) {
+      break;
+    }
+
+    Type = Original.Standard.Hdr->Type;
+    if (Type == SMBIOS_TYPE_END_OF_TABLE) {
+      break;
+    }
+
+    ++TypeIndices[Type];
+
+    if (Original.Standard.Hdr->Handle > MaxHandle) {
+      MaxHandle = Original.Standard.Hdr->Handle;
+    }
+
+    Dropped = (DroppedTypes[Type / 8] & (1U << (Type % 8))) != 0;
+    Dirty   = !Dropped
+      && (DirtyTypes[Type / 8] & (1U << (Type % 8))) != 0
+      && SmbiosDiffIsDirty (Overrides, OverrideCount, Type, TypeIndices[Type]);
+
+    if (Dropped || Dirty) {
+      //
+      // Copy the preceding clean structures before changing anything.
+      //
+      Status = SmbiosDiffFlush (Table, Run, RunSize);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      if (Stats != NULL) {
+        Stats->CopiedSize += RunSize;
+      }
+
+      Run     = NULL;
+      RunSize = 0;
+    }
+
+    if (Dirty) {
+      RebuildOffset = (UINT32) (Table->CurrentPtr.Raw - Table->Table);
+      Status = SmbiosDiffRebuild (Table, Original, Length, Overrides, OverrideCount, TypeIndices[Type]);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      if (Stats != NULL) {
+        Stats->RebuiltSize += (UINT32) (Table->CurrentPtr.Raw - Table->Table) - RebuildOffset;
+        Stats->RebuiltCount++;
+      }
+    } else if (!Dropped) {
+      if (Run == NULL) {
+        Run = Original.Raw;
+      }
+
+      RunSize += Length;
+
+      if (Stats != NULL) {
+        Stats->CopiedCount++;
+      }
+    }
+
+    if (!Dropped) {
+      if (Original.Standard.Hdr->Length > Table->MaxStructureSize) {
+        Table->MaxStructureSize = Original.Standard.Hdr->Length;
+      }
+
+      Table->NumberOfStructures++;
+    }
+
+    Original.Raw += Length;
+    OriginalSize -= Length;
+  }
+
+  Status = SmbiosDiffFlush (Table, Run, RunSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Stats != NULL) {
+    Stats->CopiedSize += RunSize;
+  }
+
+  if (MaxHandle >= Table->Handle) {
+    Table->Handle = MaxHandle + 1;
+  }
+
+  return EFI_SUCCESS;
+}
@@ -17,6 +17,7 @@
 
 #include <IndustryStandard/AppleSmBios.h>
 #include <Library/OcGuardLib.h>
+#include <Library/OcSmbiosLib.h>
 
 //
 // 2 zero bytes required in the end of each table.
@@ -133,6 +134,33 @@ typedef struct OC_SMBIOS_TABLE_ {
   UINT16                           NumberOfStructures;
 } OC_SMBIOS_TABLE;
 
+//
+// Single field override for sparse SMBIOS table rebuild.
+//
+typedef struct OC_SMBIOS_OVERRIDE_ {
+  //
+  // Structure type.
+  //
+  SMBIOS_TYPE    Type;
+  //
+  // Structure index within its type, starting from 1.
+  // 0 drops all structures of this type.
+  //
+  UINT16         Index;
+  //
+  // Field offset within the formatted area.
+  //
+  UINT8          Offset;
+  //
+  // Field size, 0 for string fields.
+  //
+  UINT8          Size;
+  //
+  // Field value, or ASCII string for string fields.
+  //
+  CONST VOID     *Value;
+} OC_SMBIOS_OVERRIDE;
+
 //
 // Map old handles to new ones.
 //
@@ -294,4 +322,31 @@ SmbiosGetStructureCount (
   IN  SMBIOS_TYPE                     Type
   );
 
+/**
+  Append original SMBIOS structures to the table applying overrides.
+  Structures without overrides are copied verbatim in contiguous blocks,
+  structures with overrides are rebuilt with their string sets, and
+  structures of dropped types are skipped.
+  End of table structure is not copied, and table handle is updated
+  to follow the largest original handle.
+
+  @param[in,out] Table          Current table buffer.
+  @param[in]     Original       Original SMBIOS table.
+  @param[in]     OriginalSize   Original SMBIOS table size.
+  @param[in]     Overrides      Field overrides.
+  @param[in]     OverrideCount  Number of field overrides.
+  @param[out]    Stats          Rebuild statistics, optional.
+
+  @retval EFI_SUCCESS on success.
+**/
+EFI_STATUS
+SmbiosDiffTable (
+  IN OUT OC_SMBIOS_TABLE                 *Table,
+  IN     APPLE_SMBIOS_STRUCTURE_POINTER  Original,
+  IN     UINT32                          OriginalSize,
+  IN     CONST OC_SMBIOS_OVERRIDE        *Overrides,
+  IN     UINT32                          OverrideCount,
+  OUT    OC_SMBIOS_PATCH_STATS           *Stats  OPTIONAL
+  );
+
 #endif // SMBIOS_INTERNAL_H
@@ -25,6 +25,7 @@
 #include <Library/OcSmbiosLib.h>
 #include <Library/OcMemoryLib.h>
 #include <Library/OcMiscLib.h>
+#include <Library/OcPerfLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcFileLib.h>
 #include <Library/OcStringLib.h>
@@ -1669,8 +1670,9 @@ SmbiosGetSmcVersion (
 
   @retval EFI_SUCCESS               The smbios tables were generated successfully
 **/
+STATIC
 EFI_STATUS
-CreateSmbios (
+InternalCreateSmbios (
   IN OC_SMBIOS_DATA         *Data,
   IN OC_SMBIOS_UPDATE_MODE  Mode,
   IN OC_CPU_INFO            *CpuInfo
@@ -1773,3 +1775,269 @@ CreateSmbios (
 
   return Status;
 }
+
+EFI_STATUS
+CreateSmbios (
+  IN OC_SMBIOS_DATA         *Data,
+  IN OC_SMBIOS_UPDATE_MODE  Mode,
+  IN OC_CPU_INFO            *CpuInfo
+  )
+{
+  EFI_STATUS  Status;
+
+  OcPerfBegin (OC_PERF_PHASE_SMBIOS);
+
+  Status = InternalCreateSmbios (
+    Data,
+    Mode,
+    CpuInfo
+    );
+
+  OcPerfEnd (OC_PERF_PHASE_SMBIOS, 0, Status);
+
+  return Status;
+}
+
+//
+// Fixed overrides besides per memory device ones.
+//
+#define OC_SMBIOS_DIFF_MAX_OVERRIDES 32
+
+/**
+  Register field override for sparse rebuild.
+
+  @param[in,out] Overrides  Override list.
+  @param[in,out] Count      Number of overrides in the list.
+  @param[in]     Max        Override list capacity.
+  @param[in]     Type       Structure type.
+  @param[in]     Index      Structure index within its type, 0 to drop the type.
+  @param[in]     Offset     Field offset.
+  @param[in]     Size       Field size, 0 for strings.
+  @param[in]     Value      Field value, no override when NULL.
+**/
+STATIC
+VOID
+SmbiosAddOverride (
+  IN OUT OC_SMBIOS_OVERRIDE  *Overrides,
+  IN OUT UINT32              *Count,
+  IN     UINT32              Max,
+  IN     SMBIOS_TYPE         Type,
+  IN     UINT16              Index,
+  IN     UINTN               Offset,
+  IN     UINTN               Size,
+  IN     CONST VOID          *Value  OPTIONAL
+  )
+{
+  if (Value == NULL && Index != 0) {
+    return;
+  }
+
+  if (*Count >= Max) {
+    ASSERT (FALSE);
+    return;
+  }
+
+  Overrides[*Count].Type   = Type;
+  Overrides[*Count].Index  = Index;
+  Overrides[*Count].Offset = (UINT8) Offset;
+  Overrides[*Count].Size   = (UINT8) Size;
+  Overrides[*Count].Value  = Value;
+  ++(*Count);
+}
+
+#define SMBIOS_DIFF_S(Overrides, Count, Max, Type, Struct, Field, Value) \
+  SmbiosAddOverride ((Overrides), (Count), (Max), (Type), 1, OFFSET_OF (Struct, Field), 0, (Value))
+
+#define SMBIOS_DIFF_V(Overrides, Count, Max, Type, Index, Struct, Field, Value) \
+  SmbiosAddOverride ((Overrides), (Count), (Max), (Type), (Index), OFFSET_OF (Struct, Field), \
+    sizeof (((Struct *) NULL)->Field), (Value))
+
+/**
+  Reassign handles of created structures to follow original handles.
+
+  @param[in,out] Table  Current table buffer.
+  @param[in]     Start  Offset of the first created structure.
+**/
+STATIC
+VOID
+SmbiosDiffAssignHandles (
+  IN OUT OC_SMBIOS_TABLE  *Table,
+  IN     UINT32           Start
+  )
+{
+  APPLE_SMBIOS_STRUCTURE_POINTER  Walker;
+  UINT32                          Size;
+  UINT32                          Length;
+
+  Walker.Raw = Table->Table + Start;
+  Size       = (UINT32) (Table->CurrentPtr.Raw - Walker.Raw);
+
+  while (Size >= sizeof (SMBIOS_STRUCTURE)) {
+    Length = SmbiosGetStructureLength (Walker, Size);
+    if (Length == 0) {
+      break;
+    }
+
+    Walker.Standard.Hdr->Handle = Table->Handle++;
+    Walker.Raw += Length;
+    Size       -= Length;
+  }
+}
+
+STATIC
+EFI_STATUS
+InternalPatchSmbios (
+  IN  OC_SMBIOS_DATA         *Data,
+  IN  OC_SMBIOS_UPDATE_MODE  Mode,
+  IN  OC_CPU_INFO            *CpuInfo,
+  OUT OC_SMBIOS_PATCH_STATS  *Stats
+  )
+{
+  EFI_STATUS          Status;
+  OC_SMBIOS_TABLE     SmbiosTable;
+  OC_SMBIOS_OVERRIDE  *Overrides;
+  UINT32              OverrideCount;
+  UINT32              OverrideMax;
+  UINT16              NumberMemoryDevices;
+  UINT16              MemoryDeviceNo;
+  UINT32              CreatedStart;
+  UINT16              OriginalCount;
+
+  ASSERT (Data != NULL);
+
+  Status = SmbiosPrepareTable (&SmbiosTable);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  NumberMemoryDevices = SmbiosGetOriginalStructureCount (SMBIOS_TYPE_MEMORY_DEVICE);
+  OverrideMax         = OC_SMBIOS_DIFF_MAX_OVERRIDES + NumberMemoryDevices;
+  OverrideCount       = 0;
+  Overrides           = AllocatePool (OverrideMax * sizeof (*Overrides));
+  if (Overrides == NULL) {
+    DEBUG ((DEBUG_WARN, "OCSMB: Cannot allocate override table\n"));
+    SmbiosTableFree (&SmbiosTable);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BIOS_INFORMATION, SMBIOS_TABLE_TYPE0, Vendor, Data->BIOSVendor);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BIOS_INFORMATION, SMBIOS_TABLE_TYPE0, BiosVersion, Data->BIOSVersion);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BIOS_INFORMATION, SMBIOS_TABLE_TYPE0, BiosReleaseDate, Data->BIOSReleaseDate);
+
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, Manufacturer, Data->SystemManufacturer);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, ProductName, Data->SystemProductName);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, Version, Data->SystemVersion);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, SerialNumber, Data->SystemSerialNumber);
+  SMBIOS_DIFF_V (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, 1, SMBIOS_TABLE_TYPE1, Uuid, Data->SystemUUID);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, SKUNumber, Data->SystemSKUNumber);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_INFORMATION, SMBIOS_TABLE_TYPE1, Family, Data->SystemFamily);
+
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, Manufacturer, Data->BoardManufacturer);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, ProductName, Data->BoardProduct);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, Version, Data->BoardVersion);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, SerialNumber, Data->BoardSerialNumber);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, AssetTag, Data->BoardAssetTag);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, SMBIOS_TABLE_TYPE2, LocationInChassis, Data->BoardLocationInChassis);
+  SMBIOS_DIFF_V (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_BASEBOARD_INFORMATION, 1, SMBIOS_TABLE_TYPE2, BoardType, Data->BoardType);
+
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_ENCLOSURE, SMBIOS_TABLE_TYPE3, Manufacturer, Data->ChassisManufacturer);
+  SMBIOS_DIFF_V (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_ENCLOSURE, 1, SMBIOS_TABLE_TYPE3, Type, Data->ChassisType);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_ENCLOSURE, SMBIOS_TABLE_TYPE3, Version, Data->ChassisVersion);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_ENCLOSURE, SMBIOS_TABLE_TYPE3, SerialNumber, Data->ChassisSerialNumber);
+  SMBIOS_DIFF_S (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_SYSTEM_ENCLOSURE, SMBIOS_TABLE_TYPE3, AssetTag, Data->ChassisAssetTag);
+
+  for (MemoryDeviceNo = 1; MemoryDeviceNo <= NumberMemoryDevices; ++MemoryDeviceNo) {
+    SMBIOS_DIFF_V (Overrides, &OverrideCount, OverrideMax, SMBIOS_TYPE_MEMORY_DEVICE, MemoryDeviceNo, SMBIOS_TABLE_TYPE17, FormFactor, Data->MemoryFormFactor);
+  }
+
+  //
+  // Apple structures are always created from the configuration.
+  //
+  SmbiosAddOverride (Overrides, &OverrideCount, OverrideMax, APPLE_SMBIOS_TYPE_FIRMWARE_INFORMATION, 0, 0, 0, NULL);
+  SmbiosAddOverride (Overrides, &OverrideCount, OverrideMax, APPLE_SMBIOS_TYPE_PROCESSOR_TYPE, 0, 0, 0, NULL);
+  SmbiosAddOverride (Overrides, &OverrideCount, OverrideMax, APPLE_SMBIOS_TYPE_PLATFORM_FEATURE, 0, 0, 0, NULL);
+  SmbiosAddOverride (Overrides, &OverrideCount, OverrideMax, APPLE_SMBIOS_TYPE_SMC_INFORMATION, 0, 0, 0, NULL);
+#ifdef OC_PROVIDE_APPLE_PROCESSOR_BUS_SPEED
+  SmbiosAddOverride (Overrides, &OverrideCount, OverrideMax, APPLE_SMBIOS_TYPE_PROCESSOR_BUS_SPEED, 0, 0, 0, NULL);
+#endif
+
+  Status = SmbiosDiffTable (
+    &SmbiosTable,
+    mOriginalTable,
+    mOriginalTableSize,
+    Overrides,
+    OverrideCount,
+    Stats
+    );
+
+  FreePool (Overrides);
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "OCSMB: Failed to rebuild original table - %r\n", Status));
+    SmbiosTableFree (&SmbiosTable);
+    return Status;
+  }
+
+  CreatedStart  = (UINT32) (SmbiosTable.CurrentPtr.Raw - SmbiosTable.Table);
+  OriginalCount = SmbiosTable.NumberOfStructures;
+
+  CreateAppleProcessorType (&SmbiosTable, Data, CpuInfo);
+  CreateAppleProcessorSpeed (&SmbiosTable, Data, CpuInfo);
+  CreateAppleFirmwareVolume (&SmbiosTable, Data);
+  CreateApplePlatformFeature (&SmbiosTable, Data);
+  CreateAppleSmcInformation (&SmbiosTable, Data);
+  CreateSmBiosEndOfTable (&SmbiosTable, Data);
+
+  SmbiosDiffAssignHandles (&SmbiosTable, CreatedStart);
+
+  Stats->CreatedCount = SmbiosTable.NumberOfStructures - OriginalCount;
+  Stats->CreatedSize  = (UINT32) (SmbiosTable.CurrentPtr.Raw - SmbiosTable.Table) - CreatedStart;
+
+  DEBUG ((
+    DEBUG_INFO,
+    "OCSMB: Patched with %u/%u copied, %u/%u rebuilt, %u/%u created structures/bytes\n",
+    Stats->CopiedCount,
+    Stats->CopiedSize,
+    Stats->RebuiltCount,
+    Stats->RebuiltSize,
+    Stats->CreatedCount,
+    Stats->CreatedSize
+    ));
+
+  Status = SmbiosTableApply (&SmbiosTable, Mode);
+
+  SmbiosTableFree (&SmbiosTable);
+
+  return Status;
+}
+
+EFI_STATUS
+PatchSmbios (
+  IN  OC_SMBIOS_DATA         *Data,
+  IN  OC_SMBIOS_UPDATE_MODE  Mode,
+  IN  OC_CPU_INFO            *CpuInfo,
+  OUT OC_SMBIOS_PATCH_STATS  *Stats  OPTIONAL
+  )
+{
+  EFI_STATUS             Status;
+  OC_SMBIOS_PATCH_STATS  LocalStats;
+
+  if (Stats == NULL) {
+    Stats = &LocalStats;
+  }
+
+  ZeroMem (Stats, sizeof (*Stats));
+
+  OcPerfBegin (OC_PERF_PHASE_SMBIOS);
+
+  Status = InternalPatchSmbios (
+    Data,
+    Mode,
+    CpuInfo,
+    Stats
+    );
+
+  OcPerfEnd (OC_PERF_PHASE_SMBIOS, Stats->CopiedSize + Stats->RebuiltSize + Stats->CreatedSize, Status);
+
+  return Status;
+}
@@ -33,9 +33,12 @@ EFI_EVENT
 mAuthenticationKeyEraseEvent;
 
 STATIC
-VIRTUALSMC_KEY_VALUE
-mVirtualSmcKeyValue[6] = {
-  { SMC_KEY_KEY, SmcKeyTypeUint32, 4, SMC_KEY_ATTRIBUTE_READ, {0, 0, 0, ARRAY_SIZE (mVirtualSmcKeyValue)} },
+CONST VIRTUALSMC_KEY_VALUE
+mVirtualSmcDefaultKeys[] = {
+  //
+  // Key count is updated as keys get registered.
+  //
+  { SMC_KEY_KEY, SmcKeyTypeUint32, 4, SMC_KEY_ATTRIBUTE_READ, {0} },
   { SMC_KEY_RMde, SmcKeyTypeChar, 1, SMC_KEY_ATTRIBUTE_READ, {SMC_MODE_APPCODE} },
   //
   // Requested yet unused (battery inside, causes missing battery in UI).
@@ -44,15 +47,194 @@ mVirtualSmcKeyValue[6] = {
   { SMC_KEY_BRSC, SmcKeyTypeUint16, 2, SMC_KEY_ATTRIBUTE_READ, {0} },
   { SMC_KEY_MSLD, SmcKeyTypeUint8, 1, SMC_KEY_ATTRIBUTE_READ, {0} },
   { SMC_KEY_BATP, SmcKeyTypeFlag, 1, SMC_KEY_ATTRIBUTE_READ, {0} },
+  { SMC_KEY_HBKP, SmcKeyTypeCh8s, SMC_HBKP_SIZE, SMC_KEY_ATTRIBUTE_READ|SMC_KEY_ATTRIBUTE_WRITE, {0} }
+};
+
+//
+// Key table sorted by key value for binary search.
+//
+STATIC
+VIRTUALSMC_KEY_VALUE
+*mVirtualSmcKeyValue;
+
+STATIC
+UINT32
+mVirtualSmcKeyCount;
+
+STATIC
+UINT32
+mVirtualSmcKeyCapacity;
+
+/**
+  Find the index of the first key not less than Key.
+
+  @param[in]  Key    SMC key to look up.
+  @param[out] Index  Lower bound index in key table.
+
+  @retval TRUE if Key is present at Index.
+**/
+STATIC
+BOOLEAN
+InternalSmcFindKey (
+  IN  SMC_KEY  Key,
+  OUT UINT32   *Index
+  )
+{
+  UINT32  Start;
+  UINT32  End;
+  UINT32  Middle;
+
+  Start = 0;
+  End   = mVirtualSmcKeyCount;
+
+  while (Start < End) {
+    Middle = Start + (End - Start) / 2;
+    if (mVirtualSmcKeyValue[Middle].Key < Key) {
+      Start = Middle + 1;
+    } else {
+      End = Middle;
+    }
+  }
+
+  *Index = Start;
+  return Start < mVirtualSmcKeyCount && mVirtualSmcKeyValue[Start].Key == Key;
+}
+
+/**
+  Look up SMC key.
+
+  @param[in]  Key    SMC key to look up.
+
+  @retval key entry or NULL.
+**/
+STATIC
+VIRTUALSMC_KEY_VALUE *
+InternalSmcGetKey (
+  IN  SMC_KEY  Key
+  )
+{
+  UINT32  Index;
+
+  if (InternalSmcFindKey (Key, &Index)) {
+    return &mVirtualSmcKeyValue[Index];
+  }
+
+  return NULL;
+}
+
+/**
+  Insert or update SMC key, preserving key table order.
+
+  @param[in]  Key         SMC key.
+  @param[in]  Type        SMC key type.
+  @param[in]  Size        SMC key data size.
+  @param[in]  Attributes  SMC key attributes.
+  @param[in]  Data        SMC key data of Size bytes, optional.
+
+  @retval EFI_SUCCESS on success.
+**/
+STATIC
+EFI_STATUS
+InternalSmcSetKey (
+  IN SMC_KEY             Key,
+  IN SMC_KEY_TYPE        Type,
+  IN SMC_DATA_SIZE       Size,
+  IN SMC_KEY_ATTRIBUTES  Attributes,
+  IN CONST SMC_DATA      *Data  OPTIONAL
+  )
+{
+  VIRTUALSMC_KEY_VALUE  *NewKeys;
+  VIRTUALSMC_KEY_VALUE  *Entry;
+  UINT32                NewCapacity;
+  UINT32                Index;
+  VIRTUALSMC_KEY_VALUE  *CountKey;
+
+  if (Size > SMC_MAX_DATA_SIZE) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!InternalSmcFindKey (Key, &Index)) {
+    if (mVirtualSmcKeyCount == mVirtualSmcKeyCapacity) {
+      NewCapacity = mVirtualSmcKeyCapacity * 2;
+      if (NewCapacity == 0) {
+        NewCapacity = VIRTUALSMC_INITIAL_KEY_COUNT;
+      }
+
+      NewKeys = ReallocatePool (
+        mVirtualSmcKeyCapacity * sizeof (mVirtualSmcKeyValue[0]),
+        NewCapacity * sizeof (mVirtualSmcKeyValue[0]),
+        mVirtualSmcKeyValue
+        );
+      if (NewKeys == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      mVirtualSmcKeyValue    = NewKeys;
+      mVirtualSmcKeyCapacity = NewCapacity;
+    }
+
+    CopyMem (
+      &mVirtualSmcKeyValue[Index + 1],
+      &mVirtualSmcKeyValue[Index],
+      (mVirtualSmcKeyCount - Index) * sizeof (mVirtualSmcKeyValue[0])
+      );
+    ++mVirtualSmcKeyCount;
+  }
+
+  Entry             = &mVirtualSmcKeyValue[Index];
+  Entry->Key        = Key;
+  Entry->Type       = Type;
+  Entry->Size       = Size;
+  Entry->Attributes = Attributes;
+  ZeroMem (Entry->Data, sizeof (Entry->Data));
+  if (Data != NULL) {
+    CopyMem (Entry->Data, Data, Size);
+  }
+
   //
-  // HBKP must always be the last key in the list (see mAuthenticationKeyIndex).
+  // Key count is stored in big endian.
   //
-  { SMC_KEY_HBKP, SmcKeyTypeCh8s, 32, SMC_KEY_ATTRIBUTE_READ|SMC_KEY_ATTRIBUTE_WRITE, {0} }
-};
+  CountKey = InternalSmcGetKey (SMC_KEY_KEY);
+  if (CountKey != NULL) {
+    WriteUnaligned32 ((UINT32 *) CountKey->Data, SwapBytes32 (mVirtualSmcKeyCount));
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Populate key table with default keys once.
 
+  @retval EFI_SUCCESS on success.
+**/
 STATIC
-CONST UINT8
-mAuthenticationKeyIndex = ARRAY_SIZE (mVirtualSmcKeyValue) - 1;
+EFI_STATUS
+InternalSmcInitializeKeys (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  if (mVirtualSmcKeyValue != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (mVirtualSmcDefaultKeys); Index++) {
+    Status = InternalSmcSetKey (
+      mVirtualSmcDefaultKeys[Index].Key,
+      mVirtualSmcDefaultKeys[Index].Type,
+      mVirtualSmcDefaultKeys[Index].Size,
+      mVirtualSmcDefaultKeys[Index].Attributes,
+      mVirtualSmcDefaultKeys[Index].Data
+      );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
 
 STATIC
 EFI_STATUS
@@ -64,7 +246,7 @@ SmcIoVirtualSmcReadValue (
   OUT SMC_DATA               *Value
   )
 {
-  UINTN      Index;
+  VIRTUALSMC_KEY_VALUE  *Entry;
 
   DEBUG ((DEBUG_INFO, "OCSMC: SmcReadValue Key %X Size %d\n", Key, Size));
 
@@ -72,16 +254,15 @@ SmcIoVirtualSmcReadValue (
     return EFI_SMC_BAD_PARAMETER;
   }
 
-  for (Index = 0; Index < ARRAY_SIZE (mVirtualSmcKeyValue); Index++) {
-    if (mVirtualSmcKeyValue[Index].Key == Key) {
-      if (mVirtualSmcKeyValue[Index].Size != Size) {
-        return EFI_SMC_KEY_MISMATCH;
-      }
+  Entry = InternalSmcGetKey (Key);
+  if (Entry != NULL) {
+    if (Entry->Size != Size) {
+      return EFI_SMC_KEY_MISMATCH;
+    }
 
-      CopyMem (Value, mVirtualSmcKeyValue[Index].Data, Size);
+    CopyMem (Value, Entry->Data, Size);
 
-      return EFI_SMC_SUCCESS;
-    }
+    return EFI_SMC_SUCCESS;
   }
 
   return EFI_SMC_NOT_FOUND;
@@ -97,7 +278,8 @@ SmcIoVirtualSmcWriteValue (
   IN  SMC_DATA               *Value
   )
 {
-  UINTN       Index;
+  UINTN                 Index;
+  VIRTUALSMC_KEY_VALUE  *Entry;
 
   DEBUG ((DEBUG_INFO, "OCSMC: SmcWriteValue Key %X Size %d\n", Key, Size));
 
@@ -105,14 +287,23 @@ SmcIoVirtualSmcWriteValue (
     return EFI_SMC_BAD_PARAMETER;
   }
 
+  Entry = InternalSmcGetKey (Key);
+  if (Entry == NULL) {
+    return EFI_SMC_NOT_WRITABLE;
+  }
+
   //
   // Handle HBKP separately to let boot.efi erase its contents as early as it wants.
   //
-  if (Key == SMC_KEY_HBKP && Size <= SMC_HBKP_SIZE) {
-    SecureZeroMem (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data, SMC_HBKP_SIZE);
-    CopyMem (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data, Value, Size);
+  if (Key == SMC_KEY_HBKP) {
+    if (Size > SMC_HBKP_SIZE) {
+      return EFI_SMC_NOT_WRITABLE;
+    }
+
+    SecureZeroMem (Entry->Data, SMC_HBKP_SIZE);
+    CopyMem (Entry->Data, Value, Size);
     for (Index = 0; Index < SMC_HBKP_SIZE; Index++) {
-      if (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data[Index] != 0) {
+      if (Entry->Data[Index] != 0) {
         DEBUG ((DEBUG_INFO, "OCSMC: Not updating key with non-zero data\n"));
         break;
       }
@@ -120,7 +311,20 @@ SmcIoVirtualSmcWriteValue (
 
     return EFI_SUCCESS;
   }
-  return EFI_SMC_NOT_WRITABLE;
+
+  //
+  // Registered writable keys accept values of their exact size.
+  //
+  if ((Entry->Attributes & SMC_KEY_ATTRIBUTE_WRITE) == 0) {
+    return EFI_SMC_NOT_WRITABLE;
+  }
+
+  if (Entry->Size != Size) {
+    return EFI_SMC_KEY_MISMATCH;
+  }
+
+  CopyMem (Entry->Data, Value, Size);
+  return EFI_SMC_SUCCESS;
 }
 
 STATIC
@@ -167,14 +371,14 @@ SmcIoVirtualSmcGetKeyCount (
   DEBUG ((
     DEBUG_VERBOSE,
     "OCSMC: SmcIoVirtualSmcGetKeyCount %u\n",
-    (UINT32) ARRAY_SIZE (mVirtualSmcKeyValue)
+    mVirtualSmcKeyCount
     ));
 
   if (Count == NULL) {
     return EFI_SMC_BAD_PARAMETER;
   }
 
-  *Count = SwapBytes32 (ARRAY_SIZE (mVirtualSmcKeyValue));
+  *Count = SwapBytes32 (mVirtualSmcKeyCount);
 
   return EFI_SMC_SUCCESS;
 }
@@ -194,7 +398,7 @@ SmcIoVirtualSmcGetKeyFromIndex (
     return EFI_SMC_BAD_PARAMETER;
   }
 
-  if (Index < ARRAY_SIZE (mVirtualSmcKeyValue)) {
+  if (Index < mVirtualSmcKeyCount) {
     *Key = mVirtualSmcKeyValue[Index].Key;
     return EFI_SMC_SUCCESS;
   }
@@ -213,7 +417,7 @@ SmcIoVirtualSmcGetKeyInfo (
   OUT SMC_KEY_ATTRIBUTES     *Attributes
   )
 {
-  UINTN Index;
+  VIRTUALSMC_KEY_VALUE  *Entry;
 
   DEBUG ((DEBUG_VERBOSE, "OCSMC: SmcIoVirtualSmcGetKeyFromIndex %X\n", Key));
 
@@ -221,13 +425,12 @@ SmcIoVirtualSmcGetKeyInfo (
     return EFI_SMC_BAD_PARAMETER;
   }
 
-  for (Index = 0; Index < ARRAY_SIZE (mVirtualSmcKeyValue); Index++) {
-    if (mVirtualSmcKeyValue[Index].Key == Key) {
-      *Size = mVirtualSmcKeyValue[Index].Size;
-      *Type = mVirtualSmcKeyValue[Index].Type;
-      *Attributes = mVirtualSmcKeyValue[Index].Attributes;
-      return EFI_SMC_SUCCESS;
-    }
+  Entry = InternalSmcGetKey (Key);
+  if (Entry != NULL) {
+    *Size = Entry->Size;
+    *Type = Entry->Type;
+    *Attributes = Entry->Attributes;
+    return EFI_SMC_SUCCESS;
   }
 
   return EFI_SMC_NOT_FOUND;
@@ -397,7 +600,12 @@ EraseAuthenticationKey (
   IN VOID      *Context
   )
 {
-  SecureZeroMem (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data, SMC_HBKP_SIZE);
+  VIRTUALSMC_KEY_VALUE  *Entry;
+
+  Entry = InternalSmcGetKey (SMC_KEY_HBKP);
+  if (Entry != NULL) {
+    SecureZeroMem (Entry->Data, SMC_HBKP_SIZE);
+  }
 }
 
 STATIC
@@ -407,13 +615,16 @@ ExtractAuthentificationKey (
   UINT32  Size
   )
 {
-  UINT8           Index;
   AES_CONTEXT     Context;
   UINT8           EncryptKey[CONFIG_AES_KEY_SIZE];
+  UINT8           ZeroKey[CONFIG_AES_KEY_SIZE];
   CONST UINT8     *InitVector;
   UINT8           *Payload;
   UINT32          PayloadSize;
   UINT32          RealSize;
+  SMC_DATA        *KeyData;
+
+  KeyData = InternalSmcGetKey (SMC_KEY_HBKP)->Data;
 
   if (Size < sizeof (UINT32) + SMC_HBKP_SIZE) {
     DEBUG ((DEBUG_INFO, "OCSMC: Invalid key length - %u\n", (UINT32) Size));
@@ -424,7 +635,7 @@ ExtractAuthentificationKey (
     //
     // Perform an as-is copy of stored contents.
     //
-    CopyMem (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data, Buffer + sizeof (UINT32), SMC_HBKP_SIZE);
+    CopyMem (KeyData, Buffer + sizeof (UINT32), SMC_HBKP_SIZE);
   } else if (Buffer[0] == 'V' && Buffer[1] == 'S' && Buffer[2] == 'E' && Buffer[3] == 'N') {
     //
     // The magic is followed by an IV and at least one AES block containing at least SMC_HBKP_SIZE bytes.
@@ -437,10 +648,9 @@ ExtractAuthentificationKey (
     //
     // Read and erase the temporary encryption key from CMOS memory.
     //
-    for (Index = 0; Index < sizeof (EncryptKey); Index++) {
-      EncryptKey[Index] = OcRtcRead (0xD0 + Index);
-      OcRtcWrite (0xD0 + Index, 0);
-    }
+    OcRtcReadBlock (0xD0, sizeof (EncryptKey), EncryptKey);
+    ZeroMem (ZeroKey, sizeof (ZeroKey));
+    OcRtcWriteBlock (0xD0, sizeof (ZeroKey), ZeroKey, FALSE);
 
     //
     // Perform the decryption.
@@ -465,7 +675,7 @@ ExtractAuthentificationKey (
     //
     // Copy the decrypted contents.
     //
-    CopyMem (mVirtualSmcKeyValue[mAuthenticationKeyIndex].Data, Payload + sizeof (UINT32), SMC_HBKP_SIZE);
+    CopyMem (KeyData, Payload + sizeof (UINT32), SMC_HBKP_SIZE);
   } else {
     DEBUG ((DEBUG_INFO, "OCSMC: Invalid key magic - %02X %02X %02X %02X\n", Buffer[0], Buffer[1], Buffer[2], Buffer[3]));
     return FALSE;
@@ -591,6 +801,12 @@ OcSmcIoInstallProtocol (
   EFI_STATUS             Status;
   APPLE_SMC_IO_PROTOCOL  *Protocol;
 
+  Status = InternalSmcInitializeKeys ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "OCSMC: Key table init failed: %r\n", Status));
+    return NULL;
+  }
+
   if (AuthRestart) {
     LoadAuthenticationKey ();
     ExportStatusKey ();
@@ -627,3 +843,39 @@ OcSmcIoInstallProtocol (
 
   return &mSmcIoProtocol;
 }
+
+EFI_STATUS
+OcSmcIoRegisterKey (
+  IN SMC_KEY             Key,
+  IN SMC_KEY_TYPE        Type,
+  IN SMC_DATA_SIZE       Size,
+  IN SMC_KEY_ATTRIBUTES  Attributes,
+  IN CONST SMC_DATA      *Data  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Key count and authentication key are managed internally.
+  //
+  if (Key == SMC_KEY_KEY || Key == SMC_KEY_HBKP) {
+    return EFI_ACCESS_DENIED;
+  }
+
+  Status = InternalSmcInitializeKeys ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = InternalSmcSetKey (Key, Type, Size, Attributes, Data);
+
+  DEBUG ((
+    EFI_ERROR (Status) ? DEBUG_WARN : DEBUG_INFO,
+    "OCSMC: Registering key %X (%u) - %r\n",
+    Key,
+    Size,
+    Status
+    ));
+
+  return Status;
+}
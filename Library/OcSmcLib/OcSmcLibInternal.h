@@ -26,6 +26,11 @@ typedef struct {
 	SMC_DATA            Data[SMC_MAX_DATA_SIZE];
 } VIRTUALSMC_KEY_VALUE;
 
+//
+// Initial key table capacity, grows as more keys get registered.
+//
+#define VIRTUALSMC_INITIAL_KEY_COUNT    16
+
 #define VIRTUALSMC_STATUS_KEY           L"vsmc-status"
 #define VIRTUALSMC_ENCRYPTION_KEY       L"vsmc-key"
 
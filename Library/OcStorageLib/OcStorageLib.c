@@ -21,6 +21,7 @@
 #include <Library/DebugLib.h>
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/OcPerfLib.h>
 #include <Library/OcStringLib.h>
 #include <Library/OcStorageLib.h>
 #include <Library/UefiBootServicesTableLib.h>
@@ -276,7 +277,9 @@ OcStorageInitFromFs (
     &DataSize
     );
 
+  OcPerfBegin (OC_PERF_PHASE_VAULT);
   Status = OcStorageInitializeVault (Context, Vault, DataSize, StorageKey, Signature, SignatureSize);
+  OcPerfEnd (OC_PERF_PHASE_VAULT, DataSize, Status);
 
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_INFO, "OCS: Vault init failure %p (%u) - %r\n", Vault, DataSize, Status));
@@ -19,6 +19,8 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/OcStringLib.h>
 
+#include "OcStringInternal.h"
+
 // IsAsciiPrint
 /** Check if character is printable
 
@@ -130,3 +132,255 @@ AsciiUint64ToLowerHex (
   return TRUE;
 }
 
+
+UINTN
+InternalAsciiStrLenGeneric (
+  IN CONST CHAR8  *String
+  )
+{
+  UINTN  Length;
+
+  for (Length = 0; String[Length] != '\0'; ++Length) {
+  }
+
+  return Length;
+}
+
+INTN
+InternalAsciiStrCmpGeneric (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  )
+{
+  while (*FirstString != '\0' && *FirstString == *SecondString) {
+    ++FirstString;
+    ++SecondString;
+  }
+
+  return *FirstString - *SecondString;
+}
+
+/**
+  Check whether String starts with Prefix.
+**/
+STATIC
+BOOLEAN
+InternalAsciiStrStartsWith (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *Prefix
+  )
+{
+  while (*Prefix != '\0') {
+    if (*String != *Prefix) {
+      return FALSE;
+    }
+
+    ++String;
+    ++Prefix;
+  }
+
+  return TRUE;
+}
+
+CHAR8 *
+InternalAsciiStrStrGeneric (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  )
+{
+  if (*SearchString == '\0') {
+    return (CHAR8 *) String;
+  }
+
+  while (*String != '\0') {
+    if (*String == *SearchString
+      && InternalAsciiStrStartsWith (String + 1, SearchString + 1)) {
+      return (CHAR8 *) String;
+    }
+
+    ++String;
+  }
+
+  return NULL;
+}
+
+#ifdef OC_STRING_SSE2
+
+OC_STRING_NO_SANITIZE
+UINTN
+InternalAsciiStrLenSse2 (
+  IN CONST CHAR8  *String
+  )
+{
+  CONST OC_STRING_V16C  *Block;
+  UINT32                Offset;
+  UINT32                Mask;
+
+  //
+  // Start from the aligned block containing the string and drop
+  // the bytes preceding it.
+  //
+  Offset = (UINT32) ((UINTN) String & (OC_STRING_VECTOR_SIZE - 1));
+  Block  = (CONST OC_STRING_V16C *) (String - Offset);
+  Mask   = OC_STRING_MOVEMASK (*Block == 0) >> Offset;
+  if (Mask != 0) {
+    return __builtin_ctz (Mask);
+  }
+
+  while (TRUE) {
+    ++Block;
+    Mask = OC_STRING_MOVEMASK (*Block == 0);
+    if (Mask != 0) {
+      return (UINTN) ((CONST CHAR8 *) Block - String) + __builtin_ctz (Mask);
+    }
+  }
+}
+
+OC_STRING_NO_SANITIZE
+INTN
+InternalAsciiStrCmpSse2 (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  )
+{
+  OC_STRING_V16C  First;
+  OC_STRING_V16C  Second;
+  UINT32          Mask;
+  UINT32          Index;
+
+  while (TRUE) {
+    if (OC_STRING_CROSSES_PAGE (FirstString) || OC_STRING_CROSSES_PAGE (SecondString)) {
+      //
+      // Step over the page boundary one character at a time.
+      //
+      if (*FirstString == '\0' || *FirstString != *SecondString) {
+        return *FirstString - *SecondString;
+      }
+
+      ++FirstString;
+      ++SecondString;
+      continue;
+    }
+
+    First  = *(CONST OC_STRING_V16C_UNALIGNED *) FirstString;
+    Second = *(CONST OC_STRING_V16C_UNALIGNED *) SecondString;
+    Mask   = OC_STRING_MOVEMASK ((First != Second) | (First == 0));
+    if (Mask != 0) {
+      Index = __builtin_ctz (Mask);
+      return FirstString[Index] - SecondString[Index];
+    }
+
+    FirstString  += OC_STRING_VECTOR_SIZE;
+    SecondString += OC_STRING_VECTOR_SIZE;
+  }
+}
+
+OC_STRING_NO_SANITIZE
+CHAR8 *
+InternalAsciiStrStrSse2 (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  )
+{
+  CONST CHAR8     *Block;
+  OC_STRING_V16C  Vector;
+  CHAR8           First;
+  CHAR8           Second;
+  UINT32          Offset;
+  UINT32          ZeroMask;
+  UINT32          MatchMask;
+
+  if (*SearchString == '\0') {
+    return (CHAR8 *) String;
+  }
+
+  //
+  // Look for the first two search characters in aligned blocks
+  // and only compare the rest at matching positions.
+  //
+  First  = SearchString[0];
+  Second = SearchString[1];
+  Offset = (UINT32) ((UINTN) String & (OC_STRING_VECTOR_SIZE - 1));
+  Block  = String - Offset;
+
+  while (TRUE) {
+    Vector    = *(CONST OC_STRING_V16C *) Block;
+    ZeroMask  = (OC_STRING_MOVEMASK (Vector == 0) >> Offset) << Offset;
+    MatchMask = (OC_STRING_MOVEMASK (Vector == First) >> Offset) << Offset;
+    Offset    = 0;
+
+    if (ZeroMask != 0) {
+      MatchMask &= (ZeroMask & (0U - ZeroMask)) - 1;
+    } else if (Second != '\0' && MatchMask != 0) {
+      //
+      // The block has no terminator, so the block shifted by one byte
+      // still belongs to the string.
+      //
+      MatchMask &= OC_STRING_MOVEMASK (
+        *(CONST OC_STRING_V16C_UNALIGNED *) (Block + 1) == Second
+        );
+    }
+
+    while (MatchMask != 0) {
+      if (InternalAsciiStrStartsWith (Block + __builtin_ctz (MatchMask) + 1, SearchString + 1)) {
+        return (CHAR8 *) Block + __builtin_ctz (MatchMask);
+      }
+
+      MatchMask &= MatchMask - 1;
+    }
+
+    if (ZeroMask != 0) {
+      return NULL;
+    }
+
+    Block += OC_STRING_VECTOR_SIZE;
+  }
+}
+
+#endif // OC_STRING_SSE2
+
+UINTN
+OcAsciiStrLen (
+  IN CONST CHAR8  *String
+  )
+{
+  ASSERT (String != NULL);
+
+#ifdef OC_STRING_SSE2
+  return InternalAsciiStrLenSse2 (String);
+#else
+  return InternalAsciiStrLenGeneric (String);
+#endif
+}
+
+INTN
+OcAsciiStrCmp (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  )
+{
+  ASSERT (FirstString != NULL);
+  ASSERT (SecondString != NULL);
+
+#ifdef OC_STRING_SSE2
+  return InternalAsciiStrCmpSse2 (FirstString, SecondString);
+#else
+  return InternalAsciiStrCmpGeneric (FirstString, SecondString);
+#endif
+}
+
+CHAR8 *
+OcAsciiStrStr (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  )
+{
+  ASSERT (String != NULL);
+  ASSERT (SearchString != NULL);
+
+#ifdef OC_STRING_SSE2
+  return InternalAsciiStrStrSse2 (String, SearchString);
+#else
+  return InternalAsciiStrStrGeneric (String, SearchString);
+#endif
+}
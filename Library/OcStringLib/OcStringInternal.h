@@ -0,0 +1,141 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#ifndef OC_STRING_INTERNAL_H
+#define OC_STRING_INTERNAL_H
+
+//
+// SSE2 string primitives are implemented with compiler vector extensions,
+// which need no intrinsic headers. Other targets use portable C.
+//
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(MDE_CPU_X64) || defined(MDE_CPU_IA32))
+#define OC_STRING_SSE2
+#endif
+
+#ifdef OC_STRING_SSE2
+
+//
+// Vector primitives read whole 16-byte blocks, possibly past the string
+// terminator. Aligned blocks never cross a page boundary, and unaligned blocks
+// are only read when they do not cross one, so the reads cannot fault.
+// Address sanitizer does not know this and must not instrument them.
+//
+#if defined(__SANITIZE_ADDRESS__)
+#define OC_STRING_NO_SANITIZE __attribute__ ((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define OC_STRING_NO_SANITIZE __attribute__ ((no_sanitize_address))
+#endif
+#endif
+
+#ifndef OC_STRING_NO_SANITIZE
+#define OC_STRING_NO_SANITIZE
+#endif
+
+#define OC_STRING_VECTOR_SIZE  16U
+
+typedef CHAR8  OC_STRING_V16C __attribute__ ((vector_size (16), may_alias));
+typedef CHAR8  OC_STRING_V16C_UNALIGNED __attribute__ ((vector_size (16), may_alias, aligned (1)));
+typedef UINT16 OC_STRING_V8W __attribute__ ((vector_size (16), may_alias));
+typedef UINT16 OC_STRING_V8W_UNALIGNED __attribute__ ((vector_size (16), may_alias, aligned (1)));
+
+/**
+  Byte mask of non-zero vector bytes, i.e. PMOVMSKB.
+**/
+#define OC_STRING_MOVEMASK(Vector) \
+  ((UINT32) __builtin_ia32_pmovmskb128 ((OC_STRING_V16C) (Vector)))
+
+/**
+  Check whether unaligned vector read at Pointer crosses a page boundary.
+**/
+#define OC_STRING_CROSSES_PAGE(Pointer) \
+  ((((UINTN) (Pointer)) & (BASE_4KB - 1)) > BASE_4KB - OC_STRING_VECTOR_SIZE)
+
+UINTN
+InternalAsciiStrLenSse2 (
+  IN CONST CHAR8  *String
+  );
+
+INTN
+InternalAsciiStrCmpSse2 (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  );
+
+CHAR8 *
+InternalAsciiStrStrSse2 (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  );
+
+UINTN
+InternalStrLenSse2 (
+  IN CONST CHAR16  *String
+  );
+
+INTN
+InternalStriCmpSse2 (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  );
+
+INTN
+InternalStrniCmpSse2 (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  );
+
+#endif // OC_STRING_SSE2
+
+//
+// Portable implementations, also used as the reference in userspace benchmarks.
+//
+
+UINTN
+InternalAsciiStrLenGeneric (
+  IN CONST CHAR8  *String
+  );
+
+INTN
+InternalAsciiStrCmpGeneric (
+  IN CONST CHAR8  *FirstString,
+  IN CONST CHAR8  *SecondString
+  );
+
+CHAR8 *
+InternalAsciiStrStrGeneric (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *SearchString
+  );
+
+UINTN
+InternalStrLenGeneric (
+  IN CONST CHAR16  *String
+  );
+
+INTN
+InternalStriCmpGeneric (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  );
+
+INTN
+InternalStrniCmpGeneric (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  );
+
+#endif // OC_STRING_INTERNAL_H
@@ -19,6 +19,218 @@
 #include <Library/OcStringLib.h>
 #include <Library/PcdLib.h>
 
+#include "OcStringInternal.h"
+
+UINTN
+InternalStrLenGeneric (
+  IN CONST CHAR16  *String
+  )
+{
+  UINTN  Length;
+
+  for (Length = 0; String[Length] != L'\0'; ++Length) {
+  }
+
+  return Length;
+}
+
+INTN
+InternalStriCmpGeneric (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  )
+{
+  CHAR16  UpperFirstString;
+  CHAR16  UpperSecondString;
+
+  UpperFirstString  = CharToUpper (*FirstString);
+  UpperSecondString = CharToUpper (*SecondString);
+  while ((*FirstString != '\0') && (*SecondString != '\0') && (UpperFirstString == UpperSecondString)) {
+    FirstString++;
+    SecondString++;
+    UpperFirstString  = CharToUpper (*FirstString);
+    UpperSecondString = CharToUpper (*SecondString);
+  }
+
+  return UpperFirstString - UpperSecondString;
+}
+
+INTN
+InternalStrniCmpGeneric (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  )
+{
+  CHAR16  UpperFirstString;
+  CHAR16  UpperSecondString;
+
+  if (Length == 0) {
+    return 0;
+  }
+
+  UpperFirstString  = CharToUpper (*FirstString);
+  UpperSecondString = CharToUpper (*SecondString);
+  while ((*FirstString != L'\0') &&
+         (*SecondString != L'\0') &&
+         (UpperFirstString == UpperSecondString) &&
+         (Length > 1)) {
+    FirstString++;
+    SecondString++;
+    UpperFirstString  = CharToUpper (*FirstString);
+    UpperSecondString = CharToUpper (*SecondString);
+    Length--;
+  }
+
+  return UpperFirstString - UpperSecondString;
+}
+
+#ifdef OC_STRING_SSE2
+
+/**
+  Upper case ASCII letters in the vector, matching CharToUpper.
+**/
+#define OC_STRING_TO_UPPER(Vector) \
+  ((Vector) - ((OC_STRING_V8W) (((Vector) >= L'a') & ((Vector) <= L'z')) & 0x20))
+
+OC_STRING_NO_SANITIZE
+UINTN
+InternalStrLenSse2 (
+  IN CONST CHAR16  *String
+  )
+{
+  CONST OC_STRING_V8W  *Block;
+  UINT32               Offset;
+  UINT32               Mask;
+
+  if (((UINTN) String & 1U) != 0) {
+    return InternalStrLenGeneric (String);
+  }
+
+  Offset = (UINT32) ((UINTN) String & (OC_STRING_VECTOR_SIZE - 1));
+  Block  = (CONST OC_STRING_V8W *) ((CONST UINT8 *) String - Offset);
+  Mask   = OC_STRING_MOVEMASK (*Block == 0) >> Offset;
+  if (Mask != 0) {
+    return __builtin_ctz (Mask) / sizeof (CHAR16);
+  }
+
+  while (TRUE) {
+    ++Block;
+    Mask = OC_STRING_MOVEMASK (*Block == 0);
+    if (Mask != 0) {
+      return ((UINTN) ((CONST UINT8 *) Block - (CONST UINT8 *) String) + __builtin_ctz (Mask))
+        / sizeof (CHAR16);
+    }
+  }
+}
+
+/**
+  Find the first position where upper cased strings differ or
+  FirstString terminates within the next vector.
+
+  @retval position in characters or MAX_UINT32 when there is none.
+**/
+OC_STRING_NO_SANITIZE
+STATIC
+UINT32
+InternalStriCmpBlockSse2 (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  )
+{
+  OC_STRING_V8W  First;
+  OC_STRING_V8W  Second;
+  UINT32         Mask;
+
+  First  = *(CONST OC_STRING_V8W_UNALIGNED *) FirstString;
+  Second = *(CONST OC_STRING_V8W_UNALIGNED *) SecondString;
+  Mask   = OC_STRING_MOVEMASK (
+    (OC_STRING_TO_UPPER (First) != OC_STRING_TO_UPPER (Second)) | (First == 0)
+    );
+
+  if (Mask == 0) {
+    return MAX_UINT32;
+  }
+
+  return __builtin_ctz (Mask) / sizeof (CHAR16);
+}
+
+INTN
+InternalStriCmpSse2 (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString
+  )
+{
+  UINT32  Index;
+
+  if ((((UINTN) FirstString | (UINTN) SecondString) & 1U) != 0) {
+    return InternalStriCmpGeneric (FirstString, SecondString);
+  }
+
+  while (TRUE) {
+    if (OC_STRING_CROSSES_PAGE (FirstString) || OC_STRING_CROSSES_PAGE (SecondString)) {
+      if (*FirstString == L'\0' || CharToUpper (*FirstString) != CharToUpper (*SecondString)) {
+        return CharToUpper (*FirstString) - CharToUpper (*SecondString);
+      }
+
+      ++FirstString;
+      ++SecondString;
+      continue;
+    }
+
+    Index = InternalStriCmpBlockSse2 (FirstString, SecondString);
+    if (Index != MAX_UINT32) {
+      return CharToUpper (FirstString[Index]) - CharToUpper (SecondString[Index]);
+    }
+
+    FirstString  += OC_STRING_VECTOR_SIZE / sizeof (CHAR16);
+    SecondString += OC_STRING_VECTOR_SIZE / sizeof (CHAR16);
+  }
+}
+
+INTN
+InternalStrniCmpSse2 (
+  IN CONST CHAR16  *FirstString,
+  IN CONST CHAR16  *SecondString,
+  IN UINTN         Length
+  )
+{
+  UINT32  Index;
+
+  if ((((UINTN) FirstString | (UINTN) SecondString) & 1U) != 0) {
+    return InternalStrniCmpGeneric (FirstString, SecondString, Length);
+  }
+
+  while (Length >= OC_STRING_VECTOR_SIZE / sizeof (CHAR16)) {
+    if (OC_STRING_CROSSES_PAGE (FirstString) || OC_STRING_CROSSES_PAGE (SecondString)) {
+      if (*FirstString == L'\0' || CharToUpper (*FirstString) != CharToUpper (*SecondString)) {
+        return CharToUpper (*FirstString) - CharToUpper (*SecondString);
+      }
+
+      ++FirstString;
+      ++SecondString;
+      --Length;
+      continue;
+    }
+
+    Index = InternalStriCmpBlockSse2 (FirstString, SecondString);
+    if (Index != MAX_UINT32) {
+      return CharToUpper (FirstString[Index]) - CharToUpper (SecondString[Index]);
+    }
+
+    FirstString  += OC_STRING_VECTOR_SIZE / sizeof (CHAR16);
+    SecondString += OC_STRING_VECTOR_SIZE / sizeof (CHAR16);
+    Length       -= OC_STRING_VECTOR_SIZE / sizeof (CHAR16);
+  }
+
+  //
+  // Shorter tails are not worth vectorising.
+  //
+  return InternalStrniCmpGeneric (FirstString, SecondString, Length);
+}
+
+#endif // OC_STRING_SSE2
+
 /**
   Performs a case insensitive comparison of two Null-terminated Unicode strings,
   and returns the difference between the first mismatched Unicode characters.
@@ -55,25 +267,17 @@ StriCmp (
   IN CHAR16  *SecondString
   )
 {
-  CHAR16  UpperFirstString;
-  CHAR16  UpperSecondString;
-
   //
   // ASSERT both strings are less long than PcdMaximumUnicodeStringLength
   //
   ASSERT (StrSize (FirstString) != 0);
   ASSERT (StrSize (SecondString) != 0);
 
-  UpperFirstString  = CharToUpper (*FirstString);
-  UpperSecondString = CharToUpper (*SecondString);
-  while ((*FirstString != '\0') && (*SecondString != '\0') && (UpperFirstString == UpperSecondString)) {
-    FirstString++;
-    SecondString++;
-    UpperFirstString  = CharToUpper (*FirstString);
-    UpperSecondString = CharToUpper (*SecondString);
-  }
-
-  return UpperFirstString - UpperSecondString;
+#ifdef OC_STRING_SSE2
+  return InternalStriCmpSse2 (FirstString, SecondString);
+#else
+  return InternalStriCmpGeneric (FirstString, SecondString);
+#endif
 }
 
 /**
@@ -122,9 +326,6 @@ StrniCmp (
   IN UINTN         Length
   )
 {
-  CHAR16  UpperFirstString;
-  CHAR16  UpperSecondString;
-
   if (Length == 0) {
     return 0;
   }
@@ -140,20 +341,25 @@ StrniCmp (
     ASSERT (Length <= PcdGet32 (PcdMaximumUnicodeStringLength));
   }
 
-  UpperFirstString  = CharToUpper (*FirstString);
-  UpperSecondString = CharToUpper (*SecondString);
-  while ((*FirstString != L'\0') &&
-         (*SecondString != L'\0') &&
-         (UpperFirstString == UpperSecondString) &&
-         (Length > 1)) {
-    FirstString++;
-    SecondString++;
-    UpperFirstString  = CharToUpper (*FirstString);
-    UpperSecondString = CharToUpper (*SecondString);
-    Length--;
-  }
+#ifdef OC_STRING_SSE2
+  return InternalStrniCmpSse2 (FirstString, SecondString, Length);
+#else
+  return InternalStrniCmpGeneric (FirstString, SecondString, Length);
+#endif
+}
 
-  return UpperFirstString - UpperSecondString;
+UINTN
+OcStrLen (
+  IN CONST CHAR16  *String
+  )
+{
+  ASSERT (String != NULL);
+
+#ifdef OC_STRING_SSE2
+  return InternalStrLenSse2 (String);
+#else
+  return InternalStrLenGeneric (String);
+#endif
 }
 
 VOID
@@ -14,6 +14,7 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 
 
 #include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/OcGuardLib.h>
 #include <Library/OcMiscLib.h>
 #include <Library/UefiLib.h>
@@ -24,6 +25,9 @@ CHAR8 mEngUpperMap[MAP_TABLE_SIZE];
 CHAR8 mEngLowerMap[MAP_TABLE_SIZE];
 CHAR8 mEngInfoMap[MAP_TABLE_SIZE];
 
+CHAR16 *mEngUpcaseTable;
+CHAR16 *mEngLowcaseTable;
+
 CHAR8 mOtherChars[] = {
   '0',
   '1',
@@ -74,6 +78,65 @@ GLOBAL_REMOVE_IF_UNREFERENCED EFI_UNICODE_COLLATION_PROTOCOL  Unicode2Eng = {
   UnicodeLanguages
 };
 
+EFI_STATUS
+InternalInitializeEngTables (
+  VOID
+  )
+{
+  UINTN  Index;
+  UINTN  Index2;
+
+  if (mEngUpcaseTable != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Both tables share one allocation, upper case mapping goes first.
+  //
+  mEngUpcaseTable = AllocatePool (2 * CASE_TABLE_SIZE * sizeof (CHAR16));
+  if (mEngUpcaseTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  mEngLowcaseTable = mEngUpcaseTable + CASE_TABLE_SIZE;
+
+  for (Index = 0; Index < MAP_TABLE_SIZE; Index++) {
+    mEngUpperMap[Index] = (CHAR8) Index;
+    mEngLowerMap[Index] = (CHAR8) Index;
+    mEngInfoMap[Index]  = 0;
+
+    if ((Index >= 'a' && Index <= 'z') || (Index >= 0xe0 && Index <= 0xf6) || (Index >= 0xf8 && Index <= 0xfe)) {
+
+      Index2                = Index - 0x20;
+      mEngUpperMap[Index]   = (CHAR8) Index2;
+      mEngLowerMap[Index2]  = (CHAR8) Index;
+
+      mEngInfoMap[Index] |= CHAR_FAT_VALID;
+      mEngInfoMap[Index2] |= CHAR_FAT_VALID;
+    }
+  }
+
+  for (Index = 0; mOtherChars[Index] != 0; Index++) {
+    Index2 = mOtherChars[Index];
+    mEngInfoMap[Index2] |= CHAR_FAT_VALID;
+  }
+
+  //
+  // Only Latin-1 characters are case mapped, the rest map to themselves.
+  // Cast through UINT8 to avoid sign extension of CHAR8 map entries.
+  //
+  for (Index = 0; Index < CASE_TABLE_SIZE; Index++) {
+    if (Index < MAP_TABLE_SIZE) {
+      mEngUpcaseTable[Index]  = (UINT8) mEngUpperMap[Index];
+      mEngLowcaseTable[Index] = (UINT8) mEngLowerMap[Index];
+    } else {
+      mEngUpcaseTable[Index]  = (CHAR16) Index;
+      mEngLowcaseTable[Index] = (CHAR16) Index;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   The user Entry Point for English module.
 
@@ -92,8 +155,6 @@ OcUnicodeCollationEngInstallProtocol (
 {
   EFI_STATUS                      Status;
   BOOLEAN                         OverwroteLang = FALSE;
-  UINTN                           Index         = 0;
-  UINTN                           Index2        = 0;
   EFI_UNICODE_COLLATION_PROTOCOL  *Existing     = NULL;
   CHAR8                           *PlatformLang = NULL;
   UINTN                           Size          = 0;
@@ -160,25 +221,9 @@ OcUnicodeCollationEngInstallProtocol (
   //
   // Initialize mapping tables for the supported languages
   //
-  for (Index = 0; Index < MAP_TABLE_SIZE; Index++) {
-    mEngUpperMap[Index] = (CHAR8) Index;
-    mEngLowerMap[Index] = (CHAR8) Index;
-    mEngInfoMap[Index]  = 0;
-
-    if ((Index >= 'a' && Index <= 'z') || (Index >= 0xe0 && Index <= 0xf6) || (Index >= 0xf8 && Index <= 0xfe)) {
-
-      Index2                = Index - 0x20;
-      mEngUpperMap[Index]   = (CHAR8) Index2;
-      mEngLowerMap[Index2]  = (CHAR8) Index;
-
-      mEngInfoMap[Index] |= CHAR_FAT_VALID;
-      mEngInfoMap[Index2] |= CHAR_FAT_VALID;
-    }
-  }
-
-  for (Index = 0; mOtherChars[Index] != 0; Index++) {
-    Index2 = mOtherChars[Index];
-    mEngInfoMap[Index2] |= CHAR_FAT_VALID;
+  Status = InternalInitializeEngTables ();
+  if (EFI_ERROR (Status)) {
+    return NULL;
   }
 
   Status = gBS->InstallMultipleProtocolInterfaces (
@@ -271,140 +316,241 @@ EngStrUpr (
   }
 }
 
+/**
+  Obtain pattern character in upper case.
+
+  @param  Folded   Pattern is already case-folded.
+  @param  Char     Pattern character.
+**/
+#define PATTERN_CHAR(Folded, Char)  ((Folded) ? (Char) : TO_UPPER (Char))
+
+/**
+  Match an upper case character against a pattern character set.
+
+  @param  CharC    Upper case string character.
+  @param  Pattern  Pattern pointing right after '['. On successful match
+                   updated to point after the closing ']'.
+  @param  Folded   Pattern is already case-folded.
+
+  @retval TRUE    CharC belongs to the set.
+  @retval FALSE   CharC does not belong to the set or the set is malformed.
+**/
+STATIC
+BOOLEAN
+EngMatchCharSet (
+  IN     CHAR16        CharC,
+  IN OUT CONST CHAR16  **Pattern,
+  IN     BOOLEAN       Folded
+  )
+{
+  CONST CHAR16  *Walker;
+  CHAR16        CharP;
+  CHAR16        Index3;
+
+  Walker = *Pattern;
+  Index3 = 0;
+  CharP  = PATTERN_CHAR (Folded, *Walker);
+  Walker += 1;
+
+  while (CharP != 0) {
+    if (CharP == ']') {
+      return FALSE;
+    }
+
+    if (CharP == '-') {
+      //
+      // if range of chars, get high range
+      //
+      CharP = PATTERN_CHAR (Folded, *Walker);
+      if (CharP == 0 || CharP == ']') {
+        //
+        // syntax problem
+        //
+        return FALSE;
+      }
+
+      if (CharC >= Index3 && CharC <= CharP) {
+        //
+        // if in range, it's a match
+        //
+        break;
+      }
+    }
+
+    Index3 = CharP;
+    if (CharC == CharP) {
+      //
+      // if char matches
+      //
+      break;
+    }
+
+    CharP = PATTERN_CHAR (Folded, *Walker);
+    Walker += 1;
+  }
+
+  //
+  // skip to end of match char set, unterminated set is a syntax problem
+  //
+  while (CharP != ']') {
+    if (CharP == 0) {
+      return FALSE;
+    }
+
+    CharP = *Walker;
+    Walker += 1;
+  }
+
+  *Pattern = Walker;
+  return TRUE;
+}
+
 /**
   Performs a case-insensitive comparison of a Null-terminated
   pattern string and a Null-terminated string.
 
-  @param  This    Protocol instance pointer.
+  Every pattern element but '*' consumes exactly one string character,
+  so only the last '*' needs to be remembered for backtracking. This makes
+  matching iterative and linear for the common patterns.
+
   @param  String  A pointer to a Null-terminated string.
   @param  Pattern A pointer to a Null-terminated pattern string.
+  @param  Folded  Pattern is already case-folded.
 
   @retval TRUE    Pattern was found in String.
   @retval FALSE   Pattern was not found in String.
 
 **/
+STATIC
 BOOLEAN
-EFIAPI
-EngMetaiMatch (
-  IN EFI_UNICODE_COLLATION_PROTOCOL   *This,
-  IN CHAR16                           *String,
-  IN CHAR16                           *Pattern
+EngMetaiMatchWorker (
+  IN CONST CHAR16  *String,
+  IN CONST CHAR16  *Pattern,
+  IN BOOLEAN       Folded
   )
 {
-  CHAR16  CharC;
-  CHAR16  CharP;
-  CHAR16  Index3;
+  CONST CHAR16  *StarString;
+  CONST CHAR16  *StarPattern;
+  CONST CHAR16  *SetPattern;
+  CHAR16        CharC;
+  CHAR16        CharP;
+
+  StarString  = NULL;
+  StarPattern = NULL;
 
   for (;;) {
-    CharP = *Pattern;
-    Pattern += 1;
+    CharP = PATTERN_CHAR (Folded, *Pattern);
+
+    if (CharP == '*') {
+      //
+      // Match zero or more chars, remember restart point
+      //
+      Pattern     += 1;
+      StarPattern  = Pattern;
+      StarString   = String;
+      continue;
+    }
 
-    switch (CharP) {
-    case 0:
+    CharC = *String;
+
+    if (CharP == 0) {
       //
       // End of pattern.  If end of string, TRUE match
       //
-      if (*String != 0) {
-        return FALSE;
-      } else {
+      if (CharC == 0) {
         return TRUE;
       }
-
-    case '*':
+    } else if (CharC == 0) {
       //
-      // Match zero or more chars
+      // End of string with remaining pattern, extending '*' cannot help
       //
-      while (*String != 0) {
-        if (EngMetaiMatch (This, String, Pattern)) {
-          return TRUE;
-        }
-
-        String += 1;
-      }
-
-      return EngMetaiMatch (This, String, Pattern);
-
-    case '?':
+      return FALSE;
+    } else if (CharP == '?') {
       //
       // Match any one char
       //
-      if (*String == 0) {
-        return FALSE;
-      }
-
-      String += 1;
-      break;
-
-    case '[':
+      Pattern += 1;
+      String  += 1;
+      continue;
+    } else if (CharP == '[') {
       //
       // Match char set
       //
-      CharC = *String;
-      if (CharC == 0) {
-        //
-        // syntax problem
-        //
-        return FALSE;
+      SetPattern = Pattern + 1;
+      if (EngMatchCharSet (TO_UPPER (CharC), &SetPattern, Folded)) {
+        Pattern = SetPattern;
+        String  += 1;
+        continue;
       }
+    } else if (TO_UPPER (CharC) == CharP) {
+      Pattern += 1;
+      String  += 1;
+      continue;
+    }
 
-      Index3  = 0;
-      CharP   = *Pattern++;
-      while (CharP != 0) {
-        if (CharP == ']') {
-          return FALSE;
-        }
-
-        if (CharP == '-') {
-          //
-          // if range of chars, get high range
-          //
-          CharP = *Pattern;
-          if (CharP == 0 || CharP == ']') {
-            //
-            // syntax problem
-            //
-            return FALSE;
-          }
-
-          if (TO_UPPER (CharC) >= TO_UPPER (Index3) && TO_UPPER (CharC) <= TO_UPPER (CharP)) {
-            //
-            // if in range, it's a match
-            //
-            break;
-          }
-        }
-
-        Index3 = CharP;
-        if (TO_UPPER (CharC) == TO_UPPER (CharP)) {
-          //
-          // if char matches
-          //
-          break;
-        }
-
-        CharP = *Pattern++;
-      }
-      //
-      // skip to end of match char set
-      //
-      while ((CharP != 0) && (CharP != ']')) {
-        CharP = *Pattern;
-        Pattern += 1;
-      }
+    //
+    // Mismatch, let the last '*' consume one more char
+    //
+    if (StarPattern == NULL || *StarString == 0) {
+      return FALSE;
+    }
 
-      String += 1;
-      break;
+    StarString += 1;
+    String      = StarString;
+    Pattern     = StarPattern;
+  }
+}
 
-    default:
-      CharC = *String;
-      if (TO_UPPER (CharC) != TO_UPPER (CharP)) {
-        return FALSE;
-      }
+/**
+  Performs a case-insensitive comparison of a Null-terminated
+  pattern string and a Null-terminated string.
 
-      String += 1;
-      break;
+  @param  This    Protocol instance pointer.
+  @param  String  A pointer to a Null-terminated string.
+  @param  Pattern A pointer to a Null-terminated pattern string.
+
+  @retval TRUE    Pattern was found in String.
+  @retval FALSE   Pattern was not found in String.
+
+**/
+BOOLEAN
+EFIAPI
+EngMetaiMatch (
+  IN EFI_UNICODE_COLLATION_PROTOCOL   *This,
+  IN CHAR16                           *String,
+  IN CHAR16                           *Pattern
+  )
+{
+  CHAR16   FoldedBuffer[FOLDED_PATTERN_SIZE];
+  CHAR16   *Folded;
+  UINTN    Index;
+  UINTN    Length;
+  BOOLEAN  Result;
+
+  //
+  // Case-fold the pattern once instead of on every comparison.
+  //
+  Length = StrLen (Pattern);
+  if (Length < ARRAY_SIZE (FoldedBuffer)) {
+    Folded = FoldedBuffer;
+  } else {
+    Folded = AllocatePool ((Length + 1) * sizeof (CHAR16));
+    if (Folded == NULL) {
+      return EngMetaiMatchWorker (String, Pattern, FALSE);
     }
   }
+
+  for (Index = 0; Index <= Length; Index++) {
+    Folded[Index] = TO_UPPER (Pattern[Index]);
+  }
+
+  Result = EngMetaiMatchWorker (String, Folded, TRUE);
+
+  if (Folded != FoldedBuffer) {
+    FreePool (Folded);
+  }
+
+  return Result;
 }
 
 
@@ -38,15 +38,43 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 //
 #define MAP_TABLE_SIZE  0x100
 
+//
+// Full CHAR16 case mapping table size.
+//
+#define CASE_TABLE_SIZE  0x10000
+
+//
+// Size of on-stack buffer for case-folded patterns.
+//
+#define FOLDED_PATTERN_SIZE  64
+
+//
+// Full CHAR16 upper and lower case mapping tables.
+//
+extern CHAR16  *mEngUpcaseTable;
+extern CHAR16  *mEngLowcaseTable;
+
 //
 // Macro to map character a to upper case.
 //
-#define TO_UPPER(a)      (CHAR16) ((a) <= 0xFF ? mEngUpperMap[a] : (a))
+#define TO_UPPER(a)      mEngUpcaseTable[(CHAR16) (a)]
 
 //
 // Macro to map character a to lower case.
 //
-#define TO_LOWER(a)      (CHAR16) ((a) <= 0xFF ? mEngLowerMap[a] : (a))
+#define TO_LOWER(a)      mEngLowcaseTable[(CHAR16) (a)]
+
+/**
+  Initialize character mapping tables used by the English collation.
+  Tables are only initialised once.
+
+  @retval EFI_SUCCESS           Tables are ready for use.
+  @retval EFI_OUT_OF_RESOURCES  Case mapping tables could not be allocated.
+**/
+EFI_STATUS
+InternalInitializeEngTables (
+  VOID
+  );
 
 //
 // Prototypes
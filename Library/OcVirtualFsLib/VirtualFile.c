@@ -21,12 +21,29 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/OcGuardLib.h>
+#include <Library/OcMiscLib.h>
 #include <Library/OcVirtualFsLib.h>
 
 #include <Guid/FileInfo.h>
 
 #include "VirtualFsInternal.h"
 
+STATIC
+VOID
+InternalFreeVirtualFileData (
+  IN VIRTUAL_FILE_DATA  *Data
+  )
+{
+  if (Data->FileBuffer != NULL) {
+    FreePool (Data->FileBuffer);
+  } else if (Data->FreeSource != NULL) {
+    Data->FreeSource (Data->SourceContext);
+  }
+
+  FreePool (Data->FileName);
+  FreePool (Data);
+}
+
 STATIC
 EFI_STATUS
 EFIAPI
@@ -87,10 +104,7 @@ VirtualFileClose (
   Data = VIRTUAL_FILE_FROM_PROTOCOL (This);
 
   if (Data->OriginalProtocol == NULL) {
-    FreePool (Data->FileBuffer);
-    FreePool (Data->FileName);
-    FreePool (Data);
-
+    InternalFreeVirtualFileData (Data);
     return EFI_SUCCESS;
   }
 
@@ -115,9 +129,7 @@ VirtualFileDelete (
   Data = VIRTUAL_FILE_FROM_PROTOCOL (This);
 
   if (Data->OriginalProtocol == NULL) {
-    FreePool (Data->FileBuffer);
-    FreePool (Data->FileName);
-    FreePool (Data);
+    InternalFreeVirtualFileData (Data);
     //
     // Virtual files cannot be deleted.
     //
@@ -141,6 +153,7 @@ VirtualFileRead (
      OUT VOID                 *Buffer
   )
 {
+  EFI_STATUS         Status;
   VIRTUAL_FILE_DATA  *Data;
   UINT64             ReadSize;
   UINTN              ReadBufferSize;
@@ -165,7 +178,23 @@ VirtualFileRead (
     }
 
     if (ReadBufferSize > 0) {
-      CopyMem (Buffer, &Data->FileBuffer[Data->FilePosition], ReadBufferSize);
+      if (Data->FileBuffer != NULL) {
+        CopyMem (Buffer, &Data->FileBuffer[Data->FilePosition], ReadBufferSize);
+      } else {
+        //
+        // Lazy sources fill the caller buffer directly, no intermediate copy.
+        //
+        Status = Data->ReadRange (
+          Data->SourceContext,
+          Data->FilePosition,
+          ReadBufferSize,
+          Buffer
+          );
+        if (EFI_ERROR (Status)) {
+          *BufferSize = 0;
+          return EFI_DEVICE_ERROR;
+        }
+      }
       Data->FilePosition += ReadBufferSize;
     }
 
@@ -448,7 +477,7 @@ VirtualFileReadEx (
   Data = VIRTUAL_FILE_FROM_PROTOCOL (This);
 
   if (Data->OriginalProtocol == NULL) {
-    Status = VirtualFileRead (This, Token->Buffer, &Token->BufferSize);
+    Status = VirtualFileRead (This, &Token->BufferSize, Token->Buffer);
 
     if (!EFI_ERROR (Status) && Token->Event != NULL) {
       Token->Status = EFI_SUCCESS;
@@ -559,6 +588,9 @@ CreateVirtualFile (
   Data->Signature        = VIRTUAL_FILE_DATA_SIGNATURE;
   Data->FileName         = FileName;
   Data->FileBuffer       = FileBuffer;
+  Data->ReadRange        = NULL;
+  Data->FreeSource       = NULL;
+  Data->SourceContext    = NULL;
   Data->FileSize         = FileSize;
   Data->FilePosition     = 0;
   Data->OpenCallback     = NULL;
@@ -575,6 +607,165 @@ CreateVirtualFile (
   return EFI_SUCCESS;
 }
 
+EFI_STATUS
+CreateVirtualFileFromSource (
+  IN     CHAR16                       *FileName,
+  IN     UINT64                       FileSize,
+  IN     OC_VIRTUAL_FILE_READ_RANGE   ReadRange,
+  IN     OC_VIRTUAL_FILE_FREE_SOURCE  FreeSource OPTIONAL,
+  IN     VOID                         *Context,
+  IN     EFI_TIME                     *ModificationTime OPTIONAL,
+  IN OUT EFI_FILE_PROTOCOL            **File
+  )
+{
+  VIRTUAL_FILE_DATA  *Data;
+
+  ASSERT (FileName != NULL);
+  ASSERT (ReadRange != NULL);
+  ASSERT (File != NULL);
+
+  Data = AllocateZeroPool (sizeof (VIRTUAL_FILE_DATA));
+
+  if (Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Data->Signature        = VIRTUAL_FILE_DATA_SIGNATURE;
+  Data->FileName         = FileName;
+  Data->ReadRange        = ReadRange;
+  Data->FreeSource       = FreeSource;
+  Data->SourceContext    = Context;
+  Data->FileSize         = FileSize;
+  CopyMem (&Data->Protocol, &mVirtualFileProtocolTemplate, sizeof (Data->Protocol));
+  if (ModificationTime != NULL) {
+    CopyMem (&Data->ModificationTime, ModificationTime, sizeof (*ModificationTime));
+  }
+
+  *File = &Data->Protocol;
+
+  return EFI_SUCCESS;
+}
+
+BOOLEAN
+InternalIsVirtualFile (
+  IN EFI_FILE_PROTOCOL  *File
+  )
+{
+  //
+  // Files from other images or drivers may not be VIRTUAL_FILE_DATA,
+  // so check the function pointer before using CR.
+  //
+  return File->Open == VirtualFileOpen
+    && VIRTUAL_FILE_FROM_PROTOCOL (File)->Signature == VIRTUAL_FILE_DATA_SIGNATURE;
+}
+
+EFI_STATUS
+GetVirtualFileBuffer (
+  IN     EFI_FILE_PROTOCOL  *File,
+  IN     UINT64             Offset,
+  IN OUT UINTN              *Size,
+     OUT CONST VOID         **Buffer
+  )
+{
+  VIRTUAL_FILE_DATA  *Data;
+  UINT64             Remaining;
+
+  ASSERT (File != NULL);
+  ASSERT (Size != NULL);
+  ASSERT (Buffer != NULL);
+
+  if (!InternalIsVirtualFile (File)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Data = VIRTUAL_FILE_FROM_PROTOCOL (File);
+
+  //
+  // Real file wrappers and lazy sources have no buffer to lend.
+  //
+  if (Data->OriginalProtocol != NULL || Data->FileBuffer == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Offset > Data->FileSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Remaining = Data->FileSize - Offset;
+  if (*Size > Remaining) {
+    *Size = (UINTN) Remaining;
+  }
+
+  *Buffer = &Data->FileBuffer[Offset];
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+VirtualFileProtocolGetBuffer (
+  IN     OC_VIRTUAL_FILE_PROTOCOL  *This,
+  IN     EFI_FILE_PROTOCOL         *File,
+  IN     UINT64                    Offset,
+  IN OUT UINTN                     *Size,
+     OUT CONST VOID                **Buffer
+  )
+{
+  if (File == NULL || Size == NULL || Buffer == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return GetVirtualFileBuffer (File, Offset, Size, Buffer);
+}
+
+STATIC
+OC_VIRTUAL_FILE_PROTOCOL
+mOcVirtualFileProtocol = {
+  OC_VIRTUAL_FILE_PROTOCOL_REVISION,
+  VirtualFileProtocolGetBuffer
+};
+
+OC_VIRTUAL_FILE_PROTOCOL *
+OcVirtualFileInstallProtocol (
+  IN BOOLEAN  Reinstall
+  )
+{
+  EFI_STATUS                Status;
+  OC_VIRTUAL_FILE_PROTOCOL  *Protocol;
+
+  if (Reinstall) {
+    Status = UninstallAllProtocolInstances (&gOcVirtualFileProtocolGuid);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "OCVFS: Uninstall failed: %r\n", Status));
+      return NULL;
+    }
+  } else {
+    Status = gBS->LocateProtocol (
+      &gOcVirtualFileProtocolGuid,
+      NULL,
+      (VOID **) &Protocol
+      );
+
+    if (!EFI_ERROR (Status)) {
+      return Protocol;
+    }
+  }
+
+  Status = gBS->InstallMultipleProtocolInterfaces (
+    &gImageHandle,
+    &gOcVirtualFileProtocolGuid,
+    (VOID *) &mOcVirtualFileProtocol,
+    NULL
+    );
+
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  return &mOcVirtualFileProtocol;
+}
+
 STATIC
 VOID
 InternalInitVirtualVolumeData (
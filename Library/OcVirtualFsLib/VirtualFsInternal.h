@@ -16,6 +16,7 @@
 #define VIRTUAL_FS_INTERNAL_H
 
 #include <Uefi.h>
+#include <Library/OcVirtualFsLib.h>
 #include <Protocol/SimpleFileSystem.h>
 
 #define VIRTUAL_VOLUME_DATA_SIGNATURE  \
@@ -47,6 +48,9 @@ struct VIRTUAL_FILE_DATA_ {
   UINT32                   Signature;
   CHAR16                   *FileName;
   UINT8                    *FileBuffer;
+  OC_VIRTUAL_FILE_READ_RANGE   ReadRange;
+  OC_VIRTUAL_FILE_FREE_SOURCE  FreeSource;
+  VOID                     *SourceContext;
   UINT64                   FileSize;
   UINT64                   FilePosition;
   EFI_TIME                 ModificationTime;
@@ -62,4 +66,16 @@ struct VIRTUAL_FILESYSTEM_DATA_ {
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  FileSystem;
 };
 
+/**
+  Check whether EFI_FILE_PROTOCOL instance is produced by this library.
+
+  @param[in]  File  File protocol.
+
+  @retval TRUE if File is VIRTUAL_FILE_DATA.
+**/
+BOOLEAN
+InternalIsVirtualFile (
+  IN EFI_FILE_PROTOCOL  *File
+  );
+
 #endif // VIRTUAL_FS_INTERNAL_H
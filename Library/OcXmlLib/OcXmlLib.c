@@ -1252,7 +1252,7 @@ XmlEasyChild (
     for (Index = 0; Index < XmlNodeChildren (Node); ++Index) {
       Child = XmlNodeChild (Node, Index);
 
-      if (AsciiStrCmp (XmlNodeName (Child), ChildName) != 0) {
+      if (OcAsciiStrCmp (XmlNodeName (Child), ChildName) != 0) {
         if (Next == NULL) {
           Next = Child;
         } else {
@@ -1366,7 +1366,7 @@ PlistNodeCast (
     return Node;
   }
 
-  if (AsciiStrCmp (XmlNodeName (Node), PlistNodeTypes[Type]) != 0) {
+  if (OcAsciiStrCmp (XmlNodeName (Node), PlistNodeTypes[Type]) != 0) {
     // XML_USAGE_ERROR ("PlistNodeType::wrong type");
     return NULL;
   }
@@ -1461,7 +1461,7 @@ PlistStringValue (
     return TRUE;
   }
 
-  Length = AsciiStrLen (Content);
+  Length = OcAsciiStrLen (Content);
   if (Length < *Size) {
     *Size = (UINT32) (Length + 1);
   }
@@ -1492,7 +1492,7 @@ PlistDataValue (
   }
 
   Length = *Size;
-  Result = OcBase64Decode (Content, AsciiStrLen (Content), Buffer, &Length);
+  Result = OcBase64Decode (Content, OcAsciiStrLen (Content), Buffer, &Length);
 
   if (!RETURN_ERROR (Result) && (UINT32) Length == Length) {
     *Size = (UINT32) Length;
@@ -1576,7 +1576,7 @@ PlistMetaDataValue (
     if (Content != NULL) {
 
       Length = *Size;
-      Result = OcBase64Decode (Content, AsciiStrLen (Content), Buffer, &Length);
+      Result = OcBase64Decode (Content, OcAsciiStrLen (Content), Buffer, &Length);
 
       if (!RETURN_ERROR (Result) && (UINT32) Length == Length) {
         *Size = (UINT32) Length;
@@ -1592,7 +1592,7 @@ PlistMetaDataValue (
   if (PlistNodeCast (Node, PLIST_NODE_TYPE_STRING) != NULL) {
     Content = XmlNodeContent (Node);
     if (Content != NULL) {
-      Length = AsciiStrLen (Content);
+      Length = OcAsciiStrLen (Content);
       if (Length < *Size) {
         *Size = (UINT32) (Length + 1);
       }
@@ -1640,7 +1640,7 @@ PlistStringSize (
 
   Content = XmlNodeContent (Node);
   if (Content != NULL) {
-    *Size = (UINT32) AsciiStrLen (Content) + 1;
+    *Size = (UINT32) OcAsciiStrLen (Content) + 1;
     return TRUE;
   }
 
@@ -1662,7 +1662,7 @@ PlistDataSize (
 
   Content = XmlNodeContent (Node);
   if (Content != NULL) {
-    *Size = (UINT32) AsciiStrLen (Content);
+    *Size = (UINT32) OcAsciiStrLen (Content);
   } else {
     *Size = 0;
   }
@@ -1681,7 +1681,7 @@ PlistMetaDataSize (
   if (PlistNodeCast (Node, PLIST_NODE_TYPE_DATA) != NULL) {
     Content = XmlNodeContent (Node);
     if (Content != NULL) {
-      *Size = (UINT32) AsciiStrLen (Content);
+      *Size = (UINT32) OcAsciiStrLen (Content);
     } else {
       *Size = 0;
     }
@@ -1691,7 +1691,7 @@ PlistMetaDataSize (
   if (PlistNodeCast (Node, PLIST_NODE_TYPE_STRING) != NULL) {
     Content = XmlNodeContent (Node);
     if (Content != NULL) {
-      *Size = (UINT32) (AsciiStrLen (Content) + 1);
+      *Size = (UINT32) (OcAsciiStrLen (Content) + 1);
     } else {
       *Size = 0;
     }
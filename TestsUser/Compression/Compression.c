@@ -0,0 +1,434 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCompressionLib.h>
+
+#include <sys/time.h>
+
+/*
+ clang -g -O2 -fsanitize=undefined,address -fshort-wchar -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h Compression.c ../../Library/OcCompressionLib/OcDecompressStream.c ../../Library/OcCompressionLib/lzss/lzss.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/zlib/*.c -o Compression
+
+ ./Compression [iterations] [size]
+
+ clang-mp-7.0 -DFUZZING_TEST=1 -g -fsanitize=undefined,address,fuzzer -fshort-wchar -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h Compression.c ../../Library/OcCompressionLib/OcDecompressStream.c ../../Library/OcCompressionLib/lzss/lzss.c ../../Library/OcCompressionLib/lzvn/lzvn.c ../../Library/OcCompressionLib/zlib/*.c -o Compression
+ rm -rf DICT fuzz*.log ; mkdir DICT ; UBSAN_OPTIONS='halt_on_error=1' ./Compression -jobs=4 DICT -rss_limit_mb=4096
+
+ rm -rf Compression.dSYM Compression DICT fuzz*.log
+*/
+
+#ifdef FUZZING_TEST
+#define main no_main
+#endif
+
+//
+// Maximum decompressed size checked during fuzzing.
+//
+#define FUZZ_OUTPUT_MAX  BASE_1MB
+
+STATIC CONST char *mTypeNames[] = {
+  "LZSS",
+  "LZVN",
+  "ZLIB"
+};
+
+STATIC
+UINT32
+NextRandom (
+  IN OUT UINT32  *Seed
+  )
+{
+  *Seed = *Seed * 1103515245U + 12345U;
+  return *Seed >> 8U;
+}
+
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+/**
+  Decompress with a stream feeding input and draining output in chunks.
+  Chunk sizes are random when Seed is not 0.
+**/
+STATIC
+RETURN_STATUS
+StreamDecompress (
+  IN  OC_DECOMPRESS_STREAM  *Stream,
+  IN  CONST UINT8           *Src,
+  IN  UINT32                SrcLen,
+  OUT UINT8                 *Dst,
+  IN  UINT32                DstLen,
+  IN  UINT32                Seed,
+  IN  UINT32                ChunkSize,
+  OUT UINT32                *Produced
+  )
+{
+  RETURN_STATUS  Status;
+  UINT32         InOffset;
+  UINT32         InSize;
+  UINT32         OutSize;
+  UINT32         Drained;
+
+  OcDecompressStreamReset (Stream);
+
+  InOffset  = 0;
+  *Produced = 0;
+  Status    = RETURN_NOT_READY;
+
+  while (*Produced < DstLen) {
+    if (Status == RETURN_NOT_READY) {
+      InSize = Seed != 0 ? NextRandom (&Seed) % ChunkSize + 1 : ChunkSize;
+      InSize = MIN (InSize, SrcLen - InOffset);
+      Status = OcDecompressStreamFeed (Stream, Src + InOffset, InSize, InOffset + InSize == SrcLen);
+      if (RETURN_ERROR (Status)) {
+        abort ();
+      }
+      InOffset += InSize;
+    }
+
+    OutSize = Seed != 0 ? NextRandom (&Seed) % ChunkSize + 1 : ChunkSize;
+    OutSize = MIN (OutSize, DstLen - *Produced);
+    Status = OcDecompressStreamDrain (Stream, Dst + *Produced, OutSize, &Drained);
+    *Produced += Drained;
+    if (Status != RETURN_SUCCESS && Status != RETURN_NOT_READY) {
+      break;
+    }
+  }
+
+  if (OcDecompressStreamOffset (Stream) != *Produced) {
+    abort ();
+  }
+
+  return Status;
+}
+
+STATIC
+UINT32
+OneShotDecompress (
+  IN  OC_COMPRESSION_TYPE  Type,
+  IN  CONST UINT8          *Src,
+  IN  UINT32               SrcLen,
+  OUT UINT8                *Dst,
+  IN  UINT32               DstLen
+  )
+{
+  switch (Type) {
+    case OcCompressionLzss:
+      return DecompressLZSS (Dst, DstLen, (UINT8 *) Src, SrcLen);
+    case OcCompressionLzvn:
+      return (UINT32) DecompressLZVN (Dst, DstLen, Src, SrcLen);
+    case OcCompressionZlib:
+      return (UINT32) DecompressZLIB (Dst, DstLen, Src, SrcLen);
+  }
+
+  return 0;
+}
+
+/**
+  Decompress with one-shot and stream interfaces and make sure they agree.
+**/
+STATIC
+VOID
+CheckStream (
+  IN OC_DECOMPRESS_STREAM  *Stream,
+  IN OC_COMPRESSION_TYPE   Type,
+  IN CONST UINT8           *Src,
+  IN UINT32                SrcLen,
+  IN UINT32                Seed,
+  IN UINT32                DstLen
+  )
+{
+  UINT8          *Expected;
+  UINT8          *Actual;
+  UINT32         ExpectedSize;
+  UINT32         ActualSize;
+  RETURN_STATUS  Status;
+  BOOLEAN        Match;
+
+  Expected = malloc (DstLen + 1);
+  Actual   = malloc (DstLen + 1);
+  if (Expected == NULL || Actual == NULL) {
+    abort ();
+  }
+
+  ExpectedSize = OneShotDecompress (Type, Src, SrcLen, Expected, DstLen);
+  Status = StreamDecompress (Stream, Src, SrcLen, Actual, DstLen, Seed | 1U, 64, &ActualSize);
+
+  if (Type == OcCompressionZlib) {
+    //
+    // One-shot ZLIB reports nothing on failure or insufficient output.
+    //
+    if (ExpectedSize != 0) {
+      Match = ActualSize == ExpectedSize && (Status == RETURN_END_OF_FILE || ActualSize == DstLen);
+    } else {
+      Match = Status != RETURN_END_OF_FILE || ActualSize == DstLen;
+    }
+  } else if (Status == RETURN_VOLUME_CORRUPTED) {
+    //
+    // One-shot LZVN drops the last instruction output before an invalid one.
+    //
+    Match = ActualSize >= ExpectedSize;
+  } else {
+    Match = ActualSize == ExpectedSize;
+  }
+
+  if (!Match || memcmp (Expected, Actual, MIN (ExpectedSize, ActualSize)) != 0) {
+    printf (
+      "%s mismatch: one-shot %u, stream %u (%llx)\n",
+      mTypeNames[Type],
+      ExpectedSize,
+      ActualSize,
+      (unsigned long long) Status
+      );
+    abort ();
+  }
+
+  free (Expected);
+  free (Actual);
+}
+
+/**
+  Produce valid LZVN data without an encoder. Literal runs are followed
+  by matches at random distances up to 64 KB, similar to kernel data.
+**/
+STATIC
+UINT32
+CreateLzvn (
+  OUT UINT8   *Dst,
+  IN  UINT32  DstLen,
+  IN  UINT32  Size,
+  IN  UINT32  Seed
+  )
+{
+  UINT32  Offset;
+  UINT32  Produced;
+  UINT32  Length;
+  UINT32  Distance;
+  UINT32  Index;
+
+  Offset   = 0;
+  Produced = 0;
+
+  while (Produced < Size && Offset + 512 < DstLen) {
+    //
+    // Large literal, LZVN always starts with one.
+    //
+    Length = NextRandom (&Seed) % 256 + 16;
+    Dst[Offset++] = 0xE0;
+    Dst[Offset++] = (UINT8) (Length - 16);
+    for (Index = 0; Index < Length; ++Index) {
+      Dst[Offset++] = (UINT8) ("OcSupportPkg kext "[NextRandom (&Seed) % 18]);
+    }
+    Produced += Length;
+
+    //
+    // Large distance match of 10 bytes followed by a previous distance large match.
+    //
+    Distance = NextRandom (&Seed) % MIN (Produced, 0xFFFF) + 1;
+    Dst[Offset++] = 0x3F;
+    Dst[Offset++] = (UINT8) Distance;
+    Dst[Offset++] = (UINT8) (Distance >> 8U);
+    Length = NextRandom (&Seed) % 256;
+    Dst[Offset++] = 0xF0;
+    Dst[Offset++] = (UINT8) Length;
+    Produced += 10 + Length + 16;
+  }
+
+  //
+  // End of stream.
+  //
+  Dst[Offset++] = 0x06;
+  for (Index = 0; Index < 7; ++Index) {
+    Dst[Offset++] = 0;
+  }
+
+  return Offset;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+  OC_COMPRESSION_TYPE   Type;
+  OC_DECOMPRESS_STREAM  *Stream;
+  UINT8                 *Compressed;
+  UINT8                 *End;
+
+  if (Data == NULL || Size < 2 || Size > FUZZ_OUTPUT_MAX) {
+    return 0;
+  }
+
+  Type   = (OC_COMPRESSION_TYPE) (Data[0] % 3);
+  Stream = OcDecompressStreamInit (Type);
+  if (Stream == NULL) {
+    return 0;
+  }
+
+  //
+  // Arbitrary input must not break the stream and must match one-shot decoding.
+  //
+  CheckStream (Stream, Type, Data + 2, (UINT32) Size - 2, Data[1], FUZZ_OUTPUT_MAX);
+
+  //
+  // Compressed input must round-trip, reusing the same stream.
+  //
+  Compressed = malloc (Size * 2 + 64);
+  if (Compressed != NULL) {
+    End = NULL;
+    if (Type == OcCompressionLzss) {
+      End = CompressLZSS (Compressed, (UINT32) Size * 2 + 64, (UINT8 *) Data, (UINT32) Size);
+    } else if (Type == OcCompressionZlib) {
+      End = CompressZLIB (Compressed, (UINT32) Size * 2 + 64, Data, (UINT32) Size);
+    }
+
+    if (End != NULL) {
+      CheckStream (Stream, Type, Compressed, (UINT32) (End - Compressed), Data[1], (UINT32) Size);
+    }
+
+    free (Compressed);
+  }
+
+  OcDecompressStreamFree (Stream);
+  return 0;
+}
+
+STATIC
+VOID
+Report (
+  IN CONST char  *Name,
+  IN UINTN       Iterations,
+  IN UINTN       Size,
+  IN uint64_t    Start
+  )
+{
+  uint64_t  Elapsed;
+
+  Elapsed = TimeUs () - Start;
+  if (Elapsed == 0) {
+    Elapsed = 1;
+  }
+
+  printf (
+    "%-28s %10llu us/call %10.2f MB/s\n",
+    Name,
+    (unsigned long long) (Elapsed / Iterations),
+    (double) (Iterations * Size) / (double) Elapsed
+    );
+}
+
+int main(int argc, char** argv) {
+  UINT32                Iterations;
+  UINT32                Size;
+  UINT32                Index;
+  UINT32                Distance;
+  UINT32                Length;
+  UINT32                Type;
+  UINT32                Seed;
+  UINT8                 *Plain;
+  UINT8                 *Compressed[3];
+  UINT32                CompressedSize[3];
+  UINT8                 *Output;
+  UINT32                Produced;
+  UINT8                 *End;
+  OC_DECOMPRESS_STREAM  *Stream;
+  uint64_t              Start;
+  char                  Name[64];
+
+  Iterations = argc > 1 ? (UINT32) strtoul (argv[1], NULL, 0) : 16;
+  Size       = argc > 2 ? (UINT32) strtoul (argv[2], NULL, 0) : BASE_8MB;
+  Iterations = MAX (Iterations, 1);
+
+  //
+  // Random data with short repeats to get realistic ratios.
+  //
+  Plain = malloc (Size);
+  Seed  = 1;
+  Index = 0;
+  while (Index < Size) {
+    if (Index >= BASE_4KB && NextRandom (&Seed) % 2 == 0) {
+      Distance = NextRandom (&Seed) % BASE_4KB + 1;
+      Length   = MIN (NextRandom (&Seed) % 32 + 4, Size - Index);
+      while (Length-- > 0) {
+        Plain[Index] = Plain[Index - Distance];
+        ++Index;
+      }
+    } else {
+      Plain[Index++] = (UINT8) NextRandom (&Seed);
+    }
+  }
+
+  Output = malloc (Size * 2);
+  for (Type = 0; Type < ARRAY_SIZE (Compressed); ++Type) {
+    Compressed[Type] = malloc (Size * 2 + 4096);
+  }
+
+  End = CompressLZSS (Compressed[OcCompressionLzss], Size * 2, Plain, Size);
+  CompressedSize[OcCompressionLzss] = End != NULL ? (UINT32) (End - Compressed[OcCompressionLzss]) : 0;
+  End = CompressZLIB (Compressed[OcCompressionZlib], Size * 2, Plain, Size);
+  CompressedSize[OcCompressionZlib] = End != NULL ? (UINT32) (End - Compressed[OcCompressionZlib]) : 0;
+  CompressedSize[OcCompressionLzvn] = CreateLzvn (Compressed[OcCompressionLzvn], Size * 2, Size, 1);
+
+  for (Type = 0; Type < ARRAY_SIZE (Compressed); ++Type) {
+    Stream = OcDecompressStreamInit ((OC_COMPRESSION_TYPE) Type);
+    if (Stream == NULL || CompressedSize[Type] == 0) {
+      printf ("%s setup failure\n", mTypeNames[Type]);
+      return -1;
+    }
+
+    //
+    // Compressed size is used for LZVN as its decompressed size is unknown here.
+    //
+    CheckStream (Stream, (OC_COMPRESSION_TYPE) Type, Compressed[Type], CompressedSize[Type], 1, Size * 2);
+
+    printf ("%s %u -> %u\n", mTypeNames[Type], CompressedSize[Type], Size);
+
+    Start = TimeUs ();
+    for (Index = 0; Index < Iterations; ++Index) {
+      Produced = OneShotDecompress ((OC_COMPRESSION_TYPE) Type, Compressed[Type], CompressedSize[Type], Output, Size * 2);
+    }
+    snprintf (Name, sizeof (Name), "%s one-shot", mTypeNames[Type]);
+    Report (Name, Iterations, Produced, Start);
+
+    Start = TimeUs ();
+    for (Index = 0; Index < Iterations; ++Index) {
+      StreamDecompress (Stream, Compressed[Type], CompressedSize[Type], Output, Size * 2, 0, BASE_64KB, &Produced);
+    }
+    snprintf (Name, sizeof (Name), "%s stream 64K", mTypeNames[Type]);
+    Report (Name, Iterations, Produced, Start);
+
+    //
+    // Header probing only needs the beginning of the data.
+    //
+    Start = TimeUs ();
+    for (Index = 0; Index < Iterations; ++Index) {
+      StreamDecompress (Stream, Compressed[Type], CompressedSize[Type], Output, BASE_4KB, 0, BASE_4KB, &Produced);
+    }
+    snprintf (Name, sizeof (Name), "%s stream 4K prefix", mTypeNames[Type]);
+    Report (Name, Iterations, Produced, Start);
+
+    OcDecompressStreamFree (Stream);
+  }
+
+  for (Type = 0; Type < ARRAY_SIZE (Compressed); ++Type) {
+    free (Compressed[Type]);
+  }
+
+  free (Output);
+  free (Plain);
+
+  return 0;
+}
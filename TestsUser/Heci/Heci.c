@@ -0,0 +1,487 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcHeciLib.h>
+#include <Library/OcMiscLib.h>
+#include <Protocol/Heci.h>
+#include <Protocol/Heci2.h>
+
+#include <sys/time.h>
+
+/*
+ clang -g -O2 -DOC_TARGET_DEBUG -DPROTOCOL_LOCATOR=NilLocateProtocolCustom -fsanitize=undefined,address -I../Include -I../../Include -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Heci.c ../../Library/OcHeciLib/OcHeciLib.c -o Heci
+
+ ./Heci [latency-us]
+
+ rm -rf Heci.dSYM Heci
+*/
+
+EFI_GUID gEfiHeciProtocolGuid;
+EFI_GUID gEfiHeci2ProtocolGuid;
+EFI_GUID gMePavpProtocolGuid = ME_PAVP_PROTOCOL_GUID;
+EFI_GUID gMeFpfProtocolGuid  = ME_FPF_PROTOCOL_GUID;
+
+#define MOCK_PAVP_ADDRESS   3
+#define MOCK_FPF_ADDRESS    7
+#define MOCK_QUEUE_MAX      64
+#define MOCK_GROUP_ID       0x1234
+
+typedef struct {
+  uint64_t  ReadyAt;
+  BOOLEAN   NeedsCredit;
+  UINT32    Length;
+  UINT32    Data[16];
+} MOCK_MESSAGE;
+
+//
+// Messages from ME to host, in order.
+//
+STATIC MOCK_MESSAGE mMockQueue[MOCK_QUEUE_MAX];
+STATIC UINT32       mMockQueueCount;
+
+//
+// Responses ME may send to the connected client, granted by host flow control.
+//
+STATIC UINT32       mMockHostCredits;
+//
+// Flow control messages ME sends on connection.
+//
+STATIC UINT32       mMockConnectCredits = 1;
+//
+// Additional delay for flow control sent after a client response.
+//
+STATIC UINT32       mMockFlowControlDelay;
+STATIC UINT32       mMockLatency = 200;
+STATIC UINT8        mMockConnected;
+STATIC BOOLEAN      mMockMute;
+
+STATIC UINT32       mMockSends;
+STATIC UINT32       mMockReads;
+STATIC UINT32       mMockPolls;
+
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+STATIC
+VOID
+MockPush (
+  IN CONST VOID  *Data,
+  IN UINT32      Length,
+  IN BOOLEAN     NeedsCredit,
+  IN UINT32      Delay
+  )
+{
+  MOCK_MESSAGE  *Message;
+
+  assert (mMockQueueCount < MOCK_QUEUE_MAX);
+  assert (Length <= sizeof (Message->Data));
+
+  Message = &mMockQueue[mMockQueueCount++];
+  ZeroMem (Message, sizeof (*Message));
+  Message->ReadyAt     = TimeUs () + Delay;
+  Message->NeedsCredit = NeedsCredit;
+  Message->Length      = Length;
+  CopyMem (Message->Data, Data, Length);
+}
+
+STATIC
+VOID
+MockPushFlowControl (
+  IN UINT32  Delay
+  )
+{
+  HBM_FLOW_CONTROL  Command;
+
+  ZeroMem (&Command, sizeof (Command));
+  Command.Command.Fields.Command = FLOW_CONTROL;
+  Command.MeAddress              = mMockConnected;
+  Command.HostAddress            = HBM_CLIENT_ADDRESS;
+  MockPush (&Command, sizeof (Command), FALSE, Delay);
+}
+
+STATIC
+VOID
+MockBusMessage (
+  IN UINT8  *Message
+  )
+{
+  HBM_HOST_ENUMERATION_BUFFER        Enumeration;
+  HBM_HOST_CLIENT_PROPERTIES_BUFFER  Properties;
+  HBM_CLIENT_CONNECT_BUFFER          Connect;
+  HBM_CLIENT_DISCONNECT_BUFFER       Disconnect;
+  UINT32                             Index;
+
+  switch (Message[0] & 0x7FU) {
+    case HOST_ENUMERATION_REQUEST:
+      ZeroMem (&Enumeration, sizeof (Enumeration));
+      Enumeration.Response.Command.Fields.Command    = HOST_ENUMERATION_REQUEST;
+      Enumeration.Response.Command.Fields.IsResponse = 1;
+      Enumeration.Response.ValidAddresses[0]         = (1U << 1U) | (1U << MOCK_PAVP_ADDRESS) | (1U << MOCK_FPF_ADDRESS);
+      MockPush (&Enumeration.Response, sizeof (Enumeration.Response), FALSE, mMockLatency);
+      break;
+    case HOST_CLIENT_PROPERTIES_REQUEST:
+      ZeroMem (&Properties, sizeof (Properties));
+      Properties.Response.Command.Fields.Command    = HOST_CLIENT_PROPERTIES_REQUEST;
+      Properties.Response.Command.Fields.IsResponse = 1;
+      Properties.Response.Address                   = Message[1];
+      if (Message[1] == MOCK_PAVP_ADDRESS) {
+        CopyGuid (&Properties.Response.ClientProperties.ProtocolName, &gMePavpProtocolGuid);
+      } else if (Message[1] == MOCK_FPF_ADDRESS) {
+        CopyGuid (&Properties.Response.ClientProperties.ProtocolName, &gMeFpfProtocolGuid);
+      }
+      Properties.Response.ClientProperties.MaxMessageLength = 4096;
+      MockPush (&Properties.Response, sizeof (Properties.Response), FALSE, mMockLatency);
+      break;
+    case CLIENT_CONNECT_REQUEST:
+      ZeroMem (&Connect, sizeof (Connect));
+      Connect.Response.Command.Fields.Command    = CLIENT_CONNECT_REQUEST;
+      Connect.Response.Command.Fields.IsResponse = 1;
+      Connect.Response.MeAddress                 = Message[1];
+      Connect.Response.HostAddress               = HBM_CLIENT_ADDRESS;
+      Connect.Response.Status                    = HBM_CLIENT_CONNECT_SUCCESS;
+      MockPush (&Connect.Response, sizeof (Connect.Response), FALSE, mMockLatency);
+      mMockConnected   = Message[1];
+      mMockHostCredits = 0;
+      for (Index = 0; Index < mMockConnectCredits; ++Index) {
+        MockPushFlowControl (mMockLatency);
+      }
+      break;
+    case FLOW_CONTROL:
+      ++mMockHostCredits;
+      break;
+    case CLIENT_DISCONNECT_REQUEST:
+      ZeroMem (&Disconnect, sizeof (Disconnect));
+      Disconnect.Response.Command.Fields.Command    = CLIENT_DISCONNECT_REQUEST;
+      Disconnect.Response.Command.Fields.IsResponse = 1;
+      Disconnect.Response.MeAddress                 = Message[1];
+      Disconnect.Response.HostAddress               = HBM_CLIENT_ADDRESS;
+      mMockQueueCount  = 0;
+      mMockHostCredits = 0;
+      mMockConnected   = 0;
+      MockPush (&Disconnect.Response, sizeof (Disconnect.Response), FALSE, mMockLatency);
+      break;
+    default:
+      break;
+  }
+}
+
+STATIC
+VOID
+MockClientMessage (
+  IN UINT32  *Message
+  )
+{
+  ME_PAVP_PROVISION_REQUEST_RESPONSE  Request;
+  ME_PAVP_PROVISION_PERFORM_RESPONSE  Perform;
+  UINT32                              Fpf[11];
+
+  if (mMockMute) {
+    return;
+  }
+
+  if (mMockConnected == MOCK_PAVP_ADDRESS) {
+    if (Message[1] == ME_PAVP_PROVISION_REQUEST_COMMAND) {
+      ZeroMem (&Request, sizeof (Request));
+      Request.Header.Version = ME_PAVP_PROTOCOL_VERSION;
+      Request.Status         = EPID_STATUS_CAN_PROVISION;
+      Request.GroupId        = MOCK_GROUP_ID;
+      MockPush (&Request, sizeof (Request), TRUE, mMockLatency);
+    } else {
+      ZeroMem (&Perform, sizeof (Perform));
+      Perform.Header.Version = ME_PAVP_PROTOCOL_VERSION;
+      Perform.Header.Command = ME_PAVP_PROVISION_PERFORM_COMMAND;
+      Perform.Header.Status  = EPID_STATUS_PROVISIONED;
+      MockPush (&Perform, sizeof (Perform), TRUE, mMockLatency);
+    }
+  } else if (mMockConnected == MOCK_FPF_ADDRESS) {
+    ZeroMem (Fpf, sizeof (Fpf));
+    Fpf[0] = Message[0];
+    if (Message[0] == 3) {
+      //
+      // Return request sequence to check response order.
+      //
+      Fpf[1] = 250;
+      Fpf[2] = Message[1];
+      MockPush (Fpf, sizeof (Fpf), TRUE, mMockLatency);
+    } else {
+      MockPush (Fpf, 2 * sizeof (Fpf[0]), TRUE, mMockLatency);
+    }
+  }
+
+  MockPushFlowControl (mMockLatency + mMockFlowControlDelay);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockReadMsg (
+  IN      UINT32           Blocking,
+  IN      UINT32           *MessageBody,
+  IN OUT  UINT32           *Length
+  )
+{
+  uint64_t  Now;
+  UINT32    Index;
+
+  Now = TimeUs ();
+
+  for (Index = 0; Index < mMockQueueCount; ++Index) {
+    if (mMockQueue[Index].ReadyAt > Now) {
+      continue;
+    }
+
+    if (mMockQueue[Index].NeedsCredit) {
+      if (mMockHostCredits == 0) {
+        continue;
+      }
+      --mMockHostCredits;
+    }
+
+    ++mMockReads;
+    *Length = MIN (*Length, mMockQueue[Index].Length);
+    CopyMem (MessageBody, mMockQueue[Index].Data, *Length);
+    --mMockQueueCount;
+    CopyMem (&mMockQueue[Index], &mMockQueue[Index + 1], (mMockQueueCount - Index) * sizeof (mMockQueue[0]));
+    return EFI_SUCCESS;
+  }
+
+  ++mMockPolls;
+  return Blocking == BLOCKING ? EFI_TIMEOUT : EFI_NOT_READY;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+MockSendMsg (
+  IN      UINT32           *Message,
+  IN      UINT32           Length,
+  IN      UINT8            HostAddress,
+  IN      UINT8            MEAddress
+  )
+{
+  ++mMockSends;
+
+  if (HostAddress == HBM_HOST_ADDRESS && MEAddress == HBM_ME_ADDRESS) {
+    MockBusMessage ((UINT8 *) Message);
+  } else if (HostAddress == HBM_CLIENT_ADDRESS && MEAddress == mMockConnected) {
+    MockClientMessage (Message);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_HECI_PROTOCOL mMockHeci = {
+  .ReadMsg = MockReadMsg,
+  .SendMsg = MockSendMsg
+};
+
+EFI_STATUS NilLocateProtocolCustom(EFI_GUID *ProtocolGuid, VOID *Registration, VOID **Interface) {
+  if (ProtocolGuid == &gEfiHeciProtocolGuid) {
+    *Interface = &mMockHeci;
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+STATIC
+VOID
+ResetCounters (
+  OUT uint64_t  *Start
+  )
+{
+  mMockSends = 0;
+  mMockReads = 0;
+  mMockPolls = 0;
+  *Start     = TimeUs ();
+}
+
+STATIC
+VOID
+Report (
+  IN CONST char  *Name,
+  IN UINT32      Requests,
+  IN uint64_t    Start
+  )
+{
+  printf (
+    "%-28s %6llu us/request, %u sends, %u reads, %u polls\n",
+    Name,
+    (unsigned long long) ((TimeUs () - Start) / Requests),
+    mMockSends,
+    mMockReads,
+    mMockPolls
+    );
+}
+
+STATIC
+int
+Check (
+  IN BOOLEAN     Condition,
+  IN CONST char  *Message
+  )
+{
+  if (!Condition) {
+    printf ("FAIL: %s\n", Message);
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  EFI_STATUS              Status;
+  UINT8                   ClientMap[HBM_ME_CLIENT_MAX];
+  UINT8                   ClientCount;
+  HECI_CLIENT_PROPERTIES  Properties;
+  UINT32                  Index;
+  UINT32                  Request[4];
+  UINT32                  Response[11];
+  UINT32                  FpfStatus;
+  UINT32                  EpidStatus;
+  UINT32                  EpidGroupId;
+  EPID_CERTIFICATE        Certificate;
+  EPID_GROUP_PUBLIC_KEY   PublicKey;
+  BOOLEAN                 SetVar;
+  uint64_t                Start;
+  int                     Failures;
+
+  mMockLatency = argc > 1 ? (UINT32) strtoul (argv[1], NULL, 0) : 200;
+  Failures     = 0;
+
+  HeciSetReadTimeout (SECONDS_TO_MICROSECONDS (1));
+
+  //
+  // Client map and properties are requested from ME only once.
+  //
+  ResetCounters (&Start);
+  Status = HeciGetClientMap (ClientMap, &ClientCount);
+  Failures += Check (!EFI_ERROR (Status) && ClientCount == 3, "client map");
+  Failures += Check (ClientMap[1] == MOCK_PAVP_ADDRESS && ClientMap[2] == MOCK_FPF_ADDRESS, "client addresses");
+  for (Index = 0; Index < ClientCount; ++Index) {
+    Status = HeciGetClientProperties (ClientMap[Index], &Properties);
+    Failures += Check (!EFI_ERROR (Status) && Properties.MaxMessageLength == 4096, "client properties");
+  }
+  Report ("Enumeration (uncached)", ClientCount + 1, Start);
+
+  ResetCounters (&Start);
+  Status = HeciGetClientMap (ClientMap, &ClientCount);
+  Failures += Check (!EFI_ERROR (Status) && ClientCount == 3, "cached client map");
+  for (Index = 0; Index < ClientCount; ++Index) {
+    Status = HeciGetClientProperties (ClientMap[Index], &Properties);
+    Failures += Check (!EFI_ERROR (Status), "cached client properties");
+  }
+  Failures += Check (CompareGuid (&Properties.ProtocolName, &gMeFpfProtocolGuid), "cached protocol");
+  Failures += Check (mMockSends == 0 && mMockReads == 0, "cached enumeration uses transport");
+  Report ("Enumeration (cached)", ClientCount + 1, Start);
+
+  //
+  // One request per round trip.
+  //
+  mMockConnectCredits = 4;
+  Status = HeciConnectToClient (MOCK_FPF_ADDRESS);
+  Failures += Check (!EFI_ERROR (Status), "fpf connect");
+
+  ResetCounters (&Start);
+  for (Index = 0; Index < 16; ++Index) {
+    FpfStatus = 0;
+    Status = HeciFpfGetStatus (&FpfStatus);
+    Failures += Check (!EFI_ERROR (Status) && FpfStatus == 250, "fpf status");
+  }
+  Report ("FPF status (serial)", 16, Start);
+
+  //
+  // Four requests in flight.
+  //
+  ResetCounters (&Start);
+  for (Index = 0; Index < 16; Index += 4) {
+    Status = HeciGrantReceiveCredits (4);
+    Failures += Check (!EFI_ERROR (Status), "grant credits");
+
+    for (Request[1] = Index; Request[1] < Index + 4; ++Request[1]) {
+      Request[0] = 3;
+      Request[2] = Request[3] = 0;
+      Status = HeciSendMessagePerClient (Request, sizeof (Request));
+      Failures += Check (!EFI_ERROR (Status), "pipelined send");
+    }
+
+    for (Request[1] = Index; Request[1] < Index + 4; ++Request[1]) {
+      Status = HeciGetResponse (Response, sizeof (Response));
+      Failures += Check (!EFI_ERROR (Status) && Response[1] == 250 && Response[2] == Request[1], "pipelined response");
+    }
+  }
+  Report ("FPF status (pipelined)", 16, Start);
+
+  //
+  // Responses arriving before flow control are kept in order.
+  //
+  mMockFlowControlDelay = mMockLatency * 4;
+  Status = HeciGrantReceiveCredits (3);
+  for (Request[1] = 100; Request[1] < 103; ++Request[1]) {
+    Request[0] = 3;
+    Status = HeciSendMessagePerClient (Request, sizeof (Request));
+    Failures += Check (!EFI_ERROR (Status), "delayed flow control send");
+  }
+  for (Request[1] = 100; Request[1] < 103; ++Request[1]) {
+    Status = HeciGetResponse (Response, sizeof (Response));
+    Failures += Check (!EFI_ERROR (Status) && Response[2] == Request[1], "delayed flow control response");
+  }
+  mMockFlowControlDelay = 0;
+
+  //
+  // Silent ME does not block longer than the timeout.
+  //
+  HeciSetReadTimeout (SECONDS_TO_MICROSECONDS (1) / 100);
+  mMockMute = TRUE;
+  Start     = TimeUs ();
+  Status    = HeciFpfGetStatus (&FpfStatus);
+  Failures += Check (Status == EFI_TIMEOUT, "read timeout");
+  Failures += Check (TimeUs () - Start < SECONDS_TO_MICROSECONDS (1) / 10, "read timeout duration");
+  mMockMute = FALSE;
+  HeciSetReadTimeout (SECONDS_TO_MICROSECONDS (1));
+
+  Status = HeciDisconnectFromClients ();
+  Failures += Check (!EFI_ERROR (Status), "fpf disconnect");
+
+  //
+  // PAVP provisioning flow.
+  //
+  mMockConnectCredits = 1;
+  ResetCounters (&Start);
+  Status = HeciConnectToClient (MOCK_PAVP_ADDRESS);
+  Failures += Check (!EFI_ERROR (Status), "pavp connect");
+  Status = HeciPavpRequestProvisioning (&EpidStatus, &EpidGroupId);
+  Failures += Check (
+    !EFI_ERROR (Status) && EpidStatus == EPID_STATUS_CAN_PROVISION && EpidGroupId == MOCK_GROUP_ID,
+    "pavp request"
+    );
+  ZeroMem (&Certificate, sizeof (Certificate));
+  ZeroMem (&PublicKey, sizeof (PublicKey));
+  Status = HeciPavpPerformProvisioning (&Certificate, &PublicKey, &SetVar);
+  Failures += Check (!EFI_ERROR (Status) && !SetVar, "pavp perform");
+  Status = HeciDisconnectFromClients ();
+  Failures += Check (!EFI_ERROR (Status), "pavp disconnect");
+  Report ("PAVP provisioning", 4, Start);
+
+  printf ("%s (%d failures)\n", Failures == 0 ? "PASS" : "FAIL", Failures);
+  return Failures == 0 ? 0 : -1;
+}
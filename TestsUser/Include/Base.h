@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <assert.h>
 #include <cpuid.h>
+#include <time.h>
 
 #ifndef RSIZE_MAX
 #define RSIZE_MAX (SIZE_MAX >> 1)
@@ -185,6 +186,10 @@ typedef struct EFI_SYSTEM_TABLE_ EFI_SYSTEM_TABLE;
 typedef struct EFI_BOOT_SERVICES_ EFI_BOOT_SERVICES;
 typedef struct EFI_RUNTIME_SERVICES_ EFI_RUNTIME_SERVICES;
 typedef VOID (*EFI_EVENT_NOTIFY)(EFI_EVENT Event, VOID *Context);
+typedef UINTN EFI_TPL;
+
+#define TPL_CALLBACK 8
+#define EVT_SIGNAL_EXIT_BOOT_SERVICES 0x00000201
 
 typedef struct _LIST_ENTRY LIST_ENTRY;
 
@@ -543,12 +548,14 @@ STATIC inline EFI_STATUS FreePool(void *x) { free (x); return EFI_SUCCESS; }
 #define ZeroMem(a,b) (memset)(a, 0, b)
 #define SetMem(Dst, Size, Value) (memset)(Dst, Value, Size)
 #define AsciiSPrint snppprintf
+UINTN AsciiPrint (CONST CHAR8 *Format, ...);
 #define AsciiStrCmp strcmp
 #define AsciiStrLen strlen
 #define AsciiStrStr strstr
 #define AsciiStrnCmp strncmp
 #define AsciiStrSize(x) (strlen(x) + 1)
 #define AsciiStrnCpyS(a, b, c, d) oc_strlcpy(a, c, b)
+#define AsciiStrnCatS(a, b, c, d) ((strncat)((a), (c), MIN ((d), (b) - strlen (a) - 1)), RETURN_SUCCESS)
 #define AsciiStrDecimalToUint64(a) (strtoull)(a, NULL, 10)
 #define AsciiStrHexToUint64(a) (strtoull)(a, NULL, 16)
 
@@ -854,6 +861,16 @@ AsmWriteMsr64 (
 {
 }
 
+STATIC
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  return __builtin_ia32_rdtsc ();
+}
+
 STATIC
 UINT64
 EFIAPI
@@ -1717,6 +1734,10 @@ struct EFI_BOOT_SERVICES_ {
   EFI_STATUS (*GetMemoryMap) (UINTN *MemoryMapSize, EFI_MEMORY_DESCRIPTOR *MemoryMap, UINTN *MapKey, UINTN *DescriptorSize, UINT32 *DescriptorVersion);
   EFI_STATUS (*FreePool) (void *x);
   EFI_STATUS (*LocateDevicePath) (EFI_GUID *Protocol, EFI_DEVICE_PATH_PROTOCOL **DevicePath, EFI_HANDLE *Device);
+  EFI_STATUS (*Stall) (UINTN Microseconds);
+  EFI_STATUS (*CreateEvent) (UINT32 Type, EFI_TPL NotifyTpl, EFI_EVENT_NOTIFY NotifyFunction, VOID *NotifyContext, EFI_EVENT *Event);
+  EFI_STATUS (*CloseEvent) (EFI_EVENT Event);
+  VOID (*CopyMem) (VOID *Destination, VOID *Source, UINTN Length);
 };
 
 typedef EFI_STATUS (*EFI_GET_VARIABLE)(CHAR16 *VariableName, EFI_GUID *VendorGuid, UINT32 *Attributes, UINTN *DataSize, VOID *Data);
@@ -1789,14 +1810,44 @@ STATIC EFI_STATUS NilLocateDevicePath (EFI_GUID *Protocol, EFI_DEVICE_PATH_PROTO
   return EFI_UNSUPPORTED;
 }
 
+STATIC EFI_STATUS NilStall (UINTN Microseconds) {
+  struct timespec  Delay;
+  Delay.tv_sec  = Microseconds / 1000000;
+  Delay.tv_nsec = (Microseconds % 1000000) * 1000;
+  nanosleep (&Delay, NULL);
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_STATUS NilCreateEvent (UINT32 Type, EFI_TPL NotifyTpl, EFI_EVENT_NOTIFY NotifyFunction, VOID *NotifyContext, EFI_EVENT *Event) {
+  //
+  // Events are never signalled, any unique handle will do.
+  //
+  STATIC UINT8 NilEvent;
+  *Event = &NilEvent;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_STATUS NilCloseEvent (EFI_EVENT Event) {
+  return EFI_SUCCESS;
+}
+
+STATIC VOID NilCopyMem (VOID *Destination, VOID *Source, UINTN Length) {
+  memmove (Destination, Source, Length);
+}
+
 extern EFI_STATUS NilInstallConfigurationTableCustom(EFI_GUID *Guid, VOID *Table);
+extern EFI_STATUS NilLocateProtocolCustom(EFI_GUID *ProtocolGuid, VOID *Registration, VOID **Interface);
 
 #ifndef CONFIG_TABLE_INSTALLER
 #define CONFIG_TABLE_INSTALLER NilInstallConfigurationTable
 #endif
 
+#ifndef PROTOCOL_LOCATOR
+#define PROTOCOL_LOCATOR NilLocateProtocol
+#endif
+
 STATIC EFI_BOOT_SERVICES gNilBS = {
-  .LocateProtocol = NilLocateProtocol,
+  .LocateProtocol = PROTOCOL_LOCATOR,
   .AllocatePages = NilAllocatePages,
   .FreePages = NilFreePages,
   .InstallConfigurationTable = CONFIG_TABLE_INSTALLER,
@@ -1805,7 +1856,11 @@ STATIC EFI_BOOT_SERVICES gNilBS = {
   .InstallProtocolInterface = NilInstallProtocolInterface,
   .GetMemoryMap = NilGetMemoryMap,
   .FreePool = FreePool,
-  .LocateDevicePath = NilLocateDevicePath
+  .LocateDevicePath = NilLocateDevicePath,
+  .Stall = NilStall,
+  .CreateEvent = NilCreateEvent,
+  .CloseEvent = NilCloseEvent,
+  .CopyMem = NilCopyMem
 };
 
 STATIC EFI_BOOT_SERVICES *gBS = &gNilBS;
@@ -0,0 +1,210 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCryptoLib.h>
+#include <Library/OcRngLib.h>
+
+#include <OcRngInternals.h>
+
+#include <sys/time.h>
+#include <x86intrin.h>
+
+/*
+ clang -g -O2 -mrdrnd -mrdseed -fsanitize=undefined,address -I../Include -I../../Include -I../../Library/OcRngLib -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h Rng.c ../../Library/OcRngLib/OcRngLib.c ../../Library/OcCryptoLib/ChaCha.c ../../Library/OcCryptoLib/SecureMem.c -o Rng
+
+ ./Rng [iterations]
+
+ rm -rf Rng.dSYM Rng
+*/
+
+RETURN_STATUS
+EFIAPI
+OcRngLibConstructor (
+  VOID
+  );
+
+UINT64
+EFIAPI
+AsmAddRngJitter (
+  IN UINT64  Value
+  )
+{
+  return __builtin_popcountll (Value);
+}
+
+UINT64
+EFIAPI
+AsmReadTsc (
+  VOID
+  )
+{
+  return __rdtsc ();
+}
+
+VOID
+EFIAPI
+CpuPause (
+  VOID
+  )
+{
+  _mm_pause ();
+}
+
+BOOLEAN
+EFIAPI
+AsmRdRand16 (
+  OUT UINT16  *Rand
+  )
+{
+  return _rdrand16_step (Rand) != 0;
+}
+
+BOOLEAN
+EFIAPI
+AsmRdRand32 (
+  OUT UINT32  *Rand
+  )
+{
+  return _rdrand32_step (Rand) != 0;
+}
+
+BOOLEAN
+EFIAPI
+AsmRdRand64 (
+  OUT UINT64  *Rand
+  )
+{
+  unsigned long long  Value;
+
+  if (_rdrand64_step (&Value) != 0) {
+    *Rand = Value;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+BOOLEAN
+EFIAPI
+AsmRdSeed64 (
+  OUT UINT64  *Seed
+  )
+{
+  unsigned long long  Value;
+
+  if (_rdseed64_step (&Value) != 0) {
+    *Seed = Value;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+STATIC
+VOID
+Report (
+  IN CONST char  *Name,
+  IN UINTN       Iterations,
+  IN UINTN       Size,
+  IN uint64_t    Start,
+  IN UINT64      Sink
+  )
+{
+  uint64_t  Elapsed;
+
+  Elapsed = TimeUs () - Start;
+  if (Elapsed == 0) {
+    Elapsed = 1;
+  }
+
+  printf (
+    "%-24s %8llu ns/call %10.2f MB/s (%016llx)\n",
+    Name,
+    (unsigned long long) (Elapsed * 1000 / Iterations),
+    (double) (Iterations * Size) / (double) Elapsed,
+    (unsigned long long) Sink
+    );
+}
+
+int main(int argc, char** argv) {
+  UINTN     Index;
+  UINTN     Iterations;
+  uint64_t  Start;
+  UINT16    Rand16;
+  UINT32    Rand32;
+  UINT64    Rand64;
+  UINT64    Sink;
+
+  Iterations = argc > 1 ? strtoul (argv[1], NULL, 0) : 1000000;
+
+  OcRngLibConstructor ();
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    GetRandomNumber16 (&Rand16);
+    Sink ^= Rand16;
+  }
+  Report ("GetRandomNumber16", Iterations, sizeof (Rand16), Start, Sink);
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    GetRandomNumber32 (&Rand32);
+    Sink ^= Rand32;
+  }
+  Report ("GetRandomNumber32", Iterations, sizeof (Rand32), Start, Sink);
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    GetRandomNumber64 (&Rand64);
+    Sink ^= Rand64;
+  }
+  Report ("GetRandomNumber64", Iterations, sizeof (Rand64), Start, Sink);
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Sink ^= GetPseudoRandomNumber16 ();
+  }
+  Report ("GetPseudoRandomNumber16", Iterations, sizeof (UINT16), Start, Sink);
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Sink ^= GetPseudoRandomNumber32 ();
+  }
+  Report ("GetPseudoRandomNumber32", Iterations, sizeof (UINT32), Start, Sink);
+
+  Sink  = 0;
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    Sink ^= GetPseudoRandomNumber64 ();
+  }
+  Report ("GetPseudoRandomNumber64", Iterations, sizeof (UINT64), Start, Sink);
+
+  return 0;
+}
@@ -19,13 +19,16 @@
 #include <sys/time.h>
 
 /*
- clang -g -fshort-wchar -DCONFIG_TABLE_INSTALLER=NilInstallConfigurationTableCustom -fsanitize=undefined,address -I../Include -I../../Include -I../../../EfiPkg/Include/ -I../../../MdePkg/Include/ -I../../../UefiCpuPkg/Include/ -include ../Include/Base.h Smbios.c ../../Library/OcSmbiosLib/DebugSmbios.c ../../Library/OcSmbiosLib/SmbiosInternal.c ../../Library/OcSmbiosLib/SmbiosPatch.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMiscLib/LegacyRegionLock.c ../../Library/OcMiscLib/LegacyRegionUnlock.c ../../Library/OcCpuLib/OcCpuLib.c -o Smbios
+ clang -g -fshort-wchar -DCONFIG_TABLE_INSTALLER=NilInstallConfigurationTableCustom -fsanitize=undefined,address -I../Include -I../../Include -I../../../EfiPkg/Include/ -I../../../MdePkg/Include/ -I../../../UefiCpuPkg/Include/ -include ../Include/Base.h Smbios.c ../../Library/OcSmbiosLib/DebugSmbios.c ../../Library/OcSmbiosLib/SmbiosInternal.c ../../Library/OcSmbiosLib/SmbiosPatch.c ../../Library/OcPerfLib/OcPerfLib.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMiscLib/LegacyRegionLock.c ../../Library/OcMiscLib/LegacyRegionUnlock.c ../../Library/OcCpuLib/OcCpuLib.c -o Smbios
 
  for fuzzing:
- clang-mp-7.0 -fshort-wchar -DCONFIG_TABLE_INSTALLER=NilInstallConfigurationTableCustom -Dmain=__main -g -fsanitize=undefined,address,fuzzer -I../Include -I../../Include -I../../../EfiPkg/Include/ -I../../../MdePkg/Include/ -I../../../UefiCpuPkg/Include/ -include ../Include/Base.h Smbios.c ../../Library/OcSmbiosLib/DebugSmbios.c ../../Library/OcSmbiosLib/SmbiosInternal.c ../../Library/OcSmbiosLib/SmbiosPatch.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMiscLib/LegacyRegionLock.c ../../Library/OcMiscLib/LegacyRegionUnlock.c ../../Library/OcCpuLib/OcCpuLib.c -o Smbios
+ clang-mp-7.0 -fshort-wchar -DCONFIG_TABLE_INSTALLER=NilInstallConfigurationTableCustom -Dmain=__main -g -fsanitize=undefined,address,fuzzer -I../Include -I../../Include -I../../../EfiPkg/Include/ -I../../../MdePkg/Include/ -I../../../UefiCpuPkg/Include/ -include ../Include/Base.h Smbios.c ../../Library/OcSmbiosLib/DebugSmbios.c ../../Library/OcSmbiosLib/SmbiosInternal.c ../../Library/OcSmbiosLib/SmbiosPatch.c ../../Library/OcPerfLib/OcPerfLib.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcMiscLib/LegacyRegionLock.c ../../Library/OcMiscLib/LegacyRegionUnlock.c ../../Library/OcCpuLib/OcCpuLib.c -o Smbios
 
  rm -rf DICT fuzz*.log ; mkdir DICT ; cp Smbios.bin DICT ; ./Smbios -jobs=4 DICT
 
+ for full rebuild vs sparse update timing add -O2 -DNDEBUG to the first command:
+ ./Smbios Smbios.bin [iterations]
+
  rm -rf Smbios.dSYM DICT fuzz*.log Smbios
 */
 
@@ -90,6 +93,7 @@ STATIC OC_SMBIOS_DATA SmbiosData = {
 
 
 bool doDump = false;
+uint32_t lastTableSize = 0;
 _Thread_local uint32_t externalUsedPages = 0;
 _Thread_local uint8_t externalBlob[EFI_PAGE_SIZE*TOTAL_PAGES];
 
@@ -109,8 +113,14 @@ EFI_STATUS EfiGetSystemConfigurationTable (EFI_GUID *TableGuid, OUT VOID **Table
 }
 
 EFI_STATUS NilInstallConfigurationTableCustom(EFI_GUID *Guid, VOID *Table) {
+  if (Guid == &gEfiSmbios3TableGuid) {
+    lastTableSize = ((SMBIOS_TABLE_3_0_ENTRY_POINT *) Table)->TableMaximumSize;
+  }
+  if (!doDump) {
+    return EFI_SUCCESS;
+  }
   printf("Set table %p, looking for %p\n", Guid, &gEfiSmbios3TableGuid);
-  if (Guid == &gEfiSmbios3TableGuid && doDump) {
+  if (Guid == &gEfiSmbios3TableGuid) {
     SMBIOS_TABLE_3_0_ENTRY_POINT  *Ep = (SMBIOS_TABLE_3_0_ENTRY_POINT *) Table;
     (void)remove("out.bin");
     FILE *fh = fopen("out.bin", "wb");
@@ -122,6 +132,65 @@ EFI_STATUS NilInstallConfigurationTableCustom(EFI_GUID *Guid, VOID *Table) {
   return EFI_SUCCESS;
 }
 
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+STATIC
+VOID
+BenchmarkSmbios (
+  IN OC_CPU_INFO  *CpuInfo,
+  IN UINT32       Iterations
+  )
+{
+  UINT32                 Index;
+  uint64_t               Start;
+  uint64_t               CreateTime;
+  uint64_t               PatchTime;
+  UINT32                 CreateSize;
+  OC_SMBIOS_PATCH_STATS  Stats;
+
+  doDump = false;
+
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    CreateSmbios (&SmbiosData, OcSmbiosUpdateCreate, CpuInfo);
+  }
+  CreateTime = TimeUs () - Start;
+  CreateSize = lastTableSize;
+
+  Start = TimeUs ();
+  for (Index = 0; Index < Iterations; ++Index) {
+    PatchSmbios (&SmbiosData, OcSmbiosUpdateCreate, CpuInfo, &Stats);
+  }
+  PatchTime = TimeUs () - Start;
+
+  printf (
+    "Full rebuild:  %8.2f us/update, %u bytes rebuilt\n",
+    (double) CreateTime / Iterations,
+    CreateSize
+    );
+  printf (
+    "Sparse update: %8.2f us/update, %u bytes in %u structures copied, "
+    "%u bytes in %u rebuilt, %u bytes in %u created, %u bytes total\n",
+    (double) PatchTime / Iterations,
+    Stats.CopiedSize,
+    Stats.CopiedCount,
+    Stats.RebuiltSize,
+    Stats.RebuiltCount,
+    Stats.CreatedSize,
+    Stats.CreatedCount,
+    lastTableSize
+    );
+}
+
 int main(int argc, char** argv) {
   uint32_t f;
   uint8_t *b;
@@ -144,6 +213,8 @@ int main(int argc, char** argv) {
     &CpuInfo
     );
 
+  BenchmarkSmbios (&CpuInfo, argc > 2 ? (UINT32) strtoul (argv[2], NULL, 0) : 1000);
+
   return 0;
 }
 
@@ -0,0 +1,347 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcStringLib.h>
+
+#include <OcStringInternal.h>
+
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/*
+ clang -g -O2 -fshort-wchar -ffreestanding -fsanitize=undefined,address -D_PCD_GET_MODE_32_PcdMaximumUnicodeStringLength=0 -I../Include -I../../Include -I../../Library/OcStringLib -I../../../MdePkg/Include/ -include ../Include/Base.h String.c ../../Library/OcStringLib/OcAsciiLib.c ../../Library/OcStringLib/OcUnicodeLib.c -o String
+
+ ./String [iterations] [length]
+
+ Build without sanitizers to get meaningful timings.
+
+ rm -rf String.dSYM String
+*/
+
+#ifndef OC_STRING_SSE2
+#error "String primitives are benchmarked against the SSE2 implementation"
+#endif
+
+STATIC
+uint64_t
+TimeNs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return ((uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec) * 1000ULL;
+}
+
+STATIC
+INTN
+Sign (
+  IN INTN  Value
+  )
+{
+  return Value < 0 ? -1 : Value > 0;
+}
+
+STATIC
+VOID
+FillAscii (
+  OUT CHAR8   *String,
+  IN  UINTN   Length,
+  IN  UINT32  Seed
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; ++Index) {
+    Seed = Seed * 1103515245U + 12345U;
+    String[Index] = (CHAR8) ('a' + (Seed >> 16) % 4);
+  }
+
+  String[Length] = '\0';
+}
+
+STATIC
+VOID
+FillUnicode (
+  OUT CHAR16  *String,
+  IN  UINTN   Length,
+  IN  UINT32  Seed
+  )
+{
+  STATIC CONST CHAR16  Alphabet[] = { L'a', L'B', L'c', L'D', L'[', 0x430, 0xFF41 };
+  UINTN                Index;
+
+  for (Index = 0; Index < Length; ++Index) {
+    Seed = Seed * 1103515245U + 12345U;
+    String[Index] = Alphabet[(Seed >> 16) % ARRAY_SIZE (Alphabet)];
+  }
+
+  String[Length] = L'\0';
+}
+
+/**
+  Compare vector and portable primitives at the given addresses.
+**/
+STATIC
+BOOLEAN
+CheckAscii (
+  IN CHAR8  *First,
+  IN CHAR8  *Second,
+  IN UINTN  Length,
+  IN UINT32 Seed
+  )
+{
+  CHAR8  *Needle;
+
+  FillAscii (First, Length, Seed);
+  CopyMem (Second, First, Length + 1);
+  if (Length > 0) {
+    Second[Seed % Length] ^= (Seed & 1) != 0 ? 0x01 : 0x00;
+  }
+
+  if (InternalAsciiStrLenSse2 (First) != InternalAsciiStrLenGeneric (First)) {
+    printf ("AsciiStrLen mismatch at %u\n", (unsigned) Length);
+    return FALSE;
+  }
+
+  if (InternalAsciiStrCmpSse2 (First, Second) != InternalAsciiStrCmpGeneric (First, Second)
+    || InternalAsciiStrCmpSse2 (Second, First) != InternalAsciiStrCmpGeneric (Second, First)) {
+    printf ("AsciiStrCmp mismatch at %u\n", (unsigned) Length);
+    return FALSE;
+  }
+
+  Needle = Length > 3 ? &Second[Length - 3] : Second;
+  if (InternalAsciiStrStrSse2 (First, Needle) != InternalAsciiStrStrGeneric (First, Needle)
+    || InternalAsciiStrStrSse2 (First, "") != InternalAsciiStrStrGeneric (First, "")
+    || InternalAsciiStrStrSse2 (First, "dddd") != InternalAsciiStrStrGeneric (First, "dddd")) {
+    printf ("AsciiStrStr mismatch at %u\n", (unsigned) Length);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+CheckUnicode (
+  IN CHAR16  *First,
+  IN CHAR16  *Second,
+  IN UINTN   Length,
+  IN UINT32  Seed
+  )
+{
+  UINTN  Limit;
+
+  FillUnicode (First, Length, Seed);
+  CopyMem (Second, First, (Length + 1) * sizeof (CHAR16));
+  if (Length > 0) {
+    Second[Seed % Length] = CharToUpper (Second[Seed % Length]) ^ ((Seed & 2) != 0 ? 0x01 : 0x00);
+  }
+
+  if (InternalStrLenSse2 (First) != InternalStrLenGeneric (First)) {
+    printf ("StrLen mismatch at %u\n", (unsigned) Length);
+    return FALSE;
+  }
+
+  if (InternalStriCmpSse2 (First, Second) != InternalStriCmpGeneric (First, Second)
+    || InternalStriCmpSse2 (Second, First) != InternalStriCmpGeneric (Second, First)) {
+    printf ("StriCmp mismatch at %u\n", (unsigned) Length);
+    return FALSE;
+  }
+
+  for (Limit = 0; Limit <= Length + 1; Limit += 1 + Limit / 4) {
+    if (InternalStrniCmpSse2 (First, Second, Limit) != InternalStrniCmpGeneric (First, Second, Limit)) {
+      printf ("StrniCmp mismatch at %u/%u\n", (unsigned) Length, (unsigned) Limit);
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+STATIC
+BOOLEAN
+RunChecks (
+  VOID
+  )
+{
+  UINT8   *Pages;
+  UINT8   *Buffer;
+  UINTN   PageSize;
+  UINTN   Length;
+  UINTN   Offset;
+  UINT32  Seed;
+
+  Buffer = malloc (4096);
+  if (Buffer == NULL) {
+    return FALSE;
+  }
+
+  Seed = 1;
+  for (Length = 0; Length < 300; ++Length) {
+    for (Offset = 0; Offset < 16; ++Offset) {
+      ++Seed;
+      if (!CheckAscii ((CHAR8 *) Buffer + Offset, (CHAR8 *) Buffer + 1024 + (Seed % 16), Length, Seed)) {
+        free (Buffer);
+        return FALSE;
+      }
+
+      if (!CheckUnicode (
+        (CHAR16 *) (Buffer + 2048) + Offset,
+        (CHAR16 *) (Buffer + 3072 - 256) + (Seed % 8),
+        Length / 2,
+        Seed
+        )) {
+        free (Buffer);
+        return FALSE;
+      }
+    }
+  }
+
+  free (Buffer);
+
+  //
+  // Strings ending right before an inaccessible page must not fault.
+  //
+  PageSize = (UINTN) sysconf (_SC_PAGESIZE);
+  Pages    = mmap (NULL, PageSize * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Pages == MAP_FAILED || mprotect (Pages + PageSize, PageSize, PROT_NONE) != 0) {
+    return FALSE;
+  }
+
+  for (Length = 0; Length < 64; ++Length) {
+    ++Seed;
+    if (!CheckAscii (
+      (CHAR8 *) Pages + PageSize - Length - 1,
+      (CHAR8 *) Pages + PageSize / 2 - Length - 1 + (Seed % 32),
+      Length,
+      Seed
+      )) {
+      munmap (Pages, PageSize * 2);
+      return FALSE;
+    }
+
+    if (!CheckUnicode (
+      (CHAR16 *) (Pages + PageSize) - Length - 1,
+      (CHAR16 *) (Pages + PageSize / 2) - Length - 1 + (Seed % 16),
+      Length,
+      Seed
+      )) {
+      munmap (Pages, PageSize * 2);
+      return FALSE;
+    }
+  }
+
+  munmap (Pages, PageSize * 2);
+
+  return Sign (StriCmp (L"\\EFI\\BOOT", L"\\efi\\boot")) == 0
+    && Sign (StrniCmp (L"\\System\\Library", L"\\SYSTEM\\Other", 8)) == 0
+    && OcAsciiStrLen ("kext") == 4
+    && OcStrLen (L"kext") == 4
+    && OcAsciiStrCmp ("__ZN", "__ZN") == 0
+    && OcAsciiStrStr ("keepsyms=1 -v debug=0x100", "-v") != NULL;
+}
+
+STATIC volatile UINTN  mSink;
+
+#define BENCH(Name, Size, Generic, Vector)                                     \
+  do {                                                                          \
+    uint64_t  Start;                                                            \
+    uint64_t  GenericNs;                                                        \
+    uint64_t  VectorNs;                                                         \
+    UINT32    Iteration;                                                        \
+    Start = TimeNs ();                                                          \
+    for (Iteration = 0; Iteration < Iterations; ++Iteration) {                  \
+      mSink += (UINTN) (Generic);                                               \
+    }                                                                           \
+    GenericNs = MAX (TimeNs () - Start, 1);                                     \
+    Start = TimeNs ();                                                          \
+    for (Iteration = 0; Iteration < Iterations; ++Iteration) {                  \
+      mSink += (UINTN) (Vector);                                                \
+    }                                                                           \
+    VectorNs = MAX (TimeNs () - Start, 1);                                      \
+    printf (                                                                    \
+      "%-12s %6u chars %10.2f ns/call generic %10.2f ns/call sse2 %6.2fx\n",   \
+      Name,                                                                     \
+      (unsigned) (Size),                                                        \
+      (double) GenericNs / Iterations,                                          \
+      (double) VectorNs / Iterations,                                           \
+      (double) GenericNs / (double) VectorNs                                    \
+      );                                                                        \
+  } while (0)
+
+int main(int argc, char** argv) {
+  UINT32  Iterations;
+  UINT32  Length;
+  CHAR8   *AsciiFirst;
+  CHAR8   *AsciiSecond;
+  CHAR16  *UnicodeFirst;
+  CHAR16  *UnicodeSecond;
+  UINTN   Index;
+
+  Iterations = argc > 1 ? (UINT32) strtoul (argv[1], NULL, 0) : 1000000;
+  Length     = argc > 2 ? (UINT32) strtoul (argv[2], NULL, 0) : 64;
+  if (Iterations == 0 || Length < 4) {
+    printf ("Invalid arguments\n");
+    return -1;
+  }
+
+  if (!RunChecks ()) {
+    printf ("Checks failed\n");
+    return -1;
+  }
+
+  printf ("Checks passed\n");
+
+  AsciiFirst    = malloc (Length + 1);
+  AsciiSecond   = malloc (Length + 1);
+  UnicodeFirst  = malloc ((Length + 1) * sizeof (CHAR16));
+  UnicodeSecond = malloc ((Length + 1) * sizeof (CHAR16));
+  if (AsciiFirst == NULL || AsciiSecond == NULL || UnicodeFirst == NULL || UnicodeSecond == NULL) {
+    return -1;
+  }
+
+  //
+  // Implementations are timed directly, as public wrappers also run ASSERTs.
+  // Strings only differ in the last character or in case, and the needle is
+  // absent, so every primitive has to scan the whole string.
+  //
+  for (Index = 0; Index < Length; ++Index) {
+    AsciiFirst[Index]    = (CHAR8) ('a' + Index % 3);
+    UnicodeFirst[Index]  = (CHAR16) (L'a' + Index % 26);
+    UnicodeSecond[Index] = (CHAR16) (L'A' + Index % 26);
+  }
+
+  AsciiFirst[Length - 1]    = 'z';
+  AsciiFirst[Length]        = '\0';
+  UnicodeFirst[Length]      = L'\0';
+  UnicodeSecond[Length]     = L'\0';
+  CopyMem (AsciiSecond, AsciiFirst, Length + 1);
+  AsciiSecond[Length - 1]   = 'y';
+
+  BENCH ("AsciiStrLen", Length, InternalAsciiStrLenGeneric (AsciiFirst), InternalAsciiStrLenSse2 (AsciiFirst));
+  BENCH ("AsciiStrCmp", Length, InternalAsciiStrCmpGeneric (AsciiFirst, AsciiSecond), InternalAsciiStrCmpSse2 (AsciiFirst, AsciiSecond));
+  BENCH ("AsciiStrStr", Length, InternalAsciiStrStrGeneric (AsciiFirst, "z-"), InternalAsciiStrStrSse2 (AsciiFirst, "z-"));
+  BENCH ("StrLen", Length, InternalStrLenGeneric (UnicodeFirst), InternalStrLenSse2 (UnicodeFirst));
+  BENCH ("StriCmp", Length, InternalStriCmpGeneric (UnicodeFirst, UnicodeSecond), InternalStriCmpSse2 (UnicodeFirst, UnicodeSecond));
+  BENCH ("StrniCmp", Length, InternalStrniCmpGeneric (UnicodeFirst, UnicodeSecond, Length), InternalStrniCmpSse2 (UnicodeFirst, UnicodeSecond, Length));
+
+  free (AsciiFirst);
+  free (AsciiSecond);
+  free (UnicodeFirst);
+  free (UnicodeSecond);
+
+  return 0;
+}
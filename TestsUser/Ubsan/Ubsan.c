@@ -0,0 +1,156 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcGuardLib.h>
+
+#include <sys/time.h>
+
+/*
+ clang -g -O2 -fshort-wchar -fsanitize=shift -fno-sanitize-link-runtime -DMDEPKG_NDEBUG -I../Include -I../../Include -I../../../MdePkg/Include/ -include ../Include/Base.h Ubsan.c ../../Library/OcGuardLib/Ubsan.c ../../Library/OcGuardLib/UbsanPrintf.c ../../Library/OcGuardLib/UbsanReport.c -o Ubsan
+
+ ./Ubsan [iterations]
+
+ UBSan runtime from OcGuardLib replaces the compiler one, so only the test
+ itself is to be instrumented and the compiler runtime must not be linked.
+
+ rm -rf Ubsan.dSYM Ubsan
+*/
+
+EFI_STATUS
+EFIAPI
+OcGuardLibConstructor (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  );
+
+STATIC CHAR8  mOutput[16384];
+STATIC UINTN  mOutputSize;
+
+UINTN
+EFIAPI
+AsciiPrint (
+  IN CONST CHAR8  *Format,
+  ...
+  )
+{
+  VA_LIST      Args;
+  CONST CHAR8  *String;
+  UINTN        Length;
+
+  //
+  // UBSan runtime only prints preformatted strings.
+  //
+  VA_START (Args, Format);
+  String = VA_ARG (Args, CONST CHAR8 *);
+  VA_END (Args);
+
+  Length = strlen (String);
+  if (Length < sizeof (mOutput) - mOutputSize) {
+    memcpy (&mOutput[mOutputSize], String, Length + 1);
+    mOutputSize += Length;
+  }
+
+  fputs (String, stdout);
+  return Length;
+}
+
+STATIC
+uint64_t
+TimeNs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return ((uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec) * 1000ULL;
+}
+
+STATIC volatile UINT32  mShift;
+
+STATIC
+UINT32
+ShiftLoop (
+  IN UINT32  Iterations
+  )
+{
+  UINT32  Index;
+  UINT32  Sum;
+
+  Sum = 0;
+  for (Index = 0; Index < Iterations; ++Index) {
+    Sum += Index << mShift;
+  }
+
+  return Sum;
+}
+
+int main(int argc, char** argv) {
+  UINT32    Iterations;
+  uint64_t  Start;
+  uint64_t  CleanNs;
+  uint64_t  FaultingNs;
+  CHAR8     Expected[64];
+  volatile UINT32  Sink;
+
+  Iterations = argc > 1 ? (UINT32) strtoul (argv[1], NULL, 0) : 10000000;
+  if (Iterations == 0) {
+    printf ("Invalid arguments\n");
+    return -1;
+  }
+
+  //
+  // Library constructors are not run in userspace.
+  //
+  OcGuardLibConstructor (NULL, NULL);
+
+  //
+  // Every iteration of the faulting loop fails the shift check at the same
+  // location, and only the first one is to produce a report.
+  //
+  mShift  = 1;
+  Start   = TimeNs ();
+  Sink    = ShiftLoop (Iterations);
+  CleanNs = MAX (TimeNs () - Start, 1);
+
+  mShift     = 40;
+  Start      = TimeNs ();
+  Sink       = ShiftLoop (Iterations);
+  FaultingNs = MAX (TimeNs () - Start, 1);
+  (VOID) Sink;
+
+  if (mOutputSize != 0) {
+    printf ("Non-fatal reports are expected to be queued\n");
+    return -1;
+  }
+
+  OcUbsanDumpReports ();
+
+  snprintf (Expected, sizeof (Expected), " failed %u time(s)\n", Iterations);
+  if (strstr (mOutput, "shift exponent 40 is too large") == NULL
+    || strstr (mOutput, "UBSan: 1 report(s) from 1 location(s)\n") == NULL
+    || strstr (mOutput, Expected) == NULL) {
+    printf ("Unexpected summary\n");
+    return -1;
+  }
+
+  printf (
+    "%u iterations: %.2f ns/iteration clean, %.2f ns/iteration faulting, %.2fx overhead\n",
+    Iterations,
+    (double) CleanNs / Iterations,
+    (double) FaultingNs / Iterations,
+    (double) FaultingNs / (double) CleanNs
+    );
+
+  return 0;
+}
@@ -0,0 +1,270 @@
+/** @file
+  Copyright (C) 2019, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Protocol/UnicodeCollation.h>
+
+#include <OcUnicodeCollationEngLibInternal.h>
+
+#include <sys/time.h>
+
+/*
+ clang -g -O2 -fshort-wchar -fsanitize=undefined,address -I../Include -I../../Include -I../../Library/OcUnicodeCollationEngLib -I../../../MdePkg/Include/ -I../../../EfiPkg/Include/ -include ../Include/Base.h UnicodeCollation.c ../../Library/OcUnicodeCollationEngLib/OcUnicodeCollationEngLib.c -o UnicodeCollation
+
+ ./UnicodeCollation [iterations]
+
+ rm -rf UnicodeCollation.dSYM UnicodeCollation
+*/
+
+EFI_GUID gEfiGlobalVariableGuid;
+EFI_GUID gEfiUnicodeCollation2ProtocolGuid;
+
+_Thread_local uint32_t externalUsedPages = 0;
+_Thread_local uint8_t externalBlob[EFI_PAGE_SIZE*TOTAL_PAGES];
+
+EFI_STATUS
+GetVariable2 (
+  IN  CONST CHAR16    *Name,
+  IN  CONST EFI_GUID  *Guid,
+  OUT VOID            **Value,
+  OUT UINTN           *Size OPTIONAL
+  )
+{
+  return EFI_NOT_FOUND;
+}
+
+EFI_STATUS
+UninstallAllProtocolInstances (
+  EFI_GUID  *Protocol
+  )
+{
+  return EFI_SUCCESS;
+}
+
+//
+// Recursive matcher equivalent to the original EDK II implementation,
+// used as a reference for well-formed patterns.
+//
+STATIC
+BOOLEAN
+ReferenceMatch (
+  IN CONST CHAR16  *String,
+  IN CONST CHAR16  *Pattern
+  )
+{
+  CHAR16  CharP;
+
+  for (;;) {
+    CharP = *Pattern++;
+
+    switch (CharP) {
+      case 0:
+        return *String == 0;
+
+      case '*':
+        while (*String != 0) {
+          if (ReferenceMatch (String, Pattern)) {
+            return TRUE;
+          }
+          String += 1;
+        }
+        return ReferenceMatch (String, Pattern);
+
+      case '?':
+        if (*String == 0) {
+          return FALSE;
+        }
+        String += 1;
+        break;
+
+      default:
+        if (TO_UPPER (*String) != TO_UPPER (CharP)) {
+          return FALSE;
+        }
+        String += 1;
+        break;
+    }
+  }
+}
+
+STATIC
+VOID
+AsciiToUnicode (
+  IN  CONST CHAR8  *Ascii,
+  OUT CHAR16       *Unicode
+  )
+{
+  while (*Ascii != '\0') {
+    *Unicode++ = (CHAR16) *Ascii++;
+  }
+  *Unicode = 0;
+}
+
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+STATIC
+int
+CheckMatch (
+  IN CONST CHAR8  *String,
+  IN CONST CHAR8  *Pattern,
+  IN BOOLEAN      Expected
+  )
+{
+  CHAR16   UnicodeString[256];
+  CHAR16   UnicodePattern[256];
+  BOOLEAN  Result;
+
+  AsciiToUnicode (String, UnicodeString);
+  AsciiToUnicode (Pattern, UnicodePattern);
+
+  Result = EngMetaiMatch (NULL, UnicodeString, UnicodePattern);
+  if (Result != Expected) {
+    printf ("FAIL: \"%s\" vs \"%s\" - %d, expected %d\n", String, Pattern, Result, Expected);
+    return 1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  STATIC CONST CHAR8 Alphabet[] = "aAbB";
+  CHAR16    String[64];
+  CHAR16    Pattern[64];
+  CHAR16    *Long;
+  CHAR16    *Adversarial;
+  UINTN     Index;
+  UINTN     Index2;
+  UINTN     Length;
+  UINTN     Iterations;
+  int       Failures;
+  uint64_t  Start;
+
+  if (EFI_ERROR (InternalInitializeEngTables ())) {
+    printf ("Table init fail\n");
+    return -1;
+  }
+
+  Iterations = argc > 1 ? strtoul (argv[1], NULL, 0) : 100000;
+  Failures   = 0;
+
+  Failures += CheckMatch ("BOOTX64.EFI", "*.efi", TRUE);
+  Failures += CheckMatch ("boot.efi", "B?OT.*", TRUE);
+  Failures += CheckMatch ("boot.efi", "[a-c]oot.efi", TRUE);
+  Failures += CheckMatch ("Boot.efi", "[xyzb]oot.efi", TRUE);
+  Failures += CheckMatch ("doot.efi", "[a-c]oot.efi", FALSE);
+  Failures += CheckMatch ("boot.efi", "[a-c", FALSE);
+  Failures += CheckMatch ("boot.efi", "*[a-c", FALSE);
+  Failures += CheckMatch ("", "*", TRUE);
+  Failures += CheckMatch ("", "?", FALSE);
+  Failures += CheckMatch ("abc", "a**c", TRUE);
+  Failures += CheckMatch ("abcabcabd", "*abd", TRUE);
+  Failures += CheckMatch ("abcabcabd", "*abc", FALSE);
+
+  //
+  // Compare against the recursive reference on random short inputs.
+  //
+  srand (0);
+  for (Index = 0; Index < Iterations; ++Index) {
+    Length = (UINTN) rand () % 12;
+    for (Index2 = 0; Index2 < Length; ++Index2) {
+      String[Index2] = Alphabet[rand () % 4];
+    }
+    String[Length] = 0;
+
+    Length = (UINTN) rand () % 8;
+    for (Index2 = 0; Index2 < Length; ++Index2) {
+      switch (rand () % 6) {
+        case 0:
+          Pattern[Index2] = '*';
+          break;
+        case 1:
+          Pattern[Index2] = '?';
+          break;
+        default:
+          Pattern[Index2] = Alphabet[rand () % 4];
+          break;
+      }
+    }
+    Pattern[Length] = 0;
+
+    if (EngMetaiMatch (NULL, String, Pattern) != ReferenceMatch (String, Pattern)) {
+      printf ("FAIL: random mismatch at %u\n", (unsigned) Index);
+      ++Failures;
+      break;
+    }
+  }
+
+  //
+  // Adversarial patterns taking exponential time with recursive matching.
+  //
+  Length      = 4096;
+  Long        = AllocatePool ((Length + 1) * sizeof (CHAR16));
+  Adversarial = AllocatePool (128 * sizeof (CHAR16));
+  if (Long == NULL || Adversarial == NULL) {
+    printf ("Alloc fail\n");
+    return -1;
+  }
+
+  for (Index = 0; Index < Length; ++Index) {
+    Long[Index] = 'a';
+  }
+  Long[Length] = 0;
+
+  for (Index = 0; Index < 60; Index += 2) {
+    Adversarial[Index]     = '*';
+    Adversarial[Index + 1] = 'a';
+  }
+  Adversarial[Index++] = 'b';
+  Adversarial[Index]   = 0;
+
+  Start = TimeUs ();
+  for (Index = 0; Index < 100; ++Index) {
+    if (EngMetaiMatch (NULL, Long, Adversarial)) {
+      printf ("FAIL: adversarial match\n");
+      ++Failures;
+      break;
+    }
+  }
+  printf ("Adversarial (*a)^30b vs a^%u: %llu us per match\n",
+    (unsigned) Length, (unsigned long long) ((TimeUs () - Start) / 100));
+
+  //
+  // Replace trailing 'b' with '*' to get a matching pattern.
+  //
+  Adversarial[60] = '*';
+  Start = TimeUs ();
+  for (Index = 0; Index < 100; ++Index) {
+    if (!EngMetaiMatch (NULL, Long, Adversarial)) {
+      printf ("FAIL: adversarial mismatch\n");
+      ++Failures;
+      break;
+    }
+  }
+  printf ("Adversarial (*a)^30* vs a^%u: %llu us per match\n",
+    (unsigned) Length, (unsigned long long) ((TimeUs () - Start) / 100));
+
+  FreePool (Long);
+  FreePool (Adversarial);
+
+  printf ("%s (%d failures)\n", Failures == 0 ? "PASS" : "FAIL", Failures);
+  return Failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,363 @@
+/** @file
+
+AppleEfiSignTool – Tool for signing and verifying Apple EFI binaries.
+
+Copyright (c) 2018, savvas
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "AppleEfiPeImage.h"
+
+#define BATCH_MAX_THREADS 256
+
+typedef enum BATCH_STATUS_ {
+  BatchStatusVerified,
+  BatchStatusInvalid,
+  BatchStatusError
+} BATCH_STATUS;
+
+typedef struct BATCH_ENTRY_ {
+  char         *Path;
+  BATCH_STATUS Status;
+  uint64_t     Size;
+  uint64_t     Microseconds;
+} BATCH_ENTRY;
+
+static BATCH_ENTRY *BatchEntries   = NULL;
+static size_t      BatchCount      = 0;
+static size_t      BatchCapacity   = 0;
+static size_t      BatchNext       = 0;
+
+static const char *BatchStatusNames[] = {
+  "verified",
+  "invalid",
+  "error"
+};
+
+static
+uint64_t
+GetTimeUs (
+  void
+  )
+{
+  struct timespec Ts;
+  clock_gettime (CLOCK_MONOTONIC, &Ts);
+  return (uint64_t) Ts.tv_sec * 1000000ULL + (uint64_t) Ts.tv_nsec / 1000ULL;
+}
+
+static
+int
+AddBatchPath (
+  const char *Path
+  )
+{
+  BATCH_ENTRY *NewEntries;
+  size_t      NewCapacity;
+
+  if (BatchCount == BatchCapacity) {
+    NewCapacity = BatchCapacity == 0 ? 256 : BatchCapacity * 2;
+    NewEntries  = realloc (BatchEntries, NewCapacity * sizeof (BATCH_ENTRY));
+    if (NewEntries == NULL) {
+      fprintf (stderr, "Batch list allocation failure\n");
+      return -1;
+    }
+    BatchEntries  = NewEntries;
+    BatchCapacity = NewCapacity;
+  }
+
+  memset (&BatchEntries[BatchCount], 0, sizeof (BATCH_ENTRY));
+  BatchEntries[BatchCount].Path = strdup (Path);
+  if (BatchEntries[BatchCount].Path == NULL) {
+    fprintf (stderr, "Batch list allocation failure\n");
+    return -1;
+  }
+
+  BatchCount++;
+  return 0;
+}
+
+/**
+  Queue every regular file found under the directory for verification.
+**/
+int
+AddBatchDirectory (
+  const char *Path
+  )
+{
+  DIR            *Dir;
+  struct dirent  *Entry;
+  struct stat    Stat;
+  char           *EntryPath;
+  int            Status = 0;
+
+  Dir = opendir (Path);
+  if (Dir == NULL) {
+    fprintf (stderr, "Failed to open %s, errno = %d\n", Path, errno);
+    return -1;
+  }
+
+  while (Status == 0 && (Entry = readdir (Dir)) != NULL) {
+    if (strcmp (Entry->d_name, ".") == 0 || strcmp (Entry->d_name, "..") == 0) {
+      continue;
+    }
+
+    EntryPath = malloc (strlen (Path) + strlen (Entry->d_name) + 2);
+    if (EntryPath == NULL) {
+      Status = -1;
+      break;
+    }
+    sprintf (EntryPath, "%s/%s", Path, Entry->d_name);
+
+    //
+    // Symbolic links are not followed to avoid walking loops
+    //
+    if (lstat (EntryPath, &Stat) == 0) {
+      if (S_ISDIR (Stat.st_mode)) {
+        Status = AddBatchDirectory (EntryPath);
+      } else if (S_ISREG (Stat.st_mode)) {
+        Status = AddBatchPath (EntryPath);
+      }
+    }
+
+    free (EntryPath);
+  }
+
+  closedir (Dir);
+  return Status;
+}
+
+/**
+  Queue every file listed in the list file (one path per line, "-" for
+  stdin) for verification.
+**/
+int
+AddBatchList (
+  const char *Path
+  )
+{
+  FILE    *ListFp;
+  char    *Line     = NULL;
+  size_t  LineSize  = 0;
+  ssize_t Length;
+  int     Status    = 0;
+
+  ListFp = strcmp (Path, "-") == 0 ? stdin : fopen (Path, "r");
+  if (ListFp == NULL) {
+    fprintf (stderr, "File not exist, errno = %d\n", errno);
+    return -1;
+  }
+
+  while ((Length = getline (&Line, &LineSize, ListFp)) != -1) {
+    while (Length > 0 && (Line[Length - 1] == '\n' || Line[Length - 1] == '\r')) {
+      Line[--Length] = '\0';
+    }
+
+    if (Length > 0 && AddBatchPath (Line) != 0) {
+      Status = -1;
+      break;
+    }
+  }
+
+  free (Line);
+  if (ListFp != stdin) {
+    fclose (ListFp);
+  }
+
+  return Status;
+}
+
+/**
+  Map the file privately, so that the verifier may treat it as its own buffer,
+  and verify every slice of it.
+**/
+static
+BATCH_STATUS
+VerifyBatchFile (
+  BATCH_ENTRY *Entry
+  )
+{
+  struct stat  Stat;
+  uint8_t      *Image;
+  int          Fd;
+  BATCH_STATUS Status;
+
+  Fd = open (Entry->Path, O_RDONLY);
+  if (Fd < 0) {
+    return BatchStatusError;
+  }
+
+  if (fstat (Fd, &Stat) != 0 || Stat.st_size <= 0 || (uint64_t) Stat.st_size > UINT32_MAX) {
+    close (Fd);
+    return BatchStatusError;
+  }
+
+  Entry->Size = (uint64_t) Stat.st_size;
+
+  Image = mmap (NULL, (size_t) Entry->Size, PROT_READ | PROT_WRITE, MAP_PRIVATE, Fd, 0);
+  close (Fd);
+  if (Image == MAP_FAILED) {
+    return BatchStatusError;
+  }
+
+  if (VerifyAppleImageSignature (Image, (uint32_t) Entry->Size) == 0) {
+    Status = BatchStatusVerified;
+  } else {
+    Status = BatchStatusInvalid;
+  }
+
+  munmap (Image, (size_t) Entry->Size);
+  return Status;
+}
+
+/**
+  Verify one queued file and record the time spent, failed files included.
+**/
+static
+void
+VerifyBatchEntry (
+  BATCH_ENTRY *Entry
+  )
+{
+  uint64_t Start;
+
+  Start               = GetTimeUs ();
+  Entry->Status       = VerifyBatchFile (Entry);
+  Entry->Microseconds = GetTimeUs () - Start;
+}
+
+static
+void *
+BatchWorker (
+  void *Arg
+  )
+{
+  size_t Index;
+
+  (void) Arg;
+
+  while ((Index = __atomic_fetch_add (&BatchNext, 1, __ATOMIC_RELAXED)) < BatchCount) {
+    VerifyBatchEntry (&BatchEntries[Index]);
+  }
+
+  return NULL;
+}
+
+static
+void
+PrintJsonString (
+  const char *String
+  )
+{
+  putchar ('"');
+  for (; *String != '\0'; String++) {
+    if (*String == '"' || *String == '\\') {
+      printf ("\\%c", *String);
+    } else if ((unsigned char) *String < 0x20) {
+      printf ("\\u%04x", (unsigned char) *String);
+    } else {
+      putchar (*String);
+    }
+  }
+  putchar ('"');
+}
+
+/**
+  Verify all queued files in a pool of worker threads. Every file produces
+  one JSON line on stdout in queue order, the summary is a JSON line on stderr.
+**/
+int
+VerifyAppleImageBatch (
+  unsigned NumThreads
+  )
+{
+  pthread_t Threads[BATCH_MAX_THREADS];
+  unsigned  Started;
+  size_t    Index;
+  size_t    Counts[3] = {0, 0, 0};
+  uint64_t  Bytes     = 0;
+  uint64_t  Start;
+  double    Seconds;
+
+  if (NumThreads == 0) {
+    NumThreads = 1;
+  } else if (NumThreads > BATCH_MAX_THREADS) {
+    NumThreads = BATCH_MAX_THREADS;
+  }
+
+  Start = GetTimeUs ();
+
+  for (Started = 0; Started < NumThreads - 1; Started++) {
+    if (pthread_create (&Threads[Started], NULL, BatchWorker, NULL) != 0) {
+      break;
+    }
+  }
+
+  //
+  // The calling thread is a worker too, this also covers thread creation failure
+  //
+  BatchWorker (NULL);
+
+  for (unsigned i = 0; i < Started; i++) {
+    pthread_join (Threads[i], NULL);
+  }
+
+  Seconds = (double) (GetTimeUs () - Start) / 1000000.0;
+  if (Seconds <= 0) {
+    Seconds = 1e-6;
+  }
+
+  for (Index = 0; Index < BatchCount; Index++) {
+    printf ("{\"file\":");
+    PrintJsonString (BatchEntries[Index].Path);
+    printf (
+      ",\"status\":\"%s\",\"size\":%llu,\"time_us\":%llu}\n",
+      BatchStatusNames[BatchEntries[Index].Status],
+      (unsigned long long) BatchEntries[Index].Size,
+      (unsigned long long) BatchEntries[Index].Microseconds
+      );
+
+    Counts[BatchEntries[Index].Status]++;
+    Bytes += BatchEntries[Index].Size;
+    free (BatchEntries[Index].Path);
+  }
+
+  fprintf (
+    stderr,
+    "{\"files\":%zu,\"verified\":%zu,\"invalid\":%zu,\"errors\":%zu,"
+    "\"bytes\":%llu,\"threads\":%u,\"seconds\":%.3f,"
+    "\"files_per_second\":%.1f,\"mb_per_second\":%.1f}\n",
+    BatchCount,
+    Counts[BatchStatusVerified],
+    Counts[BatchStatusInvalid],
+    Counts[BatchStatusError],
+    (unsigned long long) Bytes,
+    Started + 1,
+    Seconds,
+    (double) BatchCount / Seconds,
+    (double) Bytes / Seconds / (1024.0 * 1024.0)
+    );
+
+  free (BatchEntries);
+  BatchEntries  = NULL;
+  BatchCapacity = 0;
+
+  return Counts[BatchStatusVerified] == BatchCount ? 0 : -1;
+}
@@ -22,11 +22,13 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 #include <Library/OcAppleKeysLib.h>
 
 #ifndef NDEBUG
-# define DEBUG_PRINT(x) printf x
+# define DEBUG_PRINT(x) do { if (VerboseOutput) printf x; } while (0)
 #else
 # define DEBUG_PRINT(x) do {} while (0)
 #endif
 
+int VerboseOutput = 1;
+
 int
 BuildPeContext (
   void                                *Image,
@@ -395,6 +397,49 @@ GetApplePeImageSha256 (
   return 0;
 }
 
+/**
+  Lookup public key in PkDataBase by the hash of its modulus.
+  Batch mode verifies thousands of images signed with the same few keys,
+  so the last match of every thread is remembered and compared first.
+**/
+const OC_RSA_PUBLIC_KEY *
+FindApplePublicKey (
+  const uint8_t  *PkLe
+  )
+{
+  static _Thread_local uint8_t                  CachedPkLe[256];
+  static _Thread_local const OC_RSA_PUBLIC_KEY  *CachedPk = NULL;
+  uint8_t                                       PkHash[32];
+  SHA256_CONTEXT                                Sha256Ctx;
+
+  if (CachedPk != NULL && memcmp (CachedPkLe, PkLe, sizeof (CachedPkLe)) == 0) {
+    return CachedPk;
+  }
+
+  //
+  // Calculate Sha256 of extracted public key
+  //
+  Sha256Init (&Sha256Ctx);
+  Sha256Update (&Sha256Ctx, PkLe, sizeof (CachedPkLe));
+  Sha256Final (&Sha256Ctx, PkHash);
+
+  //
+  // Verify existence in DataBase
+  //
+  for (int Index = 0; Index < NUM_OF_PK; Index++) {
+    if (memcmp (PkDataBase[Index].Hash, PkHash, sizeof (PkHash)) == 0) {
+      //
+      // PublicKey valid. Remember prepared publickey from database
+      //
+      memcpy (CachedPkLe, PkLe, sizeof (CachedPkLe));
+      CachedPk = PkDataBase[Index].PublicKey;
+      return CachedPk;
+    }
+  }
+
+  return NULL;
+}
+
 int
 VerifyApplePeImageSignature (
   void     *PeImage,
@@ -406,7 +451,6 @@ VerifyApplePeImageSignature (
   uint8_t                            SigLe[256];
   uint8_t                            SigBe[256];
   uint8_t                            CalcucatedHash[32];
-  uint8_t                            PkHash[32];
   const OC_RSA_PUBLIC_KEY            *Pk                      = NULL;
   APPLE_PE_COFF_LOADER_IMAGE_CONTEXT *Context                 = NULL;
 
@@ -443,24 +487,9 @@ VerifyApplePeImageSignature (
   free (Context);
 
   //
-  // Calculate Sha256 of extracted public key
+  // Lookup extracted public key in DataBase
   //
-  SHA256_CONTEXT Sha256Ctx;
-  Sha256Init (&Sha256Ctx);
-  Sha256Update (&Sha256Ctx, PkLe, sizeof (PkLe));
-  Sha256Final (&Sha256Ctx, PkHash);
-
-  //
-  // Verify existence in DataBase
-  //
-  for (int Index = 0; Index < NUM_OF_PK; Index++) {
-    if (memcmp (PkDataBase[Index].Hash, PkHash, sizeof (PkHash)) == 0) {
-      //
-      // PublicKey valid. Extract prepared publickey from database
-      //
-      Pk = PkDataBase[Index].PublicKey;
-    }
-  }
+  Pk = FindApplePublicKey (PkLe);
 
   if (Pk == NULL) {
     DEBUG_PRINT (("Unknown publickey or malformed AppleSignature directory!\n"));
@@ -471,7 +500,6 @@ VerifyApplePeImageSignature (
   // Verify signature
   //
   if (RsaVerifySigHashFromKey (Pk, SigBe, sizeof (SigBe), CalcucatedHash, sizeof (CalcucatedHash), OcSigHashTypeSha256) == 1 ) {
-    puts ("Signature verified!\n");
     return 0;
   }
 
@@ -60,6 +60,11 @@ typedef struct APPLE_SIGNATURE_DIRECTORY_ {
 
 #define APPLE_SIGNATURE_SECENTRY_SIZE 8
 
+//
+// Print diagnostics while verifying, batch mode only enables them with -v
+//
+extern int VerboseOutput;
+
 //
 // Function prototypes
 //
@@ -87,6 +92,11 @@ GetApplePeImageSha256 (
   uint8_t                             *CalcucatedHash
   );
 
+const OC_RSA_PUBLIC_KEY *
+FindApplePublicKey (
+  const uint8_t  *PkLe
+  );
+
 int
 VerifyApplePeImageSignature (
   void     *PeImage,
@@ -99,5 +109,20 @@ VerifyAppleImageSignature (
   uint32_t ImageSize
   );
 
+int
+AddBatchDirectory (
+  const char *Path
+  );
+
+int
+AddBatchList (
+  const char *Path
+  );
+
+int
+VerifyAppleImageBatch (
+  unsigned NumThreads
+  );
+
 
 #endif //APPLE_EFI_PE_IMAGE_H
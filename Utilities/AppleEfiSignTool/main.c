@@ -29,12 +29,21 @@ WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
 static uint8_t *Image      = NULL;
 static uint32_t ImageSize  = 0;
 
+static int      BatchMode  = 0;
+static unsigned BatchJobs  = 0;
+
 static char UsageBanner[] = "AppleEfiSignTool v1.0 – Tool for signing and verifying\n"
                             "Apple EFI binaries. It supports PE and Fat binaries.\n"
                             "Usage:\n"
                             "  -i : input file\n"
+                            "  -d : batch mode, verify all files in directory\n"
+                            "  -l : batch mode, verify all files in list file (- for stdin)\n"
+                            "  -j : batch mode worker threads (defaults to CPU count)\n"
+                            "  -v : batch mode verbose output\n"
                             "  -h : show this text\n"
-                            "Example: ./AppleEfiSignTool -i apfs.efi\n";
+                            "Batch mode prints one JSON line per file and a JSON summary to stderr.\n"
+                            "Example: ./AppleEfiSignTool -i apfs.efi\n"
+                            "         ./AppleEfiSignTool -d Samples -j 8\n";
 
 
 void
@@ -72,8 +81,30 @@ main (
     exit(EXIT_FAILURE);
   }
 
-  while ((Opt = getopt (argc, argv, "i:vh")) != -1) {
+  while ((Opt = getopt (argc, argv, "i:d:l:j:vh")) != -1) {
     switch (Opt) {
+      case 'd': {
+        if (AddBatchDirectory (optarg) != 0) {
+          exit (EXIT_FAILURE);
+        }
+        BatchMode = 1;
+        break;
+      }
+      case 'l': {
+        if (AddBatchList (optarg) != 0) {
+          exit (EXIT_FAILURE);
+        }
+        BatchMode = 1;
+        break;
+      }
+      case 'j': {
+        BatchJobs = (unsigned) strtoul (optarg, NULL, 0);
+        break;
+      }
+      case 'v': {
+        VerboseOutput = 2;
+        break;
+      }
       case 'i': {
         //
         // Open input file
@@ -97,8 +128,28 @@ main (
     exit(EXIT_FAILURE);
   }
 
+  if (BatchMode) {
+    free (Image);
+    //
+    // Diagnostics would interleave with the results, keep them for -v only
+    //
+    VerboseOutput = VerboseOutput > 1;
+    if (BatchJobs == 0) {
+      long Cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      BatchJobs = Cpus > 0 ? (unsigned) Cpus : 1;
+    }
+    return VerifyAppleImageBatch (BatchJobs) == 0 ? 0 : EXIT_FAILURE;
+  }
+
+  if (Image == NULL) {
+    puts(UsageBanner);
+    exit(EXIT_FAILURE);
+  }
 
   int code = VerifyAppleImageSignature (Image, ImageSize);
+  if (code == 0) {
+    puts ("Signature verified!");
+  }
 
   free(Image);
 
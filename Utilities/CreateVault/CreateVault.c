@@ -0,0 +1,785 @@
+/** @file
+  Copyright (C) 2020, vit9696. All rights reserved.
+
+  All rights reserved.
+
+  This program and the accompanying materials
+  are licensed and made available under the terms and conditions of the BSD License
+  which accompanies this distribution.  The full text of the license may be found at
+  http://opensource.org/licenses/bsd-license.php
+
+  THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+  WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+**/
+
+#include <Library/OcCryptoLib.h>
+#include <Library/OcStringLib.h>
+#include <Library/OcXmlLib.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/*
+ Native replacement for create_vault.sh, see Makefile for building.
+
+ ./CreateVault [-i] [-j threads] path/to/EFI/OC
+
+ -i reuses hashes from the previous vault.plist for files, which size and
+ modification time match vault.cache written by the previous run.
+*/
+
+#define VAULT_PLIST_NAME      "vault.plist"
+#define VAULT_SIGNATURE_NAME  "vault.sig"
+#define VAULT_CACHE_NAME      "vault.cache"
+#define VAULT_MAX_THREADS     256
+#define VAULT_READ_SIZE       (1024 * 1024)
+#define VAULT_BASE64_SIZE     (((SHA256_DIGEST_SIZE + 2) / 3) * 4 + 1)
+
+typedef struct {
+  //
+  // Path relative to OC directory with '/' separators.
+  //
+  CHAR8    *Path;
+  //
+  // Vault key with '\\' separators, escaped for XML.
+  //
+  CHAR8    *Key;
+  UINT64   Size;
+  UINT64   Time;
+  BOOLEAN  Hashed;
+  BOOLEAN  Failed;
+  UINT8    Hash[SHA256_DIGEST_SIZE];
+  CHAR8    Base64[VAULT_BASE64_SIZE];
+} VAULT_FILE;
+
+typedef struct {
+  CHAR8    *Path;
+  UINT64   Size;
+  UINT64   Time;
+} VAULT_CACHE_ENTRY;
+
+typedef struct {
+  CONST CHAR8  *Key;
+  XML_NODE     *Value;
+} VAULT_HASH_ENTRY;
+
+STATIC VAULT_FILE  *mFiles;
+STATIC UINT32      mFileCount;
+STATIC UINT32      mFileCapacity;
+STATIC UINT32      mNextFile;
+
+STATIC CONST CHAR8 mVaultHeader[] =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n";
+
+STATIC CONST CHAR8 mVaultTemplate[] =
+  "<plist version=\"1.0\"><dict><key>Files</key><dict></dict>"
+  "<key>Version</key><integer>1</integer></dict></plist>";
+
+STATIC
+uint64_t
+TimeUs (
+  VOID
+  )
+{
+  struct timeval  Tv;
+  gettimeofday (&Tv, NULL);
+  return (uint64_t) Tv.tv_sec * 1000000ULL + (uint64_t) Tv.tv_usec;
+}
+
+STATIC
+UINT64
+StatTime (
+  IN CONST struct stat  *Stat
+  )
+{
+#ifdef __APPLE__
+  return (UINT64) Stat->st_mtimespec.tv_sec * 1000000000ULL + (UINT64) Stat->st_mtimespec.tv_nsec;
+#else
+  return (UINT64) Stat->st_mtim.tv_sec * 1000000000ULL + (UINT64) Stat->st_mtim.tv_nsec;
+#endif
+}
+
+STATIC
+VOID
+Base64Encode (
+  IN  CONST UINT8  *Data,
+  IN  UINTN        Size,
+  OUT CHAR8        *Encoded
+  )
+{
+  STATIC CONST CHAR8 Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  UINT32  Value;
+  UINTN   Index;
+
+  for (Index = 0; Index < Size; Index += 3) {
+    Value = (UINT32) Data[Index] << 16U;
+    if (Index + 1 < Size) {
+      Value |= (UINT32) Data[Index + 1] << 8U;
+    }
+    if (Index + 2 < Size) {
+      Value |= Data[Index + 2];
+    }
+
+    *Encoded++ = Alphabet[(Value >> 18U) & 0x3FU];
+    *Encoded++ = Alphabet[(Value >> 12U) & 0x3FU];
+    *Encoded++ = Index + 1 < Size ? Alphabet[(Value >> 6U) & 0x3FU] : '=';
+    *Encoded++ = Index + 2 < Size ? Alphabet[Value & 0x3FU] : '=';
+  }
+
+  *Encoded = '\0';
+}
+
+/**
+  Converts relative path to vault key as create_vault.sh did and escapes it,
+  since XmlDocumentExport writes node contents verbatim.
+**/
+STATIC
+CHAR8 *
+PathToVaultKey (
+  IN CONST CHAR8  *Path
+  )
+{
+  CHAR8  *Key;
+  CHAR8  *Walker;
+
+  Key = malloc (strlen (Path) * 5 + 1);
+  if (Key == NULL) {
+    return NULL;
+  }
+
+  for (Walker = Key; *Path != '\0'; ++Path) {
+    switch (*Path) {
+      case '/':
+        *Walker++ = '\\';
+        break;
+      case '&':
+        memcpy (Walker, "&amp;", 5);
+        Walker += 5;
+        break;
+      case '<':
+        memcpy (Walker, "&lt;", 4);
+        Walker += 4;
+        break;
+      case '>':
+        memcpy (Walker, "&gt;", 4);
+        Walker += 4;
+        break;
+      default:
+        *Walker++ = *Path;
+        break;
+    }
+  }
+
+  *Walker = '\0';
+  return Key;
+}
+
+STATIC
+int
+AddFile (
+  IN CONST CHAR8        *Path,
+  IN CONST struct stat  *Stat
+  )
+{
+  VAULT_FILE  *NewFiles;
+  UINT32      NewCapacity;
+  VAULT_FILE  *File;
+
+  if (mFileCount == mFileCapacity) {
+    NewCapacity = mFileCapacity == 0 ? 256 : mFileCapacity * 2;
+    NewFiles    = realloc (mFiles, NewCapacity * sizeof (VAULT_FILE));
+    if (NewFiles == NULL) {
+      return -1;
+    }
+
+    mFiles        = NewFiles;
+    mFileCapacity = NewCapacity;
+  }
+
+  File = &mFiles[mFileCount];
+  memset (File, 0, sizeof (*File));
+  File->Path = strdup (Path);
+  File->Key  = PathToVaultKey (Path);
+  File->Size = (UINT64) Stat->st_size;
+  File->Time = StatTime (Stat);
+  if (File->Path == NULL || File->Key == NULL) {
+    free (File->Path);
+    free (File->Key);
+    return -1;
+  }
+
+  ++mFileCount;
+  return 0;
+}
+
+/**
+  Collects files with the same filters as create_vault.sh: hidden entries,
+  vault files and OpenCore.efi are skipped, symbolic links are not followed.
+**/
+STATIC
+int
+CollectFiles (
+  IN CONST CHAR8  *Prefix
+  )
+{
+  DIR            *Dir;
+  struct dirent  *Entry;
+  struct stat    Stat;
+  CHAR8          *Path;
+  int            Status;
+
+  Dir = opendir (Prefix[0] == '\0' ? "." : Prefix);
+  if (Dir == NULL) {
+    printf ("Failed to open %s, errno = %d\n", Prefix[0] == '\0' ? "." : Prefix, errno);
+    return -1;
+  }
+
+  Status = 0;
+
+  while (Status == 0 && (Entry = readdir (Dir)) != NULL) {
+    if (Entry->d_name[0] == '.') {
+      continue;
+    }
+
+    Path = malloc (strlen (Prefix) + strlen (Entry->d_name) + 2);
+    if (Path == NULL) {
+      Status = -1;
+      break;
+    }
+
+    if (Prefix[0] == '\0') {
+      strcpy (Path, Entry->d_name);
+    } else {
+      sprintf (Path, "%s/%s", Prefix, Entry->d_name);
+    }
+
+    if (lstat (Path, &Stat) == 0) {
+      if (S_ISDIR (Stat.st_mode)) {
+        Status = CollectFiles (Path);
+      } else if (S_ISREG (Stat.st_mode)
+        && strncasecmp (Entry->d_name, "vault.", L_STR_LEN ("vault.")) != 0
+        && strcasecmp (Entry->d_name, "OpenCore.efi") != 0) {
+        Status = AddFile (Path, &Stat);
+      }
+    }
+
+    free (Path);
+  }
+
+  closedir (Dir);
+  return Status;
+}
+
+STATIC
+int
+CompareFiles (
+  IN CONST VOID  *First,
+  IN CONST VOID  *Second
+  )
+{
+  return strcmp (((CONST VAULT_FILE *) First)->Path, ((CONST VAULT_FILE *) Second)->Path);
+}
+
+STATIC
+int
+CompareCacheEntries (
+  IN CONST VOID  *First,
+  IN CONST VOID  *Second
+  )
+{
+  return strcmp (((CONST VAULT_CACHE_ENTRY *) First)->Path, ((CONST VAULT_CACHE_ENTRY *) Second)->Path);
+}
+
+STATIC
+int
+CompareHashEntries (
+  IN CONST VOID  *First,
+  IN CONST VOID  *Second
+  )
+{
+  return strcmp (((CONST VAULT_HASH_ENTRY *) First)->Key, ((CONST VAULT_HASH_ENTRY *) Second)->Key);
+}
+
+STATIC
+CHAR8 *
+ReadWholeFile (
+  IN  CONST CHAR8  *Path,
+  OUT UINT32       *Size
+  )
+{
+  FILE   *Fp;
+  long   FileSize;
+  CHAR8  *Buffer;
+
+  Fp = fopen (Path, "rb");
+  if (Fp == NULL) {
+    return NULL;
+  }
+
+  Buffer = NULL;
+  if (fseek (Fp, 0, SEEK_END) == 0
+    && (FileSize = ftell (Fp)) > 0
+    && FileSize < MAX_INT32
+    && fseek (Fp, 0, SEEK_SET) == 0) {
+    Buffer = malloc ((size_t) FileSize + 1);
+    if (Buffer != NULL && fread (Buffer, (size_t) FileSize, 1, Fp) == 1) {
+      Buffer[FileSize] = '\0';
+      *Size = (UINT32) FileSize;
+    } else {
+      free (Buffer);
+      Buffer = NULL;
+    }
+  }
+
+  fclose (Fp);
+  return Buffer;
+}
+
+/**
+  Reuses hashes of files, which did not change according to vault.cache,
+  from the previous vault.plist.
+**/
+STATIC
+UINT32
+LoadPreviousVault (
+  VOID
+  )
+{
+  CHAR8              *PlistBuffer;
+  UINT32             PlistSize;
+  XML_DOCUMENT       *Document;
+  XML_NODE           *Root;
+  XML_NODE           *FilesNode;
+  XML_NODE           *Value;
+  CONST CHAR8        *Key;
+  VAULT_HASH_ENTRY   *Hashes;
+  VAULT_HASH_ENTRY   *Hash;
+  UINT32             HashCount;
+  VAULT_CACHE_ENTRY  *Cache;
+  VAULT_CACHE_ENTRY  *CacheEntry;
+  VAULT_CACHE_ENTRY  Lookup;
+  UINT32             CacheCount;
+  UINT32             CacheCapacity;
+  FILE               *CacheFp;
+  char               *Line;
+  size_t             LineSize;
+  ssize_t            Length;
+  unsigned long long Size;
+  unsigned long long Time;
+  int                Offset;
+  UINT32             Index;
+  UINT32             HashSize;
+  UINT32             Reused;
+
+  Reused = 0;
+
+  PlistBuffer = ReadWholeFile (VAULT_PLIST_NAME, &PlistSize);
+  if (PlistBuffer == NULL) {
+    return 0;
+  }
+
+  CacheFp = fopen (VAULT_CACHE_NAME, "r");
+  if (CacheFp == NULL) {
+    free (PlistBuffer);
+    return 0;
+  }
+
+  //
+  // Every line is "<size> <mtime ns> <path>".
+  //
+  Cache         = NULL;
+  CacheCount    = 0;
+  CacheCapacity = 0;
+  Line          = NULL;
+  LineSize      = 0;
+
+  while ((Length = getline (&Line, &LineSize, CacheFp)) > 0) {
+    if (Line[Length - 1] == '\n') {
+      Line[--Length] = '\0';
+    }
+
+    if (sscanf (Line, "%llu %llu %n", &Size, &Time, &Offset) != 2 || Line[Offset] == '\0') {
+      continue;
+    }
+
+    if (CacheCount == CacheCapacity) {
+      CacheCapacity = CacheCapacity == 0 ? 256 : CacheCapacity * 2;
+      CacheEntry    = realloc (Cache, CacheCapacity * sizeof (VAULT_CACHE_ENTRY));
+      if (CacheEntry == NULL) {
+        break;
+      }
+      Cache = CacheEntry;
+    }
+
+    Cache[CacheCount].Path = strdup (&Line[Offset]);
+    Cache[CacheCount].Size = Size;
+    Cache[CacheCount].Time = Time;
+    if (Cache[CacheCount].Path == NULL) {
+      break;
+    }
+    ++CacheCount;
+  }
+
+  free (Line);
+  fclose (CacheFp);
+
+  qsort (Cache, CacheCount, sizeof (VAULT_CACHE_ENTRY), CompareCacheEntries);
+
+  Hashes    = NULL;
+  HashCount = 0;
+  Document  = XmlDocumentParse (PlistBuffer, PlistSize, FALSE);
+  Root      = Document != NULL ? PlistNodeCast (PlistDocumentRoot (Document), PLIST_NODE_TYPE_DICT) : NULL;
+  FilesNode = NULL;
+
+  for (Index = 0; Root != NULL && Index < PlistDictChildren (Root); ++Index) {
+    Key = PlistKeyValue (PlistDictChild (Root, Index, &Value));
+    if (Key != NULL && strcmp (Key, "Files") == 0) {
+      FilesNode = PlistNodeCast (Value, PLIST_NODE_TYPE_DICT);
+      break;
+    }
+  }
+
+  if (FilesNode != NULL && PlistDictChildren (FilesNode) > 0) {
+    Hashes = malloc (PlistDictChildren (FilesNode) * sizeof (VAULT_HASH_ENTRY));
+  }
+
+  if (Hashes != NULL) {
+    for (Index = 0; Index < PlistDictChildren (FilesNode); ++Index) {
+      Key = PlistKeyValue (PlistDictChild (FilesNode, Index, &Value));
+      if (Key != NULL) {
+        Hashes[HashCount].Key   = Key;
+        Hashes[HashCount].Value = Value;
+        ++HashCount;
+      }
+    }
+
+    qsort (Hashes, HashCount, sizeof (VAULT_HASH_ENTRY), CompareHashEntries);
+
+    for (Index = 0; Index < mFileCount; ++Index) {
+      Lookup.Path = mFiles[Index].Path;
+      CacheEntry  = bsearch (&Lookup, Cache, CacheCount, sizeof (VAULT_CACHE_ENTRY), CompareCacheEntries);
+      if (CacheEntry == NULL
+        || CacheEntry->Size != mFiles[Index].Size
+        || CacheEntry->Time != mFiles[Index].Time) {
+        continue;
+      }
+
+      Hash = bsearch (
+        &(VAULT_HASH_ENTRY) { .Key = mFiles[Index].Key },
+        Hashes,
+        HashCount,
+        sizeof (VAULT_HASH_ENTRY),
+        CompareHashEntries
+        );
+      HashSize = sizeof (mFiles[Index].Hash);
+      if (Hash != NULL
+        && PlistDataValue (Hash->Value, mFiles[Index].Hash, &HashSize)
+        && HashSize == sizeof (mFiles[Index].Hash)) {
+        mFiles[Index].Hashed = TRUE;
+        ++Reused;
+      }
+    }
+
+    free (Hashes);
+  }
+
+  for (Index = 0; Index < CacheCount; ++Index) {
+    free (Cache[Index].Path);
+  }
+  free (Cache);
+
+  if (Document != NULL) {
+    XmlDocumentFree (Document);
+  }
+  free (PlistBuffer);
+
+  return Reused;
+}
+
+STATIC
+VOID
+HashFile (
+  IN OUT VAULT_FILE  *File,
+  IN     UINT8       *Buffer
+  )
+{
+  SHA256_CONTEXT  Context;
+  ssize_t         Size;
+  int             Fd;
+
+  Fd = open (File->Path, O_RDONLY);
+  if (Fd < 0) {
+    File->Failed = TRUE;
+    return;
+  }
+
+  Sha256Init (&Context);
+  while ((Size = read (Fd, Buffer, VAULT_READ_SIZE)) > 0) {
+    Sha256Update (&Context, Buffer, (UINTN) Size);
+  }
+  Sha256Final (&Context, File->Hash);
+
+  close (Fd);
+
+  if (Size < 0) {
+    File->Failed = TRUE;
+  }
+}
+
+STATIC
+VOID *
+HashWorker (
+  IN VOID  *Arg
+  )
+{
+  UINT8   *Buffer;
+  UINT32  Index;
+
+  (VOID) Arg;
+
+  Buffer = malloc (VAULT_READ_SIZE);
+  if (Buffer == NULL) {
+    return NULL;
+  }
+
+  while ((Index = __atomic_fetch_add (&mNextFile, 1, __ATOMIC_RELAXED)) < mFileCount) {
+    if (!mFiles[Index].Hashed) {
+      HashFile (&mFiles[Index], Buffer);
+    }
+  }
+
+  free (Buffer);
+  return NULL;
+}
+
+/**
+  Builds the whole vault document in memory and writes it once.
+**/
+STATIC
+int
+WriteVault (
+  VOID
+  )
+{
+  CHAR8         *Template;
+  XML_DOCUMENT  *Document;
+  XML_NODE      *FilesNode;
+  CHAR8         *Exported;
+  UINT32        ExportedSize;
+  UINT32        Index;
+  FILE          *Fp;
+  BOOLEAN       Failed;
+
+  Template = strdup (mVaultTemplate);
+  if (Template == NULL) {
+    return -1;
+  }
+
+  Document = XmlDocumentParse (Template, (UINT32) L_STR_LEN (mVaultTemplate), FALSE);
+  if (Document == NULL) {
+    free (Template);
+    return -1;
+  }
+
+  PlistDictChild (PlistDocumentRoot (Document), 0, &FilesNode);
+
+  Failed = FALSE;
+  for (Index = 0; Index < mFileCount && !Failed; ++Index) {
+    Base64Encode (mFiles[Index].Hash, sizeof (mFiles[Index].Hash), mFiles[Index].Base64);
+    Failed |= XmlNodeAppend (FilesNode, "key", NULL, mFiles[Index].Key) == NULL;
+    Failed |= XmlNodeAppend (FilesNode, "data", NULL, mFiles[Index].Base64) == NULL;
+  }
+
+  Exported = Failed ? NULL : XmlDocumentExport (Document, &ExportedSize, 0);
+  XmlDocumentFree (Document);
+  free (Template);
+
+  if (Exported == NULL) {
+    return -1;
+  }
+
+  Fp = fopen (VAULT_PLIST_NAME ".tmp", "wb");
+  Failed = Fp == NULL;
+  if (!Failed) {
+    Failed |= fwrite (mVaultHeader, L_STR_LEN (mVaultHeader), 1, Fp) != 1;
+    Failed |= fwrite (Exported, ExportedSize, 1, Fp) != 1;
+    Failed |= fputc ('\n', Fp) == EOF;
+    Failed |= fclose (Fp) != 0;
+  }
+
+  FreePool (Exported);
+
+  if (Failed || rename (VAULT_PLIST_NAME ".tmp", VAULT_PLIST_NAME) != 0) {
+    unlink (VAULT_PLIST_NAME ".tmp");
+    return -1;
+  }
+
+  return 0;
+}
+
+STATIC
+int
+WriteCache (
+  VOID
+  )
+{
+  FILE    *Fp;
+  UINT32  Index;
+  int     Status;
+
+  Fp = fopen (VAULT_CACHE_NAME, "w");
+  if (Fp == NULL) {
+    return -1;
+  }
+
+  Status = 0;
+  for (Index = 0; Index < mFileCount && Status >= 0; ++Index) {
+    Status = fprintf (
+      Fp,
+      "%llu %llu %s\n",
+      (unsigned long long) mFiles[Index].Size,
+      (unsigned long long) mFiles[Index].Time,
+      mFiles[Index].Path
+      );
+  }
+
+  if (fclose (Fp) != 0 || Status < 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  pthread_t  Threads[VAULT_MAX_THREADS];
+  UINT32     NumThreads;
+  UINT32     Started;
+  UINT32     Index;
+  UINT32     Reused;
+  UINT64     Bytes;
+  uint64_t   Start;
+  BOOLEAN    Incremental;
+  long       Cpus;
+  int        Opt;
+
+  Incremental = FALSE;
+  Cpus        = sysconf (_SC_NPROCESSORS_ONLN);
+  NumThreads  = Cpus > 0 ? (UINT32) Cpus : 1;
+
+  while ((Opt = getopt (argc, argv, "ij:")) != -1) {
+    switch (Opt) {
+      case 'i':
+        Incremental = TRUE;
+        break;
+      case 'j':
+        NumThreads = (UINT32) strtoul (optarg, NULL, 0);
+        break;
+      default:
+        printf ("Usage: %s [-i] [-j threads] path/to/EFI/OC\n", argv[0]);
+        return -1;
+    }
+  }
+
+  if (optind + 1 != argc) {
+    printf ("Usage: %s [-i] [-j threads] path/to/EFI/OC\n", argv[0]);
+    return -1;
+  }
+
+  if (NumThreads == 0) {
+    NumThreads = 1;
+  } else if (NumThreads > VAULT_MAX_THREADS) {
+    NumThreads = VAULT_MAX_THREADS;
+  }
+
+  printf ("Chose %s for hashing...\n", argv[optind]);
+
+  if (chdir (argv[optind]) != 0) {
+    printf ("Fatal error: Failed to reach %s!\n", argv[optind]);
+    return -1;
+  }
+
+  Start = TimeUs ();
+
+  if (CollectFiles ("") != 0) {
+    printf ("Fatal error: Failed to enumerate files!\n");
+    return -1;
+  }
+
+  qsort (mFiles, mFileCount, sizeof (VAULT_FILE), CompareFiles);
+
+  Reused = Incremental ? LoadPreviousVault () : 0;
+
+  //
+  // The signature no longer matches once vault.plist is rewritten.
+  //
+  unlink (VAULT_SIGNATURE_NAME);
+
+  printf ("Hashing files in %s...\n", argv[optind]);
+
+  for (Started = 0; Started < NumThreads - 1; ++Started) {
+    if (pthread_create (&Threads[Started], NULL, HashWorker, NULL) != 0) {
+      break;
+    }
+  }
+
+  HashWorker (NULL);
+
+  for (Index = 0; Index < Started; ++Index) {
+    pthread_join (Threads[Index], NULL);
+  }
+
+  Bytes = 0;
+  for (Index = 0; Index < mFileCount; ++Index) {
+    if (mFiles[Index].Failed) {
+      printf ("Fatal error: Failed to hash %s!\n", mFiles[Index].Path);
+      unlink (VAULT_PLIST_NAME);
+      return -1;
+    }
+
+    if (!mFiles[Index].Hashed) {
+      Bytes += mFiles[Index].Size;
+    }
+
+    printf ("%s: ", mFiles[Index].Key);
+    for (UINT32 Byte = 0; Byte < sizeof (mFiles[Index].Hash); ++Byte) {
+      printf ("%02x", mFiles[Index].Hash[Byte]);
+    }
+    printf ("%s\n", mFiles[Index].Hashed ? " (cached)" : "");
+  }
+
+  if (WriteVault () != 0) {
+    printf ("Fatal error: Failed to write %s!\n", VAULT_PLIST_NAME);
+    return -1;
+  }
+
+  if (WriteCache () != 0) {
+    printf ("Warning: Failed to write %s, next incremental run will hash all files\n", VAULT_CACHE_NAME);
+    unlink (VAULT_CACHE_NAME);
+  }
+
+  printf (
+    "Hashed %u of %u files (%llu bytes) with %u threads in %llu ms\n",
+    (unsigned) (mFileCount - Reused),
+    (unsigned) mFileCount,
+    (unsigned long long) Bytes,
+    (unsigned) (Started + 1),
+    (unsigned long long) ((TimeUs () - Start) / 1000)
+    );
+
+  for (Index = 0; Index < mFileCount; ++Index) {
+    free (mFiles[Index].Path);
+    free (mFiles[Index].Key);
+  }
+  free (mFiles);
+
+  printf ("All done!\n");
+  return 0;
+}
@@ -0,0 +1,271 @@
+/** @file
+
+Decode OcPerfLib boot phase trace exported to a file or to
+opencore-perf-trace NVRAM variable (e.g. efivarfs dump with attribute prefix).
+
+Copyright (c) 2020, vit9696
+
+All rights reserved.
+
+This program and the accompanying materials
+are licensed and made available under the terms and conditions of the BSD License
+which accompanies this distribution.  The full text of the license may be found at
+http://opensource.org/licenses/bsd-license.php
+
+THE PROGRAM IS DISTRIBUTED UNDER THE BSD LICENSE ON AN "AS IS" BASIS,
+WITHOUT WARRANTIES OR REPRESENTATIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED.
+
+**/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_SIGNATURE    0x4650434FU /* 'OCPF' */
+#define TRACE_VERSION      1
+#define TRACE_HEADER_SIZE  24
+#define RECORD_SIZE        20
+#define RECORD_BEGIN       1
+#define RECORD_END         2
+#define STATUS_ERROR       0x80000000U
+#define MAX_DEPTH          64
+#define MAX_PHASES         0x10000
+
+typedef struct {
+  uint64_t timestamp;
+  uint32_t size;
+  uint32_t status;
+  uint16_t phase;
+  uint8_t  type;
+  uint8_t  depth;
+} record_t;
+
+typedef struct {
+  uint64_t total;
+  uint32_t count;
+  uint32_t errors;
+} phase_total_t;
+
+static const char *phase_names[] = {
+  [1] = "ConfigParse",
+  [2] = "Acpi",
+  [3] = "Smbios",
+  [4] = "Vault",
+  [5] = "Scan",
+  [6] = "KernelRead",
+  [7] = "KernelDecompress",
+  [8] = "KextLink",
+  [9] = "KextInject",
+};
+
+static uint16_t read16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8U));
+}
+
+static uint32_t read32(const uint8_t *p) {
+  return (uint32_t)read16(p) | ((uint32_t)read16(p + 2) << 16U);
+}
+
+static uint64_t read64(const uint8_t *p) {
+  return (uint64_t)read32(p) | ((uint64_t)read32(p + 4) << 32U);
+}
+
+static const char *phase_name(uint16_t phase, char *buf, size_t size) {
+  if (phase < sizeof(phase_names) / sizeof(phase_names[0]) && phase_names[phase]) {
+    return phase_names[phase];
+  }
+  snprintf(buf, size, "Phase%04X", phase);
+  return buf;
+}
+
+static int read_file(const char *filename, uint8_t **buffer, size_t *size) {
+  FILE *fh = fopen(filename, "rb");
+  if (!fh) {
+    fprintf(stderr, "Missing file %s!\n", filename);
+    return -1;
+  }
+
+  if (fseek(fh, 0, SEEK_END)) {
+    fprintf(stderr, "Failed to find end of %s!\n", filename);
+    fclose(fh);
+    return -1;
+  }
+
+  long pos = ftell(fh);
+
+  if (pos <= 0) {
+    fprintf(stderr, "Invalid file size (%ld) of %s!\n", pos, filename);
+    fclose(fh);
+    return -1;
+  }
+
+  if (fseek(fh, 0, SEEK_SET)) {
+    fprintf(stderr, "Failed to rewind %s!\n", filename);
+    fclose(fh);
+    return -1;
+  }
+
+  *size = (size_t)pos;
+  *buffer = (uint8_t *)malloc(*size);
+
+  if (!*buffer) {
+    fprintf(stderr, "Failed to allocate %zu bytes for %s!\n", *size, filename);
+    fclose(fh);
+    return -1;
+  }
+
+  if (fread(*buffer, *size, 1, fh) != 1) {
+    fprintf(stderr, "Failed to read %zu bytes from %s!\n", *size, filename);
+    fclose(fh);
+    free(*buffer);
+    return -1;
+  }
+
+  fclose(fh);
+  return 0;
+}
+
+static double to_us(uint64_t ticks, uint64_t frequency) {
+  if (frequency == 0) {
+    return (double)ticks;
+  }
+  return (double)ticks * 1000000.0 / (double)frequency;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Pass trace file!\n");
+    return -1;
+  }
+
+  uint8_t *buffer;
+  size_t size;
+
+  if (read_file(argv[1], &buffer, &size)) {
+    return -1;
+  }
+
+  //
+  // efivarfs prefixes variable data with 4-byte attributes.
+  //
+  const uint8_t *trace = buffer;
+  if (size >= TRACE_HEADER_SIZE + 4 && read32(trace) != TRACE_SIGNATURE
+    && read32(trace + 4) == TRACE_SIGNATURE) {
+    trace += 4;
+    size -= 4;
+  }
+
+  if (size < TRACE_HEADER_SIZE || read32(trace) != TRACE_SIGNATURE) {
+    fprintf(stderr, "Invalid trace signature!\n");
+    free(buffer);
+    return -1;
+  }
+
+  uint16_t version = read16(trace + 4);
+  uint16_t record_size = read16(trace + 6);
+  uint64_t frequency = read64(trace + 8);
+  uint32_t count = read32(trace + 16);
+  uint32_t dropped = read32(trace + 20);
+
+  if (version != TRACE_VERSION || record_size < RECORD_SIZE
+    || count > (size - TRACE_HEADER_SIZE) / record_size) {
+    fprintf(stderr, "Unsupported trace v%u with %u records of %u bytes in %zu bytes!\n",
+      version, count, record_size, size);
+    free(buffer);
+    return -1;
+  }
+
+  printf("Trace v%u, %u records, %u dropped, %s\n\n", version, count, dropped,
+    frequency != 0 ? "times in us" : "times in ticks (unknown frequency)");
+
+  phase_total_t *totals = calloc(MAX_PHASES, sizeof(*totals));
+  if (!totals) {
+    fprintf(stderr, "Failed to allocate phase totals!\n");
+    free(buffer);
+    return -1;
+  }
+
+  record_t stack[MAX_DEPTH];
+  size_t depth = 0;
+  uint64_t first = 0;
+  char name[16];
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint8_t *p = trace + TRACE_HEADER_SIZE + (size_t)i * record_size;
+    record_t r;
+    r.timestamp = read64(p);
+    r.size = read32(p + 8);
+    r.status = read32(p + 12);
+    r.phase = read16(p + 16);
+    r.type = p[18];
+    r.depth = p[19];
+
+    if (i == 0) {
+      first = r.timestamp;
+    }
+
+    if (r.type == RECORD_BEGIN) {
+      if (depth < MAX_DEPTH) {
+        stack[depth++] = r;
+      }
+      continue;
+    }
+
+    if (r.type != RECORD_END) {
+      fprintf(stderr, "Unknown record type %u at %u!\n", r.type, i);
+      continue;
+    }
+
+    //
+    // Match the closest begin of the same phase, drop unmatched nested ones.
+    //
+    size_t match = depth;
+    while (match > 0 && stack[match - 1].phase != r.phase) {
+      --match;
+    }
+
+    const char *pname = phase_name(r.phase, name, sizeof(name));
+
+    if (match == 0) {
+      printf("%*s%-*s  (begin lost)\n", r.depth * 2, "", 24 - r.depth * 2, pname);
+      continue;
+    }
+
+    record_t *b = &stack[match - 1];
+    uint64_t elapsed = r.timestamp - b->timestamp;
+    depth = match - 1;
+
+    printf("%*s%-*s %12.1f at %12.1f", b->depth * 2, "", 24 - b->depth * 2, pname,
+      to_us(elapsed, frequency), to_us(b->timestamp - first, frequency));
+    if (r.size != 0) {
+      printf("  %10u bytes", r.size);
+    }
+    if (r.status & STATUS_ERROR) {
+      printf("  error %u", r.status & ~STATUS_ERROR);
+    }
+    printf("\n");
+
+    totals[r.phase].total += elapsed;
+    totals[r.phase].count++;
+    if (r.status & STATUS_ERROR) {
+      totals[r.phase].errors++;
+    }
+  }
+
+  for (size_t i = 0; i < depth; ++i) {
+    printf("%*s%-*s  (unfinished)\n", stack[i].depth * 2, "", 24 - stack[i].depth * 2,
+      phase_name(stack[i].phase, name, sizeof(name)));
+  }
+
+  printf("\n%-24s %12s %8s %8s\n", "Phase", "Total", "Count", "Errors");
+  for (uint32_t i = 0; i < MAX_PHASES; ++i) {
+    if (totals[i].count != 0) {
+      printf("%-24s %12.1f %8u %8u\n", phase_name((uint16_t)i, name, sizeof(name)),
+        to_us(totals[i].total, frequency), totals[i].count, totals[i].errors);
+    }
+  }
+
+  free(totals);
+  free(buffer);
+  return 0;
+}